@@ -0,0 +1,43 @@
+/**
+ * @file capture.h
+ * @author Shambaditya Tarafder
+ * @date 12/9/2021
+ * @brief What a BLE central received from the firmware, read back line by
+ *        line by the host tools, either as the raw stream or out of the
+ *        HM10 notifications firmware_sim logs.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef CAPTURE_HG
+#define CAPTURE_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define CAPTURE_LINE_MAX    4096
+
+typedef struct {
+  FILE    *file;
+  bool    sim;                          // firmware_sim output, not the raw stream
+  char    data[CAPTURE_LINE_MAX];       // Received and not yet returned
+  size_t  used;
+  size_t  next;
+  char    line[CAPTURE_LINE_MAX];       // Line being put together
+  size_t  line_len;
+} CAPTURE;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void capture_open(CAPTURE *capture, FILE *file, bool sim);
+bool capture_line(CAPTURE *capture, char *line, size_t size);
+
+#endif
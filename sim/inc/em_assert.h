@@ -0,0 +1,30 @@
+/**
+ * @file em_assert.h
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Host simulation stand-in for the Gecko SDK assert header.  Asserts are
+ *        always enabled in the simulation, a failure reports the file, line and
+ *        virtual time and ends the run.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_ASSERT_HG
+#define EM_ASSERT_HG
+
+/* System include statements */
+#include <stdbool.h>
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define EFM_ASSERT(expr)    ((expr) ? ((void)0) : assertEFM(__FILE__, __LINE__))
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void assertEFM(const char *file, int line) __attribute__((noreturn));
+
+#endif
@@ -0,0 +1,22 @@
+/**
+ * @file em_chip.h
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Host simulation stand-in for the Gecko SDK chip errata header
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_CHIP_HG
+#define EM_CHIP_HG
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void CHIP_Init(void);
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file em_cmu.h
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Host simulation stand-in for the Gecko SDK clock management unit
+ *        header.  The simulated CMU tracks oscillators, clock selects, branch
+ *        gates and the HFRCO band, the peripheral models run from it.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_CMU_HG
+#define EM_CMU_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+typedef enum {
+  cmuClock_HF,
+  cmuClock_CORE,
+  cmuClock_HFPER,
+  cmuClock_HFLE,
+  cmuClock_LFA,
+  cmuClock_LFB,
+  cmuClock_LFE,
+  cmuClock_CORELE,
+  cmuClock_GPIO,
+  cmuClock_LDMA,
+  cmuClock_TIMER0,
+  cmuClock_TIMER1,
+  cmuClock_WTIMER0,
+  cmuClock_I2C0,
+  cmuClock_I2C1,
+  cmuClock_LETIMER0,
+  cmuClock_LEUART0,
+  cmuClock_RTCC,
+  SIM_CMU_CLOCKS
+} CMU_Clock_TypeDef;
+
+typedef enum {
+  cmuOsc_LFXO,
+  cmuOsc_LFRCO,
+  cmuOsc_HFXO,
+  cmuOsc_HFRCO,
+  cmuOsc_AUXHFRCO,
+  cmuOsc_ULFRCO,
+  SIM_CMU_OSCS
+} CMU_Osc_TypeDef;
+
+typedef enum {
+  cmuSelect_Error,
+  cmuSelect_Disabled,
+  cmuSelect_LFXO,
+  cmuSelect_LFRCO,
+  cmuSelect_HFXO,
+  cmuSelect_HFRCO,
+  cmuSelect_ULFRCO,
+  cmuSelect_HFCLKLE
+} CMU_Select_TypeDef;
+
+typedef enum {
+  cmuHFRCOFreq_1M0Hz        = 1000000U,
+  cmuHFRCOFreq_2M0Hz        = 2000000U,
+  cmuHFRCOFreq_4M0Hz        = 4000000U,
+  cmuHFRCOFreq_7M0Hz        = 7000000U,
+  cmuHFRCOFreq_13M0Hz       = 13000000U,
+  cmuHFRCOFreq_16M0Hz       = 16000000U,
+  cmuHFRCOFreq_19M0Hz       = 19000000U,
+  cmuHFRCOFreq_26M0Hz       = 26000000U,
+  cmuHFRCOFreq_32M0Hz       = 32000000U,
+  cmuHFRCOFreq_38M0Hz       = 38000000U,
+  cmuHFRCOFreq_UserDefined  = 0
+} CMU_HFRCOFreq_TypeDef;
+
+typedef struct {
+  uint16_t ctuneSteadyState;
+  uint16_t ctuneStartup;
+  bool     autoStartEm01;
+  bool     autoSelEm01;
+} CMU_HFXOInit_TypeDef;
+
+#define CMU_HFXOINIT_DEFAULT    { 0x140, 0x142, false, false }
+
+#define SIM_CMU_ULFRCO_FREQ     1000U
+#define SIM_CMU_LFXO_FREQ       32768U
+#define SIM_CMU_LFRCO_FREQ      32768U
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable);
+uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock);
+void CMU_ClockSelectSet(CMU_Clock_TypeDef clock, CMU_Select_TypeDef ref);
+CMU_Select_TypeDef CMU_ClockSelectGet(CMU_Clock_TypeDef clock);
+void CMU_HFRCOBandSet(CMU_HFRCOFreq_TypeDef setFreq);
+CMU_HFRCOFreq_TypeDef CMU_HFRCOBandGet(void);
+void CMU_OscillatorEnable(CMU_Osc_TypeDef osc, bool enable, bool wait);
+void CMU_HFXOInit(const CMU_HFXOInit_TypeDef *hfxoInit);
+
+#endif
@@ -0,0 +1,45 @@
+/**
+ * @file em_core.h
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Host simulation stand-in for the Gecko SDK core interrupt masking
+ *        header.  Critical and atomic sections both set the simulated PRIMASK,
+ *        pending interrupts are taken when the outermost section exits.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_CORE_HG
+#define EM_CORE_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+typedef uint32_t CORE_irqState_t;
+
+#define CORE_DECLARE_IRQ_STATE      CORE_irqState_t irqState
+#define CORE_ENTER_CRITICAL()       irqState = CORE_EnterCritical()
+#define CORE_EXIT_CRITICAL()        CORE_ExitCritical(irqState)
+#define CORE_ENTER_ATOMIC()         irqState = CORE_EnterAtomic()
+#define CORE_EXIT_ATOMIC()          CORE_ExitAtomic(irqState)
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+CORE_irqState_t CORE_EnterCritical(void);
+void CORE_ExitCritical(CORE_irqState_t irqState);
+CORE_irqState_t CORE_EnterAtomic(void);
+void CORE_ExitAtomic(CORE_irqState_t irqState);
+bool CORE_InIrqContext(void);
+bool CORE_IrqIsBlocked(IRQn_Type irqN);
+
+#endif
@@ -0,0 +1,535 @@
+/**
+ * @file em_device.h
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Host simulation stand-in for the EFR32MG12P device header.  Only the
+ *        registers, bit fields, IRQ numbers and CMSIS calls that src/ uses are
+ *        provided, with the same names and values as the Gecko SDK.
+ *
+ *        Registers with hardware side effects (commands, flags, status,
+ *        counters, data) are declared as one element arrays.  Firmware reaches
+ *        them through a macro of the register's name that first calls
+ *        sim_sync(), so every such access is a point where the simulated
+ *        peripherals catch up with virtual time and interrupts are taken.
+ *        The peripheral models define SIM_MODEL_SOURCE and access them directly.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_DEVICE_HG
+#define EM_DEVICE_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define EFR32MG12P332F1024GL125
+#define _SILICON_LABS_32B_SERIES_1
+#define _SILICON_LABS_32B_SERIES_1_CONFIG_2
+
+#define __IM      volatile const
+#define __OM      volatile
+#define __IOM     volatile
+
+// Register with side effects, see the file header
+#define SIM_REG(name)       volatile uint32_t name##_[1]
+
+#ifdef SIM_MODEL_SOURCE
+#define SIM_ACCESS          0
+#define SIM_RXDATA_ACCESS   0
+#define SIM_CYCCNT_ACCESS   0
+#else
+#define SIM_ACCESS          sim_sync()
+#define SIM_RXDATA_ACCESS   sim_rxdata_access()
+#define SIM_CYCCNT_ACCESS   sim_cyccnt_access()
+#endif
+
+#define CTRL        CTRL_[SIM_ACCESS]
+#define CMD         CMD_[SIM_ACCESS]
+#define STATUS      STATUS_[SIM_ACCESS]
+#define STATE       STATE_[SIM_ACCESS]
+#define IF          IF_[SIM_ACCESS]
+#define IFS         IFS_[SIM_ACCESS]
+#define IFC         IFC_[SIM_ACCESS]
+#define IEN         IEN_[SIM_ACCESS]
+#define SYNCBUSY    SYNCBUSY_[SIM_ACCESS]
+#define FREEZE      FREEZE_[SIM_ACCESS]
+#define CNT         CNT_[SIM_ACCESS]
+#define TXDATA      TXDATA_[SIM_ACCESS]
+#define RXDATA      RXDATA_[SIM_RXDATA_ACCESS]
+#define CYCCNT      CYCCNT_[SIM_CYCCNT_ACCESS]
+
+#define SIM_TXDATA_EMPTY    0xFFFFFFFFUL    // TXDATA value while nothing is written
+
+//***********************************************************************************
+// IRQ numbers and CMSIS
+//***********************************************************************************
+typedef enum {
+  LDMA_IRQn       = 9,
+  GPIO_EVEN_IRQn  = 10,
+  TIMER0_IRQn     = 11,
+  I2C0_IRQn       = 17,
+  GPIO_ODD_IRQn   = 18,
+  TIMER1_IRQn     = 19,
+  LEUART0_IRQn    = 22,
+  LETIMER0_IRQn   = 27,
+  RTCC_IRQn       = 30,
+  WTIMER0_IRQn    = 36,
+  I2C1_IRQn       = 39,
+  SIM_IRQn_COUNT  = 45
+} IRQn_Type;
+
+void NVIC_EnableIRQ(IRQn_Type irqn);
+void NVIC_DisableIRQ(IRQn_Type irqn);
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irqn);
+void NVIC_SetPendingIRQ(IRQn_Type irqn);
+void NVIC_ClearPendingIRQ(IRQn_Type irqn);
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irqn);
+
+void __NOP(void);
+void __WFI(void);
+void __DSB(void);
+void __ISB(void);
+uint32_t __get_MSP(void);
+
+uint32_t sim_sync(void);
+uint32_t sim_rxdata_access(void);
+uint32_t sim_cyccnt_access(void);
+
+//***********************************************************************************
+// Core debug, the DWT cycle counter
+//***********************************************************************************
+typedef struct {
+  SIM_REG(CTRL);
+  SIM_REG(CYCCNT);
+} DWT_Type;
+
+typedef struct {
+  volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk          (0x1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (0x1UL << 24)
+
+//***********************************************************************************
+// LEUART
+//***********************************************************************************
+typedef struct {
+  SIM_REG(CTRL);
+  SIM_REG(CMD);
+  SIM_REG(STATUS);
+  volatile uint32_t CLKDIV;
+  volatile uint32_t STARTFRAME;
+  volatile uint32_t SIGFRAME;
+  SIM_REG(IF);
+  SIM_REG(IFS);
+  SIM_REG(IFC);
+  SIM_REG(IEN);
+  volatile uint32_t PULSECTRL;
+  SIM_REG(FREEZE);
+  SIM_REG(SYNCBUSY);
+  volatile uint32_t ROUTEPEN;
+  volatile uint32_t ROUTELOC0;
+  SIM_REG(RXDATA);
+  SIM_REG(TXDATA);
+} LEUART_TypeDef;
+
+#define LEUART_CTRL_AUTOTRI             (0x1UL << 0)
+#define LEUART_CTRL_DATABITS            (0x1UL << 1)
+#define _LEUART_CTRL_PARITY_SHIFT       2
+#define _LEUART_CTRL_PARITY_MASK        0xCUL
+#define LEUART_CTRL_STOPBITS            (0x1UL << 4)
+#define LEUART_CTRL_INV                 (0x1UL << 5)
+#define LEUART_CTRL_LOOPBK              (0x1UL << 7)
+#define LEUART_CTRL_SFUBRX              (0x1UL << 8)
+
+#define LEUART_CMD_RXEN                 (0x1UL << 0)
+#define LEUART_CMD_RXDIS                (0x1UL << 1)
+#define LEUART_CMD_TXEN                 (0x1UL << 2)
+#define LEUART_CMD_TXDIS                (0x1UL << 3)
+#define LEUART_CMD_RXBLOCKEN            (0x1UL << 4)
+#define LEUART_CMD_RXBLOCKDIS           (0x1UL << 5)
+#define LEUART_CMD_CLEARTX              (0x1UL << 6)
+#define LEUART_CMD_CLEARRX              (0x1UL << 7)
+
+#define LEUART_STATUS_RXENS             (0x1UL << 0)
+#define LEUART_STATUS_TXENS             (0x1UL << 1)
+#define LEUART_STATUS_RXBLOCK           (0x1UL << 2)
+#define LEUART_STATUS_TXC               (0x1UL << 3)
+#define LEUART_STATUS_TXBL              (0x1UL << 4)
+#define LEUART_STATUS_RXDATAV           (0x1UL << 5)
+#define LEUART_STATUS_TXIDLE            (0x1UL << 6)
+
+#define LEUART_IF_TXC                   (0x1UL << 0)
+#define LEUART_IF_TXBL                  (0x1UL << 1)
+#define LEUART_IF_RXDATAV               (0x1UL << 2)
+#define LEUART_IF_RXOF                  (0x1UL << 3)
+#define LEUART_IF_RXUF                  (0x1UL << 4)
+#define LEUART_IF_TXOF                  (0x1UL << 5)
+#define LEUART_IF_PERR                  (0x1UL << 6)
+#define LEUART_IF_FERR                  (0x1UL << 7)
+#define LEUART_IF_MPAF                  (0x1UL << 8)
+#define LEUART_IF_STARTF                (0x1UL << 9)
+#define LEUART_IF_SIGF                  (0x1UL << 10)
+#define _LEUART_IF_MASK                 0x7FFUL
+#define _LEUART_IFC_MASK                0x7F9UL   // TXBL and RXDATAV are not clearable
+#define LEUART_IFC_TXC                  LEUART_IF_TXC
+#define LEUART_IEN_TXC                  LEUART_IF_TXC
+#define LEUART_IEN_TXBL                 LEUART_IF_TXBL
+#define LEUART_IEN_RXDATAV              LEUART_IF_RXDATAV
+#define LEUART_IEN_STARTF               LEUART_IF_STARTF
+#define LEUART_IEN_SIGF                 LEUART_IF_SIGF
+
+#define _LEUART_CLKDIV_MASK             0x1FFF8UL
+
+#define LEUART_FREEZE_REGFREEZE         (0x1UL << 0)
+
+#define LEUART_SYNCBUSY_CTRL            (0x1UL << 0)
+#define LEUART_SYNCBUSY_CMD             (0x1UL << 1)
+#define LEUART_SYNCBUSY_CLKDIV          (0x1UL << 2)
+#define LEUART_SYNCBUSY_STARTFRAME      (0x1UL << 3)
+#define LEUART_SYNCBUSY_SIGFRAME        (0x1UL << 4)
+#define _LEUART_SYNCBUSY_MASK           0x1FUL
+
+#define LEUART_ROUTEPEN_RXPEN           (0x1UL << 0)
+#define LEUART_ROUTEPEN_TXPEN           (0x1UL << 1)
+#define LEUART_ROUTELOC0_RXLOC_LOC27    (27UL << 0)
+#define LEUART_ROUTELOC0_TXLOC_LOC27    (27UL << 8)
+
+//***********************************************************************************
+// I2C
+//***********************************************************************************
+typedef struct {
+  SIM_REG(CTRL);
+  SIM_REG(CMD);
+  SIM_REG(STATE);
+  SIM_REG(STATUS);
+  volatile uint32_t CLKDIV;
+  volatile uint32_t SADDR;
+  volatile uint32_t SADDRMASK;
+  SIM_REG(RXDATA);
+  SIM_REG(TXDATA);
+  SIM_REG(IF);
+  SIM_REG(IFS);
+  SIM_REG(IFC);
+  SIM_REG(IEN);
+  volatile uint32_t ROUTEPEN;
+  volatile uint32_t ROUTELOC0;
+} I2C_TypeDef;
+
+#define I2C_CTRL_EN                     (0x1UL << 0)
+#define I2C_CTRL_SLAVE                  (0x1UL << 1)
+#define _I2C_CTRL_CLHR_SHIFT            8
+#define _I2C_CTRL_CLHR_MASK             0x300UL
+
+#define I2C_CMD_START                   (0x1UL << 0)
+#define I2C_CMD_STOP                    (0x1UL << 1)
+#define I2C_CMD_ACK                     (0x1UL << 2)
+#define I2C_CMD_NACK                    (0x1UL << 3)
+#define I2C_CMD_CONT                    (0x1UL << 4)
+#define I2C_CMD_ABORT                   (0x1UL << 5)
+#define I2C_CMD_CLEARTX                 (0x1UL << 6)
+#define I2C_CMD_CLEARPC                 (0x1UL << 7)
+
+#define I2C_STATE_BUSY                  (0x1UL << 0)
+#define I2C_STATE_MASTER                (0x1UL << 1)
+#define I2C_STATE_TRANSMITTER           (0x1UL << 2)
+#define I2C_STATE_NACKED                (0x1UL << 3)
+#define I2C_STATE_BUSHOLD               (0x1UL << 4)
+#define _I2C_STATE_STATE_SHIFT          5
+#define _I2C_STATE_STATE_MASK           0xE0UL
+#define I2C_STATE_STATE_IDLE            (0x0UL << 5)
+#define I2C_STATE_STATE_WAIT            (0x1UL << 5)
+#define I2C_STATE_STATE_START           (0x2UL << 5)
+#define I2C_STATE_STATE_ADDR            (0x3UL << 5)
+#define I2C_STATE_STATE_ADDRACK         (0x4UL << 5)
+#define I2C_STATE_STATE_DATA            (0x5UL << 5)
+#define I2C_STATE_STATE_DATAACK         (0x6UL << 5)
+
+#define I2C_STATUS_TXC                  (0x1UL << 6)
+#define I2C_STATUS_TXBL                 (0x1UL << 7)
+#define I2C_STATUS_RXDATAV              (0x1UL << 8)
+
+#define I2C_IF_START                    (0x1UL << 0)
+#define I2C_IF_RSTART                   (0x1UL << 1)
+#define I2C_IF_ADDR                     (0x1UL << 2)
+#define I2C_IF_TXC                      (0x1UL << 3)
+#define I2C_IF_TXBL                     (0x1UL << 4)
+#define I2C_IF_RXDATAV                  (0x1UL << 5)
+#define I2C_IF_ACK                      (0x1UL << 6)
+#define I2C_IF_NACK                     (0x1UL << 7)
+#define I2C_IF_MSTOP                    (0x1UL << 8)
+#define I2C_IF_ARBLOST                  (0x1UL << 9)
+#define I2C_IF_BUSERR                   (0x1UL << 10)
+#define _I2C_IF_MASK                    0x7FFFFUL
+#define _I2C_IFC_MASK                   0x7FFCFUL // TXBL and RXDATAV are not clearable
+#define I2C_IEN_ACK                     I2C_IF_ACK
+#define I2C_IEN_NACK                    I2C_IF_NACK
+#define I2C_IEN_MSTOP                   I2C_IF_MSTOP
+#define I2C_IEN_RXDATAV                 I2C_IF_RXDATAV
+
+#define _I2C_CLKDIV_DIV_MASK            0x1FFUL
+
+#define I2C_ROUTEPEN_SDAPEN             (0x1UL << 0)
+#define I2C_ROUTEPEN_SCLPEN             (0x1UL << 1)
+#define I2C_ROUTELOC0_SDALOC_LOC17      (17UL << 0)
+#define I2C_ROUTELOC0_SCLLOC_LOC17      (17UL << 8)
+
+//***********************************************************************************
+// LETIMER
+//***********************************************************************************
+typedef struct {
+  SIM_REG(CTRL);
+  SIM_REG(CMD);
+  SIM_REG(STATUS);
+  SIM_REG(CNT);
+  volatile uint32_t COMP0;
+  volatile uint32_t COMP1;
+  volatile uint32_t REP0;
+  volatile uint32_t REP1;
+  SIM_REG(IF);
+  SIM_REG(IFS);
+  SIM_REG(IFC);
+  SIM_REG(IEN);
+  SIM_REG(SYNCBUSY);
+  volatile uint32_t ROUTEPEN;
+  volatile uint32_t ROUTELOC0;
+} LETIMER_TypeDef;
+
+#define _LETIMER_CTRL_REPMODE_SHIFT     0
+#define _LETIMER_CTRL_REPMODE_MASK      0x3UL
+#define _LETIMER_CTRL_UFOA0_SHIFT       2
+#define _LETIMER_CTRL_UFOA0_MASK        0xCUL
+#define _LETIMER_CTRL_UFOA1_SHIFT       4
+#define _LETIMER_CTRL_UFOA1_MASK        0x30UL
+#define LETIMER_CTRL_OPOL0              (0x1UL << 6)
+#define LETIMER_CTRL_OPOL1              (0x1UL << 7)
+#define LETIMER_CTRL_BUFTOP             (0x1UL << 8)
+#define LETIMER_CTRL_COMP0TOP           (0x1UL << 9)
+#define LETIMER_CTRL_DEBUGRUN           (0x1UL << 12)
+
+#define LETIMER_CMD_START               (0x1UL << 0)
+#define LETIMER_CMD_STOP                (0x1UL << 1)
+#define LETIMER_CMD_CLEAR               (0x1UL << 2)
+
+#define LETIMER_STATUS_RUNNING          (0x1UL << 0)
+
+#define LETIMER_SYNCBUSY_CMD            (0x1UL << 1)   // CMD is the only synchronized register
+
+#define LETIMER_IF_COMP0                (0x1UL << 0)
+#define LETIMER_IF_COMP1                (0x1UL << 1)
+#define LETIMER_IF_UF                   (0x1UL << 2)
+#define LETIMER_IF_REP0                 (0x1UL << 3)
+#define LETIMER_IF_REP1                 (0x1UL << 4)
+#define _LETIMER_IF_MASK                0x1FUL
+#define LETIMER_IEN_COMP0               LETIMER_IF_COMP0
+#define LETIMER_IEN_COMP1               LETIMER_IF_COMP1
+#define LETIMER_IEN_UF                  LETIMER_IF_UF
+
+#define LETIMER_ROUTEPEN_OUT0PEN        (0x1UL << 0)
+#define LETIMER_ROUTEPEN_OUT1PEN        (0x1UL << 1)
+#define LETIMER_ROUTELOC0_OUT0LOC_LOC17 (17UL << 0)
+#define LETIMER_ROUTELOC0_OUT1LOC_LOC16 (16UL << 8)
+
+//***********************************************************************************
+// RTCC
+//***********************************************************************************
+typedef struct {
+  SIM_REG(CTRL);
+  volatile uint32_t CCV;            // Only through RTCC_ChannelCCVSet(), no sync of its own
+} RTCC_CC_TypeDef;
+
+typedef struct {
+  volatile uint32_t REG;            // Kept through EM4H, plain RAM to the model
+} RTCC_RET_TypeDef;
+
+typedef struct {
+  SIM_REG(CTRL);
+  volatile uint32_t PRECNT;
+  SIM_REG(CNT);
+  SIM_REG(IF);
+  SIM_REG(IFS);
+  SIM_REG(IFC);
+  SIM_REG(IEN);
+  RTCC_CC_TypeDef   CC[3];
+  volatile uint32_t EM4WUEN;
+  RTCC_RET_TypeDef  RET[32];
+} RTCC_TypeDef;
+
+#define RTCC_CTRL_ENABLE                (0x1UL << 0)
+#define RTCC_CTRL_DEBUGRUN              (0x1UL << 2)
+#define _RTCC_CTRL_CNTPRESC_SHIFT       8
+#define _RTCC_CTRL_CNTPRESC_MASK        0xF00UL
+
+#define RTCC_IF_OF                      (0x1UL << 0)
+#define RTCC_IF_CC0                     (0x1UL << 1)
+#define RTCC_IF_CC1                     (0x1UL << 2)
+#define RTCC_IF_CC2                     (0x1UL << 3)
+#define _RTCC_IF_MASK                   0xFUL
+#define RTCC_IEN_OF                     RTCC_IF_OF
+#define RTCC_IEN_CC0                    RTCC_IF_CC0
+#define RTCC_IEN_CC1                    RTCC_IF_CC1
+#define RTCC_IEN_CC2                    RTCC_IF_CC2
+
+#define _RTCC_CC_CTRL_MODE_MASK         0x3UL
+#define RTCC_CC_CTRL_MODE_OFF           0x0UL
+#define RTCC_CC_CTRL_MODE_INPUTCAPTURE  0x1UL
+#define RTCC_CC_CTRL_MODE_OUTPUTCOMPARE 0x2UL
+#define RTCC_CC_COUNT                   3
+#define RTCC_EM4WUEN_EM4WU              (0x1UL << 0)
+
+//***********************************************************************************
+// RMU, the causes RMU_ResetCauseGet() reports
+//***********************************************************************************
+#define RMU_RSTCAUSE_PORST              (0x1UL << 0)
+#define RMU_RSTCAUSE_EXTRST             (0x1UL << 8)
+#define RMU_RSTCAUSE_SYSREQRST          (0x1UL << 10)
+#define RMU_RSTCAUSE_WDOGRST            (0x1UL << 11)
+#define RMU_RSTCAUSE_EM4RST             (0x1UL << 16)
+
+//***********************************************************************************
+// TIMER and WTIMER
+//***********************************************************************************
+typedef struct {
+  SIM_REG(CTRL);
+  volatile uint32_t CCV;
+  volatile uint32_t CCVP;
+  volatile uint32_t CCVB;
+} TIMER_CC_TypeDef;
+
+typedef struct {
+  SIM_REG(CTRL);
+  SIM_REG(CMD);
+  SIM_REG(STATUS);
+  SIM_REG(IF);
+  SIM_REG(IFS);
+  SIM_REG(IFC);
+  SIM_REG(IEN);
+  volatile uint32_t TOP;
+  volatile uint32_t TOPB;
+  SIM_REG(CNT);
+  volatile uint32_t ROUTEPEN;
+  volatile uint32_t ROUTELOC0;
+  TIMER_CC_TypeDef CC[4];
+} TIMER_TypeDef;
+
+#define _TIMER_CTRL_MODE_SHIFT          0
+#define _TIMER_CTRL_MODE_MASK           0x3UL
+#define TIMER_CTRL_SYNC                 (0x1UL << 3)
+#define TIMER_CTRL_OSMEN                (0x1UL << 4)
+#define TIMER_CTRL_QDM_X4               (0x1UL << 5)
+#define TIMER_CTRL_DEBUGRUN             (0x1UL << 6)
+#define TIMER_CTRL_DMACLRACT            (0x1UL << 7)
+#define _TIMER_CTRL_RISEA_SHIFT         8
+#define _TIMER_CTRL_FALLA_SHIFT         10
+#define TIMER_CTRL_X2CNT                (0x1UL << 13)
+#define _TIMER_CTRL_CLKSEL_SHIFT        16
+#define _TIMER_CTRL_PRESC_SHIFT         24
+#define _TIMER_CTRL_PRESC_MASK          0xF000000UL
+#define TIMER_CTRL_ATI                  (0x1UL << 28)
+
+#define TIMER_CMD_START                 (0x1UL << 0)
+#define TIMER_CMD_STOP                  (0x1UL << 1)
+
+#define TIMER_STATUS_RUNNING            (0x1UL << 0)
+#define TIMER_STATUS_DIR                (0x1UL << 1)
+
+#define TIMER_IF_OF                     (0x1UL << 0)
+#define TIMER_IF_UF                     (0x1UL << 1)
+#define TIMER_IF_CC0                    (0x1UL << 4)
+#define TIMER_IF_CC1                    (0x1UL << 5)
+#define TIMER_IF_CC2                    (0x1UL << 6)
+#define TIMER_IF_CC3                    (0x1UL << 7)
+#define _TIMER_IF_MASK                  0xFF7UL
+#define TIMER_IEN_OF                    TIMER_IF_OF
+#define TIMER_IEN_UF                    TIMER_IF_UF
+
+#define _TIMER_CC_CTRL_MODE_SHIFT       0
+#define _TIMER_CC_CTRL_MODE_MASK        0x3UL
+#define TIMER_CC_CTRL_OUTINV            (0x1UL << 2)
+#define TIMER_CC_CTRL_COIST             (0x1UL << 4)
+#define _TIMER_CC_CTRL_CMOA_SHIFT       8
+#define _TIMER_CC_CTRL_COFOA_SHIFT      10
+#define _TIMER_CC_CTRL_CUFOA_SHIFT      12
+
+#define TIMER_ROUTEPEN_CC0PEN           (0x1UL << 0)
+#define TIMER_ROUTEPEN_CC1PEN           (0x1UL << 1)
+#define TIMER_ROUTEPEN_CC2PEN           (0x1UL << 2)
+#define TIMER_ROUTELOC0_CC0LOC_LOC19    (19UL << 0)
+#define TIMER_ROUTELOC0_CC1LOC_LOC19    (19UL << 8)
+#define TIMER_ROUTELOC0_CC2LOC_LOC19    (19UL << 16)
+
+//***********************************************************************************
+// LDMA
+//***********************************************************************************
+typedef struct {
+  SIM_REG(CTRL);
+  SIM_REG(STATUS);
+  volatile uint32_t CHEN;
+  volatile uint32_t CHBUSY;
+  volatile uint32_t CHDONE;
+  SIM_REG(IF);
+  SIM_REG(IFS);
+  SIM_REG(IFC);
+  SIM_REG(IEN);
+} LDMA_TypeDef;
+
+#define LDMA_CH_NUM                     8
+
+//***********************************************************************************
+// GPIO
+//***********************************************************************************
+typedef struct {
+  SIM_REG(CTRL);
+  volatile uint32_t MODEL;
+  volatile uint32_t MODEH;
+  volatile uint32_t DOUT;
+  volatile uint32_t DIN;
+} GPIO_P_TypeDef;
+
+typedef struct {
+  GPIO_P_TypeDef P[12];
+} GPIO_TypeDef;
+
+//***********************************************************************************
+// Peripheral instances
+//***********************************************************************************
+extern LEUART_TypeDef   sim_leuart0;
+extern I2C_TypeDef      sim_i2c0;
+extern I2C_TypeDef      sim_i2c1;
+extern LETIMER_TypeDef  sim_letimer0;
+extern RTCC_TypeDef     sim_rtcc;
+extern TIMER_TypeDef    sim_timer0;
+extern TIMER_TypeDef    sim_timer1;
+extern TIMER_TypeDef    sim_wtimer0;
+extern LDMA_TypeDef     sim_ldma;
+extern GPIO_TypeDef     sim_gpio;
+extern DWT_Type         sim_dwt;
+extern CoreDebug_Type   sim_coredebug;
+
+#define LEUART0     (&sim_leuart0)
+#define I2C0        (&sim_i2c0)
+#define I2C1        (&sim_i2c1)
+#define LETIMER0    (&sim_letimer0)
+#define RTCC        (&sim_rtcc)
+#define TIMER0      (&sim_timer0)
+#define TIMER1      (&sim_timer1)
+#define WTIMER0     (&sim_wtimer0)
+#define LDMA        (&sim_ldma)
+#define GPIO        (&sim_gpio)
+#define DWT         (&sim_dwt)
+#define CoreDebug   (&sim_coredebug)
+
+#define LEUART_COUNT    1
+#define I2C_COUNT       2
+#define LETIMER_COUNT   1
+#define RTCC_COUNT      1
+#define EXT_IRQ_COUNT   51
+#define TIMER_COUNT     2
+#define WTIMER_COUNT    1
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * @file em_emu.h
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Host simulation stand-in for the Gecko SDK energy management unit
+ *        header.  Entering an energy mode moves virtual time forward to the
+ *        next peripheral event that can wake the core from that mode, EM4H
+ *        wakes through a reset.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_EMU_HG
+#define EM_EMU_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+typedef enum {
+  emuVScaleEM01_HighPerformance = 0,
+  emuVScaleEM01_LowPower        = 2
+} EMU_VScaleEM01_TypeDef;
+
+typedef enum {
+  emuVScaleEM23_FastWakeup      = 0,
+  emuVScaleEM23_LowPower        = 1
+} EMU_VScaleEM23_TypeDef;
+
+typedef struct {
+  bool                    em23VregFullEn;
+  EMU_VScaleEM23_TypeDef  vScaleEM23Voltage;
+} EMU_EM23Init_TypeDef;
+
+typedef enum {
+  emuEM4Shutoff                 = 0,
+  emuEM4Hibernate               = 1
+} EMU_EM4State_TypeDef;
+
+typedef enum {
+  emuPinRetentionDisable        = 0,
+  emuPinRetentionEm4Exit        = 1,
+  emuPinRetentionLatch          = 2
+} EMU_EM4PinRetention_TypeDef;
+
+typedef struct {
+  bool                          retainLfrco;
+  bool                          retainLfxo;
+  bool                          retainUlfrco;
+  EMU_EM4State_TypeDef          em4State;
+  EMU_EM4PinRetention_TypeDef   pinRetentionMode;
+} EMU_EM4Init_TypeDef;
+
+typedef struct {
+  uint32_t  powerConfig;
+  uint32_t  dcdcMode;
+  uint16_t  mVout;
+  uint16_t  em01LoadCurrent_mA;
+  uint16_t  em234LoadCurrent_uA;
+  uint16_t  maxCurrent_mA;
+} EMU_DCDCInit_TypeDef;
+
+#define EMU_EM23INIT_DEFAULT    { false, emuVScaleEM23_FastWakeup }
+#define EMU_DCDCINIT_DEFAULT    { 0, 0, 1800, 5, 10, 160 }
+#define EMU_EM4INIT_DEFAULT     { false, false, false, emuEM4Shutoff, emuPinRetentionDisable }
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void EMU_EnterEM1(void);
+void EMU_EnterEM2(bool restore);
+void EMU_EnterEM3(bool restore);
+void EMU_EnterEM4H(void) __attribute__((noreturn));
+void EMU_EM23Init(const EMU_EM23Init_TypeDef *em23Init);
+void EMU_EM4Init(const EMU_EM4Init_TypeDef *em4Init);
+bool EMU_DCDCInit(const EMU_DCDCInit_TypeDef *dcdcInit);
+void EMU_VScaleEM01(EMU_VScaleEM01_TypeDef voltage, bool wait);
+EMU_VScaleEM01_TypeDef EMU_VScaleGet(void);
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ * @file em_gpio.h
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Host simulation stand-in for the Gecko SDK GPIO header
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_GPIO_HG
+#define EM_GPIO_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+typedef enum {
+  gpioPortA = 0,
+  gpioPortB = 1,
+  gpioPortC = 2,
+  gpioPortD = 3,
+  gpioPortF = 5,
+  gpioPortI = 8,
+  gpioPortJ = 9,
+  gpioPortK = 10
+} GPIO_Port_TypeDef;
+
+typedef enum {
+  gpioModeDisabled          = 0,
+  gpioModeInput             = 1,
+  gpioModeInputPull         = 2,
+  gpioModeInputPullFilter   = 3,
+  gpioModePushPull          = 4,
+  gpioModePushPullAlternate = 5,
+  gpioModeWiredOr           = 6,
+  gpioModeWiredOrPullDown   = 7,
+  gpioModeWiredAnd          = 8,
+  gpioModeWiredAndFilter    = 9,
+  gpioModeWiredAndPullUp    = 10
+} GPIO_Mode_TypeDef;
+
+typedef enum {
+  gpioDriveStrengthWeakAlternateWeak     = 0x00100010,
+  gpioDriveStrengthStrongAlternateWeak   = 0x00100000,
+  gpioDriveStrengthWeakAlternateStrong   = 0x00000010,
+  gpioDriveStrengthStrongAlternateStrong = 0x00000000
+} GPIO_DriveStrength_TypeDef;
+
+#define GPIO_PORT_MAX       11
+#define GPIO_PIN_MAX        15
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, GPIO_Mode_TypeDef mode, unsigned int out);
+void GPIO_DriveStrengthSet(GPIO_Port_TypeDef port, GPIO_DriveStrength_TypeDef strength);
+void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PinOutToggle(GPIO_Port_TypeDef port, unsigned int pin);
+unsigned int GPIO_PinOutGet(GPIO_Port_TypeDef port, unsigned int pin);
+unsigned int GPIO_PinInGet(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PortOutSet(GPIO_Port_TypeDef port, uint32_t pins);
+void GPIO_PortOutClear(GPIO_Port_TypeDef port, uint32_t pins);
+void GPIO_PortOutSetVal(GPIO_Port_TypeDef port, uint32_t val, uint32_t mask);
+uint32_t GPIO_PortOutGet(GPIO_Port_TypeDef port);
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * @file em_i2c.h
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Host simulation stand-in for the Gecko SDK I2C header
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_I2C_HG
+#define EM_I2C_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define I2C_FREQ_STANDARD_MAX   92000
+#define I2C_FREQ_FAST_MAX       392157
+#define I2C_FREQ_FASTPLUS_MAX   987167
+#define I2C_CR_MAX              4       // Worst case clock rise/fall cycles
+
+typedef enum {
+  i2cClockHLRStandard = 0,    // Ratio 4:4
+  i2cClockHLRAsymetric = 1,   // Ratio 6:3
+  i2cClockHLRFast = 2         // Ratio 11:6
+} I2C_ClockHLR_TypeDef;
+
+typedef struct {
+  bool                  enable;
+  bool                  master;
+  uint32_t              refFreq;
+  uint32_t              freq;
+  I2C_ClockHLR_TypeDef  clhr;
+} I2C_Init_TypeDef;
+
+#define I2C_INIT_DEFAULT    { true, true, 0, I2C_FREQ_STANDARD_MAX, i2cClockHLRStandard }
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void I2C_Init(I2C_TypeDef *i2c, const I2C_Init_TypeDef *init);
+void I2C_Enable(I2C_TypeDef *i2c, bool enable);
+void I2C_BusFreqSet(I2C_TypeDef *i2c, uint32_t freqRef, uint32_t freqScl, I2C_ClockHLR_TypeDef i2cMode);
+uint32_t I2C_BusFreqGet(I2C_TypeDef *i2c);
+void I2C_IntClear(I2C_TypeDef *i2c, uint32_t flags);
+void I2C_IntEnable(I2C_TypeDef *i2c, uint32_t flags);
+void I2C_IntDisable(I2C_TypeDef *i2c, uint32_t flags);
+uint32_t I2C_IntGet(I2C_TypeDef *i2c);
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file em_ldma.h
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Host simulation stand-in for the Gecko SDK LDMA header.  Descriptors
+ *        keep the SDK bit layout, addresses are 32 bit so the simulation is
+ *        linked below 4 GB.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_LDMA_HG
+#define EM_LDMA_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+typedef enum {
+  ldmaCtrlStructTypeXfer  = 0,
+  ldmaCtrlStructTypeSync  = 1,
+  ldmaCtrlStructTypeWrite = 2
+} LDMA_CtrlStructType_t;
+
+typedef enum {
+  ldmaCtrlBlockSizeUnit1    = 0,
+  ldmaCtrlBlockSizeUnit2    = 1,
+  ldmaCtrlBlockSizeUnit3    = 2,
+  ldmaCtrlBlockSizeUnit4    = 3,
+  ldmaCtrlBlockSizeUnit6    = 4,
+  ldmaCtrlBlockSizeUnit8    = 5,
+  ldmaCtrlBlockSizeUnit16   = 7,
+  ldmaCtrlBlockSizeUnit32   = 9,
+  ldmaCtrlBlockSizeUnit64   = 10,
+  ldmaCtrlBlockSizeUnit128  = 11,
+  ldmaCtrlBlockSizeUnit256  = 12,
+  ldmaCtrlBlockSizeUnit512  = 13,
+  ldmaCtrlBlockSizeUnit1024 = 14,
+  ldmaCtrlBlockSizeAll      = 15
+} LDMA_CtrlBlockSize_t;
+
+typedef enum {
+  ldmaCtrlReqModeBlock  = 0,
+  ldmaCtrlReqModeAll    = 1
+} LDMA_CtrlReqMode_t;
+
+typedef enum {
+  ldmaCtrlSrcIncOne   = 0,
+  ldmaCtrlSrcIncTwo   = 1,
+  ldmaCtrlSrcIncFour  = 2,
+  ldmaCtrlSrcIncNone  = 3
+} LDMA_CtrlSrcInc_t;
+
+typedef enum {
+  ldmaCtrlSizeByte  = 0,
+  ldmaCtrlSizeHalf  = 1,
+  ldmaCtrlSizeWord  = 2
+} LDMA_CtrlSize_t;
+
+typedef enum {
+  ldmaCtrlDstIncOne   = 0,
+  ldmaCtrlDstIncTwo   = 1,
+  ldmaCtrlDstIncFour  = 2,
+  ldmaCtrlDstIncNone  = 3
+} LDMA_CtrlDstInc_t;
+
+typedef enum {
+  ldmaCtrlSrcAddrModeAbs  = 0,
+  ldmaCtrlSrcAddrModeRel  = 1
+} LDMA_CtrlSrcAddrMode_t;
+
+typedef enum {
+  ldmaCtrlDstAddrModeAbs  = 0,
+  ldmaCtrlDstAddrModeRel  = 1
+} LDMA_CtrlDstAddrMode_t;
+
+typedef enum {
+  ldmaLinkModeAbs = 0,
+  ldmaLinkModeRel = 1
+} LDMA_LinkMode_t;
+
+typedef enum {
+  ldmaPeripheralSignal_NONE         = 0,
+  ldmaPeripheralSignal_TIMER0_UFOF  = 0x180000,
+  ldmaPeripheralSignal_TIMER1_UFOF  = 0x190000,
+  ldmaPeripheralSignal_WTIMER0_UFOF = 0x1A0000
+} LDMA_PeripheralSignal_t;
+
+typedef union {
+  struct {
+    uint32_t  structType : 2;
+    uint32_t  reserved0  : 1;
+    uint32_t  structReq  : 1;
+    uint32_t  xferCnt    : 11;
+    uint32_t  byteSwap   : 1;
+    uint32_t  blockSize  : 4;
+    uint32_t  doneIfs    : 1;
+    uint32_t  reqMode    : 1;
+    uint32_t  decLoopCnt : 1;
+    uint32_t  ignoreSrec : 1;
+    uint32_t  srcInc     : 2;
+    uint32_t  size       : 2;
+    uint32_t  dstInc     : 2;
+    uint32_t  srcAddrMode : 1;
+    uint32_t  dstAddrMode : 1;
+    uint32_t  srcAddr;
+    uint32_t  dstAddr;
+    uint32_t  linkMode   : 1;
+    uint32_t  link       : 1;
+    int32_t   linkAddr   : 30;
+  } xfer;
+  uint32_t words[4];
+} LDMA_Descriptor_t;
+
+typedef struct {
+  uint8_t   ldmaInitCtrlNumFixed;
+  uint8_t   ldmaInitCtrlSyncPrsClrEn;
+  uint8_t   ldmaInitCtrlSyncPrsSetEn;
+  uint8_t   ldmaInitIrqPriority;
+} LDMA_Init_t;
+
+typedef struct {
+  uint32_t  ldmaReqSel;
+  uint8_t   ldmaCtrlSyncPrsClrOff;
+  uint8_t   ldmaCtrlSyncPrsClrOn;
+  uint8_t   ldmaCtrlSyncPrsSetOff;
+  uint8_t   ldmaCtrlSyncPrsSetOn;
+  bool      ldmaReqDis;
+  bool      ldmaDbgHalt;
+  uint8_t   ldmaCfgArbSlots;
+  uint8_t   ldmaCfgSrcIncSign;
+  uint8_t   ldmaCfgDstIncSign;
+  uint8_t   ldmaLoopCnt;
+} LDMA_TransferCfg_t;
+
+#define LDMA_INIT_DEFAULT   { 0, 0, 0, 3 }
+
+#define LDMA_TRANSFER_CFG_PERIPHERAL(signal)  { signal, 0, 0, 0, 0, false, false, 0, 0, 0, 0 }
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void LDMA_Init(const LDMA_Init_t *init);
+void LDMA_StartTransfer(int ch, const LDMA_TransferCfg_t *transfer, const LDMA_Descriptor_t *descriptor);
+void LDMA_StopTransfer(int ch);
+bool LDMA_TransferDone(int ch);
+void LDMA_IntClear(uint32_t flags);
+void LDMA_IntEnable(uint32_t flags);
+void LDMA_IntDisable(uint32_t flags);
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ * @file em_letimer.h
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Host simulation stand-in for the Gecko SDK LETIMER header
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_LETIMER_HG
+#define EM_LETIMER_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+typedef enum {
+  letimerRepeatFree     = 0,
+  letimerRepeatOneshot  = 1,
+  letimerRepeatBuffered = 2,
+  letimerRepeatDouble   = 3
+} LETIMER_RepeatMode_TypeDef;
+
+typedef enum {
+  letimerUFOANone   = 0,
+  letimerUFOAToggle = 1,
+  letimerUFOAPulse  = 2,
+  letimerUFOAPwm    = 3
+} LETIMER_UFOA_TypeDef;
+
+typedef struct {
+  bool                        enable;
+  bool                        debugRun;
+  bool                        comp0Top;
+  bool                        bufTop;
+  uint8_t                     out0Pol;
+  uint8_t                     out1Pol;
+  LETIMER_UFOA_TypeDef        ufoa0;
+  LETIMER_UFOA_TypeDef        ufoa1;
+  LETIMER_RepeatMode_TypeDef  repMode;
+  uint32_t                    topValue;
+} LETIMER_Init_TypeDef;
+
+#define LETIMER_INIT_DEFAULT  { true, false, false, false, 0, 0, letimerUFOANone, letimerUFOANone, letimerRepeatFree, 0 }
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void LETIMER_Init(LETIMER_TypeDef *letimer, const LETIMER_Init_TypeDef *init);
+void LETIMER_Enable(LETIMER_TypeDef *letimer, bool enable);
+void LETIMER_CompareSet(LETIMER_TypeDef *letimer, unsigned int comp, uint32_t value);
+uint32_t LETIMER_CompareGet(LETIMER_TypeDef *letimer, unsigned int comp);
+uint32_t LETIMER_CounterGet(LETIMER_TypeDef *letimer);
+void LETIMER_RepeatSet(LETIMER_TypeDef *letimer, unsigned int rep, uint32_t value);
+void LETIMER_IntClear(LETIMER_TypeDef *letimer, uint32_t flags);
+void LETIMER_IntEnable(LETIMER_TypeDef *letimer, uint32_t flags);
+void LETIMER_IntDisable(LETIMER_TypeDef *letimer, uint32_t flags);
+uint32_t LETIMER_IntGet(LETIMER_TypeDef *letimer);
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * @file em_leuart.h
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Host simulation stand-in for the Gecko SDK LEUART header
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_LEUART_HG
+#define EM_LEUART_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+typedef enum {
+  leuartDatabits8 = 0,
+  leuartDatabits9 = LEUART_CTRL_DATABITS
+} LEUART_Databits_TypeDef;
+
+typedef enum {
+  leuartDisable   = 0,
+  leuartEnableRx  = LEUART_CMD_RXEN,
+  leuartEnableTx  = LEUART_CMD_TXEN,
+  leuartEnable    = (LEUART_CMD_RXEN | LEUART_CMD_TXEN)
+} LEUART_Enable_TypeDef;
+
+typedef enum {
+  leuartNoParity   = 0,
+  leuartEvenParity = (2UL << _LEUART_CTRL_PARITY_SHIFT),
+  leuartOddParity  = (3UL << _LEUART_CTRL_PARITY_SHIFT)
+} LEUART_Parity_TypeDef;
+
+typedef enum {
+  leuartStopbits1 = 0,
+  leuartStopbits2 = LEUART_CTRL_STOPBITS
+} LEUART_Stopbits_TypeDef;
+
+typedef struct {
+  LEUART_Enable_TypeDef   enable;
+  uint32_t                refFreq;
+  uint32_t                baudrate;
+  LEUART_Databits_TypeDef databits;
+  LEUART_Parity_TypeDef   parity;
+  LEUART_Stopbits_TypeDef stopbits;
+} LEUART_Init_TypeDef;
+
+#define LEUART_INIT_DEFAULT { leuartEnable, 0, 9600, leuartDatabits8, leuartNoParity, leuartStopbits1 }
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void LEUART_Init(LEUART_TypeDef *leuart, LEUART_Init_TypeDef const *init);
+void LEUART_Enable(LEUART_TypeDef *leuart, LEUART_Enable_TypeDef enable);
+void LEUART_FreezeEnable(LEUART_TypeDef *leuart, bool enable);
+void LEUART_BaudrateSet(LEUART_TypeDef *leuart, uint32_t refFreq, uint32_t baudrate);
+uint32_t LEUART_BaudrateGet(LEUART_TypeDef *leuart);
+void LEUART_IntClear(LEUART_TypeDef *leuart, uint32_t flags);
+void LEUART_IntEnable(LEUART_TypeDef *leuart, uint32_t flags);
+void LEUART_IntDisable(LEUART_TypeDef *leuart, uint32_t flags);
+uint32_t LEUART_IntGet(LEUART_TypeDef *leuart);
+void LEUART_Tx(LEUART_TypeDef *leuart, uint8_t data);
+uint8_t LEUART_Rx(LEUART_TypeDef *leuart);
+
+#endif
@@ -0,0 +1,28 @@
+/**
+ * @file em_rmu.h
+ * @author Shambaditya Tarafder
+ * @date 12/9/2021
+ * @brief Host simulation stand-in for the Gecko SDK reset management unit
+ *        header.  The run starts from a power on reset, an EM4H wake-up adds
+ *        its own cause.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_RMU_HG
+#define EM_RMU_HG
+
+/* System include statements */
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+uint32_t RMU_ResetCauseGet(void);
+void RMU_ResetCauseClear(void);
+
+#endif
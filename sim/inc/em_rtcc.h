@@ -0,0 +1,131 @@
+/**
+ * @file em_rtcc.h
+ * @author Shambaditya Tarafder
+ * @date 12/6/2021
+ * @brief Host simulation stand-in for the Gecko SDK RTCC header
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_RTCC_HG
+#define EM_RTCC_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+typedef enum {
+  rtccCntPresc_1     = 0,
+  rtccCntPresc_2     = 1,
+  rtccCntPresc_4     = 2,
+  rtccCntPresc_8     = 3,
+  rtccCntPresc_16    = 4,
+  rtccCntPresc_32    = 5,
+  rtccCntPresc_64    = 6,
+  rtccCntPresc_128   = 7,
+  rtccCntPresc_256   = 8,
+  rtccCntPresc_512   = 9,
+  rtccCntPresc_1024  = 10,
+  rtccCntPresc_2048  = 11,
+  rtccCntPresc_4096  = 12,
+  rtccCntPresc_8192  = 13,
+  rtccCntPresc_16384 = 14,
+  rtccCntPresc_32768 = 15
+} RTCC_CntPresc_TypeDef;
+
+typedef enum {
+  rtccCntTickPresc = 0,
+  rtccCntTickCCV0Match = 1
+} RTCC_PrescMode_TypeDef;
+
+typedef enum {
+  rtccCntModeNormal = 0,
+  rtccCntModeCalendar = 1
+} RTCC_CntMode_TypeDef;
+
+typedef struct {
+  bool                    enable;
+  bool                    debugRun;
+  bool                    precntWrapOnCCV0;
+  bool                    cntWrapOnCCV1;
+  RTCC_CntPresc_TypeDef   presc;
+  RTCC_PrescMode_TypeDef  prescMode;
+  bool                    enaOSCFailDetect;
+  RTCC_CntMode_TypeDef    cntMode;
+  bool                    disLeapYearCorr;
+} RTCC_Init_TypeDef;
+
+typedef enum {
+  rtccCapComChModeOff     = 0,
+  rtccCapComChModeCapture = 1,
+  rtccCapComChModeCompare = 2
+} RTCC_CapComChMode_TypeDef;
+
+typedef enum {
+  rtccCompMatchOutActionPulse  = 0,
+  rtccCompMatchOutActionToggle = 1,
+  rtccCompMatchOutActionClear  = 2,
+  rtccCompMatchOutActionSet    = 3
+} RTCC_CompMatchOutAction_TypeDef;
+
+typedef enum {
+  rtccPRSCh0 = 0
+} RTCC_PRSSel_TypeDef;
+
+typedef enum {
+  rtccInEdgeRising  = 0,
+  rtccInEdgeFalling = 1,
+  rtccInEdgeBoth    = 2,
+  rtccInEdgeNone    = 3
+} RTCC_InEdgeSel_TypeDef;
+
+typedef enum {
+  rtccCompBaseCnt    = 0,
+  rtccCompBasePreCnt = 1
+} RTCC_CompBase_TypeDef;
+
+typedef enum {
+  rtccDayCompareModeMonth = 0,
+  rtccDayCompareModeWeek  = 1
+} RTCC_DayCompareMode_TypeDef;
+
+typedef struct {
+  RTCC_CapComChMode_TypeDef       chMode;
+  RTCC_CompMatchOutAction_TypeDef compMatchOutAction;
+  RTCC_PRSSel_TypeDef             prsSel;
+  RTCC_InEdgeSel_TypeDef          inputEdgeSel;
+  RTCC_CompBase_TypeDef           compBase;
+  uint8_t                         compMask;
+  RTCC_DayCompareMode_TypeDef     dayCompMode;
+} RTCC_CCChConf_TypeDef;
+
+#define RTCC_CH_INIT_COMPARE_DEFAULT  { rtccCapComChModeCompare, rtccCompMatchOutActionPulse, rtccPRSCh0, \
+                                        rtccInEdgeNone, rtccCompBaseCnt, 0, rtccDayCompareModeMonth }
+
+#define RTCC_INIT_DEFAULT   { true, false, false, false, rtccCntPresc_32, rtccCntTickPresc, false, rtccCntModeNormal, false }
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void RTCC_Init(const RTCC_Init_TypeDef *init);
+void RTCC_Enable(bool enable);
+uint32_t RTCC_CounterGet(void);
+void RTCC_CounterSet(uint32_t value);
+void RTCC_IntClear(uint32_t flags);
+void RTCC_IntEnable(uint32_t flags);
+void RTCC_IntDisable(uint32_t flags);
+uint32_t RTCC_IntGet(void);
+void RTCC_ChannelInit(int ch, const RTCC_CCChConf_TypeDef *confPtr);
+void RTCC_ChannelCCVSet(int ch, uint32_t value);
+uint32_t RTCC_ChannelCCVGet(int ch);
+void RTCC_EM4WakeupEnable(bool enable);
+
+#endif
@@ -0,0 +1,130 @@
+/**
+ * @file em_timer.h
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Host simulation stand-in for the Gecko SDK TIMER header, covers the
+ *        16 bit TIMERs and the 32 bit WTIMER
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_TIMER_HG
+#define EM_TIMER_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+typedef enum {
+  timerModeUp     = 0,
+  timerModeDown   = 1,
+  timerModeUpDown = 2,
+  timerModeQDec   = 3
+} TIMER_Mode_TypeDef;
+
+typedef enum {
+  timerPrescale1    = 0,
+  timerPrescale2    = 1,
+  timerPrescale4    = 2,
+  timerPrescale8    = 3,
+  timerPrescale16   = 4,
+  timerPrescale32   = 5,
+  timerPrescale64   = 6,
+  timerPrescale128  = 7,
+  timerPrescale256  = 8,
+  timerPrescale512  = 9,
+  timerPrescale1024 = 10
+} TIMER_Prescale_TypeDef;
+
+typedef enum {
+  timerClkSelHFPerClk = 0,
+  timerClkSelCC1      = 1,
+  timerClkSelCascade  = 2
+} TIMER_ClkSel_TypeDef;
+
+typedef enum {
+  timerInputActionNone    = 0,
+  timerInputActionStart   = 1,
+  timerInputActionStop    = 2,
+  timerInputActionReloadStart = 3
+} TIMER_InputAction_TypeDef;
+
+typedef enum {
+  timerCCModeOff      = 0,
+  timerCCModeCapture  = 1,
+  timerCCModeCompare  = 2,
+  timerCCModePWM      = 3
+} TIMER_CCMode_TypeDef;
+
+typedef enum {
+  timerOutputActionNone   = 0,
+  timerOutputActionToggle = 1,
+  timerOutputActionClear  = 2,
+  timerOutputActionSet    = 3
+} TIMER_OutputAction_TypeDef;
+
+typedef struct {
+  bool                      enable;
+  bool                      debugRun;
+  TIMER_Prescale_TypeDef    prescale;
+  TIMER_ClkSel_TypeDef      clkSel;
+  bool                      count2x;
+  bool                      ati;
+  TIMER_InputAction_TypeDef fallAction;
+  TIMER_InputAction_TypeDef riseAction;
+  TIMER_Mode_TypeDef        mode;
+  bool                      dmaClrAct;
+  bool                      quadModeX4;
+  bool                      oneShot;
+  bool                      sync;
+} TIMER_Init_TypeDef;
+
+typedef struct {
+  uint32_t                    eventCtrl;
+  uint32_t                    edge;
+  uint32_t                    prsSel;
+  TIMER_OutputAction_TypeDef  cufoa;
+  TIMER_OutputAction_TypeDef  cofoa;
+  TIMER_OutputAction_TypeDef  cmoa;
+  TIMER_CCMode_TypeDef        mode;
+  bool                        filter;
+  bool                        prsInput;
+  bool                        coist;
+  bool                        outInvert;
+} TIMER_InitCC_TypeDef;
+
+#define TIMER_INIT_DEFAULT    { true, false, timerPrescale1, timerClkSelHFPerClk, false, false, \
+                                timerInputActionNone, timerInputActionNone, timerModeUp,      \
+                                false, false, false, false }
+
+#define TIMER_INITCC_DEFAULT  { 0, 0, 0, timerOutputActionNone, timerOutputActionNone,      \
+                                timerOutputActionNone, timerCCModeOff, false, false, false, false }
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void TIMER_Init(TIMER_TypeDef *timer, const TIMER_Init_TypeDef *init);
+void TIMER_InitCC(TIMER_TypeDef *timer, unsigned int ch, const TIMER_InitCC_TypeDef *init);
+void TIMER_Enable(TIMER_TypeDef *timer, bool enable);
+void TIMER_TopSet(TIMER_TypeDef *timer, uint32_t val);
+void TIMER_TopBufSet(TIMER_TypeDef *timer, uint32_t val);
+uint32_t TIMER_TopGet(TIMER_TypeDef *timer);
+void TIMER_CounterSet(TIMER_TypeDef *timer, uint32_t val);
+uint32_t TIMER_CounterGet(TIMER_TypeDef *timer);
+void TIMER_CompareSet(TIMER_TypeDef *timer, unsigned int ch, uint32_t val);
+void TIMER_CompareBufSet(TIMER_TypeDef *timer, unsigned int ch, uint32_t val);
+void TIMER_IntClear(TIMER_TypeDef *timer, uint32_t flags);
+void TIMER_IntEnable(TIMER_TypeDef *timer, uint32_t flags);
+void TIMER_IntDisable(TIMER_TypeDef *timer, uint32_t flags);
+uint32_t TIMER_IntGet(TIMER_TypeDef *timer);
+uint32_t TIMER_MaxCount(TIMER_TypeDef *timer);
+
+#endif
@@ -0,0 +1,178 @@
+/**
+ * @file sim.h
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Host simulation of the firmware.  An event driven virtual clock in
+ *        picoseconds drives register level models of the peripherals, which
+ *        raise interrupts into the unmodified drivers in src/.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef SIM_HG
+#define SIM_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_cmu.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_PS_PER_S        1000000000000ULL
+#define SIM_PS_PER_MS       1000000000ULL
+#define SIM_PS_PER_US       1000000ULL
+#define SIM_NEVER           UINT64_MAX
+
+#define SIM_ACCESS_CYCLES   4       // Core cycles charged per peripheral register access
+#define SIM_IRQ_CYCLES      12      // Core cycles for exception entry, and again for exit
+#define SIM_LF_SYNC_TICKS   3       // LF clock ticks a write to a synchronized register takes
+#define SIM_IRQ_STORM       100000  // Back to back entries of one IRQ treated as a hang
+#define SIM_MAX_EVENTS      16      // Pending sim_event_at() callbacks
+#define SIM_DEFAULT_SECONDS 10      // Virtual run time when -t is not given
+
+#define SIM_EXIT_ASSERT     2       // An EFM_ASSERT failed
+#define SIM_EXIT_DEADLOCK   3       // Asleep with no wake-up source, or an IRQ storm
+
+#define SIM_NO_IRQ          (-1)
+
+// Signals of sim_vcd_change(), the GPIO pins follow as port * 16 + pin
+#define SIM_VCD_EM              0
+#define SIM_VCD_LETIMER0_OUT0   1
+#define SIM_VCD_LETIMER0_OUT1   2
+#define SIM_VCD_LEUART0_TX      3
+#define SIM_VCD_LEUART0_RX      4
+#define SIM_VCD_I2C0_SCL        5
+#define SIM_VCD_I2C0_SDA        6
+#define SIM_VCD_I2C1_SCL        7
+#define SIM_VCD_I2C1_SDA        8
+#define SIM_VCD_GPIO            9
+#define SIM_VCD_GPIO_PINS       ((GPIO_PORT_MAX + 1) * (GPIO_PIN_MAX + 1))
+#define SIM_VCD_SIGNALS         (SIM_VCD_GPIO + SIM_VCD_GPIO_PINS)
+
+// MCU state that EM4H powers down, sim_run() puts its power on image back at
+// the wake-up reset.  The Makefile renames the firmware's RAM into it.
+#define SIM_EM4_RESET       __attribute__((section("sim_em4_reset")))
+
+typedef struct {
+  const char          *name;
+  void                *ctx;
+  int                 irqn;         // SIM_NO_IRQ if the model has no interrupt line
+  volatile uint32_t   *irq_if;
+  volatile uint32_t   *irq_ien;
+  void                (*sync)(void *ctx, uint64_t now);   // Take register writes, run up to now
+  uint64_t            (*next_event)(void *ctx);           // Next time the model changes state
+  bool                (*rx_valid)(void *ctx);             // NULL when there is no RXDATA
+  void                (*rx_consume)(void *ctx);
+} SIM_MODEL;
+
+typedef void (*SIM_EVENT_FN)(void *arg);
+
+typedef void (*SIM_LEUART_TX_FN)(uint8_t byte);
+
+typedef double (*SIM_ENERGY_FN)(void *ctx);     // Current of a load in its present state, uA
+typedef uint32_t (*SIM_ENERGY_OWNER_FN)(void);  // Code the core runs right now
+typedef void (*SIM_ENERGY_NAME_FN)(uint32_t owner, char *name, uint32_t size);
+
+typedef struct {
+  uint64_t  connect_at;             // Virtual time a central starts to look for the module
+  uint64_t  disconnect_at;          // Virtual time it drops the link, SIM_NEVER to keep it
+  bool      pty;                    // Carry the central's data over a pseudo-terminal
+  uint64_t  write_at;               // Virtual time the scripted central writes, SIM_NEVER for never
+  const char *write_text;           // What it writes
+  uint64_t  write_every;            // Period it writes it again at, 0 for once
+  uint32_t  baud;                   // UART baud rate at power up, 0 for the HM10 default
+} SIM_HM10_OPEN;
+
+typedef struct {
+  uint8_t   address;                // 7 bit slave address
+  bool      (*start)(bool read);    // Addressed, return true to ACK
+  bool      (*write)(uint8_t data); // Byte from the master, return true to ACK
+  uint8_t   (*read)(void);          // Byte to the master
+  void      (*stop)(void);
+  uint64_t  (*stretch)(void);       // SCL held low after a byte in ps, NULL for never
+} SIM_I2C_SLAVE;
+
+typedef struct {
+  uint32_t  nack_every;             // NACK every nth address phase, 0 for never
+  uint64_t  stretch_ps;             // SCL held low after every byte
+  uint32_t  light;                  // Counts of a measurement at HW_GAIN 0
+} SIM_SI1133_OPEN;
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+extern const SIM_MODEL sim_letimer0_model;
+extern const SIM_MODEL sim_rtcc_model;
+extern const SIM_MODEL sim_leuart0_model;
+extern const SIM_MODEL sim_i2c0_model;
+extern const SIM_MODEL sim_i2c1_model;
+extern const SIM_MODEL sim_timer0_model;
+extern const SIM_MODEL sim_timer1_model;
+extern const SIM_MODEL sim_wtimer0_model;
+extern const SIM_MODEL sim_ldma_model;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+// Virtual clock, sim_clock.c
+void sim_init(uint64_t run_ps, bool quiet);
+void sim_run(int (*firmware)(void));
+void sim_em4h(void) __attribute__((noreturn));
+uint64_t sim_now(void);
+uint64_t sim_cycles_to_ps(uint32_t cycles);
+uint32_t sim_energy_mode(void);
+void sim_sleep(uint32_t em);
+bool sim_spin_skip(void);
+void sim_watchdog_open(void);
+void sim_event_at(uint64_t when, SIM_EVENT_FN fn, void *arg);
+void sim_log(const char *format, ...);
+void sim_finish(int code) __attribute__((noreturn));
+
+// Clock tree, sim_cmu.c
+bool sim_cmu_running(CMU_Clock_TypeDef clock);
+bool sim_cmu_osc_on(CMU_Osc_TypeDef osc);
+bool sim_emu_em4_retains(CMU_Osc_TypeDef osc);
+
+// EM4H wake-up source and the replay's time line, sim_rtcc.c
+bool sim_rtcc_em4_wakeup(void);
+uint64_t sim_rtcc_time(uint32_t count);
+
+// Flags from a replay instead of the count, sim_letimer.c
+void sim_letimer_replay(void);
+void sim_letimer_raise(uint32_t flags);
+
+// Waveforms, sim_vcd.c
+void sim_vcd_open(const char *path);
+void sim_vcd_change(uint32_t signal, uint64_t when, uint32_t value);
+void sim_vcd_reset(uint64_t when);
+
+// Energy model, sim_energy.c
+void sim_energy_open(double mah);
+uint32_t sim_energy_load(const char *subsystem, const char *name, SIM_ENERGY_FN current, void *ctx);
+void sim_energy_charge(uint32_t load, double uc);
+void sim_energy_run(uint64_t ps);
+void sim_energy_owners(uint32_t count, SIM_ENERGY_OWNER_FN owner, SIM_ENERGY_NAME_FN name);
+
+// LDMA requests from the timers, sim_ldma.c
+bool sim_ldma_request(uint32_t signal);
+uint32_t sim_ldma_served(int ch);
+
+// Devices on the LEUART and I2C buses
+void sim_leuart_attach(LEUART_TypeDef *leuart, SIM_LEUART_TX_FN tx);
+void sim_leuart_send(LEUART_TypeDef *leuart, uint8_t byte);
+void sim_i2c_attach(I2C_TypeDef *i2c, const SIM_I2C_SLAVE *slave);
+void sim_hm10_open(LEUART_TypeDef *leuart, const SIM_HM10_OPEN *open);
+void sim_si1133_open(I2C_TypeDef *i2c, const SIM_SI1133_OPEN *open);
+void sim_si1133_nack(uint32_t every);
+void sim_replay_open(const char *path, LEUART_TypeDef *leuart, I2C_TypeDef *i2c);
+
+#endif
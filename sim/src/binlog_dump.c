@@ -0,0 +1,316 @@
+/**
+ * @file binlog_dump.c
+ * @author Shambaditya Tarafder
+ * @date 12/9/2021
+ * @brief Host side of the firmware's binary log.  Reads the lines
+ *        binlog_line() makes and expands every record with its format string,
+ *        taken from the binlog section of the ELF the records came from.
+ *
+ *        Usage: binlog_dump [-s] [-r hz] elf [capture]
+ *
+ *        The capture is what the central received, or with -s the output of
+ *        firmware_sim, see capture.c.  The ELF is the ARM image, or
+ *        firmware_sim for a simulated run.  -r is the RTCC rate of the time
+ *        stamps, 1000 by default.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <elf.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "capture.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define DUMP_LINE_MAX       CAPTURE_LINE_MAX
+#define DUMP_SPEC_MAX       32
+#define DUMP_RTCC_HZ        1000
+#define DUMP_LINE_MARK      'L'
+#define DUMP_HEADER         2
+#define DUMP_SEQ_MASK       0xFFF
+#define DUMP_HEX_DIGITS     8
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static char     *formats;           // Contents of the binlog section
+static uint64_t  formats_size;
+static double    rtcc_hz = DUMP_RTCC_HZ;
+static uint32_t  seq_next;
+static bool      seq_known;
+static uint32_t  lost;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static bool dump_elf(const char *path);
+static void dump_line(const char *line);
+static void dump_record(const uint32_t *words, uint32_t count);
+static void dump_format(const char *fmt, const uint32_t *args, uint32_t count);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(int argc, char **argv){
+  bool sim = false;
+  FILE *file = stdin;
+  CAPTURE capture;
+  char line[DUMP_LINE_MAX];
+  int opt;
+
+  while((opt = getopt(argc, argv, "sr:")) != -1){
+      switch(opt){
+        case 's':
+          sim = true;
+          break;
+        case 'r':
+          rtcc_hz = atof(optarg);
+          break;
+        default:
+          optind = argc + 1;
+          break;
+      }
+  }
+  if((optind >= argc) || (argc - optind > 2) || (rtcc_hz <= 0)){
+      fprintf(stderr, "usage: %s [-s] [-r hz] elf [capture]\n", argv[0]);
+      return EXIT_FAILURE;
+  }
+  if(!dump_elf(argv[optind])){
+      return EXIT_FAILURE;
+  }
+  if(optind + 1 < argc){
+      file = fopen(argv[optind + 1], "r");
+      if(!file){
+          perror(argv[optind + 1]);
+          return EXIT_FAILURE;
+      }
+  }
+
+  capture_open(&capture, file, sim);
+  while(capture_line(&capture, line, sizeof(line))){
+      dump_line(line);
+  }
+  if(lost){
+      printf("%lu records lost\n", (unsigned long)lost);
+  }
+  if(file != stdin){
+      fclose(file);
+  }
+  free(formats);
+  return EXIT_SUCCESS;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Loads the binlog section of a 32 or 64 bit ELF
+ *
+ * @details
+ *   The linker script names the section ".binlog" on the target, the host
+ *   build keeps the "binlog" of the source.  A record's ID is the offset of
+ *   its format string in either.
+ *
+ ******************************************************************************/
+
+static bool dump_elf(const char *path){
+  FILE *elf = fopen(path, "rb");
+  unsigned char *image = NULL;
+  long size;
+  bool found = false;
+
+  if(!elf){
+      perror(path);
+      return false;
+  }
+  fseek(elf, 0, SEEK_END);
+  size = ftell(elf);
+  rewind(elf);
+  image = malloc(size > 0 ? (size_t)size : 1);
+  if(!image || (size < EI_NIDENT) || (fread(image, 1, (size_t)size, elf) != (size_t)size)
+     || memcmp(image, ELFMAG, SELFMAG)){
+      fprintf(stderr, "%s: not an ELF file\n", path);
+      fclose(elf);
+      free(image);
+      return false;
+  }
+  fclose(elf);
+
+  for(int pass = 0; pass < 2 && !found; pass++){
+      uint64_t shoff, names_off = 0, offset = 0, length = 0;
+      uint32_t shnum, shstrndx, name = 0;
+      const char *wanted = pass ? "binlog" : ".binlog";
+      bool is64 = image[EI_CLASS] == ELFCLASS64;
+
+      if(is64){
+          const Elf64_Ehdr *eh = (const Elf64_Ehdr *)image;
+          shoff = eh->e_shoff; shnum = eh->e_shnum; shstrndx = eh->e_shstrndx;
+          names_off = ((const Elf64_Shdr *)(image + shoff))[shstrndx].sh_offset;
+      } else {
+          const Elf32_Ehdr *eh = (const Elf32_Ehdr *)image;
+          shoff = eh->e_shoff; shnum = eh->e_shnum; shstrndx = eh->e_shstrndx;
+          names_off = ((const Elf32_Shdr *)(image + shoff))[shstrndx].sh_offset;
+      }
+      for(uint32_t i = 0; i < shnum; i++){
+          if(is64){
+              const Elf64_Shdr *sh = (const Elf64_Shdr *)(image + shoff) + i;
+              name = sh->sh_name; offset = sh->sh_offset; length = sh->sh_size;
+          } else {
+              const Elf32_Shdr *sh = (const Elf32_Shdr *)(image + shoff) + i;
+              name = sh->sh_name; offset = sh->sh_offset; length = sh->sh_size;
+          }
+          if(!strcmp((const char *)image + names_off + name, wanted)){
+              found = true;
+              break;
+          }
+      }
+      if(found){
+          formats = malloc(length + 1);
+          memcpy(formats, image + offset, length);
+          formats[length] = '\0';
+          formats_size = length;
+      }
+  }
+  free(image);
+  if(!found){
+      fprintf(stderr, "%s: no binlog section\n", path);
+  }
+  return found;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Expands one "L<hex>" line, anything else the central received is skipped
+ *
+ ******************************************************************************/
+
+static void dump_line(const char *line){
+  uint32_t words[DUMP_LINE_MAX / DUMP_HEX_DIGITS];
+  uint32_t count = 0;
+  size_t len;
+
+  if(line[0] != DUMP_LINE_MARK){
+      return;
+  }
+  line++;
+  len = strlen(line);
+  if(!len || (len % DUMP_HEX_DIGITS) || (strspn(line, "0123456789abcdef") != len)){
+      return;
+  }
+  for(size_t i = 0; i < len; i += DUMP_HEX_DIGITS){
+      char word[DUMP_HEX_DIGITS + 1];
+      memcpy(word, line + i, DUMP_HEX_DIGITS);
+      word[DUMP_HEX_DIGITS] = '\0';
+      words[count++] = (uint32_t)strtoul(word, NULL, 16);
+  }
+  for(uint32_t i = 0; i < count;){
+      uint32_t record = DUMP_HEADER + ((words[i] >> 12) & 0xF);
+      if(i + record > count){
+          printf("truncated record\n");
+          return;
+      }
+      dump_record(words + i, record);
+      i += record;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Prints one record as "[seconds] message", after a note of the records
+ *   the ring dropped ahead of it
+ *
+ ******************************************************************************/
+
+static void dump_record(const uint32_t *words, uint32_t count){
+  uint32_t id = words[0] >> 16;
+  uint32_t seq = words[0] & DUMP_SEQ_MASK;
+
+  if(seq_known && (seq != seq_next)){
+      uint32_t gap = (seq - seq_next) & DUMP_SEQ_MASK;
+      printf("--- %lu records lost\n", (unsigned long)gap);
+      lost += gap;
+  }
+  seq_next = (seq + 1) & DUMP_SEQ_MASK;
+  seq_known = true;
+
+  printf("[%10.3f] ", words[1] / rtcc_hz);
+  if(id >= formats_size){
+      printf("unknown format %lu\n", (unsigned long)id);
+      return;
+  }
+  dump_format(formats + id, words + DUMP_HEADER, count - DUMP_HEADER);
+  putchar('\n');
+}
+
+/***************************************************************************//**
+ * @brief
+ *   printf() of a firmware format with its 32 bit arguments
+ *
+ * @details
+ *   Each conversion takes one word.  Length modifiers are dropped, the
+ *   words are int32_t for %d and %i, the bits of a float for %f, %e, %g and
+ *   %a, uint32_t for the rest.  Widths and precisions are kept, * is not
+ *   supported.
+ *
+ ******************************************************************************/
+
+static void dump_format(const char *fmt, const uint32_t *args, uint32_t count){
+  uint32_t arg = 0;
+
+  while(*fmt){
+      char spec[DUMP_SPEC_MAX];
+      size_t len = 0;
+      char conv;
+
+      if(*fmt != '%'){
+          putchar(*fmt++);
+          continue;
+      }
+      if(fmt[1] == '%'){
+          putchar('%');
+          fmt += 2;
+          continue;
+      }
+      spec[len++] = *fmt++;
+      while(*fmt && strchr("-+ #0123456789.hljztLq", *fmt)){
+          if(!strchr("hljztLq", *fmt) && (len < DUMP_SPEC_MAX - 3)){
+              spec[len++] = *fmt;
+          }
+          fmt++;
+      }
+      conv = *fmt;
+      if(!conv){
+          break;
+      }
+      fmt++;
+      if(arg >= count){
+          printf("<missing>");
+          continue;
+      }
+      spec[len++] = conv;
+      spec[len] = '\0';
+      if(strchr("fFeEgGaA", conv)){
+          union {
+            uint32_t  u;
+            float     f;
+          } bits = { args[arg] };
+          printf(spec, (double)bits.f);
+      } else if(strchr("di", conv)){
+          printf(spec, (int)(int32_t)args[arg]);
+      } else if(strchr("uxXoc", conv)){
+          printf(spec, (unsigned int)args[arg]);
+      } else {
+          printf("<%%%c>", conv);
+      }
+      arg++;
+  }
+}
@@ -0,0 +1,106 @@
+/**
+ * @file capture.c
+ * @author Shambaditya Tarafder
+ * @date 12/9/2021
+ * @brief Lines a BLE central received, shared by binlog_dump, trace_export
+ *        and the replay.  firmware_sim logs each HM10 notification, or each
+ *        line a replay sends, with C escapes, they are undone and the
+ *        pieces joined again.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdlib.h>
+#include <string.h>
+#include "capture.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define CAPTURE_SIM_TAG     "-> central"     // "HM10 -> central" and "replay -> central"
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static size_t capture_sim_payload(const char *text, char *payload, size_t size);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+void capture_open(CAPTURE *capture, FILE *file, bool sim){
+  capture->file = file;
+  capture->sim = sim;
+  capture->used = 0;
+  capture->next = 0;
+  capture->line_len = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Next line the central received, without its '\n'
+ *
+ * @return
+ *   false at the end of the capture, a last line with no '\n' is dropped
+ *
+ ******************************************************************************/
+
+bool capture_line(CAPTURE *capture, char *line, size_t size){
+  char text[CAPTURE_LINE_MAX];
+
+  for(;;){
+      while(capture->next < capture->used){
+          char c = capture->data[capture->next++];
+          if(c == '\n'){
+              size_t len = (capture->line_len < size - 1) ? capture->line_len : size - 1;
+              memcpy(line, capture->line, len);
+              line[len] = '\0';
+              capture->line_len = 0;
+              return true;
+          }
+          if(capture->line_len < CAPTURE_LINE_MAX - 1){
+              capture->line[capture->line_len++] = c;
+          }
+      }
+      if(!fgets(text, sizeof(text), capture->file)){
+          return false;
+      }
+      capture->next = 0;
+      if(capture->sim){
+          capture->used = capture_sim_payload(text, capture->data, sizeof(capture->data));
+      } else {
+          capture->used = strlen(text);
+          memcpy(capture->data, text, capture->used);
+      }
+  }
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Payload of a "-> central" line of firmware_sim with its \xHH
+ *   escapes undone, 0 bytes for the other lines
+ *
+ ******************************************************************************/
+
+static size_t capture_sim_payload(const char *text, char *payload, size_t size){
+  size_t len = 0;
+
+  text = strstr(text, CAPTURE_SIM_TAG);
+  if(!text || !(text = strchr(text, '"'))){
+      return 0;
+  }
+  for(text++; *text && (*text != '"') && (len < size); text++){
+      if((text[0] == '\\') && (text[1] == 'x') && text[2] && text[3]){
+          char hex[3] = { text[2], text[3], '\0' };
+          payload[len++] = (char)strtoul(hex, NULL, 16);
+          text += 3;
+      } else {
+          payload[len++] = *text;
+      }
+  }
+  return len;
+}
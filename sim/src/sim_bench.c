@@ -0,0 +1,107 @@
+/**
+ * @file sim_bench.c
+ * @author Shambaditya Tarafder
+ * @date 12/8/2021
+ * @brief Entry point of the host benchmarks.  Sets up the simulation and the
+ *        firmware like sim_main.c, then runs the firmware's benchmark kernels
+ *        with the host's clock next to the modelled cycle counter.
+ *
+ *        Usage: firmware_bench [-o file]
+ *
+ *        Modelled cycles only count register accesses and interrupt entry, C
+ *        code costs nothing in the model, so the formatting kernels are
+ *        judged on host_ns and the driver kernels on cycles.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim.h"
+#include "app.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_BENCH_SECONDS   600     // Virtual time limit, the kernels need a few s
+#define SIM_LIGHT_DEFAULT   1000
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static FILE *results;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static bool sim_bench_line(char *line);
+static uint64_t sim_bench_ns(void);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(int argc, char **argv){
+  SIM_HM10_OPEN hm10 = { 0, SIM_NEVER, false, SIM_NEVER, NULL, 0, 0 };
+  SIM_SI1133_OPEN si1133 = { 0, 0, SIM_LIGHT_DEFAULT };
+  int opt;
+
+  results = stdout;
+  while((opt = getopt(argc, argv, "o:")) != -1){
+      switch(opt){
+        case 'o':
+          results = fopen(optarg, "w");
+          if(!results){
+              perror(optarg);
+              return EXIT_FAILURE;
+          }
+          break;
+        default:
+          fprintf(stderr, "usage: %s [-o file]\n", argv[0]);
+          return EXIT_FAILURE;
+      }
+  }
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  sim_init((uint64_t)SIM_BENCH_SECONDS * SIM_PS_PER_S, true);
+  sim_energy_open(0);
+  sim_hm10_open(LEUART0, &hm10);
+  sim_si1133_open(I2C1, &si1133);
+  sim_watchdog_open();
+
+  // The clock main() starts the app with
+  CMU_HFRCOBandSet(MCU_HFXO_FREQ);
+  CMU_OscillatorEnable(cmuOsc_HFRCO, true, true);
+  CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFRCO);
+  app_peripheral_setup();
+  remove_scheduled_event(BOOT_UP_CB);
+  // The LEUART self test runs as a task, the main loop finishes it
+  while(leuart_test_busy()){
+      if(!scheduler_dispatch()){
+          enter_sleep();
+      }
+  }
+
+  benchmark_run(sim_bench_line, sim_bench_ns);
+  if(results != stdout){
+      fclose(results);
+  }
+  sim_finish(EXIT_SUCCESS);
+  return EXIT_SUCCESS;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static bool sim_bench_line(char *line){
+  return fputs(line, results) >= 0;
+}
+
+static uint64_t sim_bench_ns(void){
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
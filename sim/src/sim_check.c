@@ -0,0 +1,440 @@
+/**
+ * @file sim_check.c
+ * @author Shambaditya Tarafder
+ * @date 12/9/2021
+ * @brief Entry point of the host checks.  Sets up the simulation and the
+ *        firmware like sim_bench.c, then drives the drivers through sequences
+ *        the app's own run does not reach and checks what they leave behind.
+ *
+ *        Usage: firmware_check
+ *
+ *        Each check prints a line, a failed one stops the run with
+ *        EXIT_FAILURE, an EFM_ASSERT on the way with SIM_EXIT_ASSERT.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "app.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_CHECK_SECONDS   600     // Virtual time limit, the setup needs a few s
+#define SIM_LIGHT_DEFAULT   1000
+#define SIM_CHECK_LONG      (POOL_LARGE_SIZE + 20)
+#define SIM_CHECK_PERIODS   3       // Effect periods led_step runs
+#define SIM_CHECK_NACKS     2       // Addresses of a read i2c_nack has NACKed
+
+#define SIM_CHECK(expr)     sim_check_that((expr), #expr, __LINE__)
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+typedef struct {
+  const char   *name;
+  void        (*run)(void);
+} SIM_CHECK_CASE;
+
+static const char *check_name;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static void sim_check_that(bool ok, const char *expr, int line);
+static void sim_check_rgb_hf_scale(void);
+static void sim_check_rgb_dark(void);
+static void sim_check_leuart_drop(void);
+static void sim_check_leuart_freeze(void);
+static void sim_check_pool_empty(void);
+static void sim_check_sched_idle(void);
+static void sim_check_i2c_hf_defer(void);
+static void sim_check_i2c_nack(void);
+static void sim_check_led_owner(void);
+static void sim_check_led_step(void);
+static void sim_check_tx_wait(void);
+static void sim_check_i2c_wait(void);
+
+static const SIM_CHECK_CASE checks[] = {
+  { "rgb_hf_scale", sim_check_rgb_hf_scale },
+  { "rgb_dark",     sim_check_rgb_dark },
+  { "leuart_drop",  sim_check_leuart_drop },
+  { "leuart_freeze", sim_check_leuart_freeze },
+  { "pool_empty",   sim_check_pool_empty },
+  { "sched_idle",   sim_check_sched_idle },
+  { "i2c_hf_defer", sim_check_i2c_hf_defer },
+  { "i2c_nack",     sim_check_i2c_nack },
+  { "led_owner",    sim_check_led_owner },
+  { "led_step",     sim_check_led_step },
+};
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(void){
+  SIM_HM10_OPEN hm10 = { 0, SIM_NEVER, false, SIM_NEVER, NULL, 0, 0 };
+  SIM_SI1133_OPEN si1133 = { 0, 0, SIM_LIGHT_DEFAULT };
+
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  sim_init((uint64_t)SIM_CHECK_SECONDS * SIM_PS_PER_S, true);
+  sim_energy_open(0);
+  sim_hm10_open(LEUART0, &hm10);
+  sim_si1133_open(I2C1, &si1133);
+  sim_watchdog_open();
+
+  // The clock main() starts the app with
+  CMU_HFRCOBandSet(MCU_HFXO_FREQ);
+  CMU_OscillatorEnable(cmuOsc_HFRCO, true, true);
+  CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFRCO);
+  app_peripheral_setup();
+  remove_scheduled_event(BOOT_UP_CB);
+  while(leuart_test_busy()){
+      if(!scheduler_dispatch()){
+          enter_sleep();
+      }
+  }
+
+  for(uint32_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++){
+      check_name = checks[i].name;
+      checks[i].run();
+      printf("CHECK %s ok\n", check_name);
+  }
+  sim_finish(EXIT_SUCCESS);
+  return EXIT_SUCCESS;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static void sim_check_that(bool ok, const char *expr, int line){
+  if(!ok){
+      printf("CHECK %s failed, line %d: %s\n", check_name, line, expr);
+      sim_finish(EXIT_FAILURE);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Scales the HF band while an LED is lit
+ *
+ * @details
+ *   The PWM keeps its clock and takes the prescaler of the new band, and
+ *   turning it off afterwards gives the clock back.
+ *
+ ******************************************************************************/
+
+static void sim_check_rgb_hf_scale(void){
+  uint32_t level = cmu_hf_level();
+  uint32_t presc;
+
+  rgb_pwm_set(RGB_LED_1, 0, 0, 64);
+  SIM_CHECK(cmu_clock_holders(RGB_PWM_CLOCK) & CMU_OWNER_RGB_PWM);
+  presc = RGB_PWM_TIMER->CTRL & _TIMER_CTRL_PRESC_MASK;
+
+  cmu_hf_scale(level == CMU_HF_LOW ? CMU_HF_MID : CMU_HF_LOW);
+  SIM_CHECK(cmu_clock_holders(RGB_PWM_CLOCK) & CMU_OWNER_RGB_PWM);
+  SIM_CHECK((RGB_PWM_TIMER->CTRL & _TIMER_CTRL_PRESC_MASK) != presc);
+
+  rgb_pwm_off();
+  SIM_CHECK(!(cmu_clock_holders(RGB_PWM_CLOCK) & CMU_OWNER_RGB_PWM));
+  cmu_hf_scale(level);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Brightness 0 is off, full white included
+ *
+ ******************************************************************************/
+
+static void sim_check_rgb_dark(void){
+  rgb_pwm_brightness(0);
+  SIM_CHECK(rgb_pwm_duty(255) == 0);
+  rgb_pwm_set(RGB_LED_1, 255, 255, 255);
+  SIM_CHECK(!(cmu_clock_holders(RGB_PWM_CLOCK) & CMU_OWNER_RGB_PWM));
+  rgb_pwm_brightness(1);
+  SIM_CHECK(rgb_pwm_duty(255) > 0);
+  SIM_CHECK(cmu_clock_holders(RGB_PWM_CLOCK) & CMU_OWNER_RGB_PWM);
+  rgb_pwm_off();
+  rgb_pwm_brightness(STATUS_LED_BRIGHTNESS);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   A string the pool cannot hold goes out cut short or not at all
+ *
+ * @details
+ *   One longer than a large block is cut to it, with every block out it is
+ *   dropped; the pool counts both and nothing asserts.
+ *
+ ******************************************************************************/
+
+static void sim_check_leuart_drop(void){
+  static char line[SIM_CHECK_LONG + 1];
+  void *held[POOL_LARGE_BLOCKS];
+  POOL_STATS before, after;
+  uint32_t count = 0;
+
+  memset(line, 'a', SIM_CHECK_LONG);
+  line[SIM_CHECK_LONG] = 0;
+  sim_check_tx_wait();
+  pool_get(POOL_CLASSES - 1, &before);
+  SIM_CHECK(ble_write(line));
+  pool_get(POOL_CLASSES - 1, &after);
+  SIM_CHECK(after.truncated == before.truncated + 1);
+  sim_check_tx_wait();
+
+  while(count < POOL_LARGE_BLOCKS && (held[count] = pool_alloc(POOL_LARGE_SIZE))){
+      count++;
+  }
+  SIM_CHECK(count == POOL_LARGE_BLOCKS);
+  SIM_CHECK(!ble_write(line + SIM_CHECK_LONG - POOL_LARGE_SIZE));
+  SIM_CHECK(!leuart_tx_pending());
+  pool_get(POOL_CLASSES - 1, &before);
+  SIM_CHECK(before.failed == after.failed + 1);
+  while(count){
+      pool_free(held[--count]);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   A batch masks the LEUART interrupt until its commit
+ *
+ * @details
+ *   So the handler's CMD writes cannot land in the frozen CMD.
+ *
+ ******************************************************************************/
+
+static void sim_check_leuart_freeze(void){
+  SIM_CHECK(NVIC_GetEnableIRQ(LEUART0_IRQn));
+  leuart_freeze(HM10_LEUART0);
+  SIM_CHECK(!NVIC_GetEnableIRQ(LEUART0_IRQn));
+  leuart_commit(HM10_LEUART0);
+  SIM_CHECK(NVIC_GetEnableIRQ(LEUART0_IRQn));
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The app skips a sample line or a command the pool has no block for
+ *
+ * @details
+ *   With every medium and large block out the sample and the command still
+ *   run their course, the pool counts the failures and nothing asserts.
+ *
+ ******************************************************************************/
+
+static void sim_check_pool_empty(void){
+  void *held[POOL_MEDIUM_BLOCKS + POOL_LARGE_BLOCKS];
+  POOL_STATS before, after;
+  uint32_t count = 0;
+
+  sim_check_tx_wait();
+  while(count < POOL_MEDIUM_BLOCKS + POOL_LARGE_BLOCKS && (held[count] = pool_alloc(POOL_MEDIUM_SIZE))){
+      count++;
+  }
+  SIM_CHECK(count == POOL_MEDIUM_BLOCKS + POOL_LARGE_BLOCKS);
+  pool_get(1, &before);
+  scheduled_letimer0_uf_cb();
+  pool_get(1, &after);
+  SIM_CHECK(after.failed == before.failed + 1);
+  SIM_CHECK(!leuart_tx_pending());
+
+  pool_get(POOL_CLASSES - 1, &before);
+  scheduled_ble_rx_done_cb();
+  pool_get(POOL_CLASSES - 1, &after);
+  SIM_CHECK(after.failed == before.failed + 2);
+  while(count){
+      pool_free(held[--count]);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   A pending event nothing takes leaves the main loop free to sleep
+ *
+ * @details
+ *   SI1133_LIGHT_READ_CB has no callback, with no task waiting on it the
+ *   main loop's scheduler_next_event() does not see it.
+ *
+ ******************************************************************************/
+
+static void sim_check_sched_idle(void){
+  sim_check_tx_wait();
+  while(scheduler_dispatch());
+  add_scheduled_event(SI1133_LIGHT_READ_CB);
+  SIM_CHECK(get_scheduled_events() & SI1133_LIGHT_READ_CB);
+  SIM_CHECK(!scheduler_next_event());
+  remove_scheduled_event(SI1133_LIGHT_READ_CB);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   An HF change during an I2C transfer reaches the bus at its STOP
+ *
+ * @details
+ *   The SCL divider stays as it is while the part ID is read and follows
+ *   the band once the transfer is done, which gives its HF floor back.  The
+ *   check skips the boot, the bus is opened here.
+ *
+ ******************************************************************************/
+
+static void sim_check_i2c_hf_defer(void){
+  uint32_t level = cmu_hf_level();
+  uint32_t div;
+
+  si1133_i2c_open();
+  cmu_hf_scale(I2C_HF_FLOOR);
+  div = I2C1->CLKDIV;
+  si1133_read(SI1133_LIGHT_READ_CB);
+  cmu_hf_scale(CMU_HF_HIGH);
+  SIM_CHECK(I2C1->CLKDIV == div);
+  sim_check_i2c_wait();
+  SIM_CHECK(I2C1->CLKDIV != div);
+  SIM_CHECK(si1133_pass_ID() == CHECK_VAL);
+  cmu_hf_scale(CMU_HF_LOW);
+  cmu_hf_policy(0);
+  SIM_CHECK(cmu_hf_level() == CMU_HF_LOW);
+  cmu_hf_scale(level);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   A NACK of the sensor ends the read instead of asserting
+ *
+ * @details
+ *   Once on the address of the write and once on the address of the read
+ *   after the repeated START.  Each time the STOP goes out, the callback
+ *   event comes with si1133_nacked(), the HF floor is given back and the
+ *   next read goes through.  The time from each read to its callback is
+ *   printed, both start at the HF floor so a band change is not in them.
+ *
+ ******************************************************************************/
+
+static void sim_check_i2c_nack(void){
+  for(uint32_t every = 1; every <= SIM_CHECK_NACKS; every++){
+      uint64_t start;
+      double nacked_us, read_us;
+
+      si1133_i2c_open();
+      cmu_hf_scale(I2C_HF_FLOOR);
+      sim_si1133_nack(every);
+      start = sim_now();
+      si1133_read(SI1133_LIGHT_READ_CB);
+      sim_check_i2c_wait();
+      nacked_us = (double)(sim_now() - start) / SIM_PS_PER_US;
+      sim_si1133_nack(0);
+      SIM_CHECK(si1133_nacked());
+      SIM_CHECK((I2C1->STATE & _I2C_STATE_STATE_MASK) == I2C_STATE_STATE_IDLE);
+      cmu_hf_scale(CMU_HF_LOW);
+      cmu_hf_policy(0);
+      SIM_CHECK(cmu_hf_level() == CMU_HF_LOW);
+
+      cmu_hf_scale(I2C_HF_FLOOR);
+      start = sim_now();
+      si1133_read(SI1133_LIGHT_READ_CB);
+      sim_check_i2c_wait();
+      read_us = (double)(sim_now() - start) / SIM_PS_PER_US;
+      SIM_CHECK(!si1133_nacked());
+      SIM_CHECK(si1133_pass_ID() == CHECK_VAL);
+      printf("CHECK %s NACK of address %lu ends the read in %.1f us, the read after it takes %.1f us\n",
+             check_name, (unsigned long)every, nacked_us, read_us);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The color, the effect and the framebuffer take the PWM TIMER in turn
+ *
+ * @details
+ *   Each holds it alone and gives it and its clocks back when stopped.  A
+ *   brightness change leaves a running effect running.
+ *
+ ******************************************************************************/
+
+static void sim_check_led_owner(void){
+  rgb_pwm_set(RGB_LED_1, 0, 0, STATUS_LED_LEVEL);
+  SIM_CHECK(rgb_pwm_owner() == RGB_PWM_OWNER_COLOR);
+  rgb_pwm_off();
+  SIM_CHECK(rgb_pwm_owner() == RGB_PWM_OWNER_NONE);
+
+  led_effect_start(RGB_ALL_LEDS, LED_EFFECT_BREATHE, STATUS_EFFECT_MS, 0, 0, STATUS_LED_LEVEL);
+  SIM_CHECK(rgb_pwm_owner() == RGB_PWM_OWNER_EFFECT);
+  SIM_CHECK(cmu_clock_holders(RGB_EFFECT_CLOCK) & CMU_OWNER_LED_EFFECT);
+  rgb_pwm_brightness(STATUS_LED_BRIGHTNESS);
+  SIM_CHECK(rgb_pwm_owner() == RGB_PWM_OWNER_EFFECT);
+  SIM_CHECK(RGB_PWM_TIMER->STATUS & TIMER_STATUS_RUNNING);
+
+  led_fb_start();
+  SIM_CHECK(led_effect_active() == LED_EFFECT_NONE);
+  SIM_CHECK(!(cmu_clock_holders(RGB_EFFECT_CLOCK) & CMU_OWNER_LED_EFFECT));
+  SIM_CHECK(rgb_pwm_owner() == RGB_PWM_OWNER_FB);
+
+  led_fb_stop();
+  SIM_CHECK(rgb_pwm_owner() == RGB_PWM_OWNER_NONE);
+  SIM_CHECK(!(cmu_clock_holders(RGB_PWM_CLOCK) & CMU_OWNER_RGB_PWM));
+}
+
+/***************************************************************************//**
+ * @brief
+ *   A running effect moves LED_EFFECT_STEPS samples per period
+ *
+ * @details
+ *   One LDMA request per step TIMER wrap, counted on the first channel over
+ *   a few periods.  The core stays awake and skips ahead from one wrap to
+ *   the next, nothing in the check wakes it from a sleep.
+ *
+ ******************************************************************************/
+
+static void sim_check_led_step(void){
+  uint64_t start, elapsed;
+  uint32_t served, steps;
+
+  led_effect_start(RGB_ALL_LEDS, LED_EFFECT_BREATHE, STATUS_EFFECT_MS, 0, 0, STATUS_LED_LEVEL);
+  start = sim_now();
+  served = sim_ldma_served(LED_EFFECT_DMA_CH);
+  while(sim_now() - start < SIM_CHECK_PERIODS * STATUS_EFFECT_MS * SIM_PS_PER_MS){
+      if(!scheduler_dispatch() && !sim_spin_skip()){
+          break;
+      }
+  }
+  elapsed = sim_now() - start;
+  served = sim_ldma_served(LED_EFFECT_DMA_CH) - served;
+  led_effect_stop();
+
+  steps = (uint32_t)((uint64_t)served * STATUS_EFFECT_MS * SIM_PS_PER_MS / elapsed);
+  printf("CHECK %s %lu steps per period\n", check_name, (unsigned long)steps);
+  SIM_CHECK((steps >= LED_EFFECT_STEPS - 1) && (steps <= LED_EFFECT_STEPS + 1));
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Runs the main loop until the string going out is through
+ *
+ ******************************************************************************/
+
+static void sim_check_tx_wait(void){
+  while(leuart_tx_pending()){
+      if(!scheduler_dispatch()){
+          enter_sleep();
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sleeps until the I2C read posts SI1133_LIGHT_READ_CB, which has no
+ *   callback, and takes the event back
+ *
+ ******************************************************************************/
+
+static void sim_check_i2c_wait(void){
+  while(!(get_scheduled_events() & SI1133_LIGHT_READ_CB)){
+      enter_sleep();
+  }
+  remove_scheduled_event(SI1133_LIGHT_READ_CB);
+}
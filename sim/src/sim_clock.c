@@ -0,0 +1,924 @@
+/**
+ * @file sim_clock.c
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Virtual clock, NVIC and core of the host simulation.  Time only moves
+ *        when the firmware touches a peripheral register, takes an interrupt or
+ *        sleeps, and sleeping jumps straight to the next peripheral event.
+ *        EM4H ends in a reset, the firmware starts over from main() with its
+ *        RAM and the MCU's peripherals back at their power on state.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#define SIM_MODEL_SOURCE
+#include <execinfo.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include "sim.h"
+#include "em_assert.h"
+#include "em_core.h"
+#include "em_rmu.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_EMS     5
+#define SIM_WATCHDOG_MS     10      // Wall clock period of the spin watchdog
+#define SIM_WATCHDOG_HANG   200     // Periods stuck before the run is called a hang
+#define SIM_BACKTRACE       32
+#define SIM_STACK_BYTES     262144          // Main stack of the firmware, host frames are larger
+#define SIM_STR(x)          SIM_STR_(x)
+#define SIM_STR_(x)         #x
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+typedef void (*SIM_HANDLER)(void);
+
+typedef struct {
+  uint64_t      when;
+  SIM_EVENT_FN  fn;
+  void          *arg;
+} SIM_EVENT;
+
+static const SIM_MODEL *const sim_models[] = {
+  &sim_letimer0_model,
+  &sim_rtcc_model,
+  &sim_leuart0_model,
+  &sim_i2c0_model,
+  &sim_i2c1_model,
+  &sim_timer0_model,
+  &sim_timer1_model,
+  &sim_wtimer0_model,
+  &sim_ldma_model,
+};
+#define SIM_MODELS  (sizeof(sim_models) / sizeof(sim_models[0]))
+
+// Bounds of the sim_em4_reset section, made by the linker
+extern uint8_t    __start_sim_em4_reset[] __attribute__((weak));
+extern uint8_t    __stop_sim_em4_reset[] __attribute__((weak));
+
+static uint64_t   now_ps;
+static uint64_t   end_ps;
+static bool       sim_quiet;
+static uint32_t   primask SIM_EM4_RESET;
+static int        irq_active SIM_EM4_RESET = SIM_NO_IRQ;
+static uint64_t   nvic_enabled SIM_EM4_RESET;
+static uint64_t   nvic_pending SIM_EM4_RESET;
+static uint32_t   energy_mode;
+static uint64_t   em_ps[SIM_EMS];
+static uint32_t   em_entries[SIM_EMS];
+static uint32_t   irq_count[SIM_IRQn_COUNT];
+static uint64_t   irq_raised[SIM_IRQn_COUNT];   // When the line went high, SIM_NEVER while low
+static uint64_t   irq_latency_min[SIM_IRQn_COUNT];
+static uint64_t   irq_latency_max[SIM_IRQn_COUNT];
+static uint64_t   irq_latency_sum[SIM_IRQn_COUNT];
+static uint32_t   spin_skips;
+static volatile uint32_t engine_depth;
+static uint64_t   core_cycles;      // Cycles the core has run with the DWT counter enabled
+static uint64_t   core_cycles_ps;   // Picoseconds not yet worth a whole cycle
+static uint64_t   cyccnt_offset;
+static uint32_t   cyccnt_published;
+
+DWT_Type          sim_dwt SIM_EM4_RESET;
+// The firmware's main stack, named like the linker script's ends of it
+uint32_t          __StackLimit[SIM_STACK_BYTES / sizeof(uint32_t)] __attribute__((aligned(16)));
+__asm__(".globl __StackTop\n.set __StackTop, __StackLimit + " SIM_STR(SIM_STACK_BYTES));
+CoreDebug_Type    sim_coredebug SIM_EM4_RESET;
+static SIM_EVENT  events[SIM_MAX_EVENTS];
+static uint64_t   watchdog_last = SIM_NEVER;
+static uint32_t   watchdog_stuck;
+static jmp_buf    em4_wakeup;
+static ucontext_t host_context;
+static ucontext_t firmware_context;
+static int        (*firmware_entry)(void);
+static uint8_t    *em4_image;       // Power on copy of the sim_em4_reset section
+static uint32_t   reset_cause = RMU_RSTCAUSE_PORST;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static void sim_default_handler(void);
+static void sim_firmware_start(void);
+static void sim_models_sync(void);
+static uint64_t sim_next_event(void);
+static void sim_advance(uint64_t target);
+static void sim_core_run(uint64_t ps);
+static uint64_t sim_irq_lines(void);
+static void sim_irq_track(void);
+static int sim_irq_next(void);
+static void sim_irq_latency(int irqn);
+static void sim_dispatch(void);
+static void sim_watchdog(int sig);
+
+//***********************************************************************************
+// Interrupt handlers, the firmware overrides the ones it uses
+//***********************************************************************************
+void LDMA_IRQHandler(void)      __attribute__((weak, alias("sim_default_handler")));
+void TIMER0_IRQHandler(void)    __attribute__((weak, alias("sim_default_handler")));
+void TIMER1_IRQHandler(void)    __attribute__((weak, alias("sim_default_handler")));
+void I2C0_IRQHandler(void)      __attribute__((weak, alias("sim_default_handler")));
+void I2C1_IRQHandler(void)      __attribute__((weak, alias("sim_default_handler")));
+void LEUART0_IRQHandler(void)   __attribute__((weak, alias("sim_default_handler")));
+void LETIMER0_IRQHandler(void)  __attribute__((weak, alias("sim_default_handler")));
+void WTIMER0_IRQHandler(void)   __attribute__((weak, alias("sim_default_handler")));
+void RTCC_IRQHandler(void)      __attribute__((weak, alias("sim_default_handler")));
+
+static const SIM_HANDLER vector_table[SIM_IRQn_COUNT] = {
+  [LDMA_IRQn]     = LDMA_IRQHandler,
+  [TIMER0_IRQn]   = TIMER0_IRQHandler,
+  [TIMER1_IRQn]   = TIMER1_IRQHandler,
+  [I2C0_IRQn]     = I2C0_IRQHandler,
+  [I2C1_IRQn]     = I2C1_IRQHandler,
+  [LEUART0_IRQn]  = LEUART0_IRQHandler,
+  [LETIMER0_IRQn] = LETIMER0_IRQHandler,
+  [WTIMER0_IRQn]  = WTIMER0_IRQHandler,
+  [RTCC_IRQn]     = RTCC_IRQHandler,
+};
+
+static const char *const irq_names[SIM_IRQn_COUNT] = {
+  [LDMA_IRQn]     = "LDMA",
+  [TIMER0_IRQn]   = "TIMER0",
+  [TIMER1_IRQn]   = "TIMER1",
+  [I2C0_IRQn]     = "I2C0",
+  [I2C1_IRQn]     = "I2C1",
+  [LEUART0_IRQn]  = "LEUART0",
+  [LETIMER0_IRQn] = "LETIMER0",
+  [WTIMER0_IRQn]  = "WTIMER0",
+  [RTCC_IRQn]     = "RTCC",
+};
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Resets virtual time and the core state before the firmware starts
+ *
+ * @param[in] run_ps
+ *   Virtual run time, the simulation ends with sim_finish() when it is reached
+ *
+ * @param[in] quiet
+ *   true to only print the end of run report
+ *
+ ******************************************************************************/
+
+void sim_init(uint64_t run_ps, bool quiet){
+  now_ps = 0;
+  end_ps = run_ps;
+  sim_quiet = quiet;
+  primask = 0;
+  irq_active = SIM_NO_IRQ;
+  nvic_enabled = 0;
+  nvic_pending = 0;
+  for(uint32_t irqn = 0; irqn < SIM_IRQn_COUNT; irqn++){
+      irq_raised[irqn] = SIM_NEVER;
+      irq_latency_min[irqn] = SIM_NEVER;
+  }
+  energy_mode = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Runs the firmware from its reset vector, again after every EM4H wake-up
+ *
+ * @details
+ *   The sim_em4_reset section holds the firmware's RAM and the state of the
+ *   MCU's peripherals.  It is copied once the devices are set up and put
+ *   back on each wake-up, while virtual time, the RTCC, the devices on the
+ *   buses and the run's statistics carry on.  The firmware runs on a stack
+ *   of its own between __StackLimit and __StackTop, below 4 GB like the
+ *   rest of its RAM, so it can paint and measure it.
+ *
+ * @param[in] firmware
+ *   The firmware's main()
+ *
+ ******************************************************************************/
+
+void sim_run(int (*firmware)(void)){
+  size_t size = (size_t)(__stop_sim_em4_reset - __start_sim_em4_reset);
+
+  if(size){
+      em4_image = malloc(size);
+      EFM_ASSERT(em4_image);
+      memcpy(em4_image, __start_sim_em4_reset, size);
+  }
+  if(setjmp(em4_wakeup)){
+      if(size){
+          memcpy(__start_sim_em4_reset, em4_image, size);
+      }
+      reset_cause |= RMU_RSTCAUSE_EM4RST;
+  }
+  firmware_entry = firmware;
+  EFM_ASSERT(!getcontext(&firmware_context));
+  firmware_context.uc_stack.ss_sp = __StackLimit;
+  firmware_context.uc_stack.ss_size = sizeof(__StackLimit);
+  firmware_context.uc_link = &host_context;
+  makecontext(&firmware_context, sim_firmware_start, 0);
+  EFM_ASSERT(!swapcontext(&host_context, &firmware_context));
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Current virtual time in picoseconds
+ *
+ ******************************************************************************/
+
+uint64_t sim_now(void){
+  return now_ps;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Converts core clock cycles at the present HF frequency into picoseconds
+ *
+ ******************************************************************************/
+
+uint64_t sim_cycles_to_ps(uint32_t cycles){
+  uint32_t core_freq = CMU_ClockFreqGet(cmuClock_CORE);
+  return ((uint64_t)cycles * SIM_PS_PER_S) / core_freq;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The energy mode the core is in, 0 unless inside sim_sleep()
+ *
+ ******************************************************************************/
+
+uint32_t sim_energy_mode(void){
+  return energy_mode;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Synchronization point reached on every firmware access to a register
+ *   with side effects
+ *
+ * @details
+ *   The access is charged SIM_ACCESS_CYCLES of core time.  Register writes
+ *   made since the last access are handed to the models in order, the models
+ *   run up to the new time and any enabled and unmasked interrupt is taken
+ *   before the access itself completes.
+ *
+ * @return
+ *   0, used as the index of the one element register array
+ *
+ ******************************************************************************/
+
+uint32_t sim_sync(void){
+  sim_advance(now_ps + sim_cycles_to_ps(SIM_ACCESS_CYCLES));
+  sim_dispatch();
+  return 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Synchronization point for a read of RXDATA
+ *
+ * @details
+ *   Reading RXDATA pops the receive buffer.  The value is read after this
+ *   returns, so the model is only told to pop on its next sync.  When more
+ *   than one peripheral holds data, the one whose interrupt is running is
+ *   the one being read.
+ *
+ ******************************************************************************/
+
+uint32_t sim_rxdata_access(void){
+  const SIM_MODEL *reader = NULL;
+
+  sim_sync();
+  for(uint32_t i = 0; i < SIM_MODELS; i++){
+      const SIM_MODEL *model = sim_models[i];
+      if(model->rx_valid && model->rx_valid(model->ctx)){
+          if(!reader || model->irqn == irq_active){
+              reader = model;
+          }
+      }
+  }
+  if(reader){
+      reader->rx_consume(reader->ctx);
+  }
+  return 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Synchronization point for DWT->CYCCNT
+ *
+ * @details
+ *   The counter runs on the core clock, so it only moves in EM0 and at the
+ *   rate of the HF band at the time.  A firmware write is recognised by the
+ *   register no longer holding the last value published.
+ *
+ * @return
+ *   0, used as the index of the one element register array
+ *
+ ******************************************************************************/
+
+uint32_t sim_cyccnt_access(void){
+  sim_sync();
+  if(sim_dwt.CYCCNT_[0] != cyccnt_published){
+      cyccnt_offset = core_cycles - sim_dwt.CYCCNT_[0];
+  }
+  cyccnt_published = (uint32_t)(core_cycles - cyccnt_offset);
+  sim_dwt.CYCCNT_[0] = cyccnt_published;
+  return 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Waits for an interrupt in the given energy mode
+ *
+ * @details
+ *   Like WFI this returns once an enabled interrupt is pending, even with
+ *   PRIMASK set.  Virtual time jumps from one model event to the next, the
+ *   models themselves stop the clocks that do not run in this mode.
+ *
+ * @param[in] em
+ *   1 to 3
+ *
+ ******************************************************************************/
+
+void sim_sleep(uint32_t em){
+  sim_models_sync();
+  energy_mode = em;
+  em_entries[em]++;
+  sim_vcd_change(SIM_VCD_EM, now_ps, em);
+  while(sim_irq_next() == SIM_NO_IRQ){
+      uint64_t next = sim_next_event();
+      if(next == SIM_NEVER){
+          sim_log("asleep in EM%lu with no wake-up source", (unsigned long)em);
+          sim_finish(SIM_EXIT_DEADLOCK);
+      }
+      sim_advance(next);
+  }
+  energy_mode = 0;
+  sim_vcd_change(SIM_VCD_EM, now_ps, 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   EM4H, powers down until the RTCC wakes the part through a reset
+ *
+ * @details
+ *   Only an RTCC interrupt enabled with EM4WUEN ends it, the NVIC is off and
+ *   no handler runs.  The wake-up goes back to sim_run(), which restarts the
+ *   firmware.
+ *
+ ******************************************************************************/
+
+void sim_em4h(void){
+  sim_models_sync();
+  energy_mode = 4;
+  em_entries[4]++;
+  sim_vcd_change(SIM_VCD_EM, now_ps, 4);
+  while(!sim_rtcc_em4_wakeup()){
+      uint64_t next = sim_next_event();
+      if(next == SIM_NEVER){
+          sim_log("in EM4H with no wake-up source");
+          sim_finish(SIM_EXIT_DEADLOCK);
+      }
+      sim_advance(next);
+  }
+  energy_mode = 0;
+  sim_vcd_change(SIM_VCD_EM, now_ps, 0);
+  sim_vcd_reset(now_ps);
+  sim_log("EM4H wake-up, reset");
+  longjmp(em4_wakeup, 1);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Lets a firmware loop that polls RAM reach its next interrupt
+ *
+ * @details
+ *   Called from the host watchdog when virtual time has not moved for a
+ *   while.  Polling a flag in RAM never touches a register, so it never
+ *   syncs; on the part the interrupt that sets the flag simply arrives.  With
+ *   interrupts unmasked in thread mode the loop is skipped ahead to the next
+ *   model event and interrupts are taken as if they had interrupted it.
+ *
+ * @return
+ *   false if the firmware cannot be woken this way, masked, inside a handler
+ *   or with nothing left to happen, which is a hang on the part too
+ *
+ ******************************************************************************/
+
+bool sim_spin_skip(void){
+  uint64_t next;
+
+  if(engine_depth || primask || (irq_active != SIM_NO_IRQ)){
+      return false;
+  }
+  next = sim_next_event();
+  if(next == SIM_NEVER){
+      return false;
+  }
+  spin_skips++;
+  sim_advance(next);
+  sim_dispatch();
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Starts the host timer that runs sim_watchdog() on the wall clock
+ *
+ ******************************************************************************/
+
+void sim_watchdog_open(void){
+  signal(SIGALRM, sim_watchdog);
+  setitimer(ITIMER_REAL, &(struct itimerval){
+      { 0, SIM_WATCHDOG_MS * 1000 }, { 0, SIM_WATCHDOG_MS * 1000 } }, NULL);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Calls fn(arg) at virtual time when, used by the simulated devices
+ *
+ ******************************************************************************/
+
+void sim_event_at(uint64_t when, SIM_EVENT_FN fn, void *arg){
+  for(uint32_t i = 0; i < SIM_MAX_EVENTS; i++){
+      if(!events[i].fn){
+          events[i].when = (when < now_ps) ? now_ps : when;
+          events[i].fn = fn;
+          events[i].arg = arg;
+          return;
+      }
+  }
+  EFM_ASSERT(false);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   printf() to stdout with the virtual time in seconds in front
+ *
+ ******************************************************************************/
+
+void sim_log(const char *format, ...){
+  va_list args;
+
+  if(sim_quiet){
+      return;
+  }
+  printf("[%12.6f] ", (double)now_ps / SIM_PS_PER_S);
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+  printf("\n");
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Prints the run report and exits the process
+ *
+ * @details
+ *   The report gives the virtual run time, the residency in each energy mode
+ *   and how often each interrupt was taken.
+ *
+ * @param[in] code
+ *   Process exit code, EXIT_SUCCESS or one of SIM_EXIT_
+ *
+ ******************************************************************************/
+
+void sim_finish(int code){
+  uint64_t total = now_ps ? now_ps : 1;
+
+  printf("sim: %.6f s virtual time, exit %d\n", (double)now_ps / SIM_PS_PER_S, code);
+  for(uint32_t em = 0; em < SIM_EMS; em++){
+      if(em_ps[em] || em_entries[em]){
+          printf("  EM%lu %12.6f s %6.2f%%  %lu entries\n", (unsigned long)em,
+                 (double)em_ps[em] / SIM_PS_PER_S, (100.0 * em_ps[em]) / total,
+                 (unsigned long)em_entries[em]);
+      }
+  }
+  for(uint32_t irqn = 0; irqn < SIM_IRQn_COUNT; irqn++){
+      if(irq_count[irqn]){
+          printf("  %-9s IRQ %lu, latency %.3f us avg %.3f us max %.3f us jitter\n", irq_names[irqn],
+                 (unsigned long)irq_count[irqn],
+                 (double)irq_latency_sum[irqn] / irq_count[irqn] / SIM_PS_PER_US,
+                 (double)irq_latency_max[irqn] / SIM_PS_PER_US,
+                 (double)(irq_latency_max[irqn] - irq_latency_min[irqn]) / SIM_PS_PER_US);
+      }
+  }
+  if(spin_skips){
+      printf("  RAM polling loops skipped ahead %lu times\n", (unsigned long)spin_skips);
+  }
+  fflush(stdout);
+  exit(code);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Failed EFM_ASSERT, ends the run
+ *
+ ******************************************************************************/
+
+void assertEFM(const char *file, int line){
+  printf("[%12.6f] EFM_ASSERT failed at %s:%d\n", (double)now_ps / SIM_PS_PER_S, file, line);
+  sim_finish(SIM_EXIT_ASSERT);
+}
+
+//***********************************************************************************
+// CMSIS and emlib core
+//***********************************************************************************
+
+void NVIC_EnableIRQ(IRQn_Type irqn){
+  nvic_enabled |= (1ULL << irqn);
+  sim_sync();
+}
+
+void NVIC_DisableIRQ(IRQn_Type irqn){
+  nvic_enabled &= ~(1ULL << irqn);
+}
+
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irqn){
+  return (nvic_enabled >> irqn) & 0x01;
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type irqn){
+  nvic_pending |= (1ULL << irqn);
+  sim_sync();
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irqn){
+  nvic_pending &= ~(1ULL << irqn);
+}
+
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irqn){
+  return (nvic_pending >> irqn) & 0x01;
+}
+
+void __NOP(void){
+  sim_advance(now_ps + sim_cycles_to_ps(1));
+}
+
+void __WFI(void){
+  sim_sleep(1);
+}
+
+void __DSB(void){
+}
+
+void __ISB(void){
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The firmware's SP, the low 32 bits of the frame of this call on its stack
+ *
+ ******************************************************************************/
+
+uint32_t __get_MSP(void){
+  return (uint32_t)(uintptr_t)__builtin_frame_address(0);
+}
+
+CORE_irqState_t CORE_EnterCritical(void){
+  CORE_irqState_t state = primask;
+  primask = 1;
+  return state;
+}
+
+void CORE_ExitCritical(CORE_irqState_t irqState){
+  primask = irqState;
+  if(!primask){
+      sim_sync();
+  }
+}
+
+CORE_irqState_t CORE_EnterAtomic(void){
+  return CORE_EnterCritical();
+}
+
+void CORE_ExitAtomic(CORE_irqState_t irqState){
+  CORE_ExitCritical(irqState);
+}
+
+bool CORE_InIrqContext(void){
+  return irq_active != SIM_NO_IRQ;
+}
+
+bool CORE_IrqIsBlocked(IRQn_Type irqN){
+  return primask || (irq_active != SIM_NO_IRQ) || !(nvic_enabled & (1ULL << irqN));
+}
+
+uint32_t RMU_ResetCauseGet(void){
+  return reset_cause;
+}
+
+void RMU_ResetCauseClear(void){
+  reset_cause = 0;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Handler for an interrupt the firmware enabled but does not implement
+ *
+ ******************************************************************************/
+
+static void sim_default_handler(void){
+  sim_log("no handler for IRQ %d", irq_active);
+  sim_finish(SIM_EXIT_DEADLOCK);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   First function on the firmware's stack, its reset vector
+ *
+ ******************************************************************************/
+
+static void sim_firmware_start(void){
+  firmware_entry();
+  sim_log("firmware main() returned");
+  sim_finish(SIM_EXIT_DEADLOCK);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Lets every model take its pending register writes at the current time
+ *
+ ******************************************************************************/
+
+static void sim_models_sync(void){
+  for(uint32_t i = 0; i < SIM_MODELS; i++){
+      sim_models[i]->sync(sim_models[i]->ctx, now_ps);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Earliest model event or device callback, SIM_NEVER if there is none
+ *
+ ******************************************************************************/
+
+static uint64_t sim_next_event(void){
+  uint64_t next = SIM_NEVER;
+
+  for(uint32_t i = 0; i < SIM_MODELS; i++){
+      uint64_t when = sim_models[i]->next_event(sim_models[i]->ctx);
+      if(when < next){
+          next = when;
+      }
+  }
+  for(uint32_t i = 0; i < SIM_MAX_EVENTS; i++){
+      if(events[i].fn && (events[i].when < next)){
+          next = events[i].when;
+      }
+  }
+  return next;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Moves virtual time to target, stopping at every event on the way
+ *
+ * @details
+ *   Models are run event by event so that one model's output, an LDMA
+ *   request or a byte on a loopback, reaches the others at the right time.
+ *   Time is booked to the current energy mode and the run ends here once the
+ *   requested run time is used up.
+ *
+ * @param[in] target
+ *   Virtual time to advance to, in picoseconds
+ *
+ ******************************************************************************/
+
+static void sim_advance(uint64_t target){
+  uint64_t start = now_ps;
+
+  engine_depth++;
+  if(target > end_ps){
+      target = end_ps;
+  }
+  for(;;){
+      uint64_t next = sim_next_event();
+      if(next > target){
+          break;
+      }
+      if(next > now_ps){
+          sim_energy_run(next - now_ps);
+          now_ps = next;
+      }
+      sim_models_sync();
+      sim_irq_track();
+      for(uint32_t i = 0; i < SIM_MAX_EVENTS; i++){
+          if(events[i].fn && (events[i].when <= now_ps)){
+              SIM_EVENT_FN fn = events[i].fn;
+              events[i].fn = NULL;
+              fn(events[i].arg);
+          }
+      }
+      if(next == target){
+          break;
+      }
+  }
+  if(target > now_ps){
+      sim_energy_run(target - now_ps);
+  }
+  now_ps = target;
+  sim_models_sync();
+  sim_irq_track();
+  em_ps[energy_mode] += now_ps - start;
+  if(energy_mode == 0){
+      sim_core_run(now_ps - start);
+  }
+  engine_depth--;
+  if(now_ps >= end_ps){
+      sim_finish(EXIT_SUCCESS);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Counts the cycles of core time for DWT->CYCCNT
+ *
+ ******************************************************************************/
+
+static void sim_core_run(uint64_t ps){
+  unsigned __int128 total;
+
+  if(!(sim_dwt.CTRL_[0] & DWT_CTRL_CYCCNTENA_Msk) || !(sim_coredebug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk)){
+      return;
+  }
+  total = (unsigned __int128)ps * CMU_ClockFreqGet(cmuClock_CORE) + core_cycles_ps;
+  core_cycles += (uint64_t)(total / SIM_PS_PER_S);
+  core_cycles_ps = (uint64_t)(total % SIM_PS_PER_S);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Enabled interrupt lines that are high, one bit per IRQ number
+ *
+ * @details
+ *   A peripheral's line is high while any of its enabled flags, IF & IEN, is
+ *   set.
+ *
+ ******************************************************************************/
+
+static uint64_t sim_irq_lines(void){
+  uint64_t lines = nvic_pending;
+
+  for(uint32_t i = 0; i < SIM_MODELS; i++){
+      const SIM_MODEL *model = sim_models[i];
+      if((model->irqn != SIM_NO_IRQ) && (*model->irq_if & *model->irq_ien)){
+          lines |= (1ULL << model->irqn);
+      }
+  }
+  return lines & nvic_enabled;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Notes when each line went high, for the latency to its handler
+ *
+ * @details
+ *   Called after every model sync, so a line is stamped at the model event
+ *   that raised it.  A line that drops without its handler running, a flag
+ *   cleared by polling, is forgotten.
+ *
+ ******************************************************************************/
+
+static void sim_irq_track(void){
+  uint64_t lines = sim_irq_lines();
+
+  for(uint32_t irqn = 0; irqn < SIM_IRQn_COUNT; irqn++){
+      if(!((lines >> irqn) & 0x01)){
+          irq_raised[irqn] = SIM_NEVER;
+      } else if(irq_raised[irqn] == SIM_NEVER){
+          irq_raised[irqn] = now_ps;
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Lowest numbered enabled interrupt that is pending
+ *
+ * @details
+ *   Every interrupt runs at the same priority, so the lowest IRQ number is
+ *   served first as on the NVIC.
+ *
+ * @return
+ *   The IRQ number or SIM_NO_IRQ
+ *
+ ******************************************************************************/
+
+static int sim_irq_next(void){
+  uint64_t lines = sim_irq_lines();
+
+  if(!lines){
+      return SIM_NO_IRQ;
+  }
+  return __builtin_ctzll(lines);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Books the time from a line going high to its handler being entered
+ *
+ * @details
+ *   What a handler waits for: other handlers running first and the
+ *   firmware's critical sections, at SIM_ACCESS_CYCLES per register access
+ *   made inside them.  Plain C code inside a critical section costs nothing
+ *   in the model, so the figures are a lower bound.
+ *
+ ******************************************************************************/
+
+static void sim_irq_latency(int irqn){
+  uint64_t latency = (irq_raised[irqn] == SIM_NEVER) ? 0 : now_ps - irq_raised[irqn];
+
+  irq_raised[irqn] = SIM_NEVER;
+  irq_latency_sum[irqn] += latency;
+  if(latency < irq_latency_min[irqn]){
+      irq_latency_min[irqn] = latency;
+  }
+  if(latency > irq_latency_max[irqn]){
+      irq_latency_max[irqn] = latency;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes pending interrupts while the core is unmasked and in thread mode
+ *
+ * @details
+ *   Interrupts do not nest, they share one priority.  The models sync after
+ *   each handler so its flag clears are seen before the line is sampled again.
+ *
+ ******************************************************************************/
+
+static void sim_dispatch(void){
+  int last = SIM_NO_IRQ;
+  uint32_t repeats = 0;
+
+  if(primask || (irq_active != SIM_NO_IRQ)){
+      return;
+  }
+  for(;;){
+      int irqn = sim_irq_next();
+      if(irqn == SIM_NO_IRQ){
+          return;
+      }
+      repeats = (irqn == last) ? repeats + 1 : 0;
+      if(repeats > SIM_IRQ_STORM){
+          sim_log("IRQ %s re-entered %d times, flags never cleared", irq_names[irqn], SIM_IRQ_STORM);
+          sim_finish(SIM_EXIT_DEADLOCK);
+      }
+      last = irqn;
+      nvic_pending &= ~(1ULL << irqn);
+      irq_count[irqn]++;
+      sim_irq_latency(irqn);
+      irq_active = irqn;
+      sim_advance(now_ps + sim_cycles_to_ps(SIM_IRQ_CYCLES));
+      vector_table[irqn]();
+      sim_advance(now_ps + sim_cycles_to_ps(SIM_IRQ_CYCLES));
+      irq_active = SIM_NO_IRQ;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Catches the firmware spinning on RAM with virtual time standing still
+ *
+ * @details
+ *   Virtual time only moves when the firmware touches a register, so a loop
+ *   waiting on a flag in RAM stops it.  Such a loop is first skipped ahead to
+ *   its next interrupt.  If that is impossible, a wait with interrupts masked
+ *   or inside a handler, the part would hang as well and the run is ended
+ *   with a backtrace of where the firmware is stuck.
+ *
+ ******************************************************************************/
+
+static void sim_watchdog(int sig){
+  void *frames[SIM_BACKTRACE];
+  int depth;
+  (void)sig;
+
+  if(sim_now() != watchdog_last){
+      watchdog_last = sim_now();
+      watchdog_stuck = 0;
+      return;
+  }
+  if(sim_spin_skip() || (++watchdog_stuck < SIM_WATCHDOG_HANG)){
+      return;
+  }
+  printf("[%12.6f] virtual time stopped, firmware is spinning in:\n", (double)sim_now() / SIM_PS_PER_S);
+  fflush(stdout);
+  depth = backtrace(frames, SIM_BACKTRACE);
+  backtrace_symbols_fd(frames, depth, STDOUT_FILENO);
+  sim_finish(SIM_EXIT_DEADLOCK);
+}
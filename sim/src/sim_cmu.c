@@ -0,0 +1,294 @@
+/**
+ * @file sim_cmu.c
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Simulated CMU, EMU and chip init.  Keeps the oscillator, clock select
+ *        and clock gate state the peripheral models run from.  The EM4H
+ *        wake-up resets all of it, the RTCC then stands still for the few
+ *        microseconds until the firmware routes its clock again.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#define SIM_MODEL_SOURCE
+#include "sim.h"
+#include "em_assert.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_CMU_HFXO_FREQ       38400000U   // Thunderboard Sense 2 crystal
+#define SIM_CMU_HFRCO_RESET     cmuHFRCOFreq_19M0Hz
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static CMU_HFRCOFreq_TypeDef  hfrco_band SIM_EM4_RESET = SIM_CMU_HFRCO_RESET;
+static CMU_Select_TypeDef     hf_select SIM_EM4_RESET = cmuSelect_HFRCO;
+static CMU_Select_TypeDef     lfa_select SIM_EM4_RESET = cmuSelect_Disabled;
+static CMU_Select_TypeDef     lfb_select SIM_EM4_RESET = cmuSelect_Disabled;
+static CMU_Select_TypeDef     lfe_select SIM_EM4_RESET = cmuSelect_Disabled;
+static EMU_VScaleEM01_TypeDef em01_vscale SIM_EM4_RESET = emuVScaleEM01_HighPerformance;
+static bool                   osc_on[SIM_CMU_OSCS] SIM_EM4_RESET = {
+  [cmuOsc_HFRCO] = true,
+  [cmuOsc_LFRCO] = true,
+  [cmuOsc_ULFRCO] = true,
+};
+static bool                   gate_on[SIM_CMU_CLOCKS] SIM_EM4_RESET = {
+  [cmuClock_HF] = true,
+  [cmuClock_CORE] = true,
+  [cmuClock_HFPER] = true,
+};
+static EMU_EM4Init_TypeDef    em4_init = EMU_EM4INIT_DEFAULT;    // EM4 domain, kept
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static uint32_t sim_cmu_lf_freq(CMU_Select_TypeDef select);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Whether a peripheral's clock is actually reaching it
+ *
+ * @details
+ *   Besides its own gate, an HF peripheral needs HFPERCLK and an LF one needs
+ *   the CORELE interface clock and a running oscillator on its LF branch.
+ *
+ ******************************************************************************/
+
+bool sim_cmu_running(CMU_Clock_TypeDef clock){
+  if(!gate_on[clock]){
+      return false;
+  }
+  switch(clock){
+    case cmuClock_TIMER0:
+    case cmuClock_TIMER1:
+    case cmuClock_WTIMER0:
+    case cmuClock_I2C0:
+    case cmuClock_I2C1:
+      return gate_on[cmuClock_HFPER];
+    case cmuClock_LETIMER0:
+    case cmuClock_LEUART0:
+    case cmuClock_RTCC:
+      return gate_on[cmuClock_CORELE] && (CMU_ClockFreqGet(clock) != 0);
+    default:
+      return true;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Whether an oscillator is running
+ *
+ ******************************************************************************/
+
+bool sim_cmu_osc_on(CMU_Osc_TypeDef osc){
+  EFM_ASSERT(osc < SIM_CMU_OSCS);
+  return osc_on[osc];
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Whether EMU_EM4Init() keeps an LF oscillator running in EM4H
+ *
+ ******************************************************************************/
+
+bool sim_emu_em4_retains(CMU_Osc_TypeDef osc){
+  switch(osc){
+    case cmuOsc_LFXO:
+      return em4_init.retainLfxo;
+    case cmuOsc_LFRCO:
+      return em4_init.retainLfrco;
+    case cmuOsc_ULFRCO:
+      return em4_init.retainUlfrco;
+    default:
+      return false;
+  }
+}
+
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable){
+  EFM_ASSERT(clock < SIM_CMU_CLOCKS);
+  gate_on[clock] = enable;
+}
+
+uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock){
+  uint32_t hf_freq;
+
+  hf_freq = (hf_select == cmuSelect_HFXO) ? SIM_CMU_HFXO_FREQ : (uint32_t)hfrco_band;
+  switch(clock){
+    case cmuClock_LFA:
+    case cmuClock_LETIMER0:
+      return sim_cmu_lf_freq(lfa_select);
+    case cmuClock_LFB:
+    case cmuClock_LEUART0:
+      return sim_cmu_lf_freq(lfb_select);
+    case cmuClock_LFE:
+    case cmuClock_RTCC:
+      return sim_cmu_lf_freq(lfe_select);
+    default:
+      return hf_freq;
+  }
+}
+
+void CMU_ClockSelectSet(CMU_Clock_TypeDef clock, CMU_Select_TypeDef ref){
+  switch(clock){
+    case cmuClock_HF:
+      EFM_ASSERT((ref == cmuSelect_HFRCO) || (ref == cmuSelect_HFXO));
+      hf_select = ref;
+      break;
+    case cmuClock_LFA:
+      lfa_select = ref;
+      break;
+    case cmuClock_LFB:
+      lfb_select = ref;
+      break;
+    case cmuClock_LFE:
+      EFM_ASSERT((ref == cmuSelect_ULFRCO) || (ref == cmuSelect_LFXO) || (ref == cmuSelect_LFRCO));
+      lfe_select = ref;
+      break;
+    default:
+      EFM_ASSERT(false);
+      break;
+  }
+}
+
+CMU_Select_TypeDef CMU_ClockSelectGet(CMU_Clock_TypeDef clock){
+  switch(clock){
+    case cmuClock_HF:
+      return hf_select;
+    case cmuClock_LFA:
+      return lfa_select;
+    case cmuClock_LFB:
+      return lfb_select;
+    case cmuClock_LFE:
+      return lfe_select;
+    default:
+      return cmuSelect_Error;
+  }
+}
+
+void CMU_HFRCOBandSet(CMU_HFRCOFreq_TypeDef setFreq){
+  // Above 19 MHz the core needs the high performance EM01 voltage
+  if(setFreq > cmuHFRCOFreq_19M0Hz){
+      EFM_ASSERT(em01_vscale == emuVScaleEM01_HighPerformance);
+  }
+  hfrco_band = setFreq;
+}
+
+CMU_HFRCOFreq_TypeDef CMU_HFRCOBandGet(void){
+  return hfrco_band;
+}
+
+void CMU_OscillatorEnable(CMU_Osc_TypeDef osc, bool enable, bool wait){
+  (void)wait;
+  EFM_ASSERT(osc < SIM_CMU_OSCS);
+  if(osc == cmuOsc_ULFRCO){
+      return;
+  }
+  osc_on[osc] = enable;
+}
+
+void CMU_HFXOInit(const CMU_HFXOInit_TypeDef *hfxoInit){
+  (void)hfxoInit;
+}
+
+void EMU_EnterEM1(void){
+  sim_sleep(1);
+}
+
+void EMU_EnterEM2(bool restore){
+  (void)restore;
+  sim_sleep(2);
+}
+
+void EMU_EnterEM3(bool restore){
+  (void)restore;
+  sim_sleep(3);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Enters EM4H, the core only comes back through the wake-up reset
+ *
+ * @details
+ *   The RTCC is the one wake-up source modelled.  It has to keep counting,
+ *   so the oscillator on its LFE branch must be one EMU_EM4Init() retains.
+ *
+ ******************************************************************************/
+
+void EMU_EnterEM4H(void){
+  EFM_ASSERT(em4_init.em4State == emuEM4Hibernate);
+  switch(lfe_select){
+    case cmuSelect_ULFRCO:
+      EFM_ASSERT(em4_init.retainUlfrco);
+      break;
+    case cmuSelect_LFXO:
+      EFM_ASSERT(em4_init.retainLfxo);
+      break;
+    case cmuSelect_LFRCO:
+      EFM_ASSERT(em4_init.retainLfrco);
+      break;
+    default:
+      break;
+  }
+  sim_em4h();
+}
+
+void EMU_EM23Init(const EMU_EM23Init_TypeDef *em23Init){
+  (void)em23Init;
+}
+
+void EMU_EM4Init(const EMU_EM4Init_TypeDef *em4Init){
+  em4_init = *em4Init;
+}
+
+bool EMU_DCDCInit(const EMU_DCDCInit_TypeDef *dcdcInit){
+  (void)dcdcInit;
+  return true;
+}
+
+void EMU_VScaleEM01(EMU_VScaleEM01_TypeDef voltage, bool wait){
+  (void)wait;
+  // The low power voltage only supports the core up to 20 MHz
+  if(voltage == emuVScaleEM01_LowPower){
+      EFM_ASSERT(CMU_ClockFreqGet(cmuClock_HF) <= cmuHFRCOFreq_19M0Hz);
+  }
+  em01_vscale = voltage;
+}
+
+EMU_VScaleEM01_TypeDef EMU_VScaleGet(void){
+  return em01_vscale;
+}
+
+void CHIP_Init(void){
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Frequency of an LF branch, 0 while its oscillator is off
+ *
+ ******************************************************************************/
+
+static uint32_t sim_cmu_lf_freq(CMU_Select_TypeDef select){
+  switch(select){
+    case cmuSelect_ULFRCO:
+      return SIM_CMU_ULFRCO_FREQ;
+    case cmuSelect_LFXO:
+      return osc_on[cmuOsc_LFXO] ? SIM_CMU_LFXO_FREQ : 0;
+    case cmuSelect_LFRCO:
+      return osc_on[cmuOsc_LFRCO] ? SIM_CMU_LFRCO_FREQ : 0;
+    default:
+      return 0;
+  }
+}
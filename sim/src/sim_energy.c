@@ -0,0 +1,418 @@
+/**
+ * @file sim_energy.c
+ * @author Shambaditya Tarafder
+ * @date 12/7/2021
+ * @brief Energy model of the board.  Every load reports the current it draws
+ *        in its present state, the model integrates it over virtual time and
+ *        prints the average per subsystem and the battery life it gives.
+ *        The core's EM0 charge is also split by the code running and the
+ *        core clock it runs at.
+ *
+ *        Currents are typical datasheet figures at 3.0 V and room
+ *        temperature, good for comparing configurations.  Replace them with
+ *        power analyzer readings of the board for absolute numbers.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "em_assert.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_ENERGY_LOADS    24
+#define SIM_ENERGY_OWNERS   64      // Owners the EM0 core charge is split between
+#define SIM_ENERGY_BANDS    4       // Core clocks the split tells apart
+#define SIM_ENERGY_NAME     8
+
+// EFR32MG12, DCDC on, code from flash
+#define EM0_UA_PER_MHZ      70.0    // Core running, high performance EM01 voltage
+#define EM1_UA_PER_MHZ      35.0    // Core asleep, HF clocks running
+#define EM01_VSCALE_LOW     0.85    // Current factor of the low power EM01 voltage
+#define EM2_UA              2.5     // Full RAM retention, ULFRCO
+#define EM3_UA              2.1
+#define EM4H_UA             0.9
+
+// Peripherals on top of the energy mode current
+#define LFXO_UA             0.25
+#define LETIMER_UA          0.07
+#define LEUART_UA           0.15
+#define RTCC_UA             0.10
+#define HFPER_UA_PER_MHZ    1.0     // Each HF peripheral with its clock on, EM0 and EM1 only
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+typedef struct {
+  const char      *subsystem;
+  const char      *name;
+  SIM_ENERGY_FN   current;          // uA in the present state, NULL for charge only
+  void            *ctx;
+  double          charge;           // uA * ps
+} SIM_ENERGY_LOAD;
+
+typedef struct {
+  const char        *name;
+  CMU_Clock_TypeDef clock;
+  double            ua;             // LF: uA, HF: uA per MHz of HFPERCLK
+  uint32_t          run_em;         // Deepest energy mode its clock runs in
+} SIM_ENERGY_PERIPHERAL;
+
+static const double em_ua[] = { EM0_UA_PER_MHZ, EM1_UA_PER_MHZ, EM2_UA, EM3_UA, EM4H_UA };
+static const char *const em_names[] = { "EM0 core", "EM1", "EM2", "EM3", "EM4H" };
+
+static const SIM_ENERGY_PERIPHERAL lf_loads[] = {
+  { "LETIMER0", cmuClock_LETIMER0, LETIMER_UA, 3 },
+  { "LEUART0",  cmuClock_LEUART0,  LEUART_UA,  2 },
+  { "RTCC",     cmuClock_RTCC,     RTCC_UA,    4 },
+};
+
+static const SIM_ENERGY_PERIPHERAL hf_loads[] = {
+  { "TIMER0",  cmuClock_TIMER0,  HFPER_UA_PER_MHZ, 1 },
+  { "TIMER1",  cmuClock_TIMER1,  HFPER_UA_PER_MHZ, 1 },
+  { "WTIMER0", cmuClock_WTIMER0, HFPER_UA_PER_MHZ, 1 },
+  { "I2C0",    cmuClock_I2C0,    HFPER_UA_PER_MHZ, 1 },
+  { "I2C1",    cmuClock_I2C1,    HFPER_UA_PER_MHZ, 1 },
+  { "LDMA",    cmuClock_LDMA,    HFPER_UA_PER_MHZ, 1 },
+};
+
+static SIM_ENERGY_LOAD  loads[SIM_ENERGY_LOADS];
+static uint32_t         load_count;
+static uint64_t         energy_ps;
+static double           battery_mah;
+
+static SIM_ENERGY_OWNER_FN  owner_fn;
+static SIM_ENERGY_NAME_FN   owner_name;
+static uint32_t             owner_count;
+static uint32_t             band_hz[SIM_ENERGY_BANDS];     // In the order first seen
+static uint32_t             band_count;
+static double               owner_charge[SIM_ENERGY_OWNERS][SIM_ENERGY_BANDS];   // uA * ps
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static double sim_energy_hf_mhz(void);
+static double sim_energy_em(void *ctx);
+static double sim_energy_lfxo(void *ctx);
+static double sim_energy_lf(void *ctx);
+static double sim_energy_hf(void *ctx);
+static void sim_energy_split(uint64_t ps);
+static void sim_energy_report(void);
+static void sim_energy_owner_report(void);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Registers the MCU's own loads and, with a battery given, the report
+ *
+ * @param[in] mah
+ *   Battery capacity for the life estimate, 0 for no report
+ *
+ ******************************************************************************/
+
+void sim_energy_open(double mah){
+  for(uintptr_t em = 0; em < sizeof(em_ua) / sizeof(em_ua[0]); em++){
+      sim_energy_load("MCU", em_names[em], sim_energy_em, (void *)em);
+  }
+  sim_energy_load("LF", "LFXO", sim_energy_lfxo, NULL);
+  for(uint32_t i = 0; i < sizeof(lf_loads) / sizeof(lf_loads[0]); i++){
+      sim_energy_load("LF", lf_loads[i].name, sim_energy_lf, (void *)&lf_loads[i]);
+  }
+  for(uint32_t i = 0; i < sizeof(hf_loads) / sizeof(hf_loads[0]); i++){
+      sim_energy_load("HF", hf_loads[i].name, sim_energy_hf, (void *)&hf_loads[i]);
+  }
+  battery_mah = mah;
+  if(mah > 0){
+      atexit(sim_energy_report);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Adds a load to the model
+ *
+ * @param[in] subsystem
+ *   Group the load is reported under
+ *
+ * @param[in] current
+ *   Current the load draws in its present state in uA, NULL for a load that
+ *   is only charged with sim_energy_charge()
+ *
+ * @param[in] ctx
+ *   Handed to current
+ *
+ * @return
+ *   Handle for sim_energy_charge()
+ *
+ ******************************************************************************/
+
+uint32_t sim_energy_load(const char *subsystem, const char *name, SIM_ENERGY_FN current, void *ctx){
+  EFM_ASSERT(load_count < SIM_ENERGY_LOADS);
+  loads[load_count].subsystem = subsystem;
+  loads[load_count].name = name;
+  loads[load_count].current = current;
+  loads[load_count].ctx = ctx;
+  loads[load_count].charge = 0;
+  return load_count++;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Charges a load with a burst too short to model as a state, a radio
+ *   packet or a conversion
+ *
+ * @param[in] uc
+ *   Charge in uC
+ *
+ ******************************************************************************/
+
+void sim_energy_charge(uint32_t load, double uc){
+  EFM_ASSERT(load < load_count);
+  loads[load].charge += uc * SIM_PS_PER_S;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Integrates every load over the time about to pass
+ *
+ * @details
+ *   Called by the clock before it moves virtual time, so the loads are
+ *   sampled in the state they hold for the whole step.
+ *
+ ******************************************************************************/
+
+void sim_energy_run(uint64_t ps){
+  for(uint32_t i = 0; i < load_count; i++){
+      if(loads[i].current){
+          loads[i].charge += loads[i].current(loads[i].ctx) * (double)ps;
+      }
+  }
+  if(owner_fn && (sim_energy_mode() == 0)){
+      sim_energy_split(ps);
+  }
+  energy_ps += ps;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Splits the EM0 core charge between the owners of the firmware's
+ *   profiler, per core clock
+ *
+ * @details
+ *   The report then gives each handler's charge at each HF band the clock
+ *   scaling picked, in uC over the run.
+ *
+ * @param[in] count
+ *   Owners, up to SIM_ENERGY_OWNERS
+ *
+ * @param[in] owner
+ *   The owner running, sampled like the loads before each step
+ *
+ * @param[in] name
+ *   Short name of an owner for the report
+ *
+ ******************************************************************************/
+
+void sim_energy_owners(uint32_t count, SIM_ENERGY_OWNER_FN owner, SIM_ENERGY_NAME_FN name){
+  EFM_ASSERT(count <= SIM_ENERGY_OWNERS);
+  owner_count = count;
+  owner_fn = owner;
+  owner_name = name;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Effective core clock in MHz for the per MHz figures, with the EM01
+ *   voltage scaling folded in
+ *
+ ******************************************************************************/
+
+static double sim_energy_hf_mhz(void){
+  double mhz = CMU_ClockFreqGet(cmuClock_CORE) / 1e6;
+
+  return (EMU_VScaleGet() == emuVScaleEM01_LowPower) ? mhz * EM01_VSCALE_LOW : mhz;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The core and the clocks of one energy mode, ctx is the mode
+ *
+ ******************************************************************************/
+
+static double sim_energy_em(void *ctx){
+  uint32_t em = (uint32_t)(uintptr_t)ctx;
+
+  if(sim_energy_mode() != em){
+      return 0;
+  }
+  return (em <= 1) ? em_ua[em] * sim_energy_hf_mhz() : em_ua[em];
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The LFXO draws while it is on, in EM4H only if EMU_EM4Init() kept it
+ *
+ ******************************************************************************/
+
+static double sim_energy_lfxo(void *ctx){
+  (void)ctx;
+  if((sim_energy_mode() == 4) && !sim_emu_em4_retains(cmuOsc_LFXO)){
+      return 0;
+  }
+  return sim_cmu_osc_on(cmuOsc_LFXO) ? LFXO_UA : 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   An LF peripheral draws while its clock is on, in every energy mode it
+ *   runs in
+ *
+ ******************************************************************************/
+
+static double sim_energy_lf(void *ctx){
+  const SIM_ENERGY_PERIPHERAL *peripheral = ctx;
+
+  if(sim_energy_mode() > peripheral->run_em){
+      return 0;
+  }
+  return sim_cmu_running(peripheral->clock) ? peripheral->ua : 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   An HF peripheral draws while its clock is on and the HF clocks run
+ *
+ ******************************************************************************/
+
+static double sim_energy_hf(void *ctx){
+  const SIM_ENERGY_PERIPHERAL *peripheral = ctx;
+
+  if((sim_energy_mode() > peripheral->run_em) || !sim_cmu_running(peripheral->clock)){
+      return 0;
+  }
+  return peripheral->ua * CMU_ClockFreqGet(cmuClock_HFPER) / 1e6;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Charges the EM0 core current of the step to the running owner at the
+ *   present core clock
+ *
+ ******************************************************************************/
+
+static void sim_energy_split(uint64_t ps){
+  uint32_t hz = CMU_ClockFreqGet(cmuClock_CORE);
+  uint32_t owner = owner_fn();
+  uint32_t band = 0;
+
+  EFM_ASSERT(owner < owner_count);
+  while((band < band_count) && (band_hz[band] != hz)){
+      band++;
+  }
+  if(band == band_count){
+      EFM_ASSERT(band_count < SIM_ENERGY_BANDS);
+      band_hz[band_count++] = hz;
+  }
+  owner_charge[owner][band] += em_ua[0] * sim_energy_hf_mhz() * (double)ps;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Average current per load and subsystem and the battery life, printed
+ *   after the run report
+ *
+ ******************************************************************************/
+
+static void sim_energy_report(void){
+  double seconds = (double)energy_ps / SIM_PS_PER_S;
+  double total = 0;
+
+  if(!energy_ps){
+      return;
+  }
+  for(uint32_t i = 0; i < load_count; i++){
+      total += loads[i].charge;
+  }
+  total /= (double)energy_ps;
+  printf("  Energy    %.3f uA average over %.3f s, %.0f mAh lasts %.1f days\n",
+         total, seconds, battery_mah, (battery_mah * 1000.0 / total) / 24.0);
+  for(uint32_t i = 0; i < load_count; i++){
+      double sub = 0;
+      bool first = true;
+      for(uint32_t j = 0; j < i; j++){
+          first &= (loads[j].subsystem != loads[i].subsystem);
+      }
+      if(!first){
+          continue;
+      }
+      for(uint32_t j = i; j < load_count; j++){
+          if(loads[j].subsystem == loads[i].subsystem){
+              sub += loads[j].charge / (double)energy_ps;
+          }
+      }
+      printf("    %-8s %12.3f uA %6.2f%%\n", loads[i].subsystem, sub, 100.0 * sub / total);
+      for(uint32_t j = i; j < load_count; j++){
+          double avg = loads[j].charge / (double)energy_ps;
+          if((loads[j].subsystem == loads[i].subsystem) && (avg > 0)){
+              printf("      %-10s %10.3f uA %6.2f%%\n", loads[j].name, avg, 100.0 * avg / total);
+          }
+      }
+  }
+  sim_energy_owner_report();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   EM0 core charge per owner and core clock, slowest clock first, owners
+ *   that never ran left out
+ *
+ ******************************************************************************/
+
+static void sim_energy_owner_report(void){
+  uint32_t order[SIM_ENERGY_BANDS];
+  char name[SIM_ENERGY_NAME];
+
+  if(!owner_fn || !band_count){
+      return;
+  }
+  for(uint32_t i = 0; i < band_count; i++){
+      uint32_t j = i;
+      for(; (j > 0) && (band_hz[order[j - 1]] > band_hz[i]); j--){
+          order[j] = order[j - 1];
+      }
+      order[j] = i;
+  }
+  printf("    %-8s EM0 core uC per core clock\n", "Handlers");
+  printf("      %-6s", "owner");
+  for(uint32_t i = 0; i < band_count; i++){
+      printf(" %7.1f MHz", band_hz[order[i]] / 1e6);
+  }
+  printf("\n");
+  for(uint32_t owner = 0; owner < owner_count; owner++){
+      double sum = 0;
+      for(uint32_t i = 0; i < band_count; i++){
+          sum += owner_charge[owner][i];
+      }
+      if(sum <= 0){
+          continue;
+      }
+      owner_name(owner, name, sizeof(name));
+      printf("      %-6s", name);
+      for(uint32_t i = 0; i < band_count; i++){
+          printf(" %11.3f", owner_charge[owner][order[i]] / SIM_PS_PER_S);
+      }
+      printf("\n");
+  }
+}
@@ -0,0 +1,90 @@
+/**
+ * @file sim_gpio.c
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Simulated GPIO.  Pin modes and output levels are kept per port, the
+ *        pins read back what was driven.  Every level change goes to the
+ *        waveform.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#define SIM_MODEL_SOURCE
+#include "sim.h"
+#include "em_assert.h"
+#include "em_gpio.h"
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+GPIO_TypeDef sim_gpio SIM_EM4_RESET;
+
+static uint8_t pin_mode[GPIO_PORT_MAX + 1][GPIO_PIN_MAX + 1] SIM_EM4_RESET;
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, GPIO_Mode_TypeDef mode, unsigned int out){
+  EFM_ASSERT((port <= GPIO_PORT_MAX) && (pin <= GPIO_PIN_MAX));
+  EFM_ASSERT(sim_cmu_running(cmuClock_GPIO));
+  pin_mode[port][pin] = (uint8_t)mode;
+  if(out){
+      GPIO_PinOutSet(port, pin);
+  } else {
+      GPIO_PinOutClear(port, pin);
+  }
+}
+
+void GPIO_DriveStrengthSet(GPIO_Port_TypeDef port, GPIO_DriveStrength_TypeDef strength){
+  EFM_ASSERT(port <= GPIO_PORT_MAX);
+  sim_gpio.P[port].CTRL = strength;
+}
+
+void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin){
+  GPIO_PortOutSet(port, 0x01UL << pin);
+}
+
+void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin){
+  GPIO_PortOutClear(port, 0x01UL << pin);
+}
+
+void GPIO_PinOutToggle(GPIO_Port_TypeDef port, unsigned int pin){
+  GPIO_PortOutSetVal(port, ~GPIO_PortOutGet(port), 0x01UL << pin);
+}
+
+unsigned int GPIO_PinOutGet(GPIO_Port_TypeDef port, unsigned int pin){
+  return (GPIO_PortOutGet(port) >> pin) & 0x01;
+}
+
+unsigned int GPIO_PinInGet(GPIO_Port_TypeDef port, unsigned int pin){
+  EFM_ASSERT(port <= GPIO_PORT_MAX);
+  return (sim_gpio.P[port].DIN >> pin) & 0x01;
+}
+
+void GPIO_PortOutSet(GPIO_Port_TypeDef port, uint32_t pins){
+  GPIO_PortOutSetVal(port, pins, pins);
+}
+
+void GPIO_PortOutClear(GPIO_Port_TypeDef port, uint32_t pins){
+  GPIO_PortOutSetVal(port, 0, pins);
+}
+
+void GPIO_PortOutSetVal(GPIO_Port_TypeDef port, uint32_t val, uint32_t mask){
+  uint32_t changed;
+
+  EFM_ASSERT(port <= GPIO_PORT_MAX);
+  changed = (sim_gpio.P[port].DOUT ^ val) & mask;
+  for(uint32_t pin = 0; changed >> pin; pin++){
+      if((changed >> pin) & 0x01){
+          sim_vcd_change(SIM_VCD_GPIO + port * (GPIO_PIN_MAX + 1) + pin, sim_now(), (val >> pin) & 0x01);
+      }
+  }
+  sim_gpio.P[port].DOUT = (sim_gpio.P[port].DOUT & ~mask) | (val & mask);
+  sim_gpio.P[port].DIN = sim_gpio.P[port].DOUT;
+}
+
+uint32_t GPIO_PortOutGet(GPIO_Port_TypeDef port){
+  EFM_ASSERT(port <= GPIO_PORT_MAX);
+  return sim_gpio.P[port].DOUT;
+}
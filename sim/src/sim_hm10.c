@@ -0,0 +1,600 @@
+/**
+ * @file sim_hm10.c
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Simulated HM10 BLE module on the LEUART.  Speaks the AT command set
+ *        while advertising, reports OK+CONN and OK+LOST, and while connected
+ *        carries the UART data to a central in 20 byte notifications sent at
+ *        the connection events.  The central is either scripted from the
+ *        command line or a pseudo-terminal another program can open.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#undef CTRL                         // termios.h macro, the register name is needed below
+#include "sim.h"
+#include "em_assert.h"
+#include "em_leuart.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HM10_NAME_DEFAULT   "HMSoft"
+#define HM10_NAME_MAX       12
+#define HM10_CMD_MAX        32
+#define HM10_CMD_GAP        (10 * SIM_PS_PER_MS)    // UART idle time that ends a command
+#define HM10_BOOT_TIME      (500 * SIM_PS_PER_MS)   // AT+RESET until the module answers again
+#define HM10_CONNECT_TIME   (100 * SIM_PS_PER_MS)   // Advertising until a waiting central connects
+#define HM10_CONN_INTERVAL  (30 * SIM_PS_PER_MS)    // Connection interval
+#define HM10_PACKET_BYTES   20      // Notification payload with the default ATT MTU
+#define HM10_EVENT_PACKETS  4       // Notifications per connection event
+#define HM10_QUEUE_BYTES    512     // UART data waiting for a connection event
+#define HM10_WRITE_BYTES    128     // Scripted central data waiting for a connection event
+#define HM10_BAUD_TOLERANCE 2       // Percent baud error the UART still receives
+#define HM10_BAUD_DEFAULT   0
+#define HM10_AWAKE_UA       8500.0  // CC2541 module with AT+PWRM sleep off, any state
+#define HM10_PACKET_UC      7.5     // Extra charge of sending one notification
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+typedef enum {
+  HM10_ADVERTISING,
+  HM10_CONNECTED,
+  HM10_BOOTING
+} HM10_STATE;
+
+typedef struct {
+  uint8_t   data;
+  uint64_t  arrived;                // Stop bit of the byte at the module
+} HM10_BYTE;
+
+static const uint32_t hm10_bauds[] = {
+  9600, 19200, 38400, 57600, 115200, 4800, 2400, 1200, 230400
+};
+
+static LEUART_TypeDef *hm10_leuart;
+static HM10_STATE      hm10_state;
+static char            hm10_name[HM10_NAME_MAX + 1] = HM10_NAME_DEFAULT;
+static uint32_t        hm10_baud = HM10_BAUD_DEFAULT;
+static uint32_t        hm10_baud_next = HM10_BAUD_DEFAULT;  // AT+BAUD applies at the next boot
+static bool            hm10_central;    // A central wants to be connected
+static uint32_t        hm10_link;       // Bumped on every connect, stales old connection events
+
+static char            hm10_cmd[HM10_CMD_MAX + 1];
+static uint32_t        hm10_cmd_len;
+static uint64_t        hm10_cmd_end;
+static bool            hm10_cmd_timer;
+static bool            hm10_baud_warned;
+
+static HM10_BYTE       hm10_queue[HM10_QUEUE_BYTES];
+static uint32_t        hm10_queue_head;
+static uint32_t        hm10_queue_count;
+static uint64_t        hm10_uart_free;  // When the module's TX line to the LEUART is idle
+
+static char            hm10_write[HM10_WRITE_BYTES];
+static uint32_t        hm10_write_len;
+static uint64_t        hm10_write_every;
+
+static int             hm10_pty = -1;
+static struct timespec hm10_wall_start;
+static uint32_t        hm10_load;       // sim_energy_load() handle
+
+static uint64_t        stat_bytes_up;
+static uint64_t        stat_bytes_down;
+static uint64_t        stat_delivered;
+static uint64_t        stat_packets;
+static uint64_t        stat_dropped;
+static uint64_t        stat_latency_sum;
+static uint64_t        stat_latency_max;
+static uint64_t        stat_connected_ps;
+static uint64_t        stat_connected_at;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static bool sim_hm10_baud_ok(void);
+static void sim_hm10_escape(char *text, size_t size, const char *data, uint32_t len);
+static void sim_hm10_reply(const char *reply);
+static void sim_hm10_rx(uint8_t byte);
+static void sim_hm10_command(void *arg);
+static void sim_hm10_execute(void);
+static void sim_hm10_connect(void *arg);
+static void sim_hm10_link_up(void *arg);
+static void sim_hm10_disconnect(void *arg);
+static void sim_hm10_lost(void);
+static void sim_hm10_booted(void *arg);
+static void sim_hm10_conn_event(void *arg);
+static void sim_hm10_central_write(void *arg);
+static void sim_hm10_central_rx(void);
+static void sim_hm10_pace(void);
+static void sim_hm10_pty_open(void);
+static double sim_hm10_current(void *ctx);
+static void sim_hm10_report(void);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Connects the HM10 to a LEUART and schedules the central
+ *
+ * @details
+ *   The module powers up advertising at the baud rate saved with AT+BAUD,
+ *   HM10_BAUD_DEFAULT unless open->baud says otherwise.  A central that
+ *   is due at connect_at finds it HM10_CONNECT_TIME after it starts to
+ *   advertise, and drops the link at disconnect_at.  A central due at 0 is
+ *   already connected when the firmware starts, its OK+CONN went out while
+ *   the MCU was still in reset.  At write_at the central writes write_text,
+ *   which reaches the LEUART from the following connection events, and
+ *   again every write_every if it is set.
+ *
+ ******************************************************************************/
+
+void sim_hm10_open(LEUART_TypeDef *leuart, const SIM_HM10_OPEN *open){
+  hm10_leuart = leuart;
+  hm10_state = HM10_ADVERTISING;
+  for(uint32_t i = 0; open->baud && (i < sizeof(hm10_bauds) / sizeof(hm10_bauds[0])); i++){
+      if(hm10_bauds[i] == open->baud){
+          hm10_baud = hm10_baud_next = i;
+      }
+  }
+  EFM_ASSERT(!open->baud || (hm10_bauds[hm10_baud] == open->baud));
+  hm10_load = sim_energy_load("Radio", "HM10", sim_hm10_current, NULL);
+  sim_leuart_attach(leuart, sim_hm10_rx);
+  if(open->connect_at == 0){
+      hm10_central = true;
+      hm10_state = HM10_CONNECTED;
+      hm10_link++;
+      sim_event_at(HM10_CONN_INTERVAL, sim_hm10_conn_event, (void *)(uintptr_t)hm10_link);
+  } else if(open->connect_at != SIM_NEVER){
+      sim_event_at(open->connect_at, sim_hm10_connect, NULL);
+  }
+  if(open->disconnect_at != SIM_NEVER){
+      sim_event_at(open->disconnect_at, sim_hm10_disconnect, NULL);
+  }
+  hm10_write_every = open->write_every;
+  if(open->write_at != SIM_NEVER){
+      sim_event_at(open->write_at, sim_hm10_central_write, (void *)open->write_text);
+  }
+  if(open->pty){
+      sim_hm10_pty_open();
+  }
+  atexit(sim_hm10_report);
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Whether the LEUART and the module agree on the baud rate
+ *
+ * @details
+ *   Frames between mismatched UARTs come out as garbage, the model drops
+ *   them and says so once per mismatch.
+ *
+ ******************************************************************************/
+
+static bool sim_hm10_baud_ok(void){
+  uint32_t leuart_baud = LEUART_BaudrateGet(hm10_leuart);
+  uint32_t module_baud = hm10_bauds[hm10_baud];
+  uint32_t error = (leuart_baud > module_baud) ? leuart_baud - module_baud : module_baud - leuart_baud;
+
+  if((100 * error) <= (HM10_BAUD_TOLERANCE * module_baud)){
+      hm10_baud_warned = false;
+      return true;
+  }
+  if(!hm10_baud_warned){
+      sim_log("HM10 baud mismatch, LEUART at %lu, module at %lu", (unsigned long)leuart_baud,
+              (unsigned long)module_baud);
+      hm10_baud_warned = true;
+  }
+  stat_dropped++;
+  return false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Printable copy of UART data for the log, C escapes for the rest
+ *
+ ******************************************************************************/
+
+static void sim_hm10_escape(char *text, size_t size, const char *data, uint32_t len){
+  size_t pos = 0;
+
+  text[0] = '\0';
+  for(uint32_t i = 0; (i < len) && (pos + 5 < size); i++){
+      uint8_t c = (uint8_t)data[i];
+      pos += (size_t)snprintf(text + pos, size - pos,
+                              ((c >= ' ') && (c < 0x7F) && (c != '"')) ? "%c" : "\\x%02x", c);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sends a response or notification to the LEUART
+ *
+ ******************************************************************************/
+
+static void sim_hm10_reply(const char *reply){
+  if(!sim_hm10_baud_ok()){
+      return;
+  }
+  sim_log("HM10 -> LEUART \"%s\"", reply);
+  while(*reply){
+      sim_leuart_send(hm10_leuart, (uint8_t)*reply++);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   A byte from the LEUART reached the module
+ *
+ * @details
+ *   Every burst is collected as a possible AT command and examined once the
+ *   line has been idle for HM10_CMD_GAP, the HM10 has no command terminator.
+ *   While connected the bytes are also queued for the central.
+ *
+ ******************************************************************************/
+
+static void sim_hm10_rx(uint8_t byte){
+  if((hm10_state == HM10_BOOTING) || !sim_hm10_baud_ok()){
+      return;
+  }
+  if(hm10_cmd_len < HM10_CMD_MAX){
+      hm10_cmd[hm10_cmd_len++] = (char)byte;
+  }
+  hm10_cmd_end = sim_now() + HM10_CMD_GAP;
+  if(!hm10_cmd_timer){
+      hm10_cmd_timer = true;
+      sim_event_at(hm10_cmd_end, sim_hm10_command, NULL);
+  }
+  if(hm10_state == HM10_CONNECTED){
+      if(hm10_queue_count == HM10_QUEUE_BYTES){
+          stat_dropped++;
+          return;
+      }
+      hm10_queue[(hm10_queue_head + hm10_queue_count) % HM10_QUEUE_BYTES] =
+          (HM10_BYTE){ byte, sim_now() };
+      hm10_queue_count++;
+      stat_bytes_up++;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   End of the command gap timer, runs the burst once the line stayed idle
+ *
+ ******************************************************************************/
+
+static void sim_hm10_command(void *arg){
+  (void)arg;
+
+  if(sim_now() < hm10_cmd_end){
+      sim_event_at(hm10_cmd_end, sim_hm10_command, NULL);
+      return;
+  }
+  hm10_cmd_timer = false;
+  hm10_cmd[hm10_cmd_len] = '\0';
+  if(hm10_state != HM10_BOOTING){
+      sim_hm10_execute();
+  }
+  hm10_cmd_len = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Interprets a burst from the LEUART as an AT command
+ *
+ * @details
+ *   While connected only a bare "AT" is a command, it drops the link.
+ *   Everything else is data for the central.
+ *
+ ******************************************************************************/
+
+static void sim_hm10_execute(void){
+  char reply[(4 * HM10_CMD_MAX) + 1];
+  const char *cmd = hm10_cmd;
+
+  if(hm10_state == HM10_CONNECTED){
+      if(!strcmp(cmd, "AT")){
+          hm10_central = false;
+          sim_hm10_lost();
+      }
+      return;
+  }
+  if(!strcmp(cmd, "AT")){
+      sim_hm10_reply("OK");
+  } else if(!strcmp(cmd, "AT+NAME?")){
+      snprintf(reply, sizeof(reply), "OK+NAME:%s", hm10_name);
+      sim_hm10_reply(reply);
+  } else if(!strncmp(cmd, "AT+NAME", 7) && (strlen(cmd + 7) > 0) && (strlen(cmd + 7) <= HM10_NAME_MAX)){
+      strcpy(hm10_name, cmd + 7);
+      snprintf(reply, sizeof(reply), "OK+Set:%s", hm10_name);
+      sim_hm10_reply(reply);
+  } else if(!strcmp(cmd, "AT+BAUD?")){
+      snprintf(reply, sizeof(reply), "OK+Get:%lu", (unsigned long)hm10_baud_next);
+      sim_hm10_reply(reply);
+  } else if(!strncmp(cmd, "AT+BAUD", 7) && (strlen(cmd) == 8)
+            && ((uint32_t)(cmd[7] - '0') < (sizeof(hm10_bauds) / sizeof(hm10_bauds[0])))){
+      hm10_baud_next = (uint32_t)(cmd[7] - '0');
+      snprintf(reply, sizeof(reply), "OK+Set:%c", cmd[7]);
+      sim_hm10_reply(reply);
+  } else if(!strcmp(cmd, "AT+RESET")){
+      sim_hm10_reply("OK+RESET");
+      hm10_state = HM10_BOOTING;
+      sim_event_at(sim_now() + HM10_BOOT_TIME, sim_hm10_booted, NULL);
+  } else {
+      sim_hm10_escape(reply, sizeof(reply), cmd, hm10_cmd_len);
+      sim_log("HM10 ignored \"%s\"", reply);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The scripted central wants the link up, it connects once it has seen the
+ *   module advertise
+ *
+ ******************************************************************************/
+
+static void sim_hm10_connect(void *arg){
+  (void)arg;
+
+  hm10_central = true;
+  if(hm10_state == HM10_ADVERTISING){
+      sim_event_at(sim_now() + HM10_CONNECT_TIME, sim_hm10_link_up, NULL);
+  }
+}
+
+static void sim_hm10_link_up(void *arg){
+  (void)arg;
+
+  if(!hm10_central || (hm10_state != HM10_ADVERTISING)){
+      return;
+  }
+  hm10_state = HM10_CONNECTED;
+  hm10_link++;
+  stat_connected_at = sim_now();
+  sim_hm10_reply("OK+CONN");
+  sim_event_at(sim_now() + HM10_CONN_INTERVAL, sim_hm10_conn_event, (void *)(uintptr_t)hm10_link);
+}
+
+static void sim_hm10_disconnect(void *arg){
+  (void)arg;
+
+  hm10_central = false;
+  if(hm10_state == HM10_CONNECTED){
+      sim_hm10_lost();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The link went down, queued data is lost with it
+ *
+ ******************************************************************************/
+
+static void sim_hm10_lost(void){
+  hm10_state = HM10_ADVERTISING;
+  stat_connected_ps += sim_now() - stat_connected_at;
+  stat_dropped += hm10_queue_count;
+  hm10_queue_count = 0;
+  sim_hm10_reply("OK+LOST");
+}
+
+static void sim_hm10_booted(void *arg){
+  (void)arg;
+
+  hm10_state = HM10_ADVERTISING;
+  hm10_baud = hm10_baud_next;
+  hm10_cmd_len = 0;
+  sim_log("HM10 booted, %lu baud, name %s", (unsigned long)hm10_bauds[hm10_baud], hm10_name);
+  if(hm10_central){
+      sim_event_at(sim_now() + HM10_CONNECT_TIME, sim_hm10_link_up, NULL);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Connection event, the link's only chance to move data
+ *
+ * @details
+ *   Up to HM10_EVENT_PACKETS notifications of HM10_PACKET_BYTES go to the
+ *   central, each byte's latency counted from its stop bit at the module.
+ *   Then whatever the central wrote is taken for the UART.
+ *
+ * @param[in] arg
+ *   Link the event belongs to, events of a dropped link stop here
+ *
+ ******************************************************************************/
+
+static void sim_hm10_conn_event(void *arg){
+  if((hm10_state != HM10_CONNECTED) || ((uint32_t)(uintptr_t)arg != hm10_link)){
+      return;
+  }
+  for(uint32_t packet = 0; (packet < HM10_EVENT_PACKETS) && hm10_queue_count; packet++){
+      char payload[HM10_PACKET_BYTES];
+      char text[(4 * HM10_PACKET_BYTES) + 1];
+      uint32_t len = 0;
+      while((len < HM10_PACKET_BYTES) && hm10_queue_count){
+          HM10_BYTE *b = &hm10_queue[hm10_queue_head];
+          uint64_t latency = sim_now() - b->arrived;
+          stat_latency_sum += latency;
+          stat_latency_max = (latency > stat_latency_max) ? latency : stat_latency_max;
+          payload[len++] = (char)b->data;
+          hm10_queue_head = (hm10_queue_head + 1) % HM10_QUEUE_BYTES;
+          hm10_queue_count--;
+      }
+      sim_hm10_escape(text, sizeof(text), payload, len);
+      stat_packets++;
+      sim_energy_charge(hm10_load, HM10_PACKET_UC);
+      stat_delivered += len;
+      sim_log("HM10 -> central %2lu bytes \"%s\"", (unsigned long)len, text);
+      if((hm10_pty >= 0) && (write(hm10_pty, payload, len) < 0) && (errno != EAGAIN)){
+          hm10_pty = -1;
+      }
+  }
+  sim_hm10_central_rx();
+  sim_hm10_pace();
+  sim_event_at(sim_now() + HM10_CONN_INTERVAL, sim_hm10_conn_event, arg);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The scripted central writes its text, dropped if the link is not up
+ *
+ ******************************************************************************/
+
+static void sim_hm10_central_write(void *arg){
+  const char *text = arg;
+  size_t len = strlen(text);
+
+  if(hm10_write_every){
+      sim_event_at(sim_now() + hm10_write_every, sim_hm10_central_write, arg);
+  }
+  if(hm10_state != HM10_CONNECTED){
+      sim_log("HM10 central write \"%s\" with no link", text);
+      stat_dropped += len;
+      return;
+  }
+  if(len > HM10_WRITE_BYTES - hm10_write_len){
+      len = HM10_WRITE_BYTES - hm10_write_len;
+  }
+  memcpy(&hm10_write[hm10_write_len], text, len);
+  hm10_write_len += (uint32_t)len;
+  sim_log("HM10 <- central %2lu bytes \"%s\"", (unsigned long)len, text);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes what the central wrote, scripted or on the pty, as much as the
+ *   module's UART can send before the next connection event
+ *
+ ******************************************************************************/
+
+static void sim_hm10_central_rx(void){
+  uint8_t data[HM10_EVENT_PACKETS * HM10_PACKET_BYTES];
+  uint64_t frame = (10 * SIM_PS_PER_S) / hm10_bauds[hm10_baud];
+  uint64_t room;
+  ssize_t len;
+
+  if((hm10_pty < 0) && !hm10_write_len){
+      return;
+  }
+  if(hm10_uart_free < sim_now()){
+      hm10_uart_free = sim_now();
+  }
+  room = (sim_now() + HM10_CONN_INTERVAL > hm10_uart_free) ?
+         (sim_now() + HM10_CONN_INTERVAL - hm10_uart_free) / frame : 0;
+  if(room > sizeof(data)){
+      room = sizeof(data);
+  }
+  if(!room){
+      return;
+  }
+  if(hm10_write_len){
+      len = (ssize_t)((hm10_write_len < room) ? hm10_write_len : room);
+      memcpy(data, hm10_write, (size_t)len);
+      hm10_write_len -= (uint32_t)len;
+      memmove(hm10_write, &hm10_write[len], hm10_write_len);
+  } else if((len = read(hm10_pty, data, room)) <= 0){
+      return;
+  }
+  stat_bytes_down += (uint64_t)len;
+  hm10_uart_free += (uint64_t)len * frame;
+  if(!sim_hm10_baud_ok()){
+      return;
+  }
+  for(ssize_t i = 0; i < len; i++){
+      sim_leuart_send(hm10_leuart, data[i]);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Holds virtual time to the wall clock while a pty central is attached,
+ *   so a person or program on the other end can keep up
+ *
+ ******************************************************************************/
+
+static void sim_hm10_pace(void){
+  struct timespec wall;
+  int64_t ahead_us;
+
+  if(hm10_pty < 0){
+      return;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &wall);
+  ahead_us = (int64_t)(sim_now() / SIM_PS_PER_US)
+             - ((wall.tv_sec - hm10_wall_start.tv_sec) * 1000000LL)
+             - ((wall.tv_nsec - hm10_wall_start.tv_nsec) / 1000);
+  if(ahead_us > 0){
+      usleep((useconds_t)ahead_us);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Opens the pseudo-terminal the central talks through
+ *
+ ******************************************************************************/
+
+static void sim_hm10_pty_open(void){
+  struct termios raw;
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+  EFM_ASSERT(fd >= 0);
+  EFM_ASSERT(!grantpt(fd) && !unlockpt(fd));
+  EFM_ASSERT(!tcgetattr(fd, &raw));
+  cfmakeraw(&raw);
+  tcsetattr(fd, TCSANOW, &raw);
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  hm10_pty = fd;
+  clock_gettime(CLOCK_MONOTONIC, &hm10_wall_start);
+  printf("HM10 central on %s, running in real time\n", ptsname(fd));
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Link statistics for the end of run report
+ *
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *   Supply current for the energy model, the notifications are charged as
+ *   they go out
+ *
+ ******************************************************************************/
+
+static double sim_hm10_current(void *ctx){
+  (void)ctx;
+  return HM10_AWAKE_UA;
+}
+
+static void sim_hm10_report(void){
+  uint64_t connected = stat_connected_ps
+                       + ((hm10_state == HM10_CONNECTED) ? sim_now() - stat_connected_at : 0);
+  printf("  HM10      %lu bytes in %lu notifications, %lu bytes from the central, %lu dropped\n",
+         (unsigned long)stat_delivered, (unsigned long)stat_packets, (unsigned long)stat_bytes_down,
+         (unsigned long)stat_dropped);
+  if(stat_delivered && connected){
+      printf("  HM10      %.1f bytes/s connected, latency avg %.3f ms max %.3f ms\n",
+             (double)stat_delivered * SIM_PS_PER_S / connected,
+             (double)stat_latency_sum / stat_delivered / SIM_PS_PER_MS,
+             (double)stat_latency_max / SIM_PS_PER_MS);
+  }
+  fflush(stdout);
+}
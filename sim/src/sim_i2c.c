@@ -0,0 +1,574 @@
+/**
+ * @file sim_i2c.c
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Simulated I2C0 and I2C1 in master mode.  START, address, data and
+ *        STOP each take their bit times at the SCL rate set by CLKDIV, and the
+ *        attached slaves answer with ACK or NACK and may stretch the clock.
+ *        An address nobody answers to is NACKed as on an empty bus.  Each
+ *        operation is drawn on SCL and SDA in the waveform once it is done.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#define SIM_MODEL_SOURCE
+#include "sim.h"
+#include "em_assert.h"
+#include "em_i2c.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define I2C_RUN_EM          1       // HFPERCLK stops in EM2
+#define I2C_MAX_SLAVES      4
+#define I2C_ADDR_BITS       10      // START, 7 address bits, R/W and ACK
+#define I2C_BYTE_BITS       9       // 8 data bits and ACK
+#define I2C_STOP_BITS       1
+#define I2C_RESET_BITS      2       // START immediately followed by STOP
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+typedef enum {
+  I2C_OP_NONE,
+  I2C_OP_ADDR,
+  I2C_OP_WRITE,
+  I2C_OP_READ,
+  I2C_OP_STOP,
+} SIM_I2C_OP;
+
+typedef struct {
+  I2C_TypeDef           *regs;
+  CMU_Clock_TypeDef     clock;
+  const SIM_I2C_SLAVE   *slaves[I2C_MAX_SLAVES];
+  uint32_t              slave_count;
+  const SIM_I2C_SLAVE   *addressed;     // Slave that ACKed the last address
+  bool                  busy;           // Bus owned between START and STOP
+  bool                  transmitter;
+  bool                  nacked;
+  bool                  start_pending;
+  bool                  stop_pending;
+  bool                  ack_wait;       // Byte received, waiting for ACK or NACK
+  bool                  stretched;      // The operation already waited for the slave
+  bool                  tx_full;
+  uint8_t               tx_buf;
+  bool                  rx_valid;
+  uint8_t               rx_buf;
+  bool                  rx_pop;
+  SIM_I2C_OP            op;             // Bus operation in progress
+  uint8_t               op_byte;
+  uint32_t              op_bits;
+  uint64_t              op_start;
+  uint64_t              op_done;
+  uint64_t              last;
+  uint32_t              wave;           // Waveform signal of SCL, SDA follows
+} SIM_I2C;
+
+I2C_TypeDef sim_i2c0 SIM_EM4_RESET = { .TXDATA_ = { SIM_TXDATA_EMPTY }, .IF_ = { I2C_IF_TXBL } };
+I2C_TypeDef sim_i2c1 SIM_EM4_RESET = { .TXDATA_ = { SIM_TXDATA_EMPTY }, .IF_ = { I2C_IF_TXBL } };
+
+static SIM_I2C i2c0 SIM_EM4_RESET = { .regs = &sim_i2c0, .clock = cmuClock_I2C0, .wave = SIM_VCD_I2C0_SCL };
+static SIM_I2C i2c1 SIM_EM4_RESET = { .regs = &sim_i2c1, .clock = cmuClock_I2C1, .wave = SIM_VCD_I2C1_SCL };
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static SIM_I2C *sim_i2c_get(I2C_TypeDef *i2c);
+static bool sim_i2c_clocked(SIM_I2C *bus);
+static uint64_t sim_i2c_bits_ps(SIM_I2C *bus, uint32_t bits);
+static void sim_i2c_begin(SIM_I2C *bus, SIM_I2C_OP op, uint32_t bits, uint64_t when);
+static void sim_i2c_kick(SIM_I2C *bus, uint64_t when);
+static const SIM_I2C_SLAVE *sim_i2c_slave(SIM_I2C *bus);
+static void sim_i2c_complete(SIM_I2C *bus);
+static void sim_i2c_abort(SIM_I2C *bus);
+static void sim_i2c_wave(SIM_I2C *bus, SIM_I2C_OP op, uint32_t bits, uint64_t start, uint64_t done,
+                         uint8_t byte, bool ack);
+static void sim_i2c_wave_bit(SIM_I2C *bus, uint64_t when, uint64_t bit_ps, uint32_t sda);
+static void sim_i2c_sync(void *ctx, uint64_t now);
+static uint64_t sim_i2c_next(void *ctx);
+static bool sim_i2c_rx_valid(void *ctx);
+static void sim_i2c_rx_consume(void *ctx);
+
+const SIM_MODEL sim_i2c0_model = {
+  "I2C0", &i2c0, I2C0_IRQn, &sim_i2c0.IF_[0], &sim_i2c0.IEN_[0],
+  sim_i2c_sync, sim_i2c_next, sim_i2c_rx_valid, sim_i2c_rx_consume
+};
+
+const SIM_MODEL sim_i2c1_model = {
+  "I2C1", &i2c1, I2C1_IRQn, &sim_i2c1.IF_[0], &sim_i2c1.IEN_[0],
+  sim_i2c_sync, sim_i2c_next, sim_i2c_rx_valid, sim_i2c_rx_consume
+};
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Puts a slave device on the bus
+ *
+ ******************************************************************************/
+
+void sim_i2c_attach(I2C_TypeDef *i2c, const SIM_I2C_SLAVE *slave){
+  SIM_I2C *bus = sim_i2c_get(i2c);
+
+  EFM_ASSERT(bus->slave_count < I2C_MAX_SLAVES);
+  bus->slaves[bus->slave_count++] = slave;
+}
+
+void I2C_Init(I2C_TypeDef *i2c, const I2C_Init_TypeDef *init){
+  sim_sync();
+  i2c->IEN = 0;
+  i2c->IFC = _I2C_IFC_MASK;
+  sim_sync();
+  i2c->CTRL = init->master ? 0 : I2C_CTRL_SLAVE;
+  I2C_BusFreqSet(i2c, init->refFreq, init->freq, init->clhr);
+  I2C_Enable(i2c, init->enable);
+}
+
+void I2C_Enable(I2C_TypeDef *i2c, bool enable){
+  sim_sync();
+  if(enable){
+      i2c->CTRL |= I2C_CTRL_EN;
+  } else {
+      i2c->CTRL &= ~I2C_CTRL_EN;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Same CLKDIV calculation and limits as emlib
+ *
+ * @details
+ *   In master mode the reference must stay above the minimum emlib asserts
+ *   on for the given clock ratio, 2, 9 or 20 MHz for the standard, asymmetric
+ *   and fast ratios.
+ *
+ ******************************************************************************/
+
+void I2C_BusFreqSet(I2C_TypeDef *i2c, uint32_t freqRef, uint32_t freqScl, I2C_ClockHLR_TypeDef i2cMode){
+  uint32_t n, minFreq;
+  int32_t div;
+
+  if(!freqScl){
+      return;
+  }
+  if(!freqRef){
+      freqRef = CMU_ClockFreqGet(sim_i2c_get(i2c)->clock);
+  }
+  switch(i2cMode){
+    case i2cClockHLRAsymetric:
+      n = 6 + 3;
+      minFreq = 9000000;
+      break;
+    case i2cClockHLRFast:
+      n = 11 + 6;
+      minFreq = 20000000;
+      break;
+    default:
+      n = 4 + 4;
+      minFreq = 2000000;
+      break;
+  }
+  if(!(i2c->CTRL & I2C_CTRL_SLAVE)){
+      EFM_ASSERT(freqRef > minFreq);
+  }
+  div = (int32_t)(((freqRef - (I2C_CR_MAX * freqScl)) / (n * freqScl)) - 1);
+  EFM_ASSERT(div >= 0);
+  EFM_ASSERT((uint32_t)div <= _I2C_CLKDIV_DIV_MASK);
+  i2c->CTRL = (i2c->CTRL & ~_I2C_CTRL_CLHR_MASK) | ((uint32_t)i2cMode << _I2C_CTRL_CLHR_SHIFT);
+  i2c->CLKDIV = (uint32_t)div;
+}
+
+uint32_t I2C_BusFreqGet(I2C_TypeDef *i2c){
+  uint64_t bit_ps = sim_i2c_bits_ps(sim_i2c_get(i2c), 1);
+  return (uint32_t)(SIM_PS_PER_S / bit_ps);
+}
+
+void I2C_IntClear(I2C_TypeDef *i2c, uint32_t flags){
+  sim_sync();
+  i2c->IFC = flags;
+}
+
+void I2C_IntEnable(I2C_TypeDef *i2c, uint32_t flags){
+  sim_sync();
+  i2c->IEN |= flags;
+}
+
+void I2C_IntDisable(I2C_TypeDef *i2c, uint32_t flags){
+  sim_sync();
+  i2c->IEN &= ~flags;
+}
+
+uint32_t I2C_IntGet(I2C_TypeDef *i2c){
+  sim_sync();
+  return i2c->IF;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Model behind an I2C register block
+ *
+ ******************************************************************************/
+
+static SIM_I2C *sim_i2c_get(I2C_TypeDef *i2c){
+  if(i2c == I2C0){
+      return &i2c0;
+  }
+  EFM_ASSERT(i2c == I2C1);
+  return &i2c1;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Whether the bus runs at all in the present clock and energy state
+ *
+ ******************************************************************************/
+
+static bool sim_i2c_clocked(SIM_I2C *bus){
+  return sim_cmu_running(bus->clock) && (sim_energy_mode() <= I2C_RUN_EM)
+         && (bus->regs->CTRL & I2C_CTRL_EN);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Time of a number of SCL periods
+ *
+ * @details
+ *   One period is ((Nlow + Nhigh) * (DIV + 1) + I2C_CR_MAX) reference cycles,
+ *   the inverse of the emlib CLKDIV calculation.
+ *
+ ******************************************************************************/
+
+static uint64_t sim_i2c_bits_ps(SIM_I2C *bus, uint32_t bits){
+  static const uint32_t clhr_n[] = { 4 + 4, 6 + 3, 11 + 6, 11 + 6 };
+  I2C_TypeDef *regs = bus->regs;
+  uint32_t ref = CMU_ClockFreqGet(bus->clock);
+  uint64_t cycles;
+
+  cycles = (uint64_t)clhr_n[(regs->CTRL & _I2C_CTRL_CLHR_MASK) >> _I2C_CTRL_CLHR_SHIFT]
+           * ((regs->CLKDIV & _I2C_CLKDIV_DIV_MASK) + 1) + I2C_CR_MAX;
+  return (bits * cycles * SIM_PS_PER_S) / ref;
+}
+
+static void sim_i2c_begin(SIM_I2C *bus, SIM_I2C_OP op, uint32_t bits, uint64_t when){
+  bus->op = op;
+  bus->op_bits = bits;
+  bus->op_start = when;
+  bus->op_done = when + sim_i2c_bits_ps(bus, bits);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Starts the next bus operation the commands and buffers call for
+ *
+ * @details
+ *   A START goes out once there is an address in TXDATA, a START and STOP
+ *   with nothing to send is a bare START/STOP condition.  While the bus is
+ *   owned a transmitter sends TXDATA, a receiver waits for ACK or NACK of the
+ *   last byte, and a pending STOP is sent once there is nothing else to do.
+ *
+ ******************************************************************************/
+
+static void sim_i2c_kick(SIM_I2C *bus, uint64_t when){
+  if((bus->op != I2C_OP_NONE) || !(bus->regs->CTRL & I2C_CTRL_EN)){
+      return;
+  }
+  if(bus->start_pending && bus->tx_full){
+      bus->start_pending = false;
+      bus->busy = true;
+      bus->op_byte = bus->tx_buf;
+      bus->tx_full = false;
+      sim_i2c_begin(bus, I2C_OP_ADDR, I2C_ADDR_BITS, when);
+  } else if(bus->start_pending && bus->stop_pending && !bus->busy){
+      bus->start_pending = false;
+      bus->busy = true;
+      sim_i2c_begin(bus, I2C_OP_STOP, I2C_RESET_BITS, when);
+  } else if(bus->busy && bus->ack_wait){
+      return;
+  } else if(bus->busy && bus->transmitter && bus->tx_full && !bus->nacked){
+      bus->op_byte = bus->tx_buf;
+      bus->tx_full = false;
+      sim_i2c_begin(bus, I2C_OP_WRITE, I2C_BYTE_BITS, when);
+  } else if(bus->busy && bus->stop_pending){
+      sim_i2c_begin(bus, I2C_OP_STOP, I2C_STOP_BITS, when);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Slave the operation in progress talks to, NULL if nobody answers
+ *
+ ******************************************************************************/
+
+static const SIM_I2C_SLAVE *sim_i2c_slave(SIM_I2C *bus){
+  if(bus->op != I2C_OP_ADDR){
+      return bus->addressed;
+  }
+  for(uint32_t i = 0; i < bus->slave_count; i++){
+      if(bus->slaves[i]->address == (bus->op_byte >> 1)){
+          return bus->slaves[i];
+      }
+  }
+  return NULL;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The bus operation in progress reached its end
+ *
+ * @details
+ *   A slave that stretches the clock holds SCL low before the ACK bit, the
+ *   operation completes once it lets go.
+ *
+ ******************************************************************************/
+
+static void sim_i2c_complete(SIM_I2C *bus){
+  I2C_TypeDef *regs = bus->regs;
+  const SIM_I2C_SLAVE *slave = sim_i2c_slave(bus);
+  SIM_I2C_OP op = bus->op;
+  uint32_t bits = bus->op_bits;
+  uint64_t start = bus->op_start;
+  uint64_t done = bus->op_done;
+  bool ack = false;
+
+  if(!bus->stretched && (op != I2C_OP_STOP) && slave && slave->stretch){
+      uint64_t hold = slave->stretch();
+      if(hold){
+          bus->stretched = true;
+          bus->op_done += hold;
+          return;
+      }
+  }
+  bus->stretched = false;
+  bus->op = I2C_OP_NONE;
+  switch(op){
+    case I2C_OP_ADDR:
+      bus->addressed = slave;
+      bus->transmitter = !(bus->op_byte & 0x01);
+      if(bus->addressed){
+          ack = bus->addressed->start(!bus->transmitter);
+      }
+      bus->nacked = !ack;
+      regs->IF |= ack ? I2C_IF_ACK : I2C_IF_NACK;
+      if(ack && !bus->transmitter){
+          sim_i2c_begin(bus, I2C_OP_READ, I2C_BYTE_BITS - 1, bus->op_done);
+      }
+      break;
+    case I2C_OP_WRITE:
+      ack = bus->addressed && bus->addressed->write(bus->op_byte);
+      bus->nacked = !ack;
+      regs->IF |= ack ? I2C_IF_ACK : I2C_IF_NACK;
+      break;
+    case I2C_OP_READ:
+      bus->rx_buf = bus->addressed ? bus->addressed->read() : 0xFF;
+      bus->rx_valid = true;
+      bus->ack_wait = true;
+      break;
+    case I2C_OP_STOP:
+      if(bus->addressed){
+          bus->addressed->stop();
+      }
+      bus->addressed = NULL;
+      bus->busy = false;
+      bus->nacked = false;
+      bus->stop_pending = false;
+      regs->IF |= I2C_IF_MSTOP;
+      break;
+    default:
+      break;
+  }
+  sim_i2c_wave(bus, op, bits, start, done, (op == I2C_OP_READ) ? bus->rx_buf : bus->op_byte, ack);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   ABORT, the bus is released on the spot without a STOP condition
+ *
+ ******************************************************************************/
+
+static void sim_i2c_abort(SIM_I2C *bus){
+  if(bus->addressed){
+      bus->addressed->stop();
+  }
+  bus->addressed = NULL;
+  bus->op = I2C_OP_NONE;
+  bus->stretched = false;
+  bus->busy = false;
+  bus->nacked = false;
+  bus->start_pending = false;
+  bus->stop_pending = false;
+  bus->ack_wait = false;
+  sim_vcd_change(bus->wave, sim_now(), 1);
+  sim_vcd_change(bus->wave + 1, sim_now(), 1);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Draws a finished bus operation on SCL and SDA
+ *
+ * @details
+ *   The bits are spread evenly from the start of the operation, the ACK of
+ *   an address or a write ends with it so a stretched clock shows as SCL
+ *   held low ahead of the ACK.  A read after an ACK starts with that ACK,
+ *   the NACK of the last byte read goes out with the STOP.
+ *
+ ******************************************************************************/
+
+static void sim_i2c_wave(SIM_I2C *bus, SIM_I2C_OP op, uint32_t bits, uint64_t start, uint64_t done,
+                         uint8_t byte, bool ack){
+  uint64_t bit_ps = sim_i2c_bits_ps(bus, 1);
+  uint64_t when = start;
+  uint32_t scl = bus->wave;
+  uint32_t sda = bus->wave + 1;
+
+  if((op == I2C_OP_ADDR) || ((op == I2C_OP_STOP) && (bits == I2C_RESET_BITS))){
+      // START, also a repeated one: SDA falls while SCL is high
+      sim_vcd_change(sda, when, 1);
+      sim_vcd_change(scl, when + bit_ps / 4, 1);
+      sim_vcd_change(sda, when + bit_ps / 2, 0);
+      sim_vcd_change(scl, when + bit_ps, 0);
+      when += bit_ps;
+  }
+  if((op == I2C_OP_READ) && (bits == I2C_BYTE_BITS)){
+      sim_i2c_wave_bit(bus, when, bit_ps, 0);
+      when += bit_ps;
+  }
+  if((op == I2C_OP_ADDR) || (op == I2C_OP_WRITE) || (op == I2C_OP_READ)){
+      for(int32_t i = 7; i >= 0; i--){
+          sim_i2c_wave_bit(bus, when, bit_ps, (byte >> i) & 0x01);
+          when += bit_ps;
+      }
+  }
+  if((op == I2C_OP_ADDR) || (op == I2C_OP_WRITE)){
+      sim_i2c_wave_bit(bus, (done - bit_ps > when) ? done - bit_ps : when, bit_ps, !ack);
+  }
+  if(op == I2C_OP_STOP){
+      // STOP: SDA rises while SCL is high
+      sim_vcd_change(sda, when, 0);
+      sim_vcd_change(scl, when + bit_ps / 4, 1);
+      sim_vcd_change(sda, when + bit_ps / 2, 1);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   One clock of the bus, SDA set while SCL is low
+ *
+ ******************************************************************************/
+
+static void sim_i2c_wave_bit(SIM_I2C *bus, uint64_t when, uint64_t bit_ps, uint32_t sda){
+  sim_vcd_change(bus->wave, when, 0);
+  sim_vcd_change(bus->wave + 1, when, sda);
+  sim_vcd_change(bus->wave, when + bit_ps / 2, 1);
+  sim_vcd_change(bus->wave, when + bit_ps, 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes the register writes since the last sync and runs the bus up to now
+ *
+ ******************************************************************************/
+
+static void sim_i2c_sync(void *ctx, uint64_t now){
+  SIM_I2C *bus = ctx;
+  I2C_TypeDef *regs = bus->regs;
+  uint32_t cmd = regs->CMD;
+  uint32_t state;
+
+  if(bus->rx_pop){
+      bus->rx_pop = false;
+      bus->rx_valid = false;
+  }
+  if(cmd & I2C_CMD_ABORT){
+      sim_i2c_abort(bus);
+  }
+  if(cmd & I2C_CMD_CLEARTX){
+      bus->tx_full = false;
+  }
+  if(regs->TXDATA != SIM_TXDATA_EMPTY){
+      bus->tx_buf = (uint8_t)regs->TXDATA;
+      bus->tx_full = true;
+      regs->TXDATA = SIM_TXDATA_EMPTY;
+  }
+  if(cmd & I2C_CMD_START){
+      bus->start_pending = true;
+  }
+  if(cmd & I2C_CMD_STOP){
+      bus->stop_pending = true;
+  }
+  if(bus->ack_wait && (cmd & I2C_CMD_ACK)){
+      bus->ack_wait = false;
+      sim_i2c_begin(bus, I2C_OP_READ, I2C_BYTE_BITS, bus->last);
+  }
+  if(bus->ack_wait && (cmd & I2C_CMD_NACK)){
+      bus->ack_wait = false;
+  }
+  regs->CMD = 0;
+  regs->IF |= regs->IFS & _I2C_IFC_MASK;
+  regs->IF &= ~(regs->IFC & _I2C_IFC_MASK);
+  regs->IFS = 0;
+  regs->IFC = 0;
+
+  if(sim_i2c_clocked(bus)){
+      sim_i2c_kick(bus, bus->last);
+      while((bus->op != I2C_OP_NONE) && (bus->op_done <= now)){
+          uint64_t done = bus->op_done;
+          sim_i2c_complete(bus);
+          if(bus->op == I2C_OP_NONE){
+              sim_i2c_kick(bus, done);
+          }
+      }
+  } else if(bus->op != I2C_OP_NONE){
+      bus->op_done += now - bus->last;
+  }
+
+  state = bus->busy ? (I2C_STATE_BUSY | I2C_STATE_MASTER) : 0;
+  state |= (bus->busy && bus->transmitter) ? I2C_STATE_TRANSMITTER : 0;
+  state |= bus->nacked ? I2C_STATE_NACKED : 0;
+  if(!bus->busy){
+      state |= I2C_STATE_STATE_IDLE;
+  } else if(bus->op == I2C_OP_ADDR){
+      state |= I2C_STATE_STATE_ADDR;
+  } else if(bus->op != I2C_OP_NONE){
+      state |= I2C_STATE_STATE_DATA;
+  } else {
+      state |= I2C_STATE_STATE_WAIT;
+  }
+  regs->STATE = state;
+  regs->IF = (regs->IF & ~(I2C_IF_TXBL | I2C_IF_RXDATAV))
+             | (bus->tx_full ? 0 : I2C_IF_TXBL)
+             | (bus->rx_valid ? I2C_IF_RXDATAV : 0);
+  regs->STATUS = (bus->tx_full ? 0 : I2C_STATUS_TXBL) | (bus->rx_valid ? I2C_STATUS_RXDATAV : 0);
+  regs->RXDATA = bus->rx_buf;
+  bus->last = now;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   End of the bus operation in progress
+ *
+ ******************************************************************************/
+
+static uint64_t sim_i2c_next(void *ctx){
+  SIM_I2C *bus = ctx;
+
+  if((bus->op == I2C_OP_NONE) || !sim_i2c_clocked(bus)){
+      return SIM_NEVER;
+  }
+  return bus->op_done;
+}
+
+static bool sim_i2c_rx_valid(void *ctx){
+  SIM_I2C *bus = ctx;
+  return bus->rx_valid;
+}
+
+static void sim_i2c_rx_consume(void *ctx){
+  SIM_I2C *bus = ctx;
+  bus->rx_pop = true;
+}
@@ -0,0 +1,259 @@
+/**
+ * @file sim_ldma.c
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Simulated LDMA.  Transfer descriptors are walked in host memory, one
+ *        block per peripheral request, including linked and self-linked
+ *        descriptors.  Transfers take no time.  The requests are levels held
+ *        by the peripheral, which asks again for as long as it holds one.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#define SIM_MODEL_SOURCE
+#include <string.h>
+#include "sim.h"
+#include "em_assert.h"
+#include "em_ldma.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define LDMA_RUN_EM         1       // HFCLK stops in EM2
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+typedef struct {
+  bool                    active;
+  uint32_t                signal;
+  const LDMA_Descriptor_t *desc;
+  uint32_t                src;
+  uint32_t                dst;
+  uint32_t                remaining;    // Units left in the descriptor
+  uint32_t                served;       // Requests taken since LDMA_Init()
+} SIM_LDMA_CH;
+
+LDMA_TypeDef sim_ldma SIM_EM4_RESET;
+
+static SIM_LDMA_CH ldma_ch[LDMA_CH_NUM] SIM_EM4_RESET;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static void sim_ldma_load(SIM_LDMA_CH *ch, const LDMA_Descriptor_t *desc);
+static uint32_t sim_ldma_block(const LDMA_Descriptor_t *desc);
+static void sim_ldma_unit(SIM_LDMA_CH *ch);
+static void sim_ldma_sync(void *ctx, uint64_t now);
+static uint64_t sim_ldma_next(void *ctx);
+
+const SIM_MODEL sim_ldma_model = {
+  "LDMA", NULL, LDMA_IRQn, &sim_ldma.IF_[0], &sim_ldma.IEN_[0],
+  sim_ldma_sync, sim_ldma_next, NULL, NULL
+};
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   A peripheral's DMA request is up
+ *
+ * @details
+ *   Every active channel selecting the signal moves one block, or the whole
+ *   descriptor in ldmaCtrlReqModeAll, as long as the LDMA is clocked.  A
+ *   request that is still up afterwards is the peripheral's to make again.
+ *
+ * @return
+ *   true if a channel took the request
+ *
+ ******************************************************************************/
+
+bool sim_ldma_request(uint32_t signal){
+  bool taken = false;
+
+  if(!sim_cmu_running(cmuClock_LDMA) || (sim_energy_mode() > LDMA_RUN_EM)){
+      return false;
+  }
+  for(uint32_t n = 0; n < LDMA_CH_NUM; n++){
+      SIM_LDMA_CH *ch = &ldma_ch[n];
+      uint32_t units;
+      if(!ch->active || (ch->signal != signal)){
+          continue;
+      }
+      taken = true;
+      ch->served++;
+      units = (ch->desc->xfer.reqMode == ldmaCtrlReqModeAll) ? ch->remaining : sim_ldma_block(ch->desc);
+      while(ch->active && units--){
+          sim_ldma_unit(ch);
+          if(!ch->remaining){
+              const LDMA_Descriptor_t *desc = ch->desc;
+              sim_ldma.CHDONE |= (0x01UL << n);
+              if(desc->xfer.doneIfs){
+                  sim_ldma.IF |= (0x01UL << n);
+              }
+              if(desc->xfer.link){
+                  uintptr_t base = (desc->xfer.linkMode == ldmaLinkModeRel) ? (uintptr_t)desc : 0;
+                  sim_ldma_load(ch, (const LDMA_Descriptor_t *)(base + ((intptr_t)desc->xfer.linkAddr * 4)));
+              } else {
+                  ch->active = false;
+                  sim_ldma.CHEN &= ~(0x01UL << n);
+                  sim_ldma.CHBUSY &= ~(0x01UL << n);
+              }
+              break;
+          }
+      }
+  }
+  return taken;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Requests a channel has taken since LDMA_Init(), for the checks
+ *
+ ******************************************************************************/
+
+uint32_t sim_ldma_served(int ch){
+  EFM_ASSERT((ch >= 0) && (ch < LDMA_CH_NUM));
+  return ldma_ch[ch].served;
+}
+
+void LDMA_Init(const LDMA_Init_t *init){
+  (void)init;
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  memset(ldma_ch, 0, sizeof(ldma_ch));
+  sim_sync();
+  sim_ldma.CHEN = 0;
+  sim_ldma.CHBUSY = 0;
+  sim_ldma.CHDONE = 0;
+  sim_ldma.IEN = 0;
+  sim_ldma.IFC = 0xFFFFFFFFUL;
+  NVIC_EnableIRQ(LDMA_IRQn);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Loads a descriptor on a channel
+ *
+ * @details
+ *   The firmware hands over 32 bit addresses, which on the host only holds
+ *   for a binary linked below 4 GB, hence -no-pie in the Makefile.
+ *
+ ******************************************************************************/
+
+void LDMA_StartTransfer(int ch, const LDMA_TransferCfg_t *transfer, const LDMA_Descriptor_t *descriptor){
+  EFM_ASSERT((ch >= 0) && (ch < LDMA_CH_NUM));
+  EFM_ASSERT((uintptr_t)descriptor <= UINT32_MAX);
+  EFM_ASSERT(descriptor->xfer.structType == ldmaCtrlStructTypeXfer);
+  sim_sync();
+  ldma_ch[ch].signal = transfer->ldmaReqSel;
+  sim_ldma_load(&ldma_ch[ch], descriptor);
+  sim_ldma.CHDONE &= ~(0x01UL << ch);
+  sim_ldma.CHEN |= (0x01UL << ch);
+  sim_ldma.CHBUSY |= (0x01UL << ch);
+}
+
+void LDMA_StopTransfer(int ch){
+  EFM_ASSERT((ch >= 0) && (ch < LDMA_CH_NUM));
+  sim_sync();
+  ldma_ch[ch].active = false;
+  sim_ldma.CHEN &= ~(0x01UL << ch);
+  sim_ldma.CHBUSY &= ~(0x01UL << ch);
+}
+
+bool LDMA_TransferDone(int ch){
+  EFM_ASSERT((ch >= 0) && (ch < LDMA_CH_NUM));
+  sim_sync();
+  return (sim_ldma.CHDONE >> ch) & 0x01;
+}
+
+void LDMA_IntClear(uint32_t flags){
+  sim_sync();
+  sim_ldma.IFC = flags;
+}
+
+void LDMA_IntEnable(uint32_t flags){
+  sim_sync();
+  sim_ldma.IEN |= flags;
+}
+
+void LDMA_IntDisable(uint32_t flags){
+  sim_sync();
+  sim_ldma.IEN &= ~flags;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static void sim_ldma_load(SIM_LDMA_CH *ch, const LDMA_Descriptor_t *desc){
+  ch->desc = desc;
+  ch->src = desc->xfer.srcAddr;
+  ch->dst = desc->xfer.dstAddr;
+  ch->remaining = desc->xfer.xferCnt + 1;
+  ch->active = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Units per block for a descriptor's blockSize field
+ *
+ ******************************************************************************/
+
+static uint32_t sim_ldma_block(const LDMA_Descriptor_t *desc){
+  static const uint32_t units[] = { 1, 2, 3, 4, 6, 8, 8, 16, 16, 32, 64, 128, 256, 512, 1024, 0 };
+  uint32_t block = units[desc->xfer.blockSize];
+
+  return block ? block : desc->xfer.xferCnt + 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Moves one unit of a byte, half word or word
+ *
+ ******************************************************************************/
+
+static void sim_ldma_unit(SIM_LDMA_CH *ch){
+  static const uint32_t inc_units[] = { 1, 2, 4, 0 };
+  const LDMA_Descriptor_t *desc = ch->desc;
+  uint32_t size = 1UL << desc->xfer.size;
+  void *dst = (void *)(uintptr_t)ch->dst;
+  const void *src = (const void *)(uintptr_t)ch->src;
+
+  switch(size){
+    case 1:
+      *(volatile uint8_t *)dst = *(const volatile uint8_t *)src;
+      break;
+    case 2:
+      *(volatile uint16_t *)dst = *(const volatile uint16_t *)src;
+      break;
+    default:
+      *(volatile uint32_t *)dst = *(const volatile uint32_t *)src;
+      break;
+  }
+  ch->src += inc_units[desc->xfer.srcInc] * size;
+  ch->dst += inc_units[desc->xfer.dstInc] * size;
+  ch->remaining--;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes the flag writes since the last sync, the transfers themselves run
+ *   from sim_ldma_request()
+ *
+ ******************************************************************************/
+
+static void sim_ldma_sync(void *ctx, uint64_t now){
+  (void)ctx;
+  (void)now;
+  sim_ldma.IF |= sim_ldma.IFS;
+  sim_ldma.IF &= ~sim_ldma.IFC;
+  sim_ldma.IFS = 0;
+  sim_ldma.IFC = 0;
+}
+
+static uint64_t sim_ldma_next(void *ctx){
+  (void)ctx;
+  return SIM_NEVER;
+}
@@ -0,0 +1,378 @@
+/**
+ * @file sim_letimer.c
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Simulated LETIMER0.  Counts down on every LFA clock tick, reloads
+ *        from COMP0 on underflow and raises the COMP0, COMP1 and UF flags.
+ *        A command only takes effect SIM_LF_SYNC_TICKS after it is written,
+ *        with SYNCBUSY showing it until then.  This part's LETIMER has no
+ *        FREEZE, every other register is written straight through.  In a
+ *        replay the flags come from the recording instead of the count.
+ *        The two outputs follow UFOA0 and UFOA1 into the waveform.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#define SIM_MODEL_SOURCE
+#include "sim.h"
+#include "em_assert.h"
+#include "em_letimer.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define LETIMER_MAX_CNT     0xFFFF
+#define LETIMER_RUN_EM      3       // ULFRCO and LFXO both run down to EM3
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+typedef struct {
+  LETIMER_TypeDef   *regs;
+  bool              running;
+  uint32_t          cnt;            // CNT as last published to the register
+  uint64_t          last_tick;      // Virtual time of the last counted tick
+  uint32_t          cmd;            // Command written and not synchronized yet
+  uint64_t          cmd_done;       // When it lands
+  uint64_t          last;           // Virtual time of the last sync
+  bool              out[2];         // Levels of the outputs
+} SIM_LETIMER;
+
+LETIMER_TypeDef sim_letimer0 SIM_EM4_RESET;
+
+static SIM_LETIMER letimer0 SIM_EM4_RESET = { .regs = &sim_letimer0, .cmd_done = SIM_NEVER };
+static bool replayed;               // Flags from sim_letimer_raise() only
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static uint64_t sim_letimer_tick_ps(void);
+static bool sim_letimer_clocked(void);
+static void sim_letimer_tick(SIM_LETIMER *timer);
+static void sim_letimer_output(SIM_LETIMER *timer, uint32_t n, uint32_t flags);
+static void sim_letimer_command(SIM_LETIMER *timer);
+static void sim_letimer_run(SIM_LETIMER *timer, uint64_t until);
+static void sim_letimer_sync(void *ctx, uint64_t now);
+static uint64_t sim_letimer_next(void *ctx);
+
+const SIM_MODEL sim_letimer0_model = {
+  "LETIMER0", &letimer0, LETIMER0_IRQn, &sim_letimer0.IF_[0], &sim_letimer0.IEN_[0],
+  sim_letimer_sync, sim_letimer_next, NULL, NULL
+};
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+void LETIMER_Init(LETIMER_TypeDef *letimer, const LETIMER_Init_TypeDef *init){
+  uint32_t ctrl = 0;
+
+  EFM_ASSERT(letimer == LETIMER0);
+  sim_sync();
+  if(!init->enable && (letimer->STATUS & LETIMER_STATUS_RUNNING)){
+      letimer->CMD = LETIMER_CMD_STOP;
+      sim_sync();
+  }
+  ctrl |= init->debugRun ? LETIMER_CTRL_DEBUGRUN : 0;
+  if(init->comp0Top || init->topValue){
+      ctrl |= LETIMER_CTRL_COMP0TOP;
+      if(init->topValue){
+          letimer->COMP0 = init->topValue;
+      }
+  }
+  ctrl |= init->bufTop ? LETIMER_CTRL_BUFTOP : 0;
+  ctrl |= init->out0Pol ? LETIMER_CTRL_OPOL0 : 0;
+  ctrl |= init->out1Pol ? LETIMER_CTRL_OPOL1 : 0;
+  ctrl |= (uint32_t)init->ufoa0 << _LETIMER_CTRL_UFOA0_SHIFT;
+  ctrl |= (uint32_t)init->ufoa1 << _LETIMER_CTRL_UFOA1_SHIFT;
+  ctrl |= (uint32_t)init->repMode << _LETIMER_CTRL_REPMODE_SHIFT;
+  letimer->CTRL = ctrl;
+  if(init->enable && !(letimer->STATUS & LETIMER_STATUS_RUNNING)){
+      letimer->CMD = LETIMER_CMD_START;
+  }
+}
+
+void LETIMER_Enable(LETIMER_TypeDef *letimer, bool enable){
+  sim_sync();
+  letimer->CMD = enable ? LETIMER_CMD_START : LETIMER_CMD_STOP;
+}
+
+void LETIMER_CompareSet(LETIMER_TypeDef *letimer, unsigned int comp, uint32_t value){
+  EFM_ASSERT(comp <= 1);
+  sim_sync();
+  if(comp == 0){
+      letimer->COMP0 = value & LETIMER_MAX_CNT;
+  } else {
+      letimer->COMP1 = value & LETIMER_MAX_CNT;
+  }
+}
+
+uint32_t LETIMER_CompareGet(LETIMER_TypeDef *letimer, unsigned int comp){
+  EFM_ASSERT(comp <= 1);
+  return comp ? letimer->COMP1 : letimer->COMP0;
+}
+
+uint32_t LETIMER_CounterGet(LETIMER_TypeDef *letimer){
+  sim_sync();
+  return letimer->CNT;
+}
+
+void LETIMER_RepeatSet(LETIMER_TypeDef *letimer, unsigned int rep, uint32_t value){
+  EFM_ASSERT(rep <= 1);
+  if(rep == 0){
+      letimer->REP0 = value;
+  } else {
+      letimer->REP1 = value;
+  }
+}
+
+void LETIMER_IntClear(LETIMER_TypeDef *letimer, uint32_t flags){
+  sim_sync();
+  letimer->IFC = flags;
+}
+
+void LETIMER_IntEnable(LETIMER_TypeDef *letimer, uint32_t flags){
+  sim_sync();
+  letimer->IEN |= flags;
+}
+
+void LETIMER_IntDisable(LETIMER_TypeDef *letimer, uint32_t flags){
+  sim_sync();
+  letimer->IEN &= ~flags;
+}
+
+uint32_t LETIMER_IntGet(LETIMER_TypeDef *letimer){
+  sim_sync();
+  return letimer->IF;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stops the count from raising the COMP0, COMP1 and UF flags, a replay
+ *   raises the ones the hardware did at the times it did
+ *
+ ******************************************************************************/
+
+void sim_letimer_replay(void){
+  replayed = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sets interrupt flags of LETIMER0 from a replay
+ *
+ ******************************************************************************/
+
+void sim_letimer_raise(uint32_t flags){
+  sim_letimer0.IF |= flags & _LETIMER_IF_MASK;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Picoseconds per LFA clock tick
+ *
+ ******************************************************************************/
+
+static uint64_t sim_letimer_tick_ps(void){
+  return SIM_PS_PER_S / CMU_ClockFreqGet(cmuClock_LETIMER0);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Whether the LETIMER counts at all in the present clock and energy state
+ *
+ ******************************************************************************/
+
+static bool sim_letimer_clocked(void){
+  return sim_cmu_running(cmuClock_LETIMER0) && (sim_energy_mode() <= LETIMER_RUN_EM);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   One LFA clock tick of a running LETIMER
+ *
+ ******************************************************************************/
+
+static void sim_letimer_tick(SIM_LETIMER *timer){
+  LETIMER_TypeDef *regs = timer->regs;
+  uint32_t flags = 0;
+
+  if(timer->cnt == 0){
+      flags |= LETIMER_IF_UF;
+      timer->cnt = (regs->CTRL & LETIMER_CTRL_COMP0TOP) ? regs->COMP0 : LETIMER_MAX_CNT;
+      if(((regs->CTRL & _LETIMER_CTRL_REPMODE_MASK) >> _LETIMER_CTRL_REPMODE_SHIFT) == letimerRepeatOneshot){
+          timer->running = false;
+      }
+  } else {
+      timer->cnt--;
+  }
+  if(timer->cnt == regs->COMP0){
+      flags |= LETIMER_IF_COMP0;
+  }
+  if(timer->cnt == regs->COMP1){
+      flags |= LETIMER_IF_COMP1;
+  }
+  if(!replayed){
+      regs->IF |= flags;
+  }
+  sim_letimer_output(timer, 0, flags);
+  sim_letimer_output(timer, 1, flags);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Level of output n after a tick
+ *
+ * @details
+ *   OPOLn is the idle level.  Toggle changes it on every underflow, pulse is
+ *   active for the tick after one, PWM goes active on a COMP1 match and idle
+ *   on underflow.
+ *
+ ******************************************************************************/
+
+static void sim_letimer_output(SIM_LETIMER *timer, uint32_t n, uint32_t flags){
+  uint32_t ctrl = timer->regs->CTRL;
+  uint32_t ufoa = (ctrl >> (n ? _LETIMER_CTRL_UFOA1_SHIFT : _LETIMER_CTRL_UFOA0_SHIFT)) & 0x3;
+  bool idle = ctrl & (n ? LETIMER_CTRL_OPOL1 : LETIMER_CTRL_OPOL0);
+  bool out = timer->out[n];
+
+  switch(ufoa){
+    case letimerUFOAToggle:
+      out = (flags & LETIMER_IF_UF) ? !out : out;
+      break;
+    case letimerUFOAPulse:
+      out = (flags & LETIMER_IF_UF) ? !idle : idle;
+      break;
+    case letimerUFOAPwm:
+      if(flags & LETIMER_IF_UF){
+          out = idle;
+      } else if(flags & LETIMER_IF_COMP1){
+          out = !idle;
+      }
+      break;
+    default:
+      out = idle;
+      break;
+  }
+  if(out != timer->out[n]){
+      timer->out[n] = out;
+      sim_vcd_change(SIM_VCD_LETIMER0_OUT0 + n, timer->last_tick, out);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The command under synchronization reaches the LF domain
+ *
+ ******************************************************************************/
+
+static void sim_letimer_command(SIM_LETIMER *timer){
+  if(timer->cmd & LETIMER_CMD_START){
+      if(!timer->running){
+          timer->last_tick = timer->last;
+      }
+      timer->running = true;
+  }
+  if(timer->cmd & LETIMER_CMD_STOP){
+      timer->running = false;
+  }
+  if(timer->cmd & LETIMER_CMD_CLEAR){
+      timer->cnt = 0;
+  }
+  timer->cmd = 0;
+  timer->cmd_done = SIM_NEVER;
+  timer->regs->SYNCBUSY = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Counts the ticks from the last sync up to until
+ *
+ ******************************************************************************/
+
+static void sim_letimer_run(SIM_LETIMER *timer, uint64_t until){
+  if(sim_letimer_clocked()){
+      uint64_t tick_ps = sim_letimer_tick_ps();
+      while(timer->running && (timer->last_tick + tick_ps <= until)){
+          timer->last_tick += tick_ps;
+          sim_letimer_tick(timer);
+      }
+      if(!timer->running){
+          timer->last_tick = until;
+      }
+  } else {
+      // A command in synchronization waits for the clock to come back
+      if(timer->cmd_done != SIM_NEVER){
+          timer->cmd_done += until - timer->last;
+      }
+      timer->last_tick = until;
+  }
+  timer->last = until;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes the register writes since the last sync and counts the ticks up to
+ *   now
+ *
+ * @details
+ *   Writing CMD again before the last command landed is a firmware bug.
+ *
+ ******************************************************************************/
+
+static void sim_letimer_sync(void *ctx, uint64_t now){
+  SIM_LETIMER *timer = ctx;
+  LETIMER_TypeDef *regs = timer->regs;
+
+  if(regs->CNT != timer->cnt){
+      timer->cnt = regs->CNT & LETIMER_MAX_CNT;
+  }
+  if(regs->CMD){
+      EFM_ASSERT(!(regs->SYNCBUSY & LETIMER_SYNCBUSY_CMD));
+      timer->cmd = regs->CMD;
+      regs->CMD = 0;
+      regs->SYNCBUSY |= LETIMER_SYNCBUSY_CMD;
+  }
+  if(timer->cmd && (timer->cmd_done == SIM_NEVER) && sim_letimer_clocked()){
+      timer->cmd_done = now + SIM_LF_SYNC_TICKS * sim_letimer_tick_ps();
+  }
+  regs->IF |= regs->IFS & _LETIMER_IF_MASK;
+  regs->IF &= ~regs->IFC;
+  regs->IFS = 0;
+  regs->IFC = 0;
+
+  if(timer->cmd_done <= now){
+      sim_letimer_run(timer, timer->cmd_done);
+      sim_letimer_command(timer);
+  }
+  sim_letimer_run(timer, now);
+  regs->CNT = timer->cnt;
+  regs->STATUS = timer->running ? LETIMER_STATUS_RUNNING : 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Time of the next tick while the LETIMER is counting, or of the landing of
+ *   a command if that is first
+ *
+ ******************************************************************************/
+
+static uint64_t sim_letimer_next(void *ctx){
+  SIM_LETIMER *timer = ctx;
+  uint64_t next = SIM_NEVER;
+
+  if(!sim_letimer_clocked()){
+      return SIM_NEVER;
+  }
+  if(timer->running){
+      next = timer->last_tick + sim_letimer_tick_ps();
+  }
+  if(timer->cmd_done < next){
+      next = timer->cmd_done;
+  }
+  return next;
+}
@@ -0,0 +1,637 @@
+/**
+ * @file sim_leuart.c
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Simulated LEUART0.  A one byte transmit buffer in front of the shift
+ *        register and a two byte receive FIFO, with frame times taken from
+ *        CLKDIV.  Received frames honour STARTFRAME, SIGFRAME, RXBLOCK and
+ *        SFUBRX, and LOOPBK wires the transmitter back to the receiver.
+ *
+ *        Writes to CTRL, CMD, CLKDIV, STARTFRAME and SIGFRAME only reach the
+ *        LF domain SIM_LF_SYNC_TICKS later, SYNCBUSY shows them until then.
+ *        While FREEZE is set they are held and all start synchronizing
+ *        together once it clears.  The frames on TX and RX go to the
+ *        waveform bit by bit.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#define SIM_MODEL_SOURCE
+#include "sim.h"
+#include "em_assert.h"
+#include "em_leuart.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define LEUART_RUN_EM       2       // LFB stops in EM3
+#define LEUART_RX_FIFO      2
+#define LEUART_LINE_BYTES   256     // Bytes a device can have in flight to the receiver
+#define LEUART_CLKDIV_ONE   256     // CLKDIV value of one reference clock per bit
+#define LEUART_PARITY_ODD   3       // CTRL PARITY field
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+typedef struct {
+  LEUART_TypeDef    *regs;
+  SIM_LEUART_TX_FN  device;         // Receives what the LEUART sends when not in loopback
+  bool              rxen;
+  bool              txen;
+  bool              rxblock;
+  bool              tx_full;        // Transmit buffer
+  uint8_t           tx_buf;
+  bool              tx_shifting;    // Shift register
+  uint8_t           tx_shift;
+  uint64_t          tx_done;
+  uint8_t           rx_fifo[LEUART_RX_FIFO];
+  uint32_t          rx_count;
+  bool              rx_pop;         // RXDATA was read since the last sync
+  uint8_t           line[LEUART_LINE_BYTES];    // Frames from the device, in flight
+  uint64_t          line_done[LEUART_LINE_BYTES];
+  uint32_t          line_head;
+  uint32_t          line_count;
+  uint64_t          line_free;      // When the device's TX line is next idle
+  uint32_t          hf_ctrl;        // Synchronized registers as last written by the core
+  uint32_t          hf_clkdiv;
+  uint32_t          hf_startframe;
+  uint32_t          hf_sigframe;
+  uint32_t          lf_ctrl;        // The same registers as the LF domain runs on them
+  uint32_t          lf_clkdiv;
+  uint32_t          lf_startframe;
+  uint32_t          lf_sigframe;
+  uint32_t          lf_cmd;         // Commands written and not synchronized yet
+  uint64_t          lf_done;        // When the writes under synchronization land
+  uint64_t          last;
+} SIM_LEUART;
+
+LEUART_TypeDef sim_leuart0 SIM_EM4_RESET = {
+  .TXDATA_ = { SIM_TXDATA_EMPTY },
+  .STATUS_ = { LEUART_STATUS_TXBL | LEUART_STATUS_TXIDLE },
+  .IF_ = { LEUART_IF_TXBL },
+};
+
+static SIM_LEUART leuart0 SIM_EM4_RESET = { .regs = &sim_leuart0, .lf_done = SIM_NEVER };
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static SIM_LEUART *sim_leuart_get(LEUART_TypeDef *leuart);
+static bool sim_leuart_clocked(void);
+static void sim_leuart_reg_sync(LEUART_TypeDef *leuart, uint32_t mask);
+static uint32_t sim_leuart_frame_bits(SIM_LEUART *uart);
+static uint64_t sim_leuart_frame_ps(SIM_LEUART *uart);
+static void sim_leuart_wave(SIM_LEUART *uart, uint32_t signal, uint64_t start, uint8_t byte);
+static uint32_t sim_leuart_written(volatile uint32_t *reg, uint32_t *hf, uint32_t busy);
+static uint32_t sim_leuart_cmd_merge(uint32_t held, uint32_t cmd);
+static void sim_leuart_land(SIM_LEUART *uart);
+static void sim_leuart_run(SIM_LEUART *uart, uint64_t until);
+static void sim_leuart_receive(SIM_LEUART *uart, uint8_t byte);
+static void sim_leuart_tx_done(SIM_LEUART *uart, uint64_t when);
+static void sim_leuart_tx_kick(SIM_LEUART *uart, uint64_t when);
+static void sim_leuart_sync(void *ctx, uint64_t now);
+static uint64_t sim_leuart_next(void *ctx);
+static bool sim_leuart_rx_valid(void *ctx);
+static void sim_leuart_rx_consume(void *ctx);
+
+const SIM_MODEL sim_leuart0_model = {
+  "LEUART0", &leuart0, LEUART0_IRQn, &sim_leuart0.IF_[0], &sim_leuart0.IEN_[0],
+  sim_leuart_sync, sim_leuart_next, sim_leuart_rx_valid, sim_leuart_rx_consume
+};
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Connects a device to the LEUART's TX pin
+ *
+ * @param[in] tx
+ *   Called with every byte the LEUART sends, NULL to disconnect
+ *
+ ******************************************************************************/
+
+void sim_leuart_attach(LEUART_TypeDef *leuart, SIM_LEUART_TX_FN tx){
+  sim_leuart_get(leuart)->device = tx;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   A device sends one byte to the LEUART's RX pin
+ *
+ * @details
+ *   Bytes queue up behind each other on the line at the LEUART's present
+ *   baud rate and are received at the end of their stop bit.
+ *
+ ******************************************************************************/
+
+void sim_leuart_send(LEUART_TypeDef *leuart, uint8_t byte){
+  SIM_LEUART *uart = sim_leuart_get(leuart);
+  uint32_t slot;
+
+  EFM_ASSERT(uart->line_count < LEUART_LINE_BYTES);
+  if(uart->line_free < sim_now()){
+      uart->line_free = sim_now();
+  }
+  sim_leuart_wave(uart, SIM_VCD_LEUART0_RX, uart->line_free, byte);
+  uart->line_free += sim_leuart_frame_ps(uart);
+  slot = (uart->line_head + uart->line_count) % LEUART_LINE_BYTES;
+  uart->line[slot] = byte;
+  uart->line_done[slot] = uart->line_free;
+  uart->line_count++;
+}
+
+void LEUART_Init(LEUART_TypeDef *leuart, LEUART_Init_TypeDef const *init){
+  LEUART_FreezeEnable(leuart, true);
+  sim_sync();
+  leuart->CMD = LEUART_CMD_RXDIS | LEUART_CMD_TXDIS;
+  sim_sync();
+  leuart->CTRL = (leuart->CTRL & ~(_LEUART_CTRL_PARITY_MASK | LEUART_CTRL_STOPBITS | LEUART_CTRL_DATABITS))
+                 | (uint32_t)init->databits | (uint32_t)init->parity | (uint32_t)init->stopbits;
+  LEUART_BaudrateSet(leuart, init->refFreq, init->baudrate);
+  sim_sync();
+  leuart->CMD = (uint32_t)init->enable;
+  LEUART_FreezeEnable(leuart, false);
+}
+
+void LEUART_Enable(LEUART_TypeDef *leuart, LEUART_Enable_TypeDef enable){
+  uint32_t tmp;
+
+  tmp = ~((uint32_t)enable) & (LEUART_CMD_RXEN | LEUART_CMD_TXEN);
+  tmp <<= 1;
+  tmp |= (uint32_t)enable;
+  sim_leuart_reg_sync(leuart, LEUART_SYNCBUSY_CMD);
+  leuart->CMD = tmp;
+}
+
+void LEUART_FreezeEnable(LEUART_TypeDef *leuart, bool enable){
+  if(enable){
+      sim_leuart_reg_sync(leuart, _LEUART_SYNCBUSY_MASK);
+      leuart->FREEZE = LEUART_FREEZE_REGFREEZE;
+  } else {
+      sim_sync();
+      leuart->FREEZE = 0;
+  }
+}
+
+void LEUART_BaudrateSet(LEUART_TypeDef *leuart, uint32_t refFreq, uint32_t baudrate){
+  uint32_t clkdiv;
+
+  if(!refFreq){
+      refFreq = CMU_ClockFreqGet(cmuClock_LEUART0);
+  }
+  EFM_ASSERT(baudrate);
+  clkdiv = (32 * refFreq) / baudrate;
+  clkdiv -= 32;
+  clkdiv *= 8;
+  EFM_ASSERT(clkdiv <= _LEUART_CLKDIV_MASK);
+  sim_leuart_reg_sync(leuart, LEUART_SYNCBUSY_CLKDIV);
+  leuart->CLKDIV = clkdiv & _LEUART_CLKDIV_MASK;
+}
+
+uint32_t LEUART_BaudrateGet(LEUART_TypeDef *leuart){
+  return (uint32_t)(((uint64_t)CMU_ClockFreqGet(cmuClock_LEUART0) * LEUART_CLKDIV_ONE)
+                    / (LEUART_CLKDIV_ONE + leuart->CLKDIV));
+}
+
+void LEUART_IntClear(LEUART_TypeDef *leuart, uint32_t flags){
+  sim_sync();
+  leuart->IFC = flags;
+}
+
+void LEUART_IntEnable(LEUART_TypeDef *leuart, uint32_t flags){
+  sim_sync();
+  leuart->IEN |= flags;
+}
+
+void LEUART_IntDisable(LEUART_TypeDef *leuart, uint32_t flags){
+  sim_sync();
+  leuart->IEN &= ~flags;
+}
+
+uint32_t LEUART_IntGet(LEUART_TypeDef *leuart){
+  sim_sync();
+  return leuart->IF;
+}
+
+void LEUART_Tx(LEUART_TypeDef *leuart, uint8_t data){
+  do {
+      sim_sync();
+  } while(!(leuart->STATUS & LEUART_STATUS_TXBL));
+  leuart->TXDATA = data;
+}
+
+uint8_t LEUART_Rx(LEUART_TypeDef *leuart){
+  do {
+      sim_sync();
+  } while(!(leuart->STATUS & LEUART_STATUS_RXDATAV));
+  sim_leuart_rx_consume(sim_leuart_get(leuart));
+  return (uint8_t)leuart->RXDATA;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Model behind a LEUART register block
+ *
+ ******************************************************************************/
+
+static SIM_LEUART *sim_leuart_get(LEUART_TypeDef *leuart){
+  EFM_ASSERT(leuart == LEUART0);
+  return &leuart0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Whether the LEUART runs at all in the present clock and energy state
+ *
+ ******************************************************************************/
+
+static bool sim_leuart_clocked(void){
+  return sim_cmu_running(cmuClock_LEUART0) && (sim_energy_mode() <= LEUART_RUN_EM);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Waits for the writes in mask to land before emlib writes the register
+ *   again, not at all while frozen
+ *
+ ******************************************************************************/
+
+static void sim_leuart_reg_sync(LEUART_TypeDef *leuart, uint32_t mask){
+  sim_sync();
+  if(leuart->FREEZE & LEUART_FREEZE_REGFREEZE){
+      return;
+  }
+  while(leuart->SYNCBUSY & mask){
+      sim_sync();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Bits of one frame with the present CTRL, start and stop bits included
+ *
+ ******************************************************************************/
+
+static uint32_t sim_leuart_frame_bits(SIM_LEUART *uart){
+  uint32_t bits = 1 + 8 + 1;
+
+  bits += (uart->lf_ctrl & LEUART_CTRL_DATABITS) ? 1 : 0;
+  bits += (uart->lf_ctrl & _LEUART_CTRL_PARITY_MASK) ? 1 : 0;
+  bits += (uart->lf_ctrl & LEUART_CTRL_STOPBITS) ? 1 : 0;
+  return bits;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Time on the line of one frame with the present CTRL and CLKDIV
+ *
+ ******************************************************************************/
+
+static uint64_t sim_leuart_frame_ps(SIM_LEUART *uart){
+  uint32_t ref = CMU_ClockFreqGet(cmuClock_LEUART0);
+
+  EFM_ASSERT(ref);
+  return (sim_leuart_frame_bits(uart) * (LEUART_CLKDIV_ONE + (uint64_t)uart->lf_clkdiv) * SIM_PS_PER_S)
+         / (LEUART_CLKDIV_ONE * (uint64_t)ref);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Puts one frame starting at start on the TX or RX line of the waveform
+ *
+ * @details
+ *   The start bit, the data LSB first, the parity bit if there is one and
+ *   the line back at idle for the stop bits.  A ninth data bit is sent as 0.
+ *
+ ******************************************************************************/
+
+static void sim_leuart_wave(SIM_LEUART *uart, uint32_t signal, uint64_t start, uint8_t byte){
+  uint32_t data_bits = (uart->lf_ctrl & LEUART_CTRL_DATABITS) ? 9 : 8;
+  uint32_t parity = (uart->lf_ctrl & _LEUART_CTRL_PARITY_MASK) >> _LEUART_CTRL_PARITY_SHIFT;
+  uint64_t bit_ps = sim_leuart_frame_ps(uart) / sim_leuart_frame_bits(uart);
+  uint64_t when = start;
+
+  sim_vcd_change(signal, when, 0);
+  for(uint32_t i = 0; i < data_bits; i++){
+      when += bit_ps;
+      sim_vcd_change(signal, when, (byte >> i) & 0x01);
+  }
+  if(parity){
+      when += bit_ps;
+      sim_vcd_change(signal, when, (uint32_t)__builtin_parity(byte) ^ (parity == LEUART_PARITY_ODD));
+  }
+  sim_vcd_change(signal, when + bit_ps, 1);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   A complete frame arrived at the receiver
+ *
+ * @details
+ *   A STARTFRAME match raises STARTF and with SFUBRX clears RXBLOCK before the
+ *   frame itself is considered, so the start frame lands in the FIFO.  While
+ *   blocked every frame is dropped, a full FIFO drops it with RXOF.
+ *
+ ******************************************************************************/
+
+static void sim_leuart_receive(SIM_LEUART *uart, uint8_t byte){
+  LEUART_TypeDef *regs = uart->regs;
+
+  if(!uart->rxen){
+      return;
+  }
+  if(byte == (uint8_t)uart->lf_startframe){
+      regs->IF |= LEUART_IF_STARTF;
+      if(uart->lf_ctrl & LEUART_CTRL_SFUBRX){
+          uart->rxblock = false;
+      }
+  }
+  if(uart->rxblock){
+      return;
+  }
+  if(uart->rx_count == LEUART_RX_FIFO){
+      regs->IF |= LEUART_IF_RXOF;
+      return;
+  }
+  uart->rx_fifo[uart->rx_count++] = byte;
+  if(byte == (uint8_t)uart->lf_sigframe){
+      regs->IF |= LEUART_IF_SIGF;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The shift register finished its frame at time when
+ *
+ ******************************************************************************/
+
+static void sim_leuart_tx_done(SIM_LEUART *uart, uint64_t when){
+  LEUART_TypeDef *regs = uart->regs;
+
+  uart->tx_shifting = false;
+  if(uart->lf_ctrl & LEUART_CTRL_LOOPBK){
+      sim_leuart_receive(uart, uart->tx_shift);
+  } else if(uart->device){
+      uart->device(uart->tx_shift);
+  }
+  sim_leuart_tx_kick(uart, when);
+  if(!uart->tx_shifting){
+      regs->IF |= LEUART_IF_TXC;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Moves the transmit buffer into an idle shift register
+ *
+ ******************************************************************************/
+
+static void sim_leuart_tx_kick(SIM_LEUART *uart, uint64_t when){
+  if(uart->txen && uart->tx_full && !uart->tx_shifting){
+      uart->tx_shift = uart->tx_buf;
+      uart->tx_full = false;
+      uart->tx_shifting = true;
+      uart->tx_done = when + sim_leuart_frame_ps(uart);
+      sim_leuart_wave(uart, SIM_VCD_LEUART0_TX, when, uart->tx_shift);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Whether a synchronized register was written since the last sync
+ *
+ * @details
+ *   A write of the value already there goes unnoticed, which is harmless
+ *   as it changes nothing in the LF domain either.
+ *
+ * @return
+ *   busy if it was, 0 if not
+ *
+ ******************************************************************************/
+
+static uint32_t sim_leuart_written(volatile uint32_t *reg, uint32_t *hf, uint32_t busy){
+  if(*reg == *hf){
+      return 0;
+  }
+  *hf = *reg;
+  return busy;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Adds a command to the ones waiting to land
+ *
+ * @details
+ *   A later enable cancels an earlier disable of the same function and the
+ *   other way round, the rest accumulates.
+ *
+ ******************************************************************************/
+
+static uint32_t sim_leuart_cmd_merge(uint32_t held, uint32_t cmd){
+  static const uint32_t pairs[] = {
+    LEUART_CMD_RXEN | LEUART_CMD_RXDIS,
+    LEUART_CMD_TXEN | LEUART_CMD_TXDIS,
+    LEUART_CMD_RXBLOCKEN | LEUART_CMD_RXBLOCKDIS,
+  };
+
+  for(uint32_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++){
+      if(cmd & pairs[i]){
+          held &= ~pairs[i];
+      }
+  }
+  return held | cmd;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The writes under synchronization reach the LF domain
+ *
+ ******************************************************************************/
+
+static void sim_leuart_land(SIM_LEUART *uart){
+  LEUART_TypeDef *regs = uart->regs;
+  uint32_t cmd = uart->lf_cmd;
+
+  uart->lf_ctrl = uart->hf_ctrl;
+  uart->lf_clkdiv = uart->hf_clkdiv;
+  uart->lf_startframe = uart->hf_startframe;
+  uart->lf_sigframe = uart->hf_sigframe;
+  uart->rxen = (uart->rxen || (cmd & LEUART_CMD_RXEN)) && !(cmd & LEUART_CMD_RXDIS);
+  uart->txen = (uart->txen || (cmd & LEUART_CMD_TXEN)) && !(cmd & LEUART_CMD_TXDIS);
+  if(cmd & LEUART_CMD_RXBLOCKEN){
+      uart->rxblock = true;
+  }
+  if(cmd & LEUART_CMD_RXBLOCKDIS){
+      uart->rxblock = false;
+  }
+  if(cmd & LEUART_CMD_CLEARTX){
+      uart->tx_full = false;
+  }
+  if(cmd & LEUART_CMD_CLEARRX){
+      uart->rx_count = 0;
+  }
+  uart->lf_cmd = 0;
+  uart->lf_done = SIM_NEVER;
+  regs->SYNCBUSY = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Runs the transmitter and receiver from the last sync up to until
+ *
+ ******************************************************************************/
+
+static void sim_leuart_run(SIM_LEUART *uart, uint64_t until){
+  if(sim_leuart_clocked()){
+      sim_leuart_tx_kick(uart, uart->last);
+      for(;;){
+          uint64_t tx_at = uart->tx_shifting ? uart->tx_done : SIM_NEVER;
+          uint64_t rx_at = uart->line_count ? uart->line_done[uart->line_head] : SIM_NEVER;
+          if((tx_at > until) && (rx_at > until)){
+              break;
+          }
+          if(tx_at <= rx_at){
+              sim_leuart_tx_done(uart, tx_at);
+          } else {
+              uint8_t byte = uart->line[uart->line_head];
+              uart->line_head = (uart->line_head + 1) % LEUART_LINE_BYTES;
+              uart->line_count--;
+              sim_leuart_receive(uart, byte);
+          }
+      }
+  } else {
+      // Frozen, everything on the wire and in synchronization waits for the
+      // clock to come back
+      uint64_t paused = until - uart->last;
+      uart->tx_done += uart->tx_shifting ? paused : 0;
+      for(uint32_t i = 0; i < uart->line_count; i++){
+          uart->line_done[(uart->line_head + i) % LEUART_LINE_BYTES] += paused;
+      }
+      if(uart->line_count){
+          uart->line_free += paused;
+      }
+      if(uart->lf_done != SIM_NEVER){
+          uart->lf_done += paused;
+      }
+  }
+  uart->last = until;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes the register writes since the last sync and runs the transmitter
+ *   and receiver up to now
+ *
+ * @details
+ *   A write while FREEZE is clear (re)starts the synchronization of
+ *   everything not landed yet, which errs on the late side for the earlier
+ *   writes.  Writing a register again before its last write landed is a
+ *   firmware bug outside of FREEZE.
+ *
+ ******************************************************************************/
+
+static void sim_leuart_sync(void *ctx, uint64_t now){
+  SIM_LEUART *uart = ctx;
+  LEUART_TypeDef *regs = uart->regs;
+  bool frozen = regs->FREEZE & LEUART_FREEZE_REGFREEZE;
+  uint32_t written = 0;
+
+  if(uart->rx_pop){
+      uart->rx_pop = false;
+      if(uart->rx_count){
+          uart->rx_fifo[0] = uart->rx_fifo[1];
+          uart->rx_count--;
+      }
+  }
+  written |= sim_leuart_written(&regs->CTRL, &uart->hf_ctrl, LEUART_SYNCBUSY_CTRL);
+  written |= sim_leuart_written(&regs->CLKDIV, &uart->hf_clkdiv, LEUART_SYNCBUSY_CLKDIV);
+  written |= sim_leuart_written(&regs->STARTFRAME, &uart->hf_startframe, LEUART_SYNCBUSY_STARTFRAME);
+  written |= sim_leuart_written(&regs->SIGFRAME, &uart->hf_sigframe, LEUART_SYNCBUSY_SIGFRAME);
+  if(regs->CMD){
+      written |= LEUART_SYNCBUSY_CMD;
+      uart->lf_cmd = sim_leuart_cmd_merge(uart->lf_cmd, regs->CMD);
+      regs->CMD = 0;
+  }
+  EFM_ASSERT(frozen || !(written & regs->SYNCBUSY));
+  regs->SYNCBUSY |= written;
+  if(written && !frozen){
+      uart->lf_done = SIM_NEVER;
+  }
+  if(regs->SYNCBUSY && !frozen && (uart->lf_done == SIM_NEVER) && sim_leuart_clocked()){
+      uart->lf_done = now + (SIM_LF_SYNC_TICKS * SIM_PS_PER_S) / CMU_ClockFreqGet(cmuClock_LEUART0);
+  }
+
+  if(regs->TXDATA != SIM_TXDATA_EMPTY){
+      if(uart->tx_full){
+          regs->IF |= LEUART_IF_TXOF;
+      } else {
+          uart->tx_buf = (uint8_t)regs->TXDATA;
+          uart->tx_full = true;
+      }
+      regs->TXDATA = SIM_TXDATA_EMPTY;
+  }
+  regs->IF |= regs->IFS & _LEUART_IFC_MASK;
+  regs->IF &= ~(regs->IFC & _LEUART_IFC_MASK);
+  regs->IFS = 0;
+  regs->IFC = 0;
+
+  if(!frozen && (uart->lf_done <= now)){
+      sim_leuart_run(uart, uart->lf_done);
+      sim_leuart_land(uart);
+  }
+  sim_leuart_run(uart, now);
+
+  regs->IF = (regs->IF & ~(LEUART_IF_TXBL | LEUART_IF_RXDATAV))
+             | (uart->tx_full ? 0 : LEUART_IF_TXBL)
+             | (uart->rx_count ? LEUART_IF_RXDATAV : 0);
+  regs->RXDATA = uart->rx_count ? uart->rx_fifo[0] : 0;
+  regs->STATUS = (uart->rxen ? LEUART_STATUS_RXENS : 0)
+                 | (uart->txen ? LEUART_STATUS_TXENS : 0)
+                 | (uart->rxblock ? LEUART_STATUS_RXBLOCK : 0)
+                 | ((regs->IF & LEUART_IF_TXC) ? LEUART_STATUS_TXC : 0)
+                 | (uart->tx_full ? 0 : LEUART_STATUS_TXBL)
+                 | (uart->rx_count ? LEUART_STATUS_RXDATAV : 0)
+                 | ((uart->tx_full || uart->tx_shifting) ? 0 : LEUART_STATUS_TXIDLE);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   End of the frame in the shift register or on the RX line, or the landing
+ *   of the writes under synchronization, whichever is first
+ *
+ ******************************************************************************/
+
+static uint64_t sim_leuart_next(void *ctx){
+  SIM_LEUART *uart = ctx;
+  uint64_t next = SIM_NEVER;
+
+  if(!sim_leuart_clocked()){
+      return SIM_NEVER;
+  }
+  if(uart->tx_shifting){
+      next = uart->tx_done;
+  }
+  if(uart->line_count && (uart->line_done[uart->line_head] < next)){
+      next = uart->line_done[uart->line_head];
+  }
+  if(!(uart->regs->FREEZE & LEUART_FREEZE_REGFREEZE) && (uart->lf_done < next)){
+      next = uart->lf_done;
+  }
+  return next;
+}
+
+static bool sim_leuart_rx_valid(void *ctx){
+  SIM_LEUART *uart = ctx;
+  return uart->rx_count != 0;
+}
+
+static void sim_leuart_rx_consume(void *ctx){
+  SIM_LEUART *uart = ctx;
+  uart->rx_pop = true;
+}
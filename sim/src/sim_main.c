@@ -0,0 +1,157 @@
+/**
+ * @file sim_main.c
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Entry point of the host simulation.  Sets up the virtual clock and
+ *        the devices on the buses, then runs the firmware's main(), again
+ *        after every EM4H wake-up.  With -R a recording stands in for them.
+ *
+ *        Usage: firmware_sim [-t seconds] [-q] [-c seconds] [-d seconds] [-p]
+ *                            [-n count] [-s us] [-l counts] [-w seconds:text]
+ *                            [-r seconds]
+ *                            [-B baud] [-e] [-b mAh] [-R recording] [-V file]
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sim.h"
+#include "profiler.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SIM_LIGHT_DEFAULT   1000    // SI1133 counts at HW_GAIN 0
+#define SIM_BATTERY_MAH     225     // CR2032 coin cell of the Thunderboard
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static void sim_usage(const char *name);
+
+int firmware_main(void);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(int argc, char **argv){
+  double seconds = SIM_DEFAULT_SECONDS;
+  bool quiet = false;
+  SIM_HM10_OPEN hm10 = { 0, SIM_NEVER, false, SIM_NEVER, NULL, 0, 0 };
+  double battery = 0;
+  SIM_SI1133_OPEN si1133 = { 0, 0, SIM_LIGHT_DEFAULT };
+  const char *recording = NULL;
+  int opt;
+
+  while((opt = getopt(argc, argv, "t:qc:d:pn:s:l:w:r:B:b:eR:V:")) != -1){
+      switch(opt){
+        case 't':
+          seconds = atof(optarg);
+          break;
+        case 'q':
+          quiet = true;
+          break;
+        case 'c':
+          hm10.connect_at = (atof(optarg) < 0) ? SIM_NEVER : (uint64_t)(atof(optarg) * SIM_PS_PER_S);
+          break;
+        case 'd':
+          hm10.disconnect_at = (uint64_t)(atof(optarg) * SIM_PS_PER_S);
+          break;
+        case 'p':
+          hm10.pty = true;
+          break;
+        case 'n':
+          si1133.nack_every = (uint32_t)atoi(optarg);
+          break;
+        case 's':
+          si1133.stretch_ps = (uint64_t)(atof(optarg) * SIM_PS_PER_US);
+          break;
+        case 'l':
+          si1133.light = (uint32_t)atoi(optarg);
+          break;
+        case 'w':
+          hm10.write_text = strchr(optarg, ':');
+          if(!hm10.write_text){
+              sim_usage(argv[0]);
+              return EXIT_FAILURE;
+          }
+          hm10.write_at = (uint64_t)(atof(optarg) * SIM_PS_PER_S);
+          hm10.write_text++;
+          break;
+        case 'r':
+          hm10.write_every = (uint64_t)(atof(optarg) * SIM_PS_PER_S);
+          break;
+        case 'B':
+          hm10.baud = (uint32_t)atoi(optarg);
+          break;
+        case 'b':
+          battery = atof(optarg);
+          break;
+        case 'e':
+          battery = SIM_BATTERY_MAH;
+          break;
+        case 'R':
+          recording = optarg;
+          break;
+        case 'V':
+          sim_vcd_open(optarg);
+          break;
+        default:
+          sim_usage(argv[0]);
+          return EXIT_FAILURE;
+      }
+  }
+  if(seconds <= 0){
+      sim_usage(argv[0]);
+      return EXIT_FAILURE;
+  }
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  sim_init((uint64_t)(seconds * SIM_PS_PER_S), quiet);
+  sim_energy_open(battery);
+#ifdef PROFILER_ENABLED
+  sim_energy_owners(PROFILER_OWNERS, profiler_owner, profiler_owner_name);
+#endif
+  if(recording){
+      sim_replay_open(recording, LEUART0, I2C1);
+  } else {
+      sim_hm10_open(LEUART0, &hm10);
+      sim_si1133_open(I2C1, &si1133);
+  }
+  sim_watchdog_open();
+  sim_run(firmware_main);
+  sim_finish(EXIT_SUCCESS);
+  return EXIT_SUCCESS;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static void sim_usage(const char *name){
+  fprintf(stderr, "usage: %s [-t seconds] [-q] [-c seconds] [-d seconds] [-p]\n"
+                  "       [-n count] [-s us] [-l counts] [-w seconds:text] [-r seconds]\n"
+                  "       [-B baud] [-e] [-b mAh] [-R recording] [-V file]\n", name);
+  fprintf(stderr, "  -t  virtual time to run, default %d s\n", SIM_DEFAULT_SECONDS);
+  fprintf(stderr, "  -q  only print the end of run report\n");
+  fprintf(stderr, "  -c  when a central connects to the HM10, default 0, negative for never\n");
+  fprintf(stderr, "  -d  when the central disconnects, default never\n");
+  fprintf(stderr, "  -p  central on a pseudo-terminal, the run is held to real time\n");
+  fprintf(stderr, "  -n  SI1133 NACKs every count-th time it is addressed\n");
+  fprintf(stderr, "  -s  SI1133 stretches SCL by us after every byte\n");
+  fprintf(stderr, "  -l  SI1133 light level in counts at HW_GAIN 0, default %d\n", SIM_LIGHT_DEFAULT);
+  fprintf(stderr, "  -w  the central writes text at seconds, e.g. -w 3:#LAT!\n");
+  fprintf(stderr, "  -r  the central repeats the -w write every seconds\n");
+  fprintf(stderr, "  -B  HM10 baud rate at power up, default 9600\n");
+  fprintf(stderr, "  -e  print the energy estimate for a %d mAh CR2032\n", SIM_BATTERY_MAH);
+  fprintf(stderr, "  -b  print the energy estimate for a battery of mAh\n");
+  fprintf(stderr, "  -R  replay the inputs of a #REC! dump, in place of the HM10 and SI1133\n");
+  fprintf(stderr, "  -V  write the pins and the energy mode to a VCD file for GTKWave\n");
+}
@@ -0,0 +1,343 @@
+/**
+ * @file sim_replay.c
+ * @author Shambaditya Tarafder
+ * @date 12/9/2021
+ * @brief Replays what the firmware's recorder took down, in place of the
+ *        HM10 and the SI1133.  The LEUART bytes and the LETIMER0 interrupts
+ *        come back at the RTCC counts they were recorded at, the I2C bytes
+ *        in the order the firmware read them.  What the firmware sends is
+ *        checked against what the central received in the recording.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "capture.h"
+#include "em_assert.h"
+#include "em_leuart.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define REPLAY_LINE_MARK    'R'
+#define REPLAY_HEX_DIGITS   8
+#define REPLAY_DELTA_SHIFT  16
+#define REPLAY_SOURCE_SHIFT 8
+#define REPLAY_SOURCE_MASK  0xFF
+#define REPLAY_DATA_MASK    0xFF
+#define REPLAY_FRAME_BITS   10      // 8N1, the frames the HM10 sends
+#define REPLAY_I2C_ADDRESS  0x55    // The SI1133, the only device on the bus
+#define REPLAY_RTCC_WAIT    SIM_PS_PER_MS   // Retry until the RTCC runs
+#define REPLAY_TEXT_MAX     (4 * CAPTURE_LINE_MAX)
+
+// Inputs of recorder.h
+#define RECORDER_TIME       0
+#define RECORDER_LEUART_RX  1
+#define RECORDER_LETIMER    2
+#define RECORDER_I2C_RX     3
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static LEUART_TypeDef *replay_leuart;
+static uint32_t      *replay_words;
+static uint32_t       replay_count;
+static uint32_t       replay_next;  // Next word of the timed inputs
+static uint32_t       replay_at;    // RTCC count of replay_words[replay_next]
+static uint32_t       replay_i2c;   // Next word of the I2C bytes
+static bool           replay_i2c_warned;
+
+// Lines the central received in the recording, and the ones sent this time
+static char         **replay_lines;
+static uint32_t       replay_line_count;
+static uint32_t       replay_covered;   // Lines up to the last of the dump, what a replay can send
+static uint32_t       replay_matched;
+static uint32_t       replay_differ;    // Line the replay first differs at, 0 for none
+static char           replay_tx[CAPTURE_LINE_MAX];
+static uint32_t       replay_tx_len;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static void sim_replay_load(const char *path);
+static bool sim_replay_words(const char *line);
+static void sim_replay_tx(uint8_t byte);
+static void sim_replay_sent(void);
+static void sim_replay_next(void *arg);
+static void sim_replay_input(void *arg);
+static bool sim_replay_start(bool read);
+static bool sim_replay_write(uint8_t data);
+static uint8_t sim_replay_read(void);
+static void sim_replay_stop(void);
+static void sim_replay_report(void);
+
+static const SIM_I2C_SLAVE replay_slave = {
+  REPLAY_I2C_ADDRESS, sim_replay_start, sim_replay_write, sim_replay_read, sim_replay_stop, NULL
+};
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Loads a recording and puts it on the LEUART and the I2C bus
+ *
+ * @details
+ *   path holds the "R" lines recorder_line() made, as the central received
+ *   them or as firmware_sim logged them.  The recording starts at the reset,
+ *   the replay runs from a cold boot on the same build.  The LETIMER0 model
+ *   stops raising its own flags, they come from the recording.  What the
+ *   central received after the dump has no inputs to come back from, only
+ *   the lines up to the dump's last one are covered.  The report counts the
+ *   covered lines sent again and stops at the first that differs, fewer
+ *   than covered are reported as missing.
+ *
+ ******************************************************************************/
+
+void sim_replay_open(const char *path, LEUART_TypeDef *leuart, I2C_TypeDef *i2c){
+  replay_leuart = leuart;
+  sim_replay_load(path);
+  sim_leuart_attach(leuart, sim_replay_tx);
+  sim_i2c_attach(i2c, &replay_slave);
+  sim_letimer_replay();
+  sim_event_at(0, sim_replay_next, NULL);
+  atexit(sim_replay_report);
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Reads the recording and every line the central received with it
+ *
+ * @details
+ *   firmware_sim output starts with its "[" time stamps, anything else is
+ *   taken as the raw stream.
+ *
+ ******************************************************************************/
+
+static void sim_replay_load(const char *path){
+  FILE *file = fopen(path, "r");
+  CAPTURE capture;
+  char line[CAPTURE_LINE_MAX];
+  int first;
+
+  if(!file){
+      perror(path);
+      exit(EXIT_FAILURE);
+  }
+  first = fgetc(file);
+  ungetc(first, file);
+  capture_open(&capture, file, first == '[');
+  while(capture_line(&capture, line, sizeof(line))){
+      replay_lines = realloc(replay_lines, (replay_line_count + 1) * sizeof(char *));
+      EFM_ASSERT(replay_lines);
+      replay_lines[replay_line_count++] = strdup(line);
+      if(sim_replay_words(line)){
+          replay_covered = replay_line_count;
+      }
+  }
+  fclose(file);
+  if(!replay_count){
+      fprintf(stderr, "%s: no recording\n", path);
+      exit(EXIT_FAILURE);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Adds the words of one "R<hex>" line to the recording
+ *
+ * @return
+ *   false for a line that is not part of the dump
+ *
+ ******************************************************************************/
+
+static bool sim_replay_words(const char *line){
+  size_t len;
+
+  if(line[0] != REPLAY_LINE_MARK){
+      return false;
+  }
+  line++;
+  len = strlen(line);
+  if(!len || (len % REPLAY_HEX_DIGITS) || (strspn(line, "0123456789abcdef") != len)){
+      return false;
+  }
+  replay_words = realloc(replay_words, (replay_count + len / REPLAY_HEX_DIGITS) * sizeof(uint32_t));
+  EFM_ASSERT(replay_words);
+  for(size_t i = 0; i < len; i += REPLAY_HEX_DIGITS){
+      char word[REPLAY_HEX_DIGITS + 1];
+      memcpy(word, line + i, REPLAY_HEX_DIGITS);
+      word[REPLAY_HEX_DIGITS] = '\0';
+      replay_words[replay_count++] = (uint32_t)strtoul(word, NULL, 16);
+  }
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   A byte the firmware sends, logged and checked a line at a time
+ *
+ ******************************************************************************/
+
+static void sim_replay_tx(uint8_t byte){
+  if(replay_tx_len < sizeof(replay_tx) - 1){
+      replay_tx[replay_tx_len++] = (char)byte;
+  }
+  if(byte == '\n'){
+      sim_replay_sent();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Logs a line the firmware sent like the HM10 logs a notification, so the
+ *   host tools read the replay's output too, and compares it with the
+ *   recording
+ *
+ ******************************************************************************/
+
+static void sim_replay_sent(void){
+  char text[REPLAY_TEXT_MAX];
+  uint32_t line = replay_matched + 1;
+  size_t pos = 0;
+
+  text[0] = '\0';
+  for(uint32_t i = 0; (i < replay_tx_len) && (pos + 5 < sizeof(text)); i++){
+      uint8_t c = (uint8_t)replay_tx[i];
+      pos += (size_t)snprintf(text + pos, sizeof(text) - pos,
+                              ((c >= ' ') && (c < 0x7F) && (c != '"')) ? "%c" : "\\x%02x", c);
+  }
+  sim_log("replay -> central %2lu bytes \"%s\"", (unsigned long)replay_tx_len, text);
+
+  replay_tx[--replay_tx_len] = '\0';
+  if(!replay_differ && (line <= replay_covered)){
+      if(!strcmp(replay_tx, replay_lines[line - 1])){
+          replay_matched++;
+      } else {
+          replay_differ = line;
+          sim_log("replay differs from the recording at line %lu", (unsigned long)line);
+      }
+  }
+  replay_tx_len = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Schedules the next LEUART byte or LETIMER0 interrupt of the recording
+ *
+ * @details
+ *   An input lands in the middle of the RTCC tick it was recorded in, a
+ *   LEUART byte starts a frame earlier so its stop bit ends there.  Until
+ *   the firmware starts the RTCC there is no time line to put them on.
+ *
+ ******************************************************************************/
+
+static void sim_replay_next(void *arg){
+  (void)arg;
+
+  while(replay_next < replay_count){
+      uint32_t word = replay_words[replay_next];
+      uint32_t source = (word >> REPLAY_SOURCE_SHIFT) & REPLAY_SOURCE_MASK;
+      uint64_t when = sim_rtcc_time(replay_at + (word >> REPLAY_DELTA_SHIFT));
+      uint64_t frame = 0;
+
+      if(when == SIM_NEVER){
+          sim_event_at(sim_now() + REPLAY_RTCC_WAIT, sim_replay_next, NULL);
+          return;
+      }
+      if((source != RECORDER_LEUART_RX) && (source != RECORDER_LETIMER)){
+          replay_at += word >> REPLAY_DELTA_SHIFT;
+          replay_next++;
+          continue;
+      }
+      when += (sim_rtcc_time(replay_at + (word >> REPLAY_DELTA_SHIFT) + 1) - when) / 2;
+      if((source == RECORDER_LEUART_RX) && LEUART_BaudrateGet(replay_leuart)){
+          frame = REPLAY_FRAME_BITS * SIM_PS_PER_S / LEUART_BaudrateGet(replay_leuart);
+      }
+      when = (when > sim_now() + frame) ? when - frame : sim_now();
+      sim_event_at(when, sim_replay_input, NULL);
+      return;
+  }
+  sim_log("replay at the end of the recording, %lu inputs", (unsigned long)replay_count);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Puts one input on its peripheral and schedules the next
+ *
+ ******************************************************************************/
+
+static void sim_replay_input(void *arg){
+  uint32_t word = replay_words[replay_next++];
+  (void)arg;
+
+  replay_at += word >> REPLAY_DELTA_SHIFT;
+  if(((word >> REPLAY_SOURCE_SHIFT) & REPLAY_SOURCE_MASK) == RECORDER_LEUART_RX){
+      sim_leuart_send(replay_leuart, (uint8_t)(word & REPLAY_DATA_MASK));
+  } else {
+      sim_letimer_raise(word & REPLAY_DATA_MASK);
+  }
+  sim_replay_next(NULL);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The replayed SI1133 ACKs everything, a NACK is not recorded
+ *
+ ******************************************************************************/
+
+static bool sim_replay_start(bool read){
+  (void)read;
+  return true;
+}
+
+static bool sim_replay_write(uint8_t data){
+  (void)data;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Next I2C byte of the recording, 0xFF once they are used up
+ *
+ ******************************************************************************/
+
+static uint8_t sim_replay_read(void){
+  while(replay_i2c < replay_count){
+      uint32_t word = replay_words[replay_i2c++];
+      if(((word >> REPLAY_SOURCE_SHIFT) & REPLAY_SOURCE_MASK) == RECORDER_I2C_RX){
+          return (uint8_t)(word & REPLAY_DATA_MASK);
+      }
+  }
+  if(!replay_i2c_warned){
+      sim_log("replay has no more I2C bytes, the firmware read more than it did");
+      replay_i2c_warned = true;
+  }
+  return 0xFF;
+}
+
+static void sim_replay_stop(void){
+}
+
+static void sim_replay_report(void){
+  printf("  Replay    %lu inputs, %lu of %lu lines the central received up to the dump sent again",
+         (unsigned long)replay_count, (unsigned long)replay_matched,
+         (unsigned long)replay_covered);
+  if(replay_line_count > replay_covered){
+      printf(", %lu after it not covered", (unsigned long)(replay_line_count - replay_covered));
+  }
+  if(replay_differ){
+      printf(", differs at line %lu", (unsigned long)replay_differ);
+  } else if(replay_matched < replay_covered){
+      printf(", %lu missing", (unsigned long)(replay_covered - replay_matched));
+  }
+  printf("\n");
+}
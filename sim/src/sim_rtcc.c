@@ -0,0 +1,271 @@
+/**
+ * @file sim_rtcc.c
+ * @author Shambaditya Tarafder
+ * @date 12/6/2021
+ * @brief Simulated RTCC.  A 32 bit counter on the LFE clock through the
+ *        counter prescaler, running down to EM4H, with the overflow flag
+ *        and the compare channels.  Its interrupts wake the core from EM4H
+ *        when EM4WUEN allows it, the retention registers are plain RAM.
+ *        Input capture, the PRS outputs and calendar mode are not modelled.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#define SIM_MODEL_SOURCE
+#include "sim.h"
+#include "em_assert.h"
+#include "em_rtcc.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define RTCC_RUN_EM         4       // EM4H keeps the LF oscillators and the RTCC
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+typedef struct {
+  RTCC_TypeDef      *regs;
+  uint32_t          cnt;            // CNT as last published to the register
+  uint64_t          last_tick;      // Virtual time of the last counted tick
+} SIM_RTCC;
+
+RTCC_TypeDef sim_rtcc;
+
+static SIM_RTCC rtcc = { &sim_rtcc };
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static uint64_t sim_rtcc_tick_ps(void);
+static bool sim_rtcc_clocked(void);
+static void sim_rtcc_sync(void *ctx, uint64_t now);
+static uint64_t sim_rtcc_next(void *ctx);
+static bool sim_rtcc_compare(int ch);
+
+const SIM_MODEL sim_rtcc_model = {
+  "RTCC", &rtcc, RTCC_IRQn, &sim_rtcc.IF_[0], &sim_rtcc.IEN_[0],
+  sim_rtcc_sync, sim_rtcc_next, NULL, NULL
+};
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+void RTCC_Init(const RTCC_Init_TypeDef *init){
+  uint32_t ctrl = 0;
+
+  EFM_ASSERT(init->cntMode == rtccCntModeNormal);
+  EFM_ASSERT(init->prescMode == rtccCntTickPresc);
+  EFM_ASSERT(!init->precntWrapOnCCV0 && !init->cntWrapOnCCV1);
+  sim_sync();
+  ctrl |= init->enable ? RTCC_CTRL_ENABLE : 0;
+  ctrl |= init->debugRun ? RTCC_CTRL_DEBUGRUN : 0;
+  ctrl |= (uint32_t)init->presc << _RTCC_CTRL_CNTPRESC_SHIFT;
+  RTCC->CTRL = ctrl;
+}
+
+void RTCC_Enable(bool enable){
+  sim_sync();
+  if(enable){
+      RTCC->CTRL |= RTCC_CTRL_ENABLE;
+  } else {
+      RTCC->CTRL &= ~RTCC_CTRL_ENABLE;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Virtual time the counter reaches count at, for a device that follows the
+ *   RTCC's time line
+ *
+ * @return
+ *   SIM_NEVER while the RTCC is stopped, the last tick for a count it passed
+ *
+ ******************************************************************************/
+
+uint64_t sim_rtcc_time(uint32_t count){
+  int32_t ticks = (int32_t)(count - rtcc.cnt);
+
+  if(!sim_rtcc_clocked()){
+      return SIM_NEVER;
+  }
+  return rtcc.last_tick + ((ticks > 0) ? (uint64_t)ticks * sim_rtcc_tick_ps() : 0);
+}
+
+uint32_t RTCC_CounterGet(void){
+  sim_sync();
+  return RTCC->CNT;
+}
+
+void RTCC_CounterSet(uint32_t value){
+  sim_sync();
+  RTCC->CNT = value;
+}
+
+void RTCC_IntClear(uint32_t flags){
+  sim_sync();
+  RTCC->IFC = flags;
+}
+
+void RTCC_IntEnable(uint32_t flags){
+  sim_sync();
+  RTCC->IEN |= flags;
+}
+
+void RTCC_IntDisable(uint32_t flags){
+  sim_sync();
+  RTCC->IEN &= ~flags;
+}
+
+uint32_t RTCC_IntGet(void){
+  sim_sync();
+  return RTCC->IF;
+}
+
+void RTCC_ChannelInit(int ch, const RTCC_CCChConf_TypeDef *confPtr){
+  EFM_ASSERT((ch >= 0) && (ch < RTCC_CC_COUNT));
+  EFM_ASSERT(confPtr->chMode != rtccCapComChModeCapture);
+  EFM_ASSERT(confPtr->compBase == rtccCompBaseCnt);
+  sim_sync();
+  RTCC->CC[ch].CTRL = (uint32_t)confPtr->chMode;
+}
+
+void RTCC_ChannelCCVSet(int ch, uint32_t value){
+  EFM_ASSERT((ch >= 0) && (ch < RTCC_CC_COUNT));
+  sim_sync();
+  RTCC->CC[ch].CCV = value;
+}
+
+uint32_t RTCC_ChannelCCVGet(int ch){
+  EFM_ASSERT((ch >= 0) && (ch < RTCC_CC_COUNT));
+  sim_sync();
+  return RTCC->CC[ch].CCV;
+}
+
+void RTCC_EM4WakeupEnable(bool enable){
+  sim_sync();
+  RTCC->EM4WUEN = enable ? RTCC_EM4WUEN_EM4WU : 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Whether an RTCC interrupt is pending that ends EM4H
+ *
+ * @details
+ *   The NVIC is powered down in EM4H, the enabled flag itself is the
+ *   wake-up.
+ *
+ ******************************************************************************/
+
+bool sim_rtcc_em4_wakeup(void){
+  return (sim_rtcc.EM4WUEN & RTCC_EM4WUEN_EM4WU) && (sim_rtcc.IF_[0] & sim_rtcc.IEN_[0]);
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Picoseconds per counter tick, LFE clock over the counter prescaler
+ *
+ ******************************************************************************/
+
+static uint64_t sim_rtcc_tick_ps(void){
+  uint32_t presc = (sim_rtcc.CTRL_[0] & _RTCC_CTRL_CNTPRESC_MASK) >> _RTCC_CTRL_CNTPRESC_SHIFT;
+
+  return (SIM_PS_PER_S << presc) / CMU_ClockFreqGet(cmuClock_RTCC);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Whether the RTCC counts in the present clock and energy state
+ *
+ ******************************************************************************/
+
+static bool sim_rtcc_clocked(void){
+  return (sim_rtcc.CTRL_[0] & RTCC_CTRL_ENABLE) && sim_cmu_running(cmuClock_RTCC) &&
+         (sim_energy_mode() <= RTCC_RUN_EM);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes the register writes since the last sync and counts the ticks up to
+ *   now
+ *
+ * @details
+ *   The counter is worked out from the elapsed time rather than ticked one
+ *   by one.  A compare channel whose value the count passed sets its flag,
+ *   the clock stops at each match that can interrupt.
+ *
+ ******************************************************************************/
+
+static void sim_rtcc_sync(void *ctx, uint64_t now){
+  SIM_RTCC *timer = ctx;
+  RTCC_TypeDef *regs = timer->regs;
+
+  if(regs->CNT != timer->cnt){
+      timer->cnt = regs->CNT;
+  }
+  regs->IF |= regs->IFS & _RTCC_IF_MASK;
+  regs->IF &= ~regs->IFC;
+  regs->IFS = 0;
+  regs->IFC = 0;
+
+  if(sim_rtcc_clocked()){
+      uint64_t tick_ps = sim_rtcc_tick_ps();
+      uint64_t ticks = (now - timer->last_tick) / tick_ps;
+      if((uint64_t)timer->cnt + ticks > UINT32_MAX){
+          regs->IF |= RTCC_IF_OF;
+      }
+      for(int ch = 0; ch < RTCC_CC_COUNT; ch++){
+          uint32_t to_match = regs->CC[ch].CCV - timer->cnt;
+          if(sim_rtcc_compare(ch) && ticks && (to_match > 0) && (to_match <= ticks)){
+              regs->IF |= RTCC_IF_CC0 << ch;
+          }
+      }
+      timer->cnt = (uint32_t)(timer->cnt + ticks);
+      timer->last_tick += ticks * tick_ps;
+  } else {
+      timer->last_tick = now;
+  }
+  regs->CNT = timer->cnt;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Time of the next overflow or compare match, only of interest with its
+ *   interrupt enabled
+ *
+ ******************************************************************************/
+
+static uint64_t sim_rtcc_next(void *ctx){
+  SIM_RTCC *timer = ctx;
+  RTCC_TypeDef *regs = timer->regs;
+  uint64_t ticks = SIM_NEVER;
+
+  if(!sim_rtcc_clocked()){
+      return SIM_NEVER;
+  }
+  if(regs->IEN & RTCC_IEN_OF){
+      ticks = (uint64_t)UINT32_MAX - timer->cnt + 1;
+  }
+  for(int ch = 0; ch < RTCC_CC_COUNT; ch++){
+      uint64_t to_match = (uint32_t)(regs->CC[ch].CCV - timer->cnt);
+      if(!to_match){
+          to_match = (uint64_t)UINT32_MAX + 1;
+      }
+      if(sim_rtcc_compare(ch) && (regs->IEN & (RTCC_IEN_CC0 << ch)) && (to_match < ticks)){
+          ticks = to_match;
+      }
+  }
+  if(ticks == SIM_NEVER){
+      return SIM_NEVER;
+  }
+  return timer->last_tick + ticks * sim_rtcc_tick_ps();
+}
+
+static bool sim_rtcc_compare(int ch){
+  return (sim_rtcc.CC[ch].CTRL_[0] & _RTCC_CC_CTRL_MODE_MASK) == RTCC_CC_CTRL_MODE_OUTPUTCOMPARE;
+}
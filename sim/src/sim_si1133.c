@@ -0,0 +1,389 @@
+/**
+ * @file sim_si1133.c
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Simulated SI1133 light sensor on an I2C bus.  Models the register
+ *        map with its auto-incrementing address pointer, the COMMAND and
+ *        RESPONSE0 counter handshake, the parameter table behind
+ *        PARAM_QUERY and PARAM_SET, and FORCE measurements that land in
+ *        HOSTOUT after their conversion time.  NACKs and clock stretching can
+ *        be injected to exercise the I2C driver.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "em_assert.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SI1133_ADDR         0x55
+
+#define SI1133_PART_ID      0x00    // Registers
+#define SI1133_REV_ID       0x01
+#define SI1133_MFR_ID       0x02
+#define SI1133_HOSTIN0      0x0A
+#define SI1133_COMMAND      0x0B
+#define SI1133_IRQ_ENABLE   0x0F
+#define SI1133_RESPONSE1    0x10
+#define SI1133_RESPONSE0    0x11
+#define SI1133_IRQ_STATUS   0x12
+#define SI1133_HOSTOUT0     0x13
+#define SI1133_REGS         0x2D
+
+#define SI1133_CMD_RESET_CTR 0x00   // Commands
+#define SI1133_CMD_RESET_SW 0x01
+#define SI1133_CMD_FORCE    0x11
+#define SI1133_CMD_PAUSE    0x12
+#define SI1133_CMD_START    0x13
+#define SI1133_CMD_QUERY    0x40
+#define SI1133_CMD_SET      0x80
+#define SI1133_CMD_PARAM    0x3F
+
+#define SI1133_PARAM_CHAN_LIST  0x01    // Parameter table
+#define SI1133_PARAM_ADCCONFIG0 0x02
+#define SI1133_PARAM_CHAN_STEP  4       // ADCCONFIG, ADCSENS, ADCPOST, MEASCONFIG per channel
+#define SI1133_PARAMS       0x2D
+#define SI1133_CHANNELS     6
+
+#define SI1133_RSP_CTR      0x0F    // RESPONSE0
+#define SI1133_RSP_ERR      0x10
+#define SI1133_RSP_SLEEP    0x20
+#define SI1133_RSP_RUNNING  0x80
+#define SI1133_ERR_CMD      0x10    // Error codes in RESPONSE0 with SI1133_RSP_ERR
+#define SI1133_ERR_PARAM    0x11
+
+#define SI1133_ADCSENS_GAIN 0x0F
+#define SI1133_ADCPOST_24   0x40
+#define SI1133_DECIM_SHIFT  5
+
+#define SI1133_PART         0x33
+#define SI1133_REV          0x11
+#define SI1133_MFR          0x06
+#define SI1133_CMD_TIME     (25 * SIM_PS_PER_US)    // Command handling by the sequencer
+#define SI1133_BOOT_TIME    (10 * SIM_PS_PER_MS)    // RESET_SW until commands are taken
+#define SI1133_CONV_TIME    48800000ULL             // 48.8 us per channel at HW_GAIN 0, decim 1024
+#define SI1133_ACTIVE_UA    4250.0  // Sequencer busy with a command or conversion
+#define SI1133_STANDBY_UA   0.5
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static SIM_SI1133_OPEN si1133_open;
+static uint8_t  si1133_regs[SI1133_REGS];
+static uint8_t  si1133_params[SI1133_PARAMS];
+static uint8_t  si1133_pointer;
+static bool     si1133_first;       // Next written byte is the register address
+static uint64_t si1133_ready;       // Sequencer busy with a command or conversion until then
+static uint32_t si1133_addressed;
+
+static uint32_t stat_transactions;
+static uint32_t stat_nacks;
+static uint32_t stat_commands;
+static uint32_t stat_measurements;
+static uint64_t stat_bytes;
+static uint64_t stat_busy_ps;
+static uint64_t stat_start;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static void sim_si1133_reset(void);
+static void sim_si1133_respond(uint8_t response);
+static void sim_si1133_command(uint8_t cmd);
+static void sim_si1133_force(void);
+static void sim_si1133_done(void *arg);
+static bool sim_si1133_start(bool read);
+static bool sim_si1133_write(uint8_t data);
+static uint8_t sim_si1133_read(void);
+static void sim_si1133_stop(void);
+static uint64_t sim_si1133_stretch(void);
+static double sim_si1133_current(void *ctx);
+static void sim_si1133_report(void);
+
+static const SIM_I2C_SLAVE si1133_slave = {
+  SI1133_ADDR, sim_si1133_start, sim_si1133_write, sim_si1133_read, sim_si1133_stop,
+  sim_si1133_stretch
+};
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Puts the SI1133 on an I2C bus
+ *
+ ******************************************************************************/
+
+void sim_si1133_open(I2C_TypeDef *i2c, const SIM_SI1133_OPEN *open){
+  si1133_open = *open;
+  sim_si1133_reset();
+  sim_i2c_attach(i2c, &si1133_slave);
+  sim_energy_load("Sensor", "SI1133", sim_si1133_current, NULL);
+  atexit(sim_si1133_report);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Changes the NACK injection during a run, every th address from the next
+ *   one on, 0 for none
+ *
+ ******************************************************************************/
+
+void sim_si1133_nack(uint32_t every){
+  si1133_open.nack_every = every;
+  si1133_addressed = 0;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Power on or RESET_SW state, the parameter table is cleared
+ *
+ ******************************************************************************/
+
+static void sim_si1133_reset(void){
+  memset(si1133_regs, 0, sizeof(si1133_regs));
+  memset(si1133_params, 0, sizeof(si1133_params));
+  si1133_regs[SI1133_PART_ID] = SI1133_PART;
+  si1133_regs[SI1133_REV_ID] = SI1133_REV;
+  si1133_regs[SI1133_MFR_ID] = SI1133_MFR;
+  si1133_regs[SI1133_RESPONSE0] = SI1133_RSP_SLEEP;
+  si1133_params[0] = SI1133_ADDR;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Completes a command, bumping the counter or reporting an error code
+ *
+ ******************************************************************************/
+
+static void sim_si1133_respond(uint8_t response){
+  uint8_t rsp0 = si1133_regs[SI1133_RESPONSE0] & ~(SI1133_RSP_CTR | SI1133_RSP_ERR);
+
+  if(response & SI1133_RSP_ERR){
+      si1133_regs[SI1133_RESPONSE0] = rsp0 | response;
+  } else {
+      si1133_regs[SI1133_RESPONSE0] = rsp0 | ((si1133_regs[SI1133_RESPONSE0] + 1) & SI1133_RSP_CTR);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   A write to COMMAND
+ *
+ * @details
+ *   As on the part, a command written while an error is pending is ignored
+ *   until RESET_CMD_CTR, and one written while the sequencer is still busy
+ *   is lost.
+ *
+ ******************************************************************************/
+
+static void sim_si1133_command(uint8_t cmd){
+  uint8_t param = cmd & SI1133_CMD_PARAM;
+
+  stat_commands++;
+  if(cmd == SI1133_CMD_RESET_CTR){
+      si1133_regs[SI1133_RESPONSE0] &= ~(SI1133_RSP_CTR | SI1133_RSP_ERR);
+      return;
+  }
+  if((si1133_regs[SI1133_RESPONSE0] & SI1133_RSP_ERR) || (sim_now() < si1133_ready)){
+      sim_log("SI1133 dropped command 0x%02x, %s", cmd,
+              (sim_now() < si1133_ready) ? "sequencer busy" : "error pending");
+      return;
+  }
+  si1133_ready = sim_now() + SI1133_CMD_TIME;
+  if(cmd == SI1133_CMD_RESET_SW){
+      sim_si1133_reset();
+      si1133_ready = sim_now() + SI1133_BOOT_TIME;
+  } else if(cmd == SI1133_CMD_FORCE){
+      sim_si1133_force();
+  } else if((cmd == SI1133_CMD_PAUSE) || (cmd == SI1133_CMD_START)){
+      sim_si1133_respond(0);
+  } else if(((cmd & ~SI1133_CMD_PARAM) == SI1133_CMD_QUERY) || ((cmd & ~SI1133_CMD_PARAM) == SI1133_CMD_SET)){
+      if(param >= SI1133_PARAMS){
+          sim_si1133_respond(SI1133_RSP_ERR | SI1133_ERR_PARAM);
+          return;
+      }
+      if(cmd & SI1133_CMD_SET){
+          si1133_params[param] = si1133_regs[SI1133_HOSTIN0];
+      }
+      si1133_regs[SI1133_RESPONSE1] = si1133_params[param];
+      sim_si1133_respond(0);
+  } else {
+      sim_si1133_respond(SI1133_RSP_ERR | SI1133_ERR_CMD);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   FORCE, one measurement of every channel in CHAN_LIST
+ *
+ * @details
+ *   Each channel converts for 48.8 us scaled by its decimation and by
+ *   2^HW_GAIN, results arrive in HOSTOUT together once all are done.
+ *
+ ******************************************************************************/
+
+static void sim_si1133_force(void){
+  static const uint32_t decim_1024ths[] = { 1024, 2048, 4096, 512 };
+  uint8_t chan_list = si1133_params[SI1133_PARAM_CHAN_LIST];
+  uint64_t conv = 0;
+
+  for(uint32_t ch = 0; ch < SI1133_CHANNELS; ch++){
+      const uint8_t *cfg = &si1133_params[SI1133_PARAM_ADCCONFIG0 + (ch * SI1133_PARAM_CHAN_STEP)];
+      if(chan_list & (0x01 << ch)){
+          conv += (SI1133_CONV_TIME * decim_1024ths[(cfg[0] >> SI1133_DECIM_SHIFT) & 0x03] / 1024)
+                  << (cfg[1] & SI1133_ADCSENS_GAIN);
+      }
+  }
+  si1133_regs[SI1133_RESPONSE0] |= SI1133_RSP_RUNNING;
+  si1133_ready = sim_now() + SI1133_CMD_TIME + conv;
+  sim_event_at(si1133_ready, sim_si1133_done, NULL);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   End of a FORCE conversion, results are packed into HOSTOUT in channel
+ *   order, 16 or 24 bits big endian as ADCPOST asks
+ *
+ ******************************************************************************/
+
+static void sim_si1133_done(void *arg){
+  uint8_t chan_list = si1133_params[SI1133_PARAM_CHAN_LIST];
+  uint32_t out = SI1133_HOSTOUT0;
+  (void)arg;
+
+  for(uint32_t ch = 0; ch < SI1133_CHANNELS; ch++){
+      const uint8_t *cfg = &si1133_params[SI1133_PARAM_ADCCONFIG0 + (ch * SI1133_PARAM_CHAN_STEP)];
+      uint32_t counts;
+      if(!(chan_list & (0x01 << ch))){
+          continue;
+      }
+      counts = si1133_open.light << (cfg[1] & SI1133_ADCSENS_GAIN);
+      if(cfg[2] & SI1133_ADCPOST_24){
+          counts = (counts > 0xFFFFFF) ? 0xFFFFFF : counts;
+          si1133_regs[out++] = (uint8_t)(counts >> 16);
+      } else {
+          counts = (counts > 0xFFFF) ? 0xFFFF : counts;
+      }
+      si1133_regs[out++] = (uint8_t)(counts >> 8);
+      si1133_regs[out++] = (uint8_t)counts;
+  }
+  si1133_regs[SI1133_IRQ_STATUS] |= chan_list & si1133_regs[SI1133_IRQ_ENABLE];
+  si1133_regs[SI1133_RESPONSE0] &= ~SI1133_RSP_RUNNING;
+  sim_si1133_respond(0);
+  stat_measurements++;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Addressed by the master, every nth address is NACKed when injected
+ *
+ ******************************************************************************/
+
+static bool sim_si1133_start(bool read){
+  si1133_addressed++;
+  if(si1133_open.nack_every && !(si1133_addressed % si1133_open.nack_every)){
+      stat_nacks++;
+      sim_log("SI1133 injected NACK of its address");
+      return false;
+  }
+  if(!stat_start){
+      stat_start = sim_now();
+  }
+  si1133_first = !read;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Byte from the master, the first of a write is the register address
+ *
+ ******************************************************************************/
+
+static bool sim_si1133_write(uint8_t data){
+  stat_bytes++;
+  if(si1133_first){
+      si1133_first = false;
+      si1133_pointer = data;
+      return true;
+  }
+  if(si1133_pointer < SI1133_REGS){
+      if(si1133_pointer == SI1133_COMMAND){
+          sim_si1133_command(data);
+      } else if((si1133_pointer == SI1133_HOSTIN0) || (si1133_pointer == SI1133_IRQ_ENABLE)){
+          si1133_regs[si1133_pointer] = data;
+      }
+  }
+  si1133_pointer++;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Byte to the master from the register pointer, IRQ_STATUS clears on read
+ *
+ ******************************************************************************/
+
+static uint8_t sim_si1133_read(void){
+  uint8_t data = (si1133_pointer < SI1133_REGS) ? si1133_regs[si1133_pointer] : 0;
+
+  stat_bytes++;
+  if(si1133_pointer == SI1133_IRQ_STATUS){
+      si1133_regs[SI1133_IRQ_STATUS] = 0;
+  }
+  si1133_pointer++;
+  return data;
+}
+
+static void sim_si1133_stop(void){
+  if(stat_start){
+      stat_transactions++;
+      stat_busy_ps += sim_now() - stat_start;
+      stat_start = 0;
+  }
+}
+
+static uint64_t sim_si1133_stretch(void){
+  return si1133_open.stretch_ps;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Bus statistics for the end of run report
+ *
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief
+ *   Supply current for the energy model
+ *
+ ******************************************************************************/
+
+static double sim_si1133_current(void *ctx){
+  (void)ctx;
+  return (sim_now() < si1133_ready) ? SI1133_ACTIVE_UA : SI1133_STANDBY_UA;
+}
+
+static void sim_si1133_report(void){
+  if(!si1133_addressed){
+      return;
+  }
+  printf("  SI1133    %lu transactions, %llu bytes, %lu commands, %lu measurements, %lu NACKs injected\n",
+         (unsigned long)stat_transactions, (unsigned long long)stat_bytes, (unsigned long)stat_commands,
+         (unsigned long)stat_measurements, (unsigned long)stat_nacks);
+  if(stat_transactions){
+      printf("  SI1133    %.1f us per transaction from address to STOP\n",
+             (double)stat_busy_ps / stat_transactions / SIM_PS_PER_US);
+  }
+  fflush(stdout);
+}
@@ -0,0 +1,403 @@
+/**
+ * @file sim_timer.c
+ * @author Shambaditya Tarafder
+ * @date 12/4/2021
+ * @brief Simulated TIMER0, TIMER1 and WTIMER0.  Up and down counting from
+ *        the prescaled HFPERCLK with one-shot mode, buffered TOP and compare
+ *        values taken on overflow, the OF and UF interrupts and the UFOF
+ *        request to the LDMA.  The request is a level: with DMACLRACT the
+ *        channel taking it clears it, without it the channel keeps taking
+ *        it, as on the part.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#define SIM_MODEL_SOURCE
+#include "sim.h"
+#include "em_assert.h"
+#include "em_timer.h"
+#include "em_ldma.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TIMER_RUN_EM        1       // HFPERCLK stops in EM2
+#define TIMER_CC_CHANNELS   4
+#define TIMER_MAX_16        0xFFFFUL
+#define TIMER_MAX_32        0xFFFFFFFFUL
+#define TIMER_DMA_SPIN      256     // Requests a held UFOF makes per wrap, the
+                                    // LDMA takes them at bus speed on the part
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+typedef struct {
+  TIMER_TypeDef     *regs;
+  CMU_Clock_TypeDef clock;
+  uint32_t          max;                        // 16 bit TIMER or 32 bit WTIMER
+  uint32_t          dma_signal;                 // LDMA request raised on UF and OF
+  bool              dma_req;                    // That request is up
+  bool              running;
+  uint32_t          cnt;                        // CNT as last published to the register
+  bool              topb_valid;
+  uint32_t          topb;
+  bool              ccvb_valid[TIMER_CC_CHANNELS];
+  uint32_t          ccvb[TIMER_CC_CHANNELS];    // CCVB as last seen, a change is a write
+  uint64_t          last_tick;
+  uint64_t          last;
+} SIM_TIMER;
+
+TIMER_TypeDef sim_timer0 SIM_EM4_RESET = { .TOP = TIMER_MAX_16 };
+TIMER_TypeDef sim_timer1 SIM_EM4_RESET = { .TOP = TIMER_MAX_16 };
+TIMER_TypeDef sim_wtimer0 SIM_EM4_RESET = { .TOP = TIMER_MAX_32 };
+
+static SIM_TIMER timer0 SIM_EM4_RESET = {
+  .regs = &sim_timer0, .clock = cmuClock_TIMER0, .max = TIMER_MAX_16,
+  .dma_signal = ldmaPeripheralSignal_TIMER0_UFOF
+};
+static SIM_TIMER timer1 SIM_EM4_RESET = {
+  .regs = &sim_timer1, .clock = cmuClock_TIMER1, .max = TIMER_MAX_16,
+  .dma_signal = ldmaPeripheralSignal_TIMER1_UFOF
+};
+static SIM_TIMER wtimer0 SIM_EM4_RESET = {
+  .regs = &sim_wtimer0, .clock = cmuClock_WTIMER0, .max = TIMER_MAX_32,
+  .dma_signal = ldmaPeripheralSignal_WTIMER0_UFOF
+};
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static SIM_TIMER *sim_timer_get(TIMER_TypeDef *timer);
+static bool sim_timer_clocked(SIM_TIMER *timer);
+static uint64_t sim_timer_tick_ps(SIM_TIMER *timer);
+static uint32_t sim_timer_mode(SIM_TIMER *timer);
+static uint64_t sim_timer_to_wrap(SIM_TIMER *timer);
+static void sim_timer_wrap(SIM_TIMER *timer);
+static void sim_timer_dma(SIM_TIMER *timer);
+static void sim_timer_sync(void *ctx, uint64_t now);
+static uint64_t sim_timer_next(void *ctx);
+
+const SIM_MODEL sim_timer0_model = {
+  "TIMER0", &timer0, TIMER0_IRQn, &sim_timer0.IF_[0], &sim_timer0.IEN_[0],
+  sim_timer_sync, sim_timer_next, NULL, NULL
+};
+
+const SIM_MODEL sim_timer1_model = {
+  "TIMER1", &timer1, TIMER1_IRQn, &sim_timer1.IF_[0], &sim_timer1.IEN_[0],
+  sim_timer_sync, sim_timer_next, NULL, NULL
+};
+
+const SIM_MODEL sim_wtimer0_model = {
+  "WTIMER0", &wtimer0, WTIMER0_IRQn, &sim_wtimer0.IF_[0], &sim_wtimer0.IEN_[0],
+  sim_timer_sync, sim_timer_next, NULL, NULL
+};
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+void TIMER_Init(TIMER_TypeDef *timer, const TIMER_Init_TypeDef *init){
+  sim_sync();
+  if(!init->enable){
+      timer->CMD = TIMER_CMD_STOP;
+  }
+  timer->CNT = 0;
+  timer->CTRL = ((uint32_t)init->prescale << _TIMER_CTRL_PRESC_SHIFT)
+                | ((uint32_t)init->clkSel << _TIMER_CTRL_CLKSEL_SHIFT)
+                | ((uint32_t)init->fallAction << _TIMER_CTRL_FALLA_SHIFT)
+                | ((uint32_t)init->riseAction << _TIMER_CTRL_RISEA_SHIFT)
+                | ((uint32_t)init->mode << _TIMER_CTRL_MODE_SHIFT)
+                | (init->debugRun ? TIMER_CTRL_DEBUGRUN : 0)
+                | (init->dmaClrAct ? TIMER_CTRL_DMACLRACT : 0)
+                | (init->quadModeX4 ? TIMER_CTRL_QDM_X4 : 0)
+                | (init->oneShot ? TIMER_CTRL_OSMEN : 0)
+                | (init->count2x ? TIMER_CTRL_X2CNT : 0)
+                | (init->ati ? TIMER_CTRL_ATI : 0)
+                | (init->sync ? TIMER_CTRL_SYNC : 0);
+  if(init->enable){
+      timer->CMD = TIMER_CMD_START;
+  }
+}
+
+void TIMER_InitCC(TIMER_TypeDef *timer, unsigned int ch, const TIMER_InitCC_TypeDef *init){
+  EFM_ASSERT(ch < TIMER_CC_CHANNELS);
+  sim_sync();
+  timer->CC[ch].CTRL = ((uint32_t)init->mode << _TIMER_CC_CTRL_MODE_SHIFT)
+                       | ((uint32_t)init->cmoa << _TIMER_CC_CTRL_CMOA_SHIFT)
+                       | ((uint32_t)init->cofoa << _TIMER_CC_CTRL_COFOA_SHIFT)
+                       | ((uint32_t)init->cufoa << _TIMER_CC_CTRL_CUFOA_SHIFT)
+                       | (init->coist ? TIMER_CC_CTRL_COIST : 0)
+                       | (init->outInvert ? TIMER_CC_CTRL_OUTINV : 0);
+}
+
+void TIMER_Enable(TIMER_TypeDef *timer, bool enable){
+  sim_sync();
+  timer->CMD = enable ? TIMER_CMD_START : TIMER_CMD_STOP;
+}
+
+void TIMER_TopSet(TIMER_TypeDef *timer, uint32_t val){
+  sim_sync();
+  timer->TOP = val & sim_timer_get(timer)->max;
+}
+
+void TIMER_TopBufSet(TIMER_TypeDef *timer, uint32_t val){
+  SIM_TIMER *model = sim_timer_get(timer);
+
+  sim_sync();
+  timer->TOPB = val & model->max;
+  model->topb = val & model->max;
+  model->topb_valid = true;
+}
+
+uint32_t TIMER_TopGet(TIMER_TypeDef *timer){
+  return timer->TOP;
+}
+
+void TIMER_CounterSet(TIMER_TypeDef *timer, uint32_t val){
+  sim_sync();
+  timer->CNT = val & sim_timer_get(timer)->max;
+}
+
+uint32_t TIMER_CounterGet(TIMER_TypeDef *timer){
+  sim_sync();
+  return timer->CNT;
+}
+
+void TIMER_CompareSet(TIMER_TypeDef *timer, unsigned int ch, uint32_t val){
+  EFM_ASSERT(ch < TIMER_CC_CHANNELS);
+  sim_sync();
+  timer->CC[ch].CCV = val & sim_timer_get(timer)->max;
+}
+
+void TIMER_CompareBufSet(TIMER_TypeDef *timer, unsigned int ch, uint32_t val){
+  SIM_TIMER *model = sim_timer_get(timer);
+
+  EFM_ASSERT(ch < TIMER_CC_CHANNELS);
+  sim_sync();
+  timer->CC[ch].CCVB = val & model->max;
+  model->ccvb[ch] = val & model->max;
+  model->ccvb_valid[ch] = true;
+}
+
+void TIMER_IntClear(TIMER_TypeDef *timer, uint32_t flags){
+  sim_sync();
+  timer->IFC = flags;
+}
+
+void TIMER_IntEnable(TIMER_TypeDef *timer, uint32_t flags){
+  sim_sync();
+  timer->IEN |= flags;
+}
+
+void TIMER_IntDisable(TIMER_TypeDef *timer, uint32_t flags){
+  sim_sync();
+  timer->IEN &= ~flags;
+}
+
+uint32_t TIMER_IntGet(TIMER_TypeDef *timer){
+  sim_sync();
+  return timer->IF;
+}
+
+uint32_t TIMER_MaxCount(TIMER_TypeDef *timer){
+  return sim_timer_get(timer)->max;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Model behind a TIMER register block
+ *
+ ******************************************************************************/
+
+static SIM_TIMER *sim_timer_get(TIMER_TypeDef *timer){
+  if(timer == TIMER0){
+      return &timer0;
+  }
+  if(timer == TIMER1){
+      return &timer1;
+  }
+  EFM_ASSERT(timer == WTIMER0);
+  return &wtimer0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Whether the timer counts at all in the present clock and energy state
+ *
+ ******************************************************************************/
+
+static bool sim_timer_clocked(SIM_TIMER *timer){
+  return sim_cmu_running(timer->clock) && (sim_energy_mode() <= TIMER_RUN_EM);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Picoseconds per count with the present HFPERCLK and prescaler
+ *
+ ******************************************************************************/
+
+static uint64_t sim_timer_tick_ps(SIM_TIMER *timer){
+  uint32_t presc = (timer->regs->CTRL & _TIMER_CTRL_PRESC_MASK) >> _TIMER_CTRL_PRESC_SHIFT;
+  return ((SIM_PS_PER_S << presc) / CMU_ClockFreqGet(timer->clock));
+}
+
+static uint32_t sim_timer_mode(SIM_TIMER *timer){
+  return (timer->regs->CTRL & _TIMER_CTRL_MODE_MASK) >> _TIMER_CTRL_MODE_SHIFT;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Counts until the next overflow or underflow
+ *
+ ******************************************************************************/
+
+static uint64_t sim_timer_to_wrap(SIM_TIMER *timer){
+  uint32_t top = timer->regs->TOP;
+
+  if(sim_timer_mode(timer) == timerModeDown){
+      return (uint64_t)timer->cnt + 1;
+  }
+  if(timer->cnt > top){
+      // Past TOP the counter runs round through its full range first
+      return (uint64_t)(timer->max - timer->cnt) + top + 2;
+  }
+  return (uint64_t)(top - timer->cnt) + 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Overflow or underflow
+ *
+ * @details
+ *   Raises OF or UF, loads the buffered TOP and compare values, requests the
+ *   LDMA and in one-shot mode stops the timer.
+ *
+ ******************************************************************************/
+
+static void sim_timer_wrap(SIM_TIMER *timer){
+  TIMER_TypeDef *regs = timer->regs;
+
+  if(sim_timer_mode(timer) == timerModeDown){
+      regs->IF |= TIMER_IF_UF;
+      timer->cnt = regs->TOP;
+  } else {
+      regs->IF |= TIMER_IF_OF;
+      timer->cnt = 0;
+  }
+  if(timer->topb_valid){
+      regs->TOP = timer->topb;
+      timer->topb_valid = false;
+  }
+  for(uint32_t ch = 0; ch < TIMER_CC_CHANNELS; ch++){
+      if(timer->ccvb_valid[ch]){
+          regs->CC[ch].CCV = timer->ccvb[ch];
+          timer->ccvb_valid[ch] = false;
+      }
+  }
+  if(regs->CTRL & TIMER_CTRL_OSMEN){
+      timer->running = false;
+  }
+  timer->dma_req = true;
+  sim_timer_dma(timer);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Hands the UFOF request to the LDMA while it is up
+ *
+ * @details
+ *   With DMACLRACT set the first channel to take it clears it.  Without, it
+ *   stays up and the channels keep taking it, bounded to TIMER_DMA_SPIN per
+ *   wrap here; a request no channel takes waits for the next wrap.
+ *
+ ******************************************************************************/
+
+static void sim_timer_dma(SIM_TIMER *timer){
+  uint32_t spin = 0;
+
+  while(timer->dma_req && (spin++ < TIMER_DMA_SPIN) && sim_ldma_request(timer->dma_signal)){
+      if(timer->regs->CTRL & TIMER_CTRL_DMACLRACT){
+          timer->dma_req = false;
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes the register writes since the last sync and counts up to now
+ *
+ ******************************************************************************/
+
+static void sim_timer_sync(void *ctx, uint64_t now){
+  SIM_TIMER *timer = ctx;
+  TIMER_TypeDef *regs = timer->regs;
+
+  if(regs->CMD & TIMER_CMD_START){
+      if(!timer->running){
+          timer->last_tick = timer->last;
+      }
+      timer->running = true;
+  }
+  if(regs->CMD & TIMER_CMD_STOP){
+      timer->running = false;
+  }
+  regs->CMD = 0;
+  if(regs->CNT != timer->cnt){
+      timer->cnt = regs->CNT & timer->max;
+  }
+  if(regs->TOPB != timer->topb){
+      timer->topb = regs->TOPB & timer->max;
+      timer->topb_valid = true;
+  }
+  for(uint32_t ch = 0; ch < TIMER_CC_CHANNELS; ch++){
+      if(regs->CC[ch].CCVB != timer->ccvb[ch]){
+          timer->ccvb[ch] = regs->CC[ch].CCVB & timer->max;
+          timer->ccvb_valid[ch] = true;
+      }
+  }
+  regs->IF |= regs->IFS & _TIMER_IF_MASK;
+  regs->IF &= ~regs->IFC;
+  regs->IFS = 0;
+  regs->IFC = 0;
+
+  if(timer->running && sim_timer_clocked(timer)){
+      uint64_t tick_ps = sim_timer_tick_ps(timer);
+      uint64_t ticks = (now - timer->last_tick) / tick_ps;
+      timer->last_tick += ticks * tick_ps;
+      while(timer->running && ticks){
+          uint64_t to_wrap = sim_timer_to_wrap(timer);
+          if(ticks < to_wrap){
+              timer->cnt = (sim_timer_mode(timer) == timerModeDown) ? timer->cnt - (uint32_t)ticks
+                                                                     : (timer->cnt + (uint32_t)ticks) & timer->max;
+              break;
+          }
+          ticks -= to_wrap;
+          sim_timer_wrap(timer);
+      }
+  } else {
+      timer->last_tick = now;
+  }
+  regs->CNT = timer->cnt;
+  regs->STATUS = (timer->running ? TIMER_STATUS_RUNNING : 0)
+                 | ((sim_timer_mode(timer) == timerModeDown) ? TIMER_STATUS_DIR : 0);
+  timer->last = now;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Time of the next overflow or underflow while the timer counts
+ *
+ ******************************************************************************/
+
+static uint64_t sim_timer_next(void *ctx){
+  SIM_TIMER *timer = ctx;
+
+  if(!timer->running || !sim_timer_clocked(timer)){
+      return SIM_NEVER;
+  }
+  return timer->last_tick + sim_timer_to_wrap(timer) * sim_timer_tick_ps(timer);
+}
@@ -0,0 +1,277 @@
+/**
+ * @file sim_vcd.c
+ * @author Shambaditya Tarafder
+ * @date 12/9/2021
+ * @brief Waveforms of the simulated pins for GTKWave.  The models report
+ *        every level change of the GPIO pins, the LETIMER0 outputs, the
+ *        LEUART0 TX and RX lines, SCL and SDA of both I2C buses and the
+ *        energy mode, they are written out as a VCD file at the end of the
+ *        run.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "em_assert.h"
+#include "em_gpio.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define VCD_CHANGES_MAX     (1UL << 22)     // 96 MB of changes, the rest of the run is dropped
+#define VCD_CHANGES_FIRST   4096
+#define VCD_PS_PER_UNIT     1000            // $timescale 1 ns
+#define VCD_ID_FIRST        '!'             // Identifier codes run from ! to ~
+#define VCD_ID_CHARS        ('~' - '!' + 1)
+#define VCD_EM_BITS         3
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+typedef struct {
+  uint64_t  when;
+  uint32_t  seq;                    // Order of the reports, keeps equal times in order
+  uint16_t  signal;
+  uint16_t  value;
+} VCD_CHANGE;
+
+static const char *vcd_path;
+static VCD_CHANGE *vcd_changes;
+static uint32_t    vcd_count;
+static uint32_t    vcd_size;
+static bool        vcd_full;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static int sim_vcd_order(const void *a, const void *b);
+static void sim_vcd_name(uint32_t signal, char *scope, char *name, size_t size);
+static uint32_t sim_vcd_width(uint32_t signal);
+static uint32_t sim_vcd_idle(uint32_t signal);
+static void sim_vcd_id(uint32_t index, char *id);
+static void sim_vcd_value(FILE *file, uint32_t signal, uint32_t value, const char *id);
+static void sim_vcd_write(void);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Starts taking down the level changes, written to path when the run ends
+ *
+ ******************************************************************************/
+
+void sim_vcd_open(const char *path){
+  vcd_path = path;
+  atexit(sim_vcd_write);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   A signal changes level at virtual time when
+ *
+ * @details
+ *   The models run in bursts up to the present, so the reports come in
+ *   slightly out of time order and are sorted when the file is written.
+ *   Reports of the level a signal already has are dropped then too.
+ *
+ * @param[in] signal
+ *   SIM_VCD_EM to SIM_VCD_GPIO + port * 16 + pin
+ *
+ * @param[in] value
+ *   0 or 1, the energy mode for SIM_VCD_EM
+ *
+ ******************************************************************************/
+
+void sim_vcd_change(uint32_t signal, uint64_t when, uint32_t value){
+  if(!vcd_path || vcd_full){
+      return;
+  }
+  if(vcd_count == vcd_size){
+      if(vcd_size == VCD_CHANGES_MAX){
+          sim_log("waveform full after %lu changes, the rest is not in %s",
+                  (unsigned long)vcd_count, vcd_path);
+          vcd_full = true;
+          return;
+      }
+      vcd_size = vcd_size ? 2 * vcd_size : VCD_CHANGES_FIRST;
+      vcd_changes = realloc(vcd_changes, vcd_size * sizeof(VCD_CHANGE));
+      EFM_ASSERT(vcd_changes);
+  }
+  vcd_changes[vcd_count] = (VCD_CHANGE){ when, vcd_count, (uint16_t)signal, (uint16_t)value };
+  vcd_count++;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The wake-up from EM4H reset the MCU, its pins and the LETIMER0 outputs
+ *   are back at their reset levels
+ *
+ ******************************************************************************/
+
+void sim_vcd_reset(uint64_t when){
+  for(uint32_t signal = SIM_VCD_LETIMER0_OUT0; signal <= SIM_VCD_LETIMER0_OUT1; signal++){
+      sim_vcd_change(signal, when, sim_vcd_idle(signal));
+  }
+  for(uint32_t pin = 0; pin < SIM_VCD_GPIO_PINS; pin++){
+      sim_vcd_change(SIM_VCD_GPIO + pin, when, 0);
+  }
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static int sim_vcd_order(const void *a, const void *b){
+  const VCD_CHANGE *x = a;
+  const VCD_CHANGE *y = b;
+
+  if(x->when != y->when){
+      return (x->when < y->when) ? -1 : 1;
+  }
+  return (x->seq < y->seq) ? -1 : (x->seq > y->seq);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Scope and name of a signal, the GPIO pins as PA0 to PK15
+ *
+ ******************************************************************************/
+
+static void sim_vcd_name(uint32_t signal, char *scope, char *name, size_t size){
+  static const char *const names[][2] = {
+    [SIM_VCD_EM]            = { "emu",      "energy_mode" },
+    [SIM_VCD_LETIMER0_OUT0] = { "letimer0", "out0" },
+    [SIM_VCD_LETIMER0_OUT1] = { "letimer0", "out1" },
+    [SIM_VCD_LEUART0_TX]    = { "leuart0",  "tx" },
+    [SIM_VCD_LEUART0_RX]    = { "leuart0",  "rx" },
+    [SIM_VCD_I2C0_SCL]      = { "i2c0",     "scl" },
+    [SIM_VCD_I2C0_SDA]      = { "i2c0",     "sda" },
+    [SIM_VCD_I2C1_SCL]      = { "i2c1",     "scl" },
+    [SIM_VCD_I2C1_SDA]      = { "i2c1",     "sda" },
+  };
+
+  if(signal >= SIM_VCD_GPIO){
+      snprintf(scope, size, "gpio");
+      snprintf(name, size, "P%c%lu", 'A' + (int)((signal - SIM_VCD_GPIO) / (GPIO_PIN_MAX + 1)),
+               (unsigned long)((signal - SIM_VCD_GPIO) % (GPIO_PIN_MAX + 1)));
+  } else {
+      snprintf(scope, size, "%s", names[signal][0]);
+      snprintf(name, size, "%s", names[signal][1]);
+  }
+}
+
+static uint32_t sim_vcd_width(uint32_t signal){
+  return (signal == SIM_VCD_EM) ? VCD_EM_BITS : 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Level of a signal before its first change, the UART and I2C lines idle
+ *   high
+ *
+ ******************************************************************************/
+
+static uint32_t sim_vcd_idle(uint32_t signal){
+  return (signal >= SIM_VCD_LEUART0_TX) && (signal <= SIM_VCD_I2C1_SDA);
+}
+
+static void sim_vcd_id(uint32_t index, char *id){
+  do {
+      *id++ = (char)(VCD_ID_FIRST + index % VCD_ID_CHARS);
+      index /= VCD_ID_CHARS;
+  } while(index);
+  *id = '\0';
+}
+
+static void sim_vcd_value(FILE *file, uint32_t signal, uint32_t value, const char *id){
+  if(sim_vcd_width(signal) == 1){
+      fprintf(file, "%lu%s\n", (unsigned long)(value & 1), id);
+      return;
+  }
+  fputc('b', file);
+  for(int32_t bit = (int32_t)sim_vcd_width(signal) - 1; bit >= 0; bit--){
+      fputc('0' + ((value >> bit) & 1), file);
+  }
+  fprintf(file, " %s\n", id);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Writes the VCD file, at exit
+ *
+ * @details
+ *   Only the signals that change are declared, grouped into a scope per
+ *   peripheral, and the energy mode always.  The file ends at the time the
+ *   run ended.
+ *
+ ******************************************************************************/
+
+static void sim_vcd_write(void){
+  static uint32_t level[SIM_VCD_SIGNALS];
+  static char ids[SIM_VCD_SIGNALS][4];
+  static bool used[SIM_VCD_SIGNALS];
+  FILE *file = fopen(vcd_path, "w");
+  const char *open_scope = NULL;
+  uint32_t declared = 0;
+  uint64_t unit = 0;
+
+  if(!file){
+      perror(vcd_path);
+      return;
+  }
+  qsort(vcd_changes, vcd_count, sizeof(VCD_CHANGE), sim_vcd_order);
+  used[SIM_VCD_EM] = true;
+  for(uint32_t i = 0; i < vcd_count; i++){
+      used[vcd_changes[i].signal] |= vcd_changes[i].value != sim_vcd_idle(vcd_changes[i].signal);
+  }
+
+  fprintf(file, "$comment firmware_sim $end\n$timescale 1 ns $end\n$scope module firmware_sim $end\n");
+  for(uint32_t signal = 0; signal < SIM_VCD_SIGNALS; signal++){
+      static char scope[SIM_VCD_SIGNALS][16];
+      char name[16];
+
+      if(!used[signal]){
+          continue;
+      }
+      sim_vcd_name(signal, scope[signal], name, sizeof(name));
+      if(!open_scope || strcmp(open_scope, scope[signal])){
+          fprintf(file, "%s$scope module %s $end\n", open_scope ? "$upscope $end\n" : "", scope[signal]);
+          open_scope = scope[signal];
+      }
+      sim_vcd_id(declared++, ids[signal]);
+      fprintf(file, "$var wire %lu %s %s $end\n", (unsigned long)sim_vcd_width(signal), ids[signal], name);
+  }
+  fprintf(file, "$upscope $end\n$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n");
+  for(uint32_t signal = 0; signal < SIM_VCD_SIGNALS; signal++){
+      level[signal] = sim_vcd_idle(signal);
+      if(used[signal]){
+          sim_vcd_value(file, signal, level[signal], ids[signal]);
+      }
+  }
+  fprintf(file, "$end\n");
+
+  for(uint32_t i = 0; i < vcd_count; i++){
+      VCD_CHANGE *change = &vcd_changes[i];
+      if(!used[change->signal] || (level[change->signal] == change->value)){
+          continue;
+      }
+      level[change->signal] = change->value;
+      if(change->when / VCD_PS_PER_UNIT != unit){
+          unit = change->when / VCD_PS_PER_UNIT;
+          fprintf(file, "#%llu\n", (unsigned long long)unit);
+      }
+      sim_vcd_value(file, change->signal, change->value, ids[change->signal]);
+  }
+  if(sim_now() / VCD_PS_PER_UNIT != unit){
+      fprintf(file, "#%llu\n", (unsigned long long)(sim_now() / VCD_PS_PER_UNIT));
+  }
+  fclose(file);
+  free(vcd_changes);
+  vcd_changes = NULL;
+  vcd_count = 0;
+}
@@ -0,0 +1,609 @@
+/**
+ * @file stack_budget.c
+ * @author Shambaditya Tarafder
+ * @date 12/9/2021
+ * @brief Static RAM and stack budget of a firmware build, from its map file
+ *        and the .su and .ci files gcc writes with -fstack-usage
+ *        -fcallgraph-info=su.
+ *
+ *        Usage: stack_budget [-s bytes] [-r bytes] [-e bytes] [-n rows] [-m main] map su...
+ *
+ *        The RAM is the .stack, .noinit, .data and .bss sections of the map,
+ *        by module.  The stack estimate is the deepest call chain from main,
+ *        -m for a main() of another name,
+ *        plus the deepest function nothing calls directly (the scheduler
+ *        callbacks and tasks, run through pointers from the main loop), plus
+ *        the deepest interrupt handler and the -e bytes the core stacks on
+ *        an interrupt, 104 for a Cortex-M4 with an FPU context.  The handlers
+ *        are at one priority and do not nest.  Functions without stack
+ *        information, the libraries built without -fstack-usage, count 0
+ *        and are listed.  The run fails if the estimate is over -s, by
+ *        default the .stack section, or the static RAM over -r, by default
+ *        the RAM region.
+ *
+ *        On the board build the options go into toolchain_settings of the
+ *        .slcp, the map and the .su files are in the build directory.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define BUDGET_LINE_MAX     1024
+#define BUDGET_NAME_MAX     96
+#define BUDGET_ROWS         10
+#define BUDGET_IRQ_FRAME    104         // R0-R3, R12, LR, PC, xPSR, S0-S15, FPSCR and padding
+#define BUDGET_INDIRECT     "__indirect_call"
+#define BUDGET_HANDLER      "_IRQHandler"
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+typedef struct {
+  char          name[BUDGET_NAME_MAX];
+  char          file[BUDGET_NAME_MAX];
+  uint32_t      frame;
+  bool          known;              // In a .su file
+  bool          dynamic;            // The frame is not all static
+  bool          called;             // Called directly by a known function
+  uint32_t     *callees;
+  uint32_t      callee_count;
+  uint32_t      state;              // Of budget_worst(), BUDGET_NEW to BUDGET_DONE
+  uint32_t      worst;              // Deepest chain from here, frame included
+  uint32_t      next;               // Callee on that chain, UINT32_MAX at its end
+  bool          recursive;
+} BUDGET_FN;
+
+enum { BUDGET_NEW, BUDGET_VISITING, BUDGET_DONE };
+
+typedef struct {
+  char          name[BUDGET_NAME_MAX];
+  uint32_t      data;
+  uint32_t      bss;
+} BUDGET_MODULE;
+
+typedef struct {
+  char          name[BUDGET_NAME_MAX];
+  char          module[BUDGET_NAME_MAX];
+  uint32_t      size;
+} BUDGET_OBJECT;
+
+static BUDGET_FN     *fns;
+static uint32_t       fn_count;
+static BUDGET_MODULE *modules;
+static uint32_t       module_count;
+static BUDGET_OBJECT *objects;
+static uint32_t       object_count;
+static uint64_t       ram_length;
+static uint64_t       stack_section;
+static uint64_t       heap_section;
+static uint32_t       rows = BUDGET_ROWS;
+static const char    *main_name = "main";
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static void budget_map(const char *path);
+static void budget_input(const char *output, const char *name, uint64_t size, const char *file);
+static void budget_module_name(const char *file, char *name);
+static void budget_su(const char *path);
+static void budget_ci(const char *path);
+static const char *budget_ci_name(const char *name);
+static uint32_t budget_fn(const char *name);
+static void budget_call(uint32_t caller, uint32_t callee);
+static uint32_t budget_worst(uint32_t fn);
+static uint32_t budget_deepest(bool handlers);
+static void budget_chain(const char *what, uint32_t fn);
+static int budget_module_order(const void *a, const void *b);
+static int budget_object_order(const void *a, const void *b);
+static int budget_frame_order(const void *a, const void *b);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(int argc, char **argv){
+  uint64_t stack_limit = 0;
+  uint64_t ram_limit = 0;
+  uint32_t irq_frame = BUDGET_IRQ_FRAME;
+  uint32_t data = 0;
+  uint32_t bss = 0;
+  uint32_t main_fn = UINT32_MAX;
+  uint32_t root;
+  uint32_t handler;
+  uint64_t estimate;
+  bool over = false;
+  int opt;
+
+  while((opt = getopt(argc, argv, "s:r:e:n:m:")) != -1){
+      switch(opt){
+        case 's':
+          stack_limit = strtoull(optarg, NULL, 0);
+          break;
+        case 'r':
+          ram_limit = strtoull(optarg, NULL, 0);
+          break;
+        case 'e':
+          irq_frame = (uint32_t)strtoul(optarg, NULL, 0);
+          break;
+        case 'n':
+          rows = (uint32_t)strtoul(optarg, NULL, 0);
+          break;
+        case 'm':
+          main_name = optarg;
+          break;
+        default:
+          optind = argc + 1;
+          break;
+      }
+  }
+  if(argc - optind < 2){
+      fprintf(stderr, "usage: %s [-s bytes] [-r bytes] [-e bytes] [-n rows] [-m main] map su...\n", argv[0]);
+      return EXIT_FAILURE;
+  }
+  budget_map(argv[optind]);
+  for(int i = optind + 1; i < argc; i++){
+      budget_su(argv[i]);
+  }
+  for(int i = optind + 1; i < argc; i++){
+      budget_ci(argv[i]);
+  }
+  if(!stack_limit){
+      stack_limit = stack_section;
+  }
+  if(!ram_limit){
+      ram_limit = ram_length;
+  }
+
+  qsort(modules, module_count, sizeof(BUDGET_MODULE), budget_module_order);
+  printf("Static RAM, %s\n  %-20s %8s %8s %8s\n", argv[optind], "module", "data", "bss", "total");
+  for(uint32_t i = 0; i < module_count; i++){
+      printf("  %-20s %8u %8u %8u\n", modules[i].name, modules[i].data, modules[i].bss,
+             modules[i].data + modules[i].bss);
+      data += modules[i].data;
+      bss += modules[i].bss;
+  }
+  printf("  %-20s %8u %8u %8u\n", "total", data, bss, data + bss);
+  printf("  %-20s %8llu\n", ".stack", (unsigned long long)stack_section);
+  printf("  %-20s %8llu  the rest of RAM\n", ".heap", (unsigned long long)heap_section);
+  if(ram_limit){
+      printf("  static RAM and stack %llu of %llu, %.1f%%\n", (unsigned long long)(data + bss + stack_section),
+             (unsigned long long)ram_limit, 100.0 * (data + bss + stack_section) / ram_limit);
+      if(data + bss + stack_section > ram_limit){
+          printf("  OVER the RAM budget by %llu\n", (unsigned long long)(data + bss + stack_section - ram_limit));
+          over = true;
+      }
+  }
+  qsort(objects, object_count, sizeof(BUDGET_OBJECT), budget_object_order);
+  printf("  largest\n");
+  for(uint32_t i = 0; (i < object_count) && (i < rows); i++){
+      printf("    %-30s %-16s %8u\n", objects[i].name, objects[i].module, objects[i].size);
+  }
+
+  printf("Stack, %u functions in %d .su files\n", fn_count, argc - optind - 1);
+  for(uint32_t i = 0; i < fn_count; i++){
+      budget_worst(i);
+      if(!strcmp(fns[i].name, main_name)){
+          main_fn = i;
+      }
+  }
+  root = budget_deepest(false);
+  handler = budget_deepest(true);
+  if(main_fn != UINT32_MAX){
+      budget_chain("main", main_fn);
+  }
+  if(root != UINT32_MAX){
+      budget_chain("no direct caller", root);
+  }
+  if(handler != UINT32_MAX){
+      budget_chain("handler", handler);
+  }
+  printf("  %-17s %6u\n", "interrupt frame", irq_frame);
+  estimate = (uint64_t)((main_fn != UINT32_MAX) ? fns[main_fn].worst : 0)
+             + ((root != UINT32_MAX) ? fns[root].worst : 0)
+             + ((handler != UINT32_MAX) ? fns[handler].worst + irq_frame : 0);
+  printf("  %-17s %6llu", "estimate", (unsigned long long)estimate);
+  if(stack_limit){
+      printf(" of %llu, %.1f%%", (unsigned long long)stack_limit, 100.0 * estimate / stack_limit);
+  }
+  printf("\n");
+  if(stack_limit && (estimate > stack_limit)){
+      printf("  OVER the stack budget by %llu\n", (unsigned long long)(estimate - stack_limit));
+      over = true;
+  }
+
+  printf("  recursive:");
+  for(uint32_t i = 0; i < fn_count; i++){
+      if(fns[i].recursive){
+          printf(" %s", fns[i].name);
+      }
+  }
+  printf("\n  dynamic frames:");
+  for(uint32_t i = 0; i < fn_count; i++){
+      if(fns[i].dynamic){
+          printf(" %s", fns[i].name);
+      }
+  }
+  printf("\n  no stack information:");
+  for(uint32_t i = 0; i < fn_count; i++){
+      if(!fns[i].known && strcmp(fns[i].name, BUDGET_INDIRECT)){
+          printf(" %s", fns[i].name);
+      }
+  }
+  printf("\n  largest frames\n");
+  qsort(fns, fn_count, sizeof(BUDGET_FN), budget_frame_order);
+  for(uint32_t i = 0; (i < fn_count) && (i < rows) && fns[i].frame; i++){
+      printf("    %-30s %-16s %8u\n", fns[i].name, fns[i].file, fns[i].frame);
+  }
+  return over ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Reads the RAM region and the input sections of the RAM output sections
+ *
+ * @details
+ *   An output section starts in the first column, its input sections one
+ *   space in.  A name too long for its column has the address, size and
+ *   file on the next line.
+ *
+ ******************************************************************************/
+
+static void budget_map(const char *path){
+  FILE *file = fopen(path, "r");
+  char line[BUDGET_LINE_MAX];
+  char output[BUDGET_NAME_MAX] = "";
+  char pending[BUDGET_NAME_MAX] = "";
+  bool memory = false;
+
+  if(!file){
+      perror(path);
+      exit(EXIT_FAILURE);
+  }
+  while(fgets(line, sizeof(line), file)){
+      char name[BUDGET_NAME_MAX];
+      char object[BUDGET_LINE_MAX];
+      unsigned long long address;
+      unsigned long long size;
+      int fields;
+
+      if(!strncmp(line, "Memory Configuration", 20)){
+          memory = true;
+          continue;
+      }
+      if(!strncmp(line, "Linker script and memory map", 28)){
+          memory = false;
+          continue;
+      }
+      if(memory){
+          if((sscanf(line, "%95s %llx %llx", name, &address, &size) == 3) && !strcmp(name, "RAM")){
+              ram_length = size;
+          }
+          continue;
+      }
+      if(line[0] == '.'){
+          fields = sscanf(line, "%95s %llx %llx", output, &address, &size);
+          if(fields == 3){
+              if(!strcmp(output, ".stack")){
+                  stack_section = size;
+              } else if(!strcmp(output, ".heap")){
+                  heap_section = size;
+              }
+          }
+          pending[0] = '\0';
+          continue;
+      }
+      if(line[0] != ' '){
+          output[0] = '\0';
+          continue;
+      }
+      if((line[1] != ' ') && (line[1] != '*')){
+          fields = sscanf(line, "%95s %llx %llx %1023s", name, &address, &size, object);
+          if(fields == 1){
+              strcpy(pending, name);
+          } else if(fields == 4){
+              budget_input(output, name, size, object);
+          }
+          continue;
+      }
+      if(pending[0] && (sscanf(line, "%llx %llx %1023s", &address, &size, object) == 3)){
+          budget_input(output, pending, size, object);
+      }
+      pending[0] = '\0';
+  }
+  fclose(file);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Charges one input section to its module, if it lies in RAM
+ *
+ ******************************************************************************/
+
+static void budget_input(const char *output, const char *name, uint64_t size, const char *file){
+  BUDGET_MODULE *module = NULL;
+  char module_name[BUDGET_NAME_MAX];
+  bool bss = !strcmp(output, ".bss") || !strcmp(output, ".noinit");
+
+  if(!size || (!bss && strcmp(output, ".data"))){
+      return;
+  }
+  budget_module_name(file, module_name);
+  for(uint32_t i = 0; i < module_count; i++){
+      if(!strcmp(modules[i].name, module_name)){
+          module = &modules[i];
+      }
+  }
+  if(!module){
+      modules = realloc(modules, (module_count + 1) * sizeof(BUDGET_MODULE));
+      if(!modules){
+          exit(EXIT_FAILURE);
+      }
+      module = &modules[module_count++];
+      memset(module, 0, sizeof(BUDGET_MODULE));
+      snprintf(module->name, sizeof(module->name), "%s", module_name);
+  }
+  if(bss){
+      module->bss += (uint32_t)size;
+  } else {
+      module->data += (uint32_t)size;
+  }
+  objects = realloc(objects, (object_count + 1) * sizeof(BUDGET_OBJECT));
+  if(!objects){
+      exit(EXIT_FAILURE);
+  }
+  snprintf(objects[object_count].name, BUDGET_NAME_MAX, "%s", name);
+  snprintf(objects[object_count].module, BUDGET_NAME_MAX, "%s", module_name);
+  objects[object_count++].size = (uint32_t)size;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   build/fw/trace.o and libc.a(lib_a-memcpy.o) as trace and libc.a
+ *
+ ******************************************************************************/
+
+static void budget_module_name(const char *file, char *name){
+  const char *base = strrchr(file, '/');
+  char *end;
+
+  snprintf(name, BUDGET_NAME_MAX, "%s", base ? base + 1 : file);
+  end = strchr(name, '(');
+  if(!end){
+      end = strrchr(name, '.');
+  }
+  if(end && (end != name)){
+      *end = '\0';
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes the frames of a .su file, "file:line:column:name<tab>bytes<tab>kind"
+ *
+ ******************************************************************************/
+
+static void budget_su(const char *path){
+  FILE *file = fopen(path, "r");
+  char line[BUDGET_LINE_MAX];
+
+  if(!file){
+      perror(path);
+      exit(EXIT_FAILURE);
+  }
+  while(fgets(line, sizeof(line), file)){
+      char *tab = strchr(line, '\t');
+      char *name;
+      char *colon;
+      uint32_t fn;
+      uint32_t frame;
+
+      if(!tab){
+          continue;
+      }
+      *tab = '\0';
+      name = strrchr(line, ':');
+      name = name ? name + 1 : line;
+      frame = (uint32_t)strtoul(tab + 1, &tab, 10);
+      fn = budget_fn(name);
+      // The same static name in two files keeps the larger frame
+      if(!fns[fn].known || (frame > fns[fn].frame)){
+          fns[fn].frame = frame;
+          colon = strchr(line, ':');
+          if(colon){
+              *colon = '\0';
+          }
+          snprintf(fns[fn].file, BUDGET_NAME_MAX, "%.*s", BUDGET_NAME_MAX - 1, line);
+      }
+      fns[fn].known = true;
+      fns[fn].dynamic |= (strstr(tab, "dynamic") != NULL);
+  }
+  fclose(file);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes the calls of the .ci file next to a .su file
+ *
+ ******************************************************************************/
+
+static void budget_ci(const char *path){
+  char ci[BUDGET_LINE_MAX];
+  char line[BUDGET_LINE_MAX];
+  char *dot;
+  FILE *file;
+
+  snprintf(ci, sizeof(ci), "%s", path);
+  dot = strrchr(ci, '.');
+  if(!dot || strcmp(dot, ".su")){
+      return;
+  }
+  strcpy(dot, ".ci");
+  file = fopen(ci, "r");
+  if(!file){
+      fprintf(stderr, "%s: no call graph, build with -fcallgraph-info=su\n", ci);
+      return;
+  }
+  while(fgets(line, sizeof(line), file)){
+      char caller[BUDGET_NAME_MAX];
+      char callee[BUDGET_NAME_MAX];
+
+      // A static function is "file:name" in the graph, only "name" in the .su
+      if(sscanf(line, "edge: { sourcename: \"%95[^\"]\" targetname: \"%95[^\"]\"", caller, callee) == 2){
+          uint32_t from = budget_fn(budget_ci_name(caller));
+
+          budget_call(from, budget_fn(budget_ci_name(callee)));
+      }
+  }
+  fclose(file);
+}
+
+static const char *budget_ci_name(const char *name){
+  static char plain[BUDGET_NAME_MAX];
+  const char *colon = strrchr(name, ':');
+  char *clone;
+
+  // The .su leaves the number off a ".constprop.0" clone
+  snprintf(plain, sizeof(plain), "%s", colon ? colon + 1 : name);
+  clone = strstr(plain, ".constprop.");
+  if(clone){
+      clone[strlen(".constprop")] = '\0';
+  }
+  return plain;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Index of a function by name, added if new
+ *
+ ******************************************************************************/
+
+static uint32_t budget_fn(const char *name){
+  for(uint32_t i = 0; i < fn_count; i++){
+      if(!strcmp(fns[i].name, name)){
+          return i;
+      }
+  }
+  fns = realloc(fns, (fn_count + 1) * sizeof(BUDGET_FN));
+  if(!fns){
+      exit(EXIT_FAILURE);
+  }
+  memset(&fns[fn_count], 0, sizeof(BUDGET_FN));
+  snprintf(fns[fn_count].name, BUDGET_NAME_MAX, "%s", name);
+  fns[fn_count].next = UINT32_MAX;
+  return fn_count++;
+}
+
+static void budget_call(uint32_t caller, uint32_t callee){
+  BUDGET_FN *fn = &fns[caller];
+
+  for(uint32_t i = 0; i < fn->callee_count; i++){
+      if(fn->callees[i] == callee){
+          return;
+      }
+  }
+  fn->callees = realloc(fn->callees, (fn->callee_count + 1) * sizeof(uint32_t));
+  if(!fn->callees){
+      exit(EXIT_FAILURE);
+  }
+  fn->callees[fn->callee_count++] = callee;
+  if(caller != callee){
+      fns[callee].called = true;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Deepest chain of calls from a function, its frame included
+ *
+ * @details
+ *   A call back into a function on the chain is recursion, marked and left
+ *   out, its depth has no bound.
+ *
+ ******************************************************************************/
+
+static uint32_t budget_worst(uint32_t fn){
+  BUDGET_FN *f = &fns[fn];
+  uint32_t deepest = 0;
+
+  if(f->state == BUDGET_DONE){
+      return f->worst;
+  }
+  if(f->state == BUDGET_VISITING){
+      f->recursive = true;
+      return 0;
+  }
+  f->state = BUDGET_VISITING;
+  for(uint32_t i = 0; i < f->callee_count; i++){
+      uint32_t callee = f->callees[i];
+      uint32_t depth = budget_worst(callee);
+      f = &fns[fn];
+      if((fns[callee].state == BUDGET_DONE) && ((depth > deepest) || (f->next == UINT32_MAX))){
+          deepest = depth;
+          f->next = callee;
+      }
+  }
+  f->worst = f->frame + deepest;
+  f->state = BUDGET_DONE;
+  return f->worst;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Deepest interrupt handler, or deepest other function nothing calls
+ *   directly, main aside
+ *
+ ******************************************************************************/
+
+static uint32_t budget_deepest(bool handlers){
+  uint32_t deepest = UINT32_MAX;
+
+  for(uint32_t i = 0; i < fn_count; i++){
+      size_t len = strlen(fns[i].name);
+      bool handler = (len > strlen(BUDGET_HANDLER))
+                     && !strcmp(fns[i].name + len - strlen(BUDGET_HANDLER), BUDGET_HANDLER);
+
+      if(!fns[i].known || fns[i].called || (handler != handlers) || !strcmp(fns[i].name, main_name)){
+          continue;
+      }
+      if((deepest == UINT32_MAX) || (fns[i].worst > fns[deepest].worst)){
+          deepest = i;
+      }
+  }
+  return deepest;
+}
+
+static void budget_chain(const char *what, uint32_t fn){
+  printf("  %-17s %6u  %s", what, fns[fn].worst, fns[fn].name);
+  for(fn = fns[fn].next; fn != UINT32_MAX; fn = fns[fn].next){
+      printf(" > %s", fns[fn].name);
+  }
+  printf("\n");
+}
+
+static int budget_module_order(const void *a, const void *b){
+  const BUDGET_MODULE *x = a;
+  const BUDGET_MODULE *y = b;
+
+  return (int)(y->data + y->bss) - (int)(x->data + x->bss);
+}
+
+static int budget_object_order(const void *a, const void *b){
+  return (int)((const BUDGET_OBJECT *)b)->size - (int)((const BUDGET_OBJECT *)a)->size;
+}
+
+static int budget_frame_order(const void *a, const void *b){
+  return (int)((const BUDGET_FN *)b)->frame - (int)((const BUDGET_FN *)a)->frame;
+}
@@ -0,0 +1,344 @@
+/**
+ * @file trace_export.c
+ * @author Shambaditya Tarafder
+ * @date 12/9/2021
+ * @brief Host side of the firmware's event trace.  Reads the lines
+ *        trace_line() makes and writes them as Chrome trace JSON, which
+ *        ui.perfetto.dev and chrome://tracing open as a timeline.
+ *
+ *        Usage: trace_export [-s] [-r hz] [-o file] [capture]
+ *
+ *        The capture is what the central received, or with -s the output of
+ *        firmware_sim, see capture.c.  -r is the RTCC rate, 1000 by default.
+ *        The handlers are on one track, the scheduler callbacks E<n>, named
+ *        by their event bit like the "#PRF!" report, on another, the sleeps
+ *        on a third, with the core clock as a counter.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "capture.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define EXPORT_RTCC_HZ      1000
+#define EXPORT_LINE_MARK    'T'
+#define EXPORT_HEX_DIGITS   16          // Per record, two words
+#define EXPORT_CYCLE_MASK   0xFFFF
+#define EXPORT_MHZ_DEFAULT  26          // Until the first TRACE_HF record
+
+// Record types of trace.h
+#define TRACE_IRQ_ENTER     1
+#define TRACE_IRQ_EXIT      2
+#define TRACE_POST          3
+#define TRACE_DISPATCH      4
+#define TRACE_DONE          5
+#define TRACE_SLEEP         6
+#define TRACE_WAKE          7
+#define TRACE_HF            8
+
+// Tracks
+#define EXPORT_PID          1
+#define EXPORT_TID_MAIN     1
+#define EXPORT_TID_IRQ      2
+#define EXPORT_TID_SLEEP    3
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static FILE     *out;
+static double   rtcc_hz = EXPORT_RTCC_HZ;
+static bool     first_event = true;
+
+// Time of the records, see export_time()
+static bool     have_prev;
+static uint32_t prev_lf;
+static uint32_t prev_cycles;
+static double   prev_us;
+static uint64_t lf_ticks;           // RTCC ticks since the first record, unwrapped
+static bool     asleep;             // The cycle counter stops in the sleep
+static uint32_t mhz = EXPORT_MHZ_DEFAULT;
+
+// Open slices
+static uint32_t irq_depth;
+static bool     dispatching;
+static bool     sleeping;
+
+static const char *const irq_names[] = {
+  [9] = "LDMA", [10] = "GPIO_EVEN", [11] = "TIMER0", [17] = "I2C0", [18] = "GPIO_ODD",
+  [19] = "TIMER1", [22] = "LEUART0", [27] = "LETIMER0", [30] = "RTCC", [36] = "WTIMER0",
+  [39] = "I2C1",
+};
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static void export_line(const char *line);
+static void export_record(uint32_t lf, uint32_t word);
+static double export_time(uint32_t lf, uint32_t cycles);
+static void export_event(const char *name, const char *phase, double us, uint32_t tid);
+static void export_thread(uint32_t tid, const char *name);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(int argc, char **argv){
+  bool sim = false;
+  FILE *file = stdin;
+  CAPTURE capture;
+  char line[CAPTURE_LINE_MAX];
+  int opt;
+
+  out = stdout;
+  while((opt = getopt(argc, argv, "sr:o:")) != -1){
+      switch(opt){
+        case 's':
+          sim = true;
+          break;
+        case 'r':
+          rtcc_hz = atof(optarg);
+          break;
+        case 'o':
+          out = fopen(optarg, "w");
+          if(!out){
+              perror(optarg);
+              return EXIT_FAILURE;
+          }
+          break;
+        default:
+          optind = argc + 1;
+          break;
+      }
+  }
+  if((argc - optind > 1) || (argc < optind) || (rtcc_hz <= 0)){
+      fprintf(stderr, "usage: %s [-s] [-r hz] [-o file] [capture]\n", argv[0]);
+      return EXIT_FAILURE;
+  }
+  if(optind < argc){
+      file = fopen(argv[optind], "r");
+      if(!file){
+          perror(argv[optind]);
+          return EXIT_FAILURE;
+      }
+  }
+
+  fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  export_thread(EXPORT_TID_MAIN, "main loop");
+  export_thread(EXPORT_TID_IRQ, "interrupts");
+  export_thread(EXPORT_TID_SLEEP, "sleep");
+  capture_open(&capture, file, sim);
+  while(capture_line(&capture, line, sizeof(line))){
+      export_line(line);
+  }
+  // Slices still open at the end of the trace end with it
+  while(irq_depth){
+      export_event(NULL, "E", prev_us, EXPORT_TID_IRQ);
+      irq_depth--;
+  }
+  if(dispatching){
+      export_event(NULL, "E", prev_us, EXPORT_TID_MAIN);
+  }
+  if(sleeping){
+      export_event(NULL, "E", prev_us, EXPORT_TID_SLEEP);
+  }
+  fprintf(out, "\n]}\n");
+
+  if(file != stdin){
+      fclose(file);
+  }
+  if(out != stdout){
+      fclose(out);
+  }
+  return EXIT_SUCCESS;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Converts one "T<hex>" line, anything else the central received is
+ *   skipped
+ *
+ ******************************************************************************/
+
+static void export_line(const char *line){
+  size_t len;
+
+  if(line[0] != EXPORT_LINE_MARK){
+      return;
+  }
+  line++;
+  len = strlen(line);
+  if(!len || (len % EXPORT_HEX_DIGITS) || (strspn(line, "0123456789abcdef") != len)){
+      return;
+  }
+  for(size_t i = 0; i < len; i += EXPORT_HEX_DIGITS){
+      char word[EXPORT_HEX_DIGITS / 2 + 1];
+      uint32_t lf;
+
+      memcpy(word, line + i, EXPORT_HEX_DIGITS / 2);
+      word[EXPORT_HEX_DIGITS / 2] = '\0';
+      lf = (uint32_t)strtoul(word, NULL, 16);
+      memcpy(word, line + i + EXPORT_HEX_DIGITS / 2, EXPORT_HEX_DIGITS / 2);
+      export_record(lf, (uint32_t)strtoul(word, NULL, 16));
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Writes the trace events of one record
+ *
+ * @details
+ *   A post is an instant on the track of whoever posted it.  Exits, ends
+ *   and wake-ups whose start is older than the ring are dropped.
+ *
+ ******************************************************************************/
+
+static void export_record(uint32_t lf, uint32_t word){
+  uint32_t type = word >> 24;
+  uint32_t arg = (word >> 16) & 0xFF;
+  double us = export_time(lf, word & EXPORT_CYCLE_MASK);
+  char name[32];
+
+  switch(type){
+    case TRACE_IRQ_ENTER:
+      if((arg < sizeof(irq_names) / sizeof(irq_names[0])) && irq_names[arg]){
+          snprintf(name, sizeof(name), "%s", irq_names[arg]);
+      } else {
+          snprintf(name, sizeof(name), "I%lu", (unsigned long)arg);
+      }
+      export_event(name, "B", us, EXPORT_TID_IRQ);
+      irq_depth++;
+      break;
+    case TRACE_IRQ_EXIT:
+      if(irq_depth){
+          export_event(NULL, "E", us, EXPORT_TID_IRQ);
+          irq_depth--;
+      }
+      break;
+    case TRACE_POST:
+      snprintf(name, sizeof(name), "post E%lu", (unsigned long)arg);
+      export_event(name, "i", us, irq_depth ? EXPORT_TID_IRQ : EXPORT_TID_MAIN);
+      break;
+    case TRACE_DISPATCH:
+      if(dispatching){
+          export_event(NULL, "E", us, EXPORT_TID_MAIN);
+      }
+      snprintf(name, sizeof(name), "E%lu", (unsigned long)arg);
+      export_event(name, "B", us, EXPORT_TID_MAIN);
+      dispatching = true;
+      break;
+    case TRACE_DONE:
+      if(dispatching){
+          export_event(NULL, "E", us, EXPORT_TID_MAIN);
+          dispatching = false;
+      }
+      break;
+    case TRACE_SLEEP:
+      snprintf(name, sizeof(name), "EM%lu", (unsigned long)arg);
+      export_event(name, "B", us, EXPORT_TID_SLEEP);
+      sleeping = true;
+      asleep = true;
+      break;
+    case TRACE_WAKE:
+      if(sleeping){
+          export_event(NULL, "E", us, EXPORT_TID_SLEEP);
+          sleeping = false;
+      }
+      asleep = false;
+      break;
+    case TRACE_HF:
+      if(arg){
+          mhz = arg;
+      }
+      fprintf(out, "%s{\"name\":\"core MHz\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":%d,"
+              "\"args\":{\"MHz\":%lu}}", first_event ? "" : ",\n", us, EXPORT_PID,
+              (unsigned long)arg);
+      first_event = false;
+      break;
+    default:
+      break;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Time of a record in us from the first one
+ *
+ * @details
+ *   The RTCC tick gives the time to 1 ms through the sleeps.  While the core
+ *   stays awake from one record to the next, the 16 bit cycle stamps place
+ *   the record within the tick: the previous time plus the cycles between
+ *   them at the core clock, kept inside the record's tick.  After a sleep,
+ *   or a gap of more than a tick where the cycle stamp may have wrapped, the
+ *   time starts again from the tick.
+ *
+ ******************************************************************************/
+
+static double export_time(uint32_t lf, uint32_t cycles){
+  double tick_us = 1000000.0 / rtcc_hz;
+  double lf_us;
+  double us;
+  uint32_t ticks = have_prev ? lf - prev_lf : 0;
+
+  lf_ticks += ticks;
+  lf_us = lf_ticks * tick_us;
+  if(!have_prev || asleep || (ticks > 1)){
+      us = lf_us;
+  } else {
+      us = prev_us + (double)((cycles - prev_cycles) & EXPORT_CYCLE_MASK) / mhz;
+  }
+  if(us < lf_us){
+      us = lf_us;
+  }
+  if(us > lf_us + tick_us){
+      us = lf_us + tick_us;
+  }
+  if(us < prev_us){
+      us = prev_us;
+  }
+  have_prev = true;
+  prev_lf = lf;
+  prev_cycles = cycles;
+  prev_us = us;
+  return us;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   One trace event, without a name for the end of a slice
+ *
+ ******************************************************************************/
+
+static void export_event(const char *name, const char *phase, double us, uint32_t tid){
+  fprintf(out, "%s{", first_event ? "" : ",\n");
+  first_event = false;
+  if(name){
+      fprintf(out, "\"name\":\"%s\",", name);
+  }
+  fprintf(out, "\"ph\":\"%s\",\"ts\":%.3f,\"pid\":%d,\"tid\":%lu%s}", phase, us, EXPORT_PID,
+          (unsigned long)tid, strcmp(phase, "i") ? "" : ",\"s\":\"t\"");
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Names a track
+ *
+ ******************************************************************************/
+
+static void export_thread(uint32_t tid, const char *name){
+  fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%lu,"
+          "\"args\":{\"name\":\"%s\"}}", first_event ? "" : ",\n", EXPORT_PID,
+          (unsigned long)tid, name);
+  first_event = false;
+}
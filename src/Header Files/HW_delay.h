@@ -12,6 +12,7 @@
 
 #include "em_timer.h"
 #include "em_cmu.h"
+#include "cmu.h"
 
 //***********************************************************************************
 // function prototypes
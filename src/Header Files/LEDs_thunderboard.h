@@ -30,6 +30,9 @@
 #define RGB_LED_2		(0x01 << 2)
 #define RGB_LED_3		(0x01 << 3)
 #define NO_LEDS			(0x00 << 0)
+#define RGB_LED_COUNT	4
+#define RGB_ALL_LED_BITS	0x0F
+#define RGB_ALL_COLOR_BITS	0x07
 
 #define	RGB_PWM_PERIOD	20
 #define RGB_PWM_ACTIVE	1
@@ -45,5 +48,6 @@
 //***********************************************************************************
 void rgb_init(void);
 void leds_enabled(uint32_t leds, uint32_t color, bool enable);
+uint32_t rgb_select_mask(uint32_t leds);
 
 #endif
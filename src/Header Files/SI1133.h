@@ -23,6 +23,7 @@
 #define POR 25
 #define SI1133_ADDRESS  0x55
 #define SI1133_PART           0x00
+#define SI1133_READ_TRIES     3       // Reads of the part ID at boot before a NACK is fatal
 
 //***********************************************************************************
 // global variables
@@ -31,5 +32,6 @@
 void si1133_i2c_open();
 void si1133_read(uint32_t SI1133_LIGHT_READ_CB);
 uint32_t si1133_pass_ID(void);
+bool si1133_nacked(void);
 
 #endif /* HEADER_FILES_SI1133_H_ */
@@ -18,15 +18,31 @@
 #include "brd_config.h"
 #include "scheduler.h"
 #include "LEDs_thunderboard.h"
+#include "rgb_pwm.h"
+#include "led_effects.h"
+#include "led_fb.h"
 #include "SI1133.h"
 #include "HW_delay.h"
 #include "ble.h"
+#include "event_latency.h"
+#include "profiler.h"
+#include "benchmark.h"
+#include "task.h"
+#include "hibernate.h"
+#include "boot.h"
+#include "binlog.h"
+#include "trace.h"
+#include "recorder.h"
+#include "pool.h"
+#include "stack.h"
 
 
 //***********************************************************************************
 // defined files
 //***********************************************************************************
+#ifndef PWM_PER                 // Build option, also the light sampling period
 #define   PWM_PER         2.0   // PWM period in seconds
+#endif
 #define   PWM_ACT_PER     0.002 // PWM active period in seconds
 
 #define LETIMER0_COMP0_CB        0x00000001   //0b0001
@@ -44,8 +60,32 @@
 #define CHAR_SEND                25
 #define ADD_THREE                3
 #define ADD_ONE                  1
+#define STATUS_LED_LEVEL         64     // Dimmed status LED level, 0 to 255
+#define STATUS_LED_BRIGHTNESS    128    // Global brightness of the RGB LEDs
+#define STATUS_EFFECT_MS         2000   // Period of the breathing status effect
+#define STATUS_FB_BAND           0      // Framebuffer LED showing the HF band
+#define STATUS_FB_LIGHT          1      // Framebuffer LED showing the light status
+#define BLE_CMD_LATENCY          "#LAT!"   // Central asks for the event latency report
+#define BLE_CMD_PROFILE          "#PRF!"   // Central asks for the CPU load profile
+#define BLE_CMD_BOOT             "#BOOT!"  // Central asks for the boot times
+#define BLE_CMD_LOG              "#LOG!"   // Central asks for the binary log records
+#define BLE_CMD_TRACE            "#TRC!"   // Central asks for the event trace
+#define BLE_CMD_RECORD           "#REC!"   // Central asks for the input recording
+#define BLE_CMD_POOL             "#POOL!"  // Central asks for the buffer pool peaks
+#define BLE_CMD_STACK            "#STK!"   // Central asks for the stack high-water marks
+#define BLE_CMD_CLOCK            "#CLK!"   // Central asks for the clocks that are on and their holders
+#define BLE_CMD_EFFECT           "#FX!"    // Central turns the breathing LED effect on or off
+#define BLE_CMD_FRAMEBUFFER      "#FB!"    // Central turns the per LED status framebuffer on or off
+#define BLE_CMD_LEN              80
+#define BLE_POOL_RETRY_MS        10     // A dump task with no pool block free tries again this much later
+#define APP_RETAINED_WORDS       2      // x and y, kept across EM4H
+#ifndef HIBERNATE_PERIOD                // Build option, the sampling period in s with HIBERNATE_ENABLED
+#define HIBERNATE_PERIOD         60
+#endif
 
 //#define BLE_TEST_ENABLED
+//#define BENCHMARK_ENABLED     // Boot up runs the benchmarks and sends the results to the central
+//#define HIBERNATE_ENABLED     // One sample per boot, EM4H for HIBERNATE_PERIOD in between
 //***********************************************************************************
 // global variables
 //***********************************************************************************
@@ -63,5 +103,6 @@ void si1133_white_op(void);
 void scheduled_boot_up_cb(void);
 void scheduled_boot_up_cb(void);
 void scheduled_ble_tx_done_cb(void);
+void scheduled_ble_rx_done_cb(void);
 
 #endif
@@ -0,0 +1,48 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef BENCHMARK_HG
+#define BENCHMARK_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define BENCHMARK_REPEATS     5             // Runs per kernel, the fastest one is reported
+#define BENCHMARK_LINE_SIZE   80            // One ble_write()
+#define BENCHMARK_EVENT       0x00000100    // Scheduler bit no callback is attached to
+#define BENCHMARK_NO_IRQ      (-1)
+#define BENCHMARK_FRAME       "#0123456789abcdef!\n"  // START_FRAME to SIG_FRAME, newline for the central
+
+typedef bool (*BENCHMARK_OUT_FN)(char *line);     // false if the line was dropped
+typedef uint64_t (*BENCHMARK_NS_FN)(void);  // Wall clock in ns, NULL on the board
+
+typedef struct {
+  const char  *name;
+  void        (*run)(uint32_t ops);
+  uint32_t    ops;                          // Operations per run, the results are per operation
+  int32_t     irqn;                         // Handler whose cycles are reported, BENCHMARK_NO_IRQ for none
+} BENCHMARK_KERNEL;
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void benchmark_run(BENCHMARK_OUT_FN out, BENCHMARK_NS_FN ns);
+
+#endif
@@ -0,0 +1,73 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef BINLOG_HG
+#define BINLOG_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_assert.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define BINLOG_WORDS        256           // Ring size, 1 KB of RAM
+#define BINLOG_ARGS_MAX     4             // 32 bit arguments per record
+#define BINLOG_HEADER       2             // Words ahead of the arguments, see binlog_write()
+#define BINLOG_SEQ_MASK     0xFFF
+#define BINLOG_LINE_MARK    'L'           // First character of a line binlog_line() makes
+
+// The format strings go to their own section, which binlog.ld keeps out of
+// flash.  A record only carries the string's offset in it, the host
+// expands the record with the string from the ELF.
+extern const char __start_binlog[];
+
+#define BINLOG_FMT(fmt)                                                         \
+  static const char binlog_fmt_[] __attribute__((section("binlog"), used)) = fmt
+#define BINLOG_ID()         ((uint32_t)(binlog_fmt_ - __start_binlog))
+
+// One 32 bit word per argument: integers as they are, float and double as
+// the bits of a float.  Pointers do not compile, there is no %s.
+#define BINLOG_ARG(x)       _Generic((x), float: binlog_float(x),           \
+                                          double: binlog_float((float)(x)), \
+                                          default: (uint32_t)(x))
+
+#define BINLOG0(fmt)                                                            \
+  do { BINLOG_FMT(fmt); binlog_write(BINLOG_ID(), 0, 0, 0, 0, 0); } while(0)
+#define BINLOG1(fmt, a)                                                         \
+  do { BINLOG_FMT(fmt); binlog_write(BINLOG_ID(), 1, BINLOG_ARG(a), 0, 0, 0); } while(0)
+#define BINLOG2(fmt, a, b)                                                      \
+  do { BINLOG_FMT(fmt); binlog_write(BINLOG_ID(), 2, BINLOG_ARG(a), BINLOG_ARG(b), 0, 0); } while(0)
+#define BINLOG3(fmt, a, b, c)                                                   \
+  do { BINLOG_FMT(fmt); binlog_write(BINLOG_ID(), 3, BINLOG_ARG(a), BINLOG_ARG(b), \
+                                     BINLOG_ARG(c), 0); } while(0)
+#define BINLOG4(fmt, a, b, c, d)                                                \
+  do { BINLOG_FMT(fmt); binlog_write(BINLOG_ID(), 4, BINLOG_ARG(a), BINLOG_ARG(b), \
+                                     BINLOG_ARG(c), BINLOG_ARG(d)); } while(0)
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void binlog_write(uint32_t id, uint32_t count, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+bool binlog_line(char *line, uint32_t size);
+
+static inline uint32_t binlog_float(float value){
+  union {
+    float     f;
+    uint32_t  u;
+  } bits = { value };
+  return bits.u;
+}
+
+#endif
@@ -37,8 +37,9 @@
 //***********************************************************************************
 // function prototypes
 //***********************************************************************************
-void ble_open(uint32_t tx_event, uint32_t rx_event);
-void ble_write(char *string);
+void ble_open(uint32_t tx_event, uint32_t rx_event, bool self_test);
+bool ble_write(char *string);
+void ble_read(char *string, uint32_t size);
 
 bool ble_test(char *mod_name);
 
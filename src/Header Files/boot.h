@@ -0,0 +1,51 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef BOOT_HG
+#define BOOT_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "task.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define BOOT_STEPS_MAX    2             // Bring-up steps running at once
+#define BOOT_EVENT        0x00000400    // Scheduler bit for the steps' driver completions
+#define BOOT_TIMEOUT      100           // ms a step waits on a peripheral before it fails
+#define BOOT_NOT_YET      UINT32_MAX    // A boot time not reached yet
+#define BOOT_REPORT_SIZE  64            // Buffer size for boot_report()
+
+typedef struct {
+  const char  *name;
+  TASK_FN     fn;                       // Brings one peripheral up, between TASK_BEGIN() and TASK_END()
+} BOOT_STEP;
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void boot_open(bool warm);
+void boot_start(const BOOT_STEP *steps, uint32_t count);
+bool boot_busy(void);
+bool boot_warm(void);
+void boot_sample(void);
+uint32_t boot_ready_ms(void);
+uint32_t boot_sample_ms(void);
+void boot_report(char *report, uint32_t size);
+
+#endif
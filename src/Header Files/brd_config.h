@@ -53,17 +53,26 @@
 #define RGB2_PIN          2
 #define RGB3_PORT         gpioPortI
 #define RGB3_PIN          3
+#define RGB_SELECT_PORT   RGB0_PORT     // RGB0..3 enables share one port, written as a mask
+#define RGB_SELECT_ALL_MASK ((1u << RGB0_PIN) | (1u << RGB1_PIN) | (1u << RGB2_PIN) | (1u << RGB3_PIN))
 #define RGB_RED_PORT      gpioPortD
 #define RGB_RED_PIN       11
 #define RGB_GREEN_PORT    gpioPortD
 #define RGB_GREEN_PIN     12
 #define RGB_BLUE_PORT     gpioPortD
 #define RGB_BLUE_PIN      13
+#define RGB_COLOR_PORT    RGB_RED_PORT  // Red, green and blue lines share one port
 #define RGB_DEFAULT_OFF     false
 #define COLOR_DEFAULT_OFF   false
 #define RED_RGB_LOC       TIMER_ROUTELOC0_CC0LOC_LOC19
 #define GREEN_RGB_LOC     TIMER_ROUTELOC0_CC1LOC_LOC19
 #define BLUE_RGB_LOC      TIMER_ROUTELOC0_CC2LOC_LOC19
+#define RGB_PWM_TIMER     TIMER1
+#define RGB_PWM_CLOCK     cmuClock_TIMER1
+#define RGB_PWM_IRQn      TIMER1_IRQn
+#define RGB_EFFECT_TIMER  WTIMER0
+#define RGB_EFFECT_CLOCK  cmuClock_WTIMER0
+#define RGB_EFFECT_DMA_SIGNAL   ldmaPeripheralSignal_WTIMER0_UFOF
 
 #define SI1133_SCL_PORT                  gpioPortC
 #define SI1133_SCL_PIN                    4u
@@ -94,7 +103,9 @@
 #define   LEUART_TR_DEFAULT   true
 
 #define HM10_LEUART0      LEUART0
+#ifndef HM10_BAUDRATE             // Build option, the module must be set to match with AT+BAUD
 #define HM10_BAUDRATE     9600
+#endif
 #define HM10_DATABITS     leuartDatabits8
 #define HM10_ENABLE       leuartEnable
 #define HM10_PARITY       leuartNoParity
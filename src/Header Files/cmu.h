@@ -5,20 +5,51 @@
 #define CMU_HG
 
 /* System include statements */
-
+#include <stdbool.h>
+#include <stdint.h>
 
 /* Silicon Labs include statements */
 #include "em_cmu.h"
+#include "em_emu.h"
+#include "em_core.h"
 #include "em_assert.h"
 
 /* The developer's include statements */
-
+#include "brd_config.h"
 
 
 //***********************************************************************************
 // defined files
 //***********************************************************************************
 
+// Clock owners, one bit per driver holding a clock
+#define CMU_OWNER_GPIO        (0x01 << 0)
+#define CMU_OWNER_LETIMER     (0x01 << 1)
+#define CMU_OWNER_LEUART      (0x01 << 2)
+#define CMU_OWNER_I2C         (0x01 << 3)
+#define CMU_OWNER_DELAY       (0x01 << 4)
+#define CMU_OWNER_RGB_PWM     (0x01 << 5)
+#define CMU_OWNER_LED_EFFECT  (0x01 << 6)
+#define CMU_OWNER_PROFILER    (0x01 << 7)
+#define CMU_OWNER_TASK        (0x01 << 8)
+#define CMU_OWNER_HIBERNATE   (0x01 << 9)
+#define CMU_OWNERS            10    // Bits above, each owner's holds are counted
+
+#define CMU_NO_HOLDERS        0
+
+// HF clock performance levels, see hf_levels[] in cmu.c for the bands
+#define CMU_HF_LOW            0     // 7 MHz, low power voltage scaling
+#define CMU_HF_MID            1     // 13 MHz, low power voltage scaling
+#define CMU_HF_HIGH           2     // 26 MHz, high performance voltage scaling
+#define CMU_HF_LEVELS         3
+
+#define CMU_HF_LIGHT_EVENTS   1     // Pending events handled at CMU_HF_LOW
+#define CMU_HF_MEDIUM_EVENTS  3     // Pending events handled at CMU_HF_MID
+#define CMU_HF_MAX_NOTIFY     4     // Drivers that can follow HF clock changes
+
+// Called after every HF clock change with the new HFPERCLK frequency in Hz
+typedef void (*CMU_HF_NOTIFY)(uint32_t hfper_freq);
+
 
 //***********************************************************************************
 // global variables
@@ -29,5 +60,20 @@
 // function prototypes
 //***********************************************************************************
 void cmu_open(void);
+void cmu_clock_request(CMU_Clock_TypeDef clock, uint32_t owner);
+void cmu_clock_release(CMU_Clock_TypeDef clock, uint32_t owner);
+void cmu_osc_request(CMU_Osc_TypeDef osc, uint32_t owner);
+void cmu_osc_release(CMU_Osc_TypeDef osc, uint32_t owner);
+bool cmu_clock_is_on(CMU_Clock_TypeDef clock);
+uint32_t cmu_clock_holders(CMU_Clock_TypeDef clock);
+bool cmu_clock_report(char *report, uint32_t size, uint32_t *next);
+void cmu_hf_scale(uint32_t level);
+uint32_t cmu_hf_level(void);
+void cmu_hf_policy(uint32_t pending_events);
+void cmu_hf_burst_begin(void);
+void cmu_hf_burst_end(void);
+void cmu_hf_floor_request(uint32_t level);
+void cmu_hf_floor_release(uint32_t level);
+void cmu_hf_notify_register(CMU_HF_NOTIFY notify);
 
 #endif
@@ -0,0 +1,50 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EVENT_LATENCY_HG
+#define EVENT_LATENCY_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define EVENT_LATENCY_ENABLED           // Comment out to remove the scheduler hooks
+#define EVENT_LATENCY_EVENTS    8       // Event bits tracked, up to BLE_RX_DONE_CB
+#define EVENT_LATENCY_BUCKETS   24      // Power of two cycle buckets, the last is open ended
+
+typedef struct {
+  uint32_t  count;
+  uint32_t  min;
+  uint32_t  max;
+  uint64_t  sum;
+  uint32_t  histogram[EVENT_LATENCY_BUCKETS];   // Bucket n counts latencies of 2^n to 2^(n+1)-1
+} EVENT_LATENCY_STATS;
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void event_latency_open(void);
+void event_latency_post(uint32_t events);
+void event_latency_dispatch(uint32_t events);
+bool event_latency_get(uint32_t event, EVENT_LATENCY_STATS *stats);
+uint32_t event_latency_percentile(const EVENT_LATENCY_STATS *stats, uint32_t percent);
+uint32_t event_latency_report(uint32_t event, char *report, uint32_t size);
+void event_latency_clear(void);
+
+#endif
@@ -14,6 +14,7 @@
 
 /* The developer's include statements */
 #include "brd_config.h"
+#include "cmu.h"
 
 //***********************************************************************************
 // defined files
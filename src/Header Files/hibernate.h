@@ -0,0 +1,41 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef HIBERNATE_HG
+#define HIBERNATE_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_assert.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HIBERNATE_RTCC_CH     2             // RTCC compare channel of the wake-up
+#define HIBERNATE_RTCC_HZ     1000          // ULFRCO with no prescaler, shared with the tasks
+#define HIBERNATE_RET_WORDS   32            // RTCC retention registers
+#define HIBERNATE_RET_HEADER  2             // Of them, the magic and the check word
+#define HIBERNATE_MAGIC       0x48424E31    // "HBN1", the retention holds a saved state
+#define HIBERNATE_MAX_SIZE    ((HIBERNATE_RET_WORDS - HIBERNATE_RET_HEADER) * 4)
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void hibernate_open(void);
+bool hibernate_warm_boot(void);
+bool hibernate_restore(void *state, uint32_t size);
+void hibernate_save(const void *state, uint32_t size);
+void hibernate_enter(uint32_t seconds) __attribute__((noreturn));
+
+#endif
@@ -12,6 +12,7 @@
 /* Silicon Labs include statements */
 #include "em_i2c.h"
 #include "em_assert.h"
+#include "cmu.h"
 #include "sleep_routines.h"
 #include "scheduler.h"
 
@@ -20,24 +21,25 @@
 //***********************************************************************************
 
 #define I2C_EM_BLOCK  EM2
+#define I2C_HF_FLOOR  CMU_HF_MID    // emlib needs more than 9 MHz for the asymmetric bus
 #define I2C_READ    1
 #define I2C_WRITE   0
 
+// Fastest SCL each high/low ratio is specified for
+#define I2C_FREQ_VALID(freq, clhr)  (((freq) > 0) && ((freq) <= \
+  (((clhr) == i2cClockHLRFast) ? I2C_FREQ_FASTPLUS_MAX : \
+   ((clhr) == i2cClockHLRAsymetric) ? I2C_FREQ_FAST_MAX : I2C_FREQ_STANDARD_MAX)))
+
 //***********************************************************************************
 // global variables
 //***********************************************************************************
 
+// A const table, every value computed at compile time
 typedef struct {
 
-  volatile bool    enable;
-  bool    master;
-  uint32_t refFreq;
-  uint32_t freq;
-  I2C_ClockHLR_TypeDef clhr;
-  uint32_t   out_pin_scl_route;
-  uint32_t   out_pin_sda_route;
-  uint32_t   out_pin_scl_en;
-  uint32_t   out_pin_sda_en;
+  I2C_Init_TypeDef init;      // Bus frequency checked with I2C_FREQ_VALID()
+  uint32_t   routeloc0;       // SCLLOC | SDALOC
+  uint32_t   routepen;        // I2C_ROUTEPEN_ of the pins driven
 
 }I2C_OPEN_STRUCT;
 
@@ -50,9 +52,11 @@ typedef struct {
     bool            write_read;
     uint32_t        *data_add;
     uint32_t        bytes;
-    bool            busy;
+    volatile bool   busy;
     uint32_t        cb;
     int             counter;
+    uint32_t        hfper_freq;     // HF change during the transfer, applied at its STOP, 0 for none
+    volatile bool   nacked;         // The last transfer was cut short by a NACK
 
 
 
@@ -65,7 +69,8 @@ typedef struct {
 void i2c_start(I2C_TypeDef *i2c, uint32_t slave_add, uint32_t slave_reg, bool write_read, uint32_t *data_add, uint32_t bytes, uint32_t cb,int counter);
 void I2C0_IRQHandler(void);
 void I2C1_IRQHandler(void);
-void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_open);
+void i2c_open(I2C_TypeDef *i2c, const I2C_OPEN_STRUCT *i2c_open);
+bool i2c_nacked(I2C_TypeDef *i2c);
 
 
 #endif /* HEADER_FILES_I2C_H_ */
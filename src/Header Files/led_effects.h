@@ -0,0 +1,49 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef LED_EFFECTS_HG
+#define LED_EFFECTS_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_ldma.h"
+#include "em_timer.h"
+#include "em_cmu.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "brd_config.h"
+#include "rgb_pwm.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define LED_EFFECT_NONE       0
+#define LED_EFFECT_FADE       1       // Linear ramp up and down
+#define LED_EFFECT_BREATHE    2       // Exponential-sine "breathing" curve
+#define LED_EFFECT_BLINK      3       // 50% on / 50% off
+
+#define LED_EFFECT_STEPS      64      // Waveform samples per effect period
+#define LED_EFFECT_MIN_MS     LED_EFFECT_STEPS    // Shortest period, 1 ms per sample
+#define LED_EFFECT_PRESCALE   timerPrescale1024
+#define LED_EFFECT_PRESCALE_DIV  1024
+
+#define LED_EFFECT_DMA_CH     0       // First of RGB_PWM_CHANNELS consecutive LDMA channels
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void led_effect_open(void);
+void led_effect_start(uint32_t leds, uint32_t effect, uint32_t period_ms, uint8_t red, uint8_t green, uint8_t blue);
+void led_effect_stop(void);
+uint32_t led_effect_active(void);
+
+#endif
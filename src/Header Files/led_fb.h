@@ -0,0 +1,45 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef LED_FB_HG
+#define LED_FB_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_timer.h"
+#include "em_gpio.h"
+#include "em_core.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "brd_config.h"
+#include "LEDs_thunderboard.h"
+#include "rgb_pwm.h"
+#include "led_effects.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define LED_FB_BUFFERS    2       // Front buffer shown by the ISR, back buffer being built
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void led_fb_open(void);
+void led_fb_set(uint32_t led, uint8_t red, uint8_t green, uint8_t blue);
+void led_fb_fill(uint8_t red, uint8_t green, uint8_t blue);
+void led_fb_commit(void);
+void led_fb_start(void);
+void led_fb_stop(void);
+void TIMER1_IRQHandler(void);
+
+#endif
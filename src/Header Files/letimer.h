@@ -14,6 +14,7 @@
 #include "em_assert.h"
 
 /* The developer's include statements */
+#include "cmu.h"
 #include "scheduler.h"
 #include "sleep_routines.h"
 //***********************************************************************************
@@ -21,24 +22,31 @@
 //***********************************************************************************
 #define LETIMER_HZ		1000 // Utilizing ULFRCO oscillator for LETIMERs
 #define LETIMER_EM    EM4
+#define LETIMER_COMP_MAX  0xFFFF  // COMP0 and COMP1 are 16 bits
+
+// Seconds in LETIMER_HZ counts, rounded, for the tables and their
+// _Static_assert()s against LETIMER_COMP_MAX
+#define LETIMER_TICKS(seconds)  ((uint32_t)((seconds) * LETIMER_HZ + 0.5))
+
+// LETIMER_Init_TypeDef of the PWM driver, COMP0 is the top and both outputs
+// are PWM, idle low, in free running mode
+#define LETIMER_PWM_INIT(en, debug, top)  \
+  { .enable = (en), .debugRun = (debug), .comp0Top = true, .bufTop = false, .out0Pol = 0, .out1Pol = 0, \
+    .ufoa0 = letimerUFOAPwm, .ufoa1 = letimerUFOAPwm, .repMode = letimerRepeatFree, .topValue = (top) }
 
 //***********************************************************************************
 // global variables
 //***********************************************************************************
+// A const table, every value computed at compile time
 typedef struct {
-	bool 			debugRun;			// True = keep LETIMER running will halted
-	bool 			enable;				// enable the LETIMER upon completion of open
-	uint32_t		out_pin_route0;		// out 0 route to gpio port/pin
-	uint32_t		out_pin_route1;		// out 1 route to gpio port/pin
-	bool			out_pin_0_en;		// enable out 0 route
-	bool			out_pin_1_en;		// enable out 1 route
-	float			period;				// seconds
-	float			active_period;		// seconds
-	bool      comp0_irq_enable;
+	LETIMER_Init_TypeDef	init;		// LETIMER_PWM_INIT()
+	uint32_t		period;				// COMP0, LETIMER_TICKS() of the period
+	uint32_t		active_period;		// COMP1, LETIMER_TICKS() of the active period
+	uint32_t		routeloc0;			// OUT0LOC | OUT1LOC to gpio port/pin
+	uint32_t		routepen;			// LETIMER_ROUTEPEN_OUTxPEN of the outputs driven
+	uint32_t		ien;				// LETIMER_IEN_ of the interrupts enabled
 	uint32_t  comp0_cb;
-	bool      comp1_irq_enable;
 	uint32_t  comp1_cb;
-	bool      uf_irq_enable;
 	uint32_t  uf_cb;
 
 } APP_LETIMER_PWM_TypeDef ;
@@ -47,7 +55,7 @@ typedef struct {
 //***********************************************************************************
 // function prototypes
 //***********************************************************************************
-void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_letimer_struct);
+void letimer_pwm_open(LETIMER_TypeDef *letimer, const APP_LETIMER_PWM_TypeDef *app_letimer_struct);
 void letimer_start(LETIMER_TypeDef *letimer, bool enable);
 void LETIMER0_IRQHandler(void);
 
@@ -5,9 +5,11 @@
 #define	LEUART_GUARD_H
 
 #include "em_leuart.h"
+#include "cmu.h"
 #include "sleep_routines.h"
 #include "scheduler.h"
 #include "HW_delay.h"
+#include "pool.h"
 
 //***********************************************************************************
 // defined files
@@ -20,33 +22,33 @@
 #define TIME_DELAY_LONG   25
 #define ZERO              0
 #define CHAR_SIZE         80
+#define LEUART_RX_SIZE    POOL_LARGE_SIZE  // Longest frame kept, start and signal frames included
 #define ONE               1
 
+// Baud rates of the LFB clock, the LFXO.  The reference manual gives 9600
+// as the most the 32.768 kHz clock receives reliably, the slowest is the
+// largest divider CLKDIV holds
+#define LEUART_REF_HZ     32768
+#define LEUART_BAUD_MAX   9600
+#define LEUART_CLKDIV(baud)       ((256UL * LEUART_REF_HZ) / (baud) - 256UL)
+#define LEUART_BAUD_VALID(baud)   (((baud) > 0) && ((baud) <= LEUART_BAUD_MAX) && \
+                                   (LEUART_CLKDIV(baud) <= _LEUART_CLKDIV_MASK))
+
 /***************************************************************************//**
  * @addtogroup leuart
  * @{
  ******************************************************************************/
 
+// A const table, every value computed at compile time.  The receiver always
+// blocks until the start frame and wakes on the signal frame
 typedef struct {
-	uint32_t					baudrate;
-	LEUART_Databits_TypeDef		databits;
-	LEUART_Enable_TypeDef		enable;
-	LEUART_Parity_TypeDef 		parity;
-	LEUART_Stopbits_TypeDef		stopbits;
-	bool						rxblocken;
-	bool						sfubrx;
-	bool						startframe_en;
+	LEUART_Init_TypeDef			init;			// Baud rate checked with LEUART_BAUD_VALID()
 	char						startframe;
-	bool						sigframe_en;
 	char						sigframe;
-	uint32_t					rx_loc;
-	uint32_t					rx_pin_en;
-	uint32_t					tx_loc;
-	uint32_t					tx_pin_en;
+	uint32_t					routeloc0;		// RXLOC | TXLOC
+	uint32_t					routepen;		// LEUART_ROUTEPEN_ of the directions enabled
 	bool						rx_en;
 	bool						tx_en;
-	uint32_t					rx_done_evt;
-	uint32_t					tx_done_evt;
 } LEUART_OPEN_STRUCT;
 
 typedef struct {
@@ -55,19 +57,28 @@ typedef struct {
   uint32_t               count;
   uint32_t               length;
   uint32_t               callback;
-  char                   string[80];
-  bool                   busy;
+  char                   *string;       // Block of the pool, given back once sent
+  volatile bool          busy;
 
 } LEUART_STATE_MACHINE;
 
 typedef struct {
   uint32_t          state;
-  char            string[80];
+  char            *string;       // Block of the pool, until leuart_rx_copy() takes the frame
   uint32_t          length;
   LEUART_TypeDef       *leuart;
   uint32_t          callback;
 } RX_LEUART_STATE_MACHINE;
 
+// Writes between leuart_freeze() and leuart_commit() reach the LF domain in
+// one synchronization
+typedef struct {
+  bool              frozen;
+  bool              irq;            // LEUART0_IRQn was enabled before the batch masked it
+  uint32_t          cmd;            // Commands of the batch, written as one
+  uint32_t          ctrl;           // CTRL as last written, read-modify-writes start from it
+} LEUART_SHADOW;
+
 
 /** @} (end addtogroup leuart) */
 
@@ -79,16 +90,24 @@ typedef struct {
 //***********************************************************************************
 // function prototypes
 //***********************************************************************************
-void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings);
+void leuart_open(LEUART_TypeDef *leuart, const LEUART_OPEN_STRUCT *leuart_settings, uint32_t tx_event,
+                 uint32_t rx_event, bool self_test);
 void LEUART0_IRQHandler(void);
-void leuart_start(LEUART_TypeDef *leuart, char *string, uint32_t string_len);
+bool leuart_start(LEUART_TypeDef *leuart, char *string, uint32_t string_len);
 bool leuart_tx_busy(LEUART_TypeDef *leuart);
+void leuart_rx_copy(char *string, uint32_t size);
 
 uint32_t leuart_status(LEUART_TypeDef *leuart);
 void leuart_cmd_write(LEUART_TypeDef *leuart, uint32_t cmd_update);
+void leuart_ctrl_write(LEUART_TypeDef *leuart, uint32_t set, uint32_t clear);
+void leuart_freeze(LEUART_TypeDef *leuart);
+void leuart_commit(LEUART_TypeDef *leuart);
+void leuart_sync(LEUART_TypeDef *leuart, uint32_t mask);
 void leuart_if_reset(LEUART_TypeDef *leuart);
 void leuart_app_transmit_byte(LEUART_TypeDef *leuart, uint8_t data_out);
 uint8_t leuart_app_receive_byte(LEUART_TypeDef *leuart);
 void leuart_test(void);
+bool leuart_test_busy(void);
+bool leuart_tx_pending(void);
 
 #endif
@@ -0,0 +1,60 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef POOL_HG
+#define POOL_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_assert.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+// Size classes, smallest first.  The block counts are the peaks "#POOL!"
+// reported in firmware_sim over the boot and each of the commands, in the
+// default, BLE_TEST_ENABLED and BENCHMARK_ENABLED builds, one more for a
+// frame coming in on top.  Whoever finds no block skips its line or
+// command, the failed count shows it, see leuart_start() and app.c
+#define POOL_SMALL_SIZE     16          // Sample lines going out, "z = 4.5 \n"
+#define POOL_SMALL_BLOCKS   2           // Peak 1
+#define POOL_MEDIUM_SIZE    32          // Sample lines being formatted, CHAR_SEND
+#define POOL_MEDIUM_BLOCKS  3           // Peak 2
+#define POOL_LARGE_SIZE     80          // Frames received, commands, report and dump lines
+#define POOL_LARGE_BLOCKS   5           // Peak 4, a command, its line, a dump line and its copy going out,
+                                        // or ble_test()'s three strings and one going out
+#define POOL_CLASSES        3
+#define POOL_BLOCKS_MAX     32          // Per class, one bit each in the free mask
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef struct {
+  uint32_t          size;           // Bytes per block
+  uint32_t          blocks;
+  uint32_t          used;           // Blocks handed out now
+  uint32_t          peak;           // Most blocks handed out at once
+  uint32_t          largest;        // Largest size asked of this class
+  uint32_t          borrowed;       // Handed out for a smaller class that was empty
+  uint32_t          failed;         // Asked of this class with it and every larger one empty
+  uint32_t          truncated;      // Asked for more than POOL_LARGE_SIZE, given a large block
+} POOL_STATS;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void pool_open(void);
+void *pool_alloc(uint32_t size);
+void *pool_alloc_clamp(uint32_t *size);
+void pool_free(void *block);
+bool pool_get(uint32_t pool_class, POOL_STATS *out);
+uint32_t pool_report(uint32_t pool_class, char *report, uint32_t size);
+
+#endif
@@ -0,0 +1,70 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef PROFILER_HG
+#define PROFILER_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "trace.h"
+#include "stack.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define PROFILER_ENABLED                // Comment out to remove the handler hooks
+#define PROFILER_EVENTS       8         // Scheduler event bits, up to BLE_RX_DONE_CB
+#define PROFILER_DEPTH        4         // Interrupt nesting the owner stack holds
+#define PROFILER_TOP          3         // Consumers named in the report
+#define PROFILER_REPORT_SIZE  80        // One ble_write()
+
+// Owners the active cycles are charged to
+#define PROFILER_MAIN         0                                 // Main loop between handlers
+#define PROFILER_EVENT(n)     (1 + (n))                         // Handler of scheduler event bit n
+#define PROFILER_IRQ(irqn)    (1 + PROFILER_EVENTS + (irqn))    // Interrupt handler
+#define PROFILER_OWNERS       (1 + PROFILER_EVENTS + EXT_IRQ_COUNT)
+
+#define PROFILER_RTCC_HZ      1000      // ULFRCO with no prescaler, the sleep timebase
+
+// The handler hooks also bracket the handler in the trace and, built with
+// STACK_IRQ_ENABLED, measure its stack, outermost so the stack hooks see the
+// others' frames as the handler's
+#ifdef PROFILER_ENABLED
+#define PROFILER_IRQ_ENTER(irqn)  do { STACK_IRQ_ENTER(irqn); profiler_irq_enter(irqn); TRACE(TRACE_IRQ_ENTER, (irqn)); } while(0)
+#define PROFILER_IRQ_EXIT()       do { TRACE(TRACE_IRQ_EXIT, 0); profiler_irq_exit(); STACK_IRQ_EXIT(); } while(0)
+#else
+#define PROFILER_IRQ_ENTER(irqn)  do { STACK_IRQ_ENTER(irqn); TRACE(TRACE_IRQ_ENTER, (irqn)); } while(0)
+#define PROFILER_IRQ_EXIT()       do { TRACE(TRACE_IRQ_EXIT, 0); STACK_IRQ_EXIT(); } while(0)
+#endif
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void profiler_open(void);
+void profiler_irq_enter(IRQn_Type irqn);
+void profiler_irq_exit(void);
+void profiler_dispatch(uint32_t events);
+void profiler_sleep_begin(void);
+void profiler_sleep_end(void);
+uint64_t profiler_cycles(uint32_t owner);
+uint32_t profiler_load(void);
+uint32_t profiler_report(char *report, uint32_t size);
+void profiler_clear(void);
+uint32_t profiler_owner(void);
+void profiler_owner_name(uint32_t owner, char *name, uint32_t size);
+
+#endif
@@ -0,0 +1,48 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef RECORDER_HG
+#define RECORDER_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_assert.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define RECORDER_ENABLED                // Comment out to remove the input hooks
+#define RECORDER_WORDS      512         // One word per input, 2 KB of RAM
+#define RECORDER_LINE_MARK  'R'         // First character of a line recorder_line() makes
+
+// Inputs, the data each one carries follows it
+#define RECORDER_TIME       0           // None, only moves the time on, see recorder_input()
+#define RECORDER_LEUART_RX  1           // Byte read from RXDATA
+#define RECORDER_LETIMER    2           // Interrupt flags taken, IF & IEN
+#define RECORDER_I2C_RX     3           // Byte read from RXDATA
+
+#ifdef RECORDER_ENABLED
+#define RECORD(source, data)  recorder_input((source), (data))
+#else
+#define RECORD(source, data)
+#endif
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void recorder_open(void);
+void recorder_input(uint32_t source, uint32_t data);
+bool recorder_line(char *line, uint32_t size, uint32_t *next);
+
+#endif
@@ -0,0 +1,61 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef RGB_PWM_HG
+#define RGB_PWM_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_timer.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "brd_config.h"
+#include "cmu.h"
+#include "sleep_routines.h"
+#include "LEDs_thunderboard.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define RGB_PWM_TOP           1023    // 10-bit compare resolution after gamma correction
+#define RGB_PWM_FREQ          400     // Minimum PWM frequency in Hz, keeps the LEDs flicker free
+#define RGB_PWM_EM            EM2     // TIMER runs from HFPERCLK, the lowest EM is EM1
+#define RGB_PWM_BRIGHT_MAX    255
+#define RGB_PWM_MAX_PRESCALE  10      // timerPrescale1024
+
+#define RGB_RED_CH            0       // TIMER CC channel of the red color line
+#define RGB_GREEN_CH          1       // TIMER CC channel of the green color line
+#define RGB_BLUE_CH           2       // TIMER CC channel of the blue color line
+#define RGB_PWM_CHANNELS      3
+
+#define RGB_ALL_LEDS          (RGB_LED_0 | RGB_LED_1 | RGB_LED_2 | RGB_LED_3)
+
+// Drivers of the compare buffers of RGB_PWM_TIMER, one at a time
+#define RGB_PWM_OWNER_NONE    0       // TIMER stopped
+#define RGB_PWM_OWNER_COLOR   1       // rgb_pwm_set()
+#define RGB_PWM_OWNER_EFFECT  2       // led_effects.c, the LDMA streams the buffers
+#define RGB_PWM_OWNER_FB      3       // led_fb.c, the TIMER interrupt loads them
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void rgb_pwm_open(void);
+void rgb_pwm_set(uint32_t leds, uint8_t red, uint8_t green, uint8_t blue);
+void rgb_pwm_brightness(uint8_t brightness);
+void rgb_pwm_off(void);
+void rgb_pwm_stream(uint32_t owner, uint32_t leds);
+uint32_t rgb_pwm_owner(void);
+uint32_t rgb_pwm_duty(uint8_t level);
+
+#endif
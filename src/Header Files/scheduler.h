@@ -5,6 +5,7 @@
 #define	SCHEDULER_HG
 
 /* System include statements */
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Silicon Labs include statements */
@@ -16,6 +17,14 @@
 //***********************************************************************************
 // defined files
 //***********************************************************************************
+#define SCHEDULER_EVENTS        32      // One per bit of the event word
+#define SCHEDULER_PRIORITIES    4       // Run to completion levels, 0 is served first
+#define SCHEDULER_PRIO_URGENT   0       // Answers to the central
+#define SCHEDULER_PRIO_HIGH     1       // Driver completions
+#define SCHEDULER_PRIO_NORMAL   2
+#define SCHEDULER_PRIO_LOW      3       // Periodic telemetry
+
+typedef void (*SCHEDULER_CB)(void);
 
 
 //***********************************************************************************
@@ -30,6 +39,9 @@ void scheduler_open(void);
 void add_scheduled_event(uint32_t event);
 void remove_scheduled_event(uint32_t event);
 uint32_t get_scheduled_events(void);
+void scheduler_register(uint32_t event, uint32_t priority, SCHEDULER_CB callback);
+uint32_t scheduler_next_event(void);
+bool scheduler_dispatch(void);
 
 
 #endif
@@ -0,0 +1,59 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef STACK_HG
+#define STACK_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_assert.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define STACK_ENABLED                   // Comment out to remove the painting and the handler hooks
+// STACK_IRQ_ENABLED, build option of a debug profile, e.g. -DSTACK_IRQ_ENABLED.
+// The handler hooks scan and paint STACK_IRQ_WINDOW with interrupts masked
+// on every interrupt, off by default so the LEUART RX path is not held up
+#define STACK_PAINT         0xC5C5C5C5UL    // Words of the main stack never used
+#define STACK_GUARD         64          // Bytes under the SP stack_open() leaves alone
+#define STACK_IRQ_WINDOW    256         // Bytes under a handler's SP painted on entry
+#define STACK_DEPTH         4           // Interrupt nesting the entry stack holds
+
+#if defined(STACK_ENABLED) && defined(STACK_IRQ_ENABLED)
+#define STACK_IRQ_ENTER(irqn)  stack_irq_enter(irqn)
+#define STACK_IRQ_EXIT()       stack_irq_exit()
+#else
+#define STACK_IRQ_ENTER(irqn)
+#define STACK_IRQ_EXIT()
+#endif
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef struct {
+  uint32_t          count;          // Runs of the handler measured
+  uint32_t          depth;          // Most of the main stack in use while it ran, in bytes
+  uint32_t          own;            // Most it used under the SP it was entered at, in bytes
+} STACK_IRQ_STATS;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void stack_open(void);
+uint32_t stack_size(void);
+uint32_t stack_used(void);
+void stack_irq_enter(IRQn_Type irqn);
+void stack_irq_exit(void);
+bool stack_irq_get(IRQn_Type irqn, STACK_IRQ_STATS *out);
+void stack_report(char *report, uint32_t size);
+uint32_t stack_irq_report(IRQn_Type irqn, char *report, uint32_t size);
+
+#endif
@@ -0,0 +1,90 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef TASK_HG
+#define TASK_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "scheduler.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TASK_MAX          6             // Tasks running at once
+#define TASK_EVENT        0x00000200    // Scheduler bit of the timeouts and task ends
+#define TASK_PRIORITY     SCHEDULER_PRIO_NORMAL   // Level the tasks resume at
+#define TASK_RTCC_CH      1             // RTCC compare channel of the timeouts
+#define TASK_RTCC_HZ      1000          // ULFRCO with no prescaler, shared with the profiler
+#define TASK_FOREVER      UINT32_MAX    // No timeout
+
+typedef enum {
+  TASK_WAITING,
+  TASK_ENDED
+} TASK_STATUS;
+
+typedef struct TASK TASK;
+typedef TASK_STATUS (*TASK_FN)(TASK *task);
+
+struct TASK {
+  uint32_t  lc;                         // Line to resume at, 0 at the start
+  TASK_FN   fn;
+  uint32_t  waiting;                    // Event bits the task waits on
+  uint32_t  events;                     // Waited bits that arrived during this wait
+  uint32_t  deadline;                   // RTCC tick of the timeout
+  bool      timed;
+  bool      timed_out;
+  bool      running;
+};
+
+// Stackless task bodies, a switch on the line the task left at.  Locals do
+// not survive a wait, keep what is needed across one in statics, and do not
+// wait from inside another switch.
+#define TASK_BEGIN(task)      switch((task)->lc){ case 0:
+#define TASK_END(task)        } (task)->lc = 0; return TASK_ENDED
+
+// Yields until cond holds, checked each time one of wait's events arrives
+// and on every TASK_EVENT, or until ms have passed
+#define TASK_WAIT_UNTIL(task, cond, wait, ms)                   \
+  do {                                                          \
+      task_timeout((task), (ms));                               \
+      (task)->lc = __LINE__; case __LINE__:                     \
+      if(!(cond) && !(task)->timed_out){                        \
+          (task)->waiting = (wait);                             \
+          return TASK_WAITING;                                  \
+      }                                                         \
+      (task)->timed = false;                                    \
+  } while(0)
+
+// Yields until one of the events is posted, the task takes it ahead of the
+// event's callback
+#define TASK_WAIT(task, wait, ms)   TASK_WAIT_UNTIL((task), (task)->events & (wait), (wait), (ms))
+#define TASK_DELAY(task, ms)        TASK_WAIT_UNTIL((task), false, 0, (ms))
+#define TASK_TIMED_OUT(task)        ((task)->timed_out)
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void task_open(void);
+void task_start(TASK *task, TASK_FN fn);
+bool task_running(TASK *task);
+void task_timeout(TASK *task, uint32_t ms);
+uint32_t task_waiting(void);
+void task_notify(uint32_t event);
+void task_run(void);
+
+#endif
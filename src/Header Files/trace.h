@@ -0,0 +1,54 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef TRACE_HG
+#define TRACE_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_assert.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TRACE_ENABLED                   // Comment out to remove the trace hooks
+#define TRACE_RECORDS       256         // Ring size, 2 KB of RAM
+#define TRACE_WORDS         2           // Words per record, see trace_record()
+#define TRACE_LINE_MARK     'T'         // First character of a line trace_line() makes
+
+// Record types, the argument each one carries follows it
+#define TRACE_IRQ_ENTER     1           // IRQ number
+#define TRACE_IRQ_EXIT      2           // 0, closes the innermost handler
+#define TRACE_POST          3           // Scheduler event bit number
+#define TRACE_DISPATCH      4           // Scheduler event bit number
+#define TRACE_DONE          5           // Scheduler event bit number
+#define TRACE_SLEEP         6           // Energy mode
+#define TRACE_WAKE          7           // Energy mode slept in
+#define TRACE_HF            8           // Core clock in MHz, the rate of the cycle stamps
+
+#ifdef TRACE_ENABLED
+#define TRACE(type, arg)    trace_record((type), (arg))
+#else
+#define TRACE(type, arg)
+#endif
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void trace_start(void);
+void trace_stop(void);
+void trace_record(uint32_t type, uint32_t arg);
+bool trace_line(char *line, uint32_t size);
+
+#endif
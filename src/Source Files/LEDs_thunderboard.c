@@ -17,6 +17,19 @@
 //***********************************************************************************
 // defined files
 //***********************************************************************************
+#define RGB_SELECT_BITS(leds) ((((leds) & RGB_LED_0) ? (1u << RGB0_PIN) : 0) | \
+                               (((leds) & RGB_LED_1) ? (1u << RGB1_PIN) : 0) | \
+                               (((leds) & RGB_LED_2) ? (1u << RGB2_PIN) : 0) | \
+                               (((leds) & RGB_LED_3) ? (1u << RGB3_PIN) : 0))
+
+#define RGB_COLOR_BITS(color) ((((color) & COLOR_RED) ? (1u << RGB_RED_PIN) : 0) | \
+                               (((color) & COLOR_GREEN) ? (1u << RGB_GREEN_PIN) : 0) | \
+                               (((color) & COLOR_BLUE) ? (1u << RGB_BLUE_PIN) : 0))
+
+_Static_assert((RGB1_PORT == RGB_SELECT_PORT) && (RGB2_PORT == RGB_SELECT_PORT) &&
+               (RGB3_PORT == RGB_SELECT_PORT), "RGB enables must share a port");
+_Static_assert((RGB_GREEN_PORT == RGB_COLOR_PORT) && (RGB_BLUE_PORT == RGB_COLOR_PORT),
+               "RGB color lines must share a port");
 
 
 //***********************************************************************************
@@ -24,6 +37,19 @@
 //***********************************************************************************
 bool	rgb_enabled_status;
 
+/* Port pin masks of every combination of LEDs and colors, built at compile time */
+static const uint16_t rgb_select_lut[RGB_ALL_LED_BITS + 1] = {
+  RGB_SELECT_BITS(0),  RGB_SELECT_BITS(1),  RGB_SELECT_BITS(2),  RGB_SELECT_BITS(3),
+  RGB_SELECT_BITS(4),  RGB_SELECT_BITS(5),  RGB_SELECT_BITS(6),  RGB_SELECT_BITS(7),
+  RGB_SELECT_BITS(8),  RGB_SELECT_BITS(9),  RGB_SELECT_BITS(10), RGB_SELECT_BITS(11),
+  RGB_SELECT_BITS(12), RGB_SELECT_BITS(13), RGB_SELECT_BITS(14), RGB_SELECT_BITS(15),
+};
+
+static const uint16_t rgb_color_lut[RGB_ALL_COLOR_BITS + 1] = {
+  RGB_COLOR_BITS(0), RGB_COLOR_BITS(1), RGB_COLOR_BITS(2), RGB_COLOR_BITS(3),
+  RGB_COLOR_BITS(4), RGB_COLOR_BITS(5), RGB_COLOR_BITS(6), RGB_COLOR_BITS(7),
+};
+
 //***********************************************************************************
 // Private functions
 //***********************************************************************************
@@ -65,7 +91,9 @@ void rgb_init(void) {
  * @details
  *When the UF and the comp1 interrupts call this function it is for enabling and
  * disabling the RGB leds on a certain location based on the input arguments
- *which causes the it to rotate in the required from in sync.
+ *which causes the it to rotate in the required from in sync.  The LED and color
+ *arguments are turned into port pin masks by table lookup and each port is
+ *updated with a single atomic set or clear.
  *
  *
  * @note
@@ -74,34 +102,31 @@ void rgb_init(void) {
  ******************************************************************************/
 
 void leds_enabled(uint32_t leds, uint32_t color, bool enable){
+  uint32_t color_mask = rgb_color_lut[color & RGB_ALL_COLOR_BITS];
+  uint32_t select_mask = rgb_select_lut[leds & RGB_ALL_LED_BITS];
+
+  if (enable) {
+    if (color_mask) GPIO_PortOutSet(RGB_COLOR_PORT, color_mask);
+    if (select_mask) GPIO_PortOutSet(RGB_SELECT_PORT, select_mask);
+  } else {
+    if (color_mask) GPIO_PortOutClear(RGB_COLOR_PORT, color_mask);
+    if (select_mask) GPIO_PortOutClear(RGB_SELECT_PORT, select_mask);
+  }
+}
 
-    if ((color & COLOR_RED) && enable) {
-      GPIO_PinOutSet(RGB_RED_PORT,RGB_RED_PIN);
-    } else if ((color & COLOR_RED) && !enable) GPIO_PinOutClear(RGB_RED_PORT,RGB_RED_PIN);
-
-    if ((color & COLOR_GREEN) && enable) {
-      GPIO_PinOutSet(RGB_GREEN_PORT,RGB_GREEN_PIN);
-    } else if ((color & COLOR_GREEN) && !enable)  GPIO_PinOutClear(RGB_GREEN_PORT,RGB_GREEN_PIN);
-
-    if ((color & COLOR_BLUE) && enable) {
-      GPIO_PinOutSet(RGB_BLUE_PORT,RGB_BLUE_PIN);
-    } else if ((color & COLOR_BLUE) && !enable)  GPIO_PinOutClear(RGB_BLUE_PORT,RGB_BLUE_PIN);
-
-		if ((leds & RGB_LED_0) && enable) {
-			GPIO_PinOutSet(RGB0_PORT,RGB0_PIN);
-		} else if ((leds & RGB_LED_0) && !enable) GPIO_PinOutClear(RGB0_PORT,RGB0_PIN);
-
-		if ((leds & RGB_LED_1) && enable) {
-			GPIO_PinOutSet(RGB1_PORT,RGB1_PIN);
-		} else if ((leds & RGB_LED_1) && !enable)  GPIO_PinOutClear(RGB1_PORT,RGB1_PIN);
-
-		if ((leds & RGB_LED_2) && enable) {
-			GPIO_PinOutSet(RGB0_PORT,RGB2_PIN);
-		} else if ((leds & RGB_LED_2) && !enable)  GPIO_PinOutClear(RGB2_PORT,RGB2_PIN);
-
-		if ((leds & RGB_LED_3) && enable) {
-			GPIO_PinOutSet(RGB3_PORT,RGB3_PIN);
-		} else if ((leds & RGB_LED_3) && !enable)  GPIO_PinOutClear(RGB3_PORT,RGB3_PIN);
+/***************************************************************************//**
+ * @brief
+ *Returns the RGB_SELECT_PORT pin mask of a set of LEDs
+ *
+ * @param[in] leds
+ *Bit mask of RGB_LED_0 to RGB_LED_3
+ *
+ * @return
+ *The pins of RGB_SELECT_PORT that enable those LEDs
+ *
+ ******************************************************************************/
 
+uint32_t rgb_select_mask(uint32_t leds){
+  return rgb_select_lut[leds & RGB_ALL_LED_BITS];
 }
 
@@ -13,11 +13,34 @@
 #include "SI1133.h"
 #include "em_i2c.h"
 
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SI1133_I2C_FREQ   I2C_FREQ_FAST_MAX       // Fast mode, the Si1133 takes up to 400 kHz
+#define SI1133_I2C_CLHR   i2cClockHLRAsymetric
+
+_Static_assert(I2C_FREQ_VALID(SI1133_I2C_FREQ, SI1133_I2C_CLHR) && (SI1133_I2C_FREQ <= 400000),
+               "SI1133_I2C_FREQ is too fast for its clock ratio or for the Si1133");
+
 //***********************************************************************************
 // Private variables
 //***********************************************************************************
+// I2C1 to the Si1133, master at the current HFPERCLK
+static const I2C_OPEN_STRUCT si1133_i2c = {
+  .init = {
+    .enable = true,
+    .master = true,
+    .refFreq = 0,           // The current HFPERCLK
+    .freq = SI1133_I2C_FREQ,
+    .clhr = SI1133_I2C_CLHR,
+  },
+  .routeloc0 = SCL_ROUTE | SDA_ROUTE,
+  .routepen = I2C_ROUTEPEN_SCLPEN | I2C_ROUTEPEN_SDAPEN,
+};
+
 
 static uint32_t data;
+static bool opened;
 uint32_t byte = 1;
 bool Write_Read = true;
 int counter = 0;
@@ -62,33 +85,42 @@ uint32_t si1133_pass_ID(void){
   return data;
 }
 
+/***************************************************************************//**
+ * @brief
+ *   Tells whether the last read was cut short by a NACK of the sensor
+ *
+ * @details
+ *   The read's callback event is posted either way, si1133_pass_ID() is not
+ *   valid after a NACK.
+ *
+ ******************************************************************************/
+
+bool si1133_nacked(void){
+  return i2c_nacked(I2C1);
+}
+
 /***************************************************************************//**
  * @brief
  *   This function initiates the SI1133 sensor
  *
  * @details
- *   This STRUCT contains the information to complete the set-up of the I2C external devices.
+ *   The const si1133_i2c table contains the information to complete the
+ *   set-up of the I2C external devices.
  *
  *
  * @note
- *   Time delay must be incorporated to take into account the delays
+ *   The sensor needs POR ms after power up before it answers, the boot
+ *   sequencer sleeps through them instead of spinning here.  Opening again
+ *   does nothing.
  *
  ******************************************************************************/
 
 void si1133_i2c_open(){
-  timer_delay(POR);
-  I2C_OPEN_STRUCT i2cOpen;
-
-  i2cOpen.enable = true;
-  i2cOpen.master = true;
-  i2cOpen.out_pin_scl_en = true;
-  i2cOpen.out_pin_sda_en = true;
-  i2cOpen.out_pin_scl_route = SCL_ROUTE;
-  i2cOpen.out_pin_sda_route = SDA_ROUTE;
-  i2cOpen.freq = I2C_FREQ_FAST_MAX;
-  i2cOpen.clhr = i2cClockHLRAsymetric;
-
-  i2c_open(I2C1, &i2cOpen);
+  if(opened){
+      return;
+  }
+  opened = true;
+  i2c_open(I2C1, &si1133_i2c);
 }
 
 
@@ -12,18 +12,46 @@
 #include "app.h"
 #include "LEDs_thunderboard.h"
 #include <stdio.h>
+#include <string.h>
 
 //***********************************************************************************
 // defined files
 //***********************************************************************************
+_Static_assert(LETIMER_TICKS(PWM_PER) <= LETIMER_COMP_MAX, "PWM_PER does not fit the 16-bit COMP0");
+_Static_assert((LETIMER_TICKS(PWM_ACT_PER) > 0) && (LETIMER_TICKS(PWM_ACT_PER) < LETIMER_TICKS(PWM_PER)),
+               "PWM_ACT_PER must be at least a count and shorter than PWM_PER");
 
 
 //***********************************************************************************
 // Private variables
 //***********************************************************************************
+// LETIMER0 in PWM mode, the outputs not driven, the heart beat of the sampling
+static const APP_LETIMER_PWM_TypeDef app_letimer_pwm = {
+  .init = LETIMER_PWM_INIT(false, false, LETIMER_TICKS(PWM_PER)),
+  .period = LETIMER_TICKS(PWM_PER),
+  .active_period = LETIMER_TICKS(PWM_ACT_PER),
+  .routeloc0 = PWM_ROUTE_0 | PWM_ROUTE_1,
+  .routepen = 0,
+  .ien = LETIMER_IEN_COMP1 | LETIMER_IEN_UF,
+  .comp0_cb = LETIMER0_COMP0_CB,
+  .comp1_cb = LETIMER0_COMP1_CB,
+  .uf_cb = LETIMER0_UF_CB,
+};
+
 //static int colorLED=0;
  uint32_t x = 3;
  uint32_t y =0;
+static TASK boot_task;
+static TASK log_task;
+static TASK trace_task;
+static TASK record_task;
+static TASK_STATUS app_boot_link(TASK *task);
+static TASK_STATUS app_boot_sensor(TASK *task);
+
+static const BOOT_STEP boot_steps[] = {
+  { "link",   app_boot_link },
+  { "sensor", app_boot_sensor },
+};
 
 //***********************************************************************************
 // Private functions
@@ -31,7 +59,17 @@
 
 
 
-static void app_letimer_pwm_open(float period, float act_period, uint32_t out0_route, uint32_t out1_route);
+static void app_scheduler_register(void);
+static void app_restore(void);
+static TASK_STATUS app_boot_task(TASK *task);
+static TASK_STATUS app_log_task(TASK *task);
+static TASK_STATUS app_trace_task(TASK *task);
+static TASK_STATUS app_record_task(TASK *task);
+static void app_status_led(bool dark);
+static void app_led_owner(uint32_t owner);
+#ifdef HIBERNATE_ENABLED
+static void app_hibernate(void) __attribute__((noreturn));
+#endif
 
 //***********************************************************************************
 // Global functions
@@ -43,9 +81,11 @@ static void app_letimer_pwm_open(float period, float act_period, uint32_t out0_r
  *
  * @details
  *This function makes call to the cmu_open() ,gpio_open(),scheduler_open(),
- * sleep_(),rgb_init() function for the
- *initial setup.then called the letimer_pwm_open() function and starts the
- *LETIMER0
+ * sleep_(),rgb_init(),rgb_pwm_open() function for the
+ *initial setup.then opens the LETIMER0 from its const table.  The boot task
+ *starts the LETIMER0 once the LEUART self test has given the link back.
+ *An EM4H wake-up is a warm boot, the counters come back from retention and
+ *the LEUART self test is skipped
  *
  * @note
  *This function is for setting up and intializing the application peripherals
@@ -54,62 +94,67 @@ static void app_letimer_pwm_open(float period, float act_period, uint32_t out0_r
 
 
 void app_peripheral_setup(void){
+  stack_open();         // First, the less of the stack in use the more of it is painted
   cmu_open();
+  hibernate_open();
+  app_restore();
   gpio_open();
   scheduler_open();
+  app_scheduler_register();
+  task_open();
+  recorder_open();
+  pool_open();
+  boot_open(hibernate_warm_boot());
   sleep_open();
   rgb_init();
+  rgb_pwm_open();
+  rgb_pwm_brightness(STATUS_LED_BRIGHTNESS);
+  led_effect_open();
+  led_fb_open();
  // si1133_i2c_open();
-  ble_open(BLE_TX_DONE_CB,BLE_RX_DONE_CB);
+  ble_open(BLE_TX_DONE_CB,BLE_RX_DONE_CB, !hibernate_warm_boot());
   sleep_block_mode(SYSTEM_BLOCK_EM);
-  app_letimer_pwm_open(PWM_PER, PWM_ACT_PER, PWM_ROUTE_0, PWM_ROUTE_1);
-  letimer_start(LETIMER0, true);  //This command will initiate the start of the LETIMER0
+  letimer_pwm_open(LETIMER0, &app_letimer_pwm);
   add_scheduled_event(BOOT_UP_CB);
+  profiler_open();      // Last, the profile covers the main loop and not the setup
+  trace_start();
 }
 
 /***************************************************************************//**
  * @brief
- *This function is used for setting up the struct
+ *   Hands the main loop the callback and priority of every app event
  *
  * @details
- *This function is used for setting up the structures and data for the
- *app_letimer_pwm_open() function
- *
- * @note
- *Setting up the LETIMER and the pwm function
+ *   Answers to the central come first so a command is not held up behind
+ *   the telemetry line, driver completions next, and the periodic sample
+ *   last.
  *
- * @param[in]
- *PWM periods in seconds , initialized by float
- *
- * @param[in]
- *PWM active period in seconds, initialized by float
  ******************************************************************************/
 
-void app_letimer_pwm_open(float period, float act_period, uint32_t out0_route, uint32_t out1_route){
-  // Initializing LETIMER0 for PWM operation by creating the
-  // letimer_pwm_struct and initializing all of its elements
-  // APP_LETIMER_PWM_TypeDef is defined in letimer.h
-  APP_LETIMER_PWM_TypeDef   pwm;
-
-  pwm.enable = false;
-  pwm.debugRun = false;
-  pwm.active_period = act_period;
-  pwm.period = period;
-  pwm.out_pin_0_en = false;
-  pwm.out_pin_1_en = false;
-  pwm.out_pin_route0 = out0_route;
-  pwm.out_pin_route1 = out1_route;
-  pwm.comp0_irq_enable = false;
-  pwm.comp0_cb = LETIMER0_COMP0_CB;
-  pwm.comp1_irq_enable = true;
-  pwm.comp1_cb = LETIMER0_COMP1_CB;
-  pwm.uf_irq_enable = true;
-  pwm.uf_cb = LETIMER0_UF_CB;
-
-
- letimer_pwm_open(LETIMER0, &pwm);
+static void app_scheduler_register(void){
+  scheduler_register(BLE_RX_DONE_CB, SCHEDULER_PRIO_URGENT, scheduled_ble_rx_done_cb);
+  scheduler_register(SI1133_REG_READ_CB, SCHEDULER_PRIO_HIGH, si1133_white_op);
+  scheduler_register(BLE_TX_DONE_CB, SCHEDULER_PRIO_HIGH, scheduled_ble_tx_done_cb);
+  scheduler_register(BOOT_UP_CB, SCHEDULER_PRIO_NORMAL, scheduled_boot_up_cb);
+  scheduler_register(LETIMER0_COMP0_CB, SCHEDULER_PRIO_NORMAL, scheduled_letimer0_comp0_cb);
+  scheduler_register(LETIMER0_COMP1_CB, SCHEDULER_PRIO_NORMAL, scheduled_letimer0_comp1_cb);
+  scheduler_register(LETIMER0_UF_CB, SCHEDULER_PRIO_LOW, scheduled_letimer0_uf_cb);
 }
 
+/***************************************************************************//**
+ * @brief
+ *   Takes the sample counters back from retention on a warm boot
+ *
+ ******************************************************************************/
+
+static void app_restore(void){
+  uint32_t state[APP_RETAINED_WORDS];
+
+  if(hibernate_restore(state, sizeof(state))){
+      x = state[0];
+      y = state[1];
+  }
+}
 
 /***************************************************************************//**
  * @brief
@@ -150,9 +195,15 @@ void scheduled_letimer0_uf_cb (void){
   x=x+ADD_THREE;
   y=y+ADD_ONE;
   z=(float)x/y;
-  char send[CHAR_SEND];
-  sprintf(send, "z = %1.1f \n", z);
-  ble_write(send);
+  char *send = pool_alloc(CHAR_SEND);
+  // No block free: the sample still goes in the log, only its line is skipped
+  if(send){
+      sprintf(send, "z = %1.1f \n", z);
+      ble_write(send);
+      pool_free(send);
+  }
+  BINLOG3("sample x=%lu y=%lu z=%.2f", x, y, z);
+  boot_sample();
 
 
 }
@@ -244,8 +295,9 @@ void scheduled_letimer0_comp1_cb (void){
  *
  * @details
  *   This function checks if the desired value matches with the pass_ID(function)/register
- *   If the value is less than 20 then the blue led of RGB LED_1 lights up else if
- *   its greater than or equal to 20 then it turns off
+ *   If the value is less than 20 then the blue led of RGB LED_1 lights up dimmed
+ *   through the PWM driver else if its greater than or equal to 20 then it turns off,
+ *   see app_status_led() for the framebuffer and the effect
  *
  *
  *
@@ -258,12 +310,7 @@ void scheduled_letimer0_comp1_cb (void){
 void si1133_white_op(void){
 
     uint32_t value = si1133_pass_ID();
-    if(value < SENSE_VAL) {
-        leds_enabled(RGB_LED_1,COLOR_BLUE,true);
-    }
-    else if(value >= SENSE_VAL){
-        leds_enabled(RGB_LED_1,COLOR_BLUE,false);
-    }
+    app_status_led(value < SENSE_VAL);
 
 }
 
@@ -273,7 +320,9 @@ void si1133_white_op(void){
  *
  * @details
  *   This function was initially used to set the connection name and then it would
- *   print hello world on the terminal and call the letimer_start function
+ *   print hello world on the terminal and call the letimer_start function.  The
+ *   peripherals now come up as concurrent boot steps and the rest runs as the
+ *   boot task once they are done, neither holds up the main loop.
  *
  *
  *
@@ -281,14 +330,113 @@ void si1133_white_op(void){
 
 void scheduled_boot_up_cb(void){
 //  EFM_ASSERT(get_scheduled_events() & BOOT_UP_CB);
-#ifdef BLE_TEST_ENABLED
-  EFM_ASSERT(ble_test("Sam"));
-  timer_delay(DELAY);
+  boot_start(boot_steps, sizeof(boot_steps) / sizeof(boot_steps[0]));
+  task_start(&boot_task, app_boot_task);
+}
+
+/***************************************************************************//**
+ * @brief
+ *  What follows the peripherals' bring-up, the HM10 link is only used once
+ *  the boot steps are done
+ *
+ * @details
+ *  The LETIMER0 underflows as it starts, so the first sample follows at
+ *  once.  A warm boot goes straight to it.  With HIBERNATE_ENABLED every
+ *  boot sends one sample and hibernates once it has left, the LETIMER0 is
+ *  not used.
+ *
+ ******************************************************************************/
+
+static TASK_STATUS app_boot_task(TASK *task){
+  TASK_BEGIN(task);
+  TASK_WAIT_UNTIL(task, !boot_busy(), 0, TASK_FOREVER);
+  BINLOG2("boot warm=%lu ready after %lu ms", boot_warm(), boot_ready_ms());
+  if(!boot_warm()){
+#ifdef BENCHMARK_ENABLED
+      benchmark_run(ble_write, NULL);
 #endif
-  ble_write("\nHello World\n");
+      ble_write("\nHello World\n");
+  }
+#ifdef HIBERNATE_ENABLED
+  scheduled_letimer0_uf_cb();
+  TASK_WAIT_UNTIL(task, !leuart_tx_pending(), BLE_TX_DONE_CB, TASK_FOREVER);
+  app_hibernate();
+#else
   letimer_start(LETIMER0, true);
+#endif
+  TASK_END(task);
 }
 
+/***************************************************************************//**
+ * @brief
+ *  Boot step of the HM10 link, ready once the LEUART self test ble_open()
+ *  started has given it back
+ *
+ * @details
+ *  BLE_TEST_ENABLED renames the module on a cold boot, the delay only
+ *  holds up the link and not the other steps.
+ *
+ ******************************************************************************/
+
+static TASK_STATUS app_boot_link(TASK *task){
+  TASK_BEGIN(task);
+  TASK_WAIT_UNTIL(task, !leuart_test_busy(), 0, TASK_FOREVER);
+#ifdef BLE_TEST_ENABLED
+  if(!boot_warm()){
+      EFM_ASSERT(ble_test("Sam"));
+      TASK_DELAY(task, DELAY);
+  }
+#endif
+  TASK_END(task);
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Boot step of the SI1133, sleeps through its power on time and checks its
+ *  part ID on a cold boot
+ *
+ * @details
+ *  The sensor stays powered through EM4H, a warm boot only opens the I2C.
+ *  A read the sensor NACKs is tried again, up to SI1133_READ_TRIES reads.
+ *
+ ******************************************************************************/
+
+static TASK_STATUS app_boot_sensor(TASK *task){
+  static uint32_t tries;
+
+  TASK_BEGIN(task);
+  if(!boot_warm()){
+      TASK_DELAY(task, POR);
+  }
+  si1133_i2c_open();
+  if(!boot_warm()){
+      for(tries = 1; ; tries++){
+          si1133_read(BOOT_EVENT);
+          TASK_WAIT(task, BOOT_EVENT, BOOT_TIMEOUT);
+          if(TASK_TIMED_OUT(task) || !si1133_nacked() || (tries == SI1133_READ_TRIES)){
+              break;
+          }
+      }
+      EFM_ASSERT(!TASK_TIMED_OUT(task) && !si1133_nacked() && (si1133_pass_ID() == CHECK_VAL));
+  }
+  TASK_END(task);
+}
+
+#ifdef HIBERNATE_ENABLED
+/***************************************************************************//**
+ * @brief
+ *  Keeps the sample counters and hibernates until the next sample
+ *
+ ******************************************************************************/
+
+static void app_hibernate(void){
+  uint32_t state[APP_RETAINED_WORDS] = { x, y };
+
+  hibernate_save(state, sizeof(state));
+  hibernate_enter(HIBERNATE_PERIOD);
+}
+#endif
+
 /***************************************************************************//**
  * @brief
  *  Not currently in use
@@ -300,5 +448,270 @@ void scheduled_ble_tx_done_cb(void) {
 // Not in use
 }
 
+/***************************************************************************//**
+ * @brief
+ *  Handles a command frame from the BLE central
+ *
+ * @details
+ *  "#LAT!" answers with one line per scheduler event handled so far: its
+ *  count and min/p50/p90/p99/max pending time in core cycles.  "#PRF!"
+ *  answers with the CPU load and its top consumers since the last "#PRF!".
+ *  "#BOOT!" answers with the boot times, see boot_report().  "#LOG!"
+ *  sends the binary log as lines of hex, a task waits out each line so a
+ *  full ring does not hold up the main loop.  "#TRC!" does the same with
+ *  the event trace and "#REC!" with the input recording.  "#POOL!" sends a
+ *  line per size class of the buffer pool, see pool_report().  "#STK!" sends
+ *  the high-water mark of the main stack and, built with STACK_IRQ_ENABLED,
+ *  a line per interrupt handler that has run, see stack_irq_report().
+ *  "#CLK!" sends the clocks that are on and the drivers holding each, see
+ *  cmu_clock_report().
+ *  "#FX!" and "#FB!" turn the breathing effect and the status framebuffer
+ *  on or off, see app_led_owner().  A command that finds no pool block for
+ *  itself and its answer is dropped, the pool's failed count shows it.
+ *
+ ******************************************************************************/
+
+void scheduled_ble_rx_done_cb(void) {
+  char *command = pool_alloc(BLE_CMD_LEN);
+  char *line = pool_alloc(BLE_CMD_LEN);
+
+  if(!command || !line){
+      BINLOG0("command dropped, no pool block");
+      pool_free(line);
+      pool_free(command);
+      return;
+  }
+  ble_read(command, BLE_CMD_LEN);
+  if(strcmp(command, BLE_CMD_LATENCY) == 0){
+      for(uint32_t event = 0; event < EVENT_LATENCY_EVENTS; event++){
+          if(event_latency_report(event, line, BLE_CMD_LEN)){
+              ble_write(line);
+          }
+      }
+  } else if(strcmp(command, BLE_CMD_PROFILE) == 0){
+      profiler_report(line, BLE_CMD_LEN);
+      profiler_clear();
+      ble_write(line);
+  } else if(strcmp(command, BLE_CMD_BOOT) == 0){
+      boot_report(line, BLE_CMD_LEN);
+      ble_write(line);
+  } else if(strcmp(command, BLE_CMD_LOG) == 0){
+      if(!task_running(&log_task)){
+          task_start(&log_task, app_log_task);
+      }
+  } else if(strcmp(command, BLE_CMD_TRACE) == 0){
+      if(!task_running(&trace_task)){
+          task_start(&trace_task, app_trace_task);
+      }
+  } else if(strcmp(command, BLE_CMD_RECORD) == 0){
+      if(!task_running(&record_task)){
+          task_start(&record_task, app_record_task);
+      }
+  } else if(strcmp(command, BLE_CMD_POOL) == 0){
+      for(uint32_t pool_class = 0; pool_class < POOL_CLASSES; pool_class++){
+          pool_report(pool_class, line, BLE_CMD_LEN);
+          ble_write(line);
+      }
+  } else if(strcmp(command, BLE_CMD_EFFECT) == 0){
+      app_led_owner(RGB_PWM_OWNER_EFFECT);
+  } else if(strcmp(command, BLE_CMD_FRAMEBUFFER) == 0){
+      app_led_owner(RGB_PWM_OWNER_FB);
+  } else if(strcmp(command, BLE_CMD_CLOCK) == 0){
+      uint32_t next = 0;
+      while(cmu_clock_report(line, BLE_CMD_LEN, &next)){
+          ble_write(line);
+      }
+  } else if(strcmp(command, BLE_CMD_STACK) == 0){
+      stack_report(line, BLE_CMD_LEN);
+      ble_write(line);
+      for(uint32_t irqn = 0; irqn < EXT_IRQ_COUNT; irqn++){
+          if(stack_irq_report((IRQn_Type)irqn, line, BLE_CMD_LEN)){
+              ble_write(line);
+          }
+      }
+  } else {
+      BINLOG1("unknown command of %lu bytes", strlen(command));
+  }
+  pool_free(line);
+  pool_free(command);
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Sends the binary log records one line at a time until the ring is empty
+ *
+ * @details
+ *  The lines go out through the HM10 as text, binlog_dump on the host turns
+ *  them back into messages with the format strings in the ELF.  Records
+ *  logged while it sends go out in the same run.  With no pool block free
+ *  for a line it waits BLE_POOL_RETRY_MS and tries again.
+ *
+ ******************************************************************************/
+
+static TASK_STATUS app_log_task(TASK *task){
+  char *line;
+
+  TASK_BEGIN(task);
+  // leuart_start() keeps a copy of the line, its block is not held over the wait
+  for(;;){
+      line = pool_alloc(BLE_CMD_LEN);
+      if(!line){
+          TASK_DELAY(task, BLE_POOL_RETRY_MS);
+          continue;
+      }
+      if(!binlog_line(line, BLE_CMD_LEN)){
+          pool_free(line);
+          break;
+      }
+      ble_write(line);
+      pool_free(line);
+      TASK_WAIT_UNTIL(task, !leuart_tx_pending(), BLE_TX_DONE_CB, TASK_FOREVER);
+  }
+  TASK_END(task);
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Sends the event trace one line at a time and starts a new one
+ *
+ * @details
+ *  The trace stops first, so it ends at the "#TRC!" and the interrupts of
+ *  the lines going out are not in it.  trace_export on the host turns the
+ *  lines into a Chrome/Perfetto trace.  A line that finds no pool block is
+ *  tried again as in app_log_task().
+ *
+ ******************************************************************************/
 
+static TASK_STATUS app_trace_task(TASK *task){
+  char *line;
+
+  TASK_BEGIN(task);
+  trace_stop();
+  for(;;){
+      line = pool_alloc(BLE_CMD_LEN);
+      if(!line){
+          TASK_DELAY(task, BLE_POOL_RETRY_MS);
+          continue;
+      }
+      if(!trace_line(line, BLE_CMD_LEN)){
+          pool_free(line);
+          break;
+      }
+      ble_write(line);
+      pool_free(line);
+      TASK_WAIT_UNTIL(task, !leuart_tx_pending(), BLE_TX_DONE_CB, TASK_FOREVER);
+  }
+  trace_start();
+  TASK_END(task);
+}
 
+/***************************************************************************//**
+ * @brief
+ *  Sends the input recording so far one line at a time
+ *
+ * @details
+ *  The recording keeps going and is sent from its start every time, the
+ *  "#REC!" itself is in it.  firmware_sim -R replays the lines.  A line that
+ *  finds no pool block is tried again as in app_log_task().
+ *
+ ******************************************************************************/
+
+static TASK_STATUS app_record_task(TASK *task){
+  static uint32_t next;
+  char *line;
+
+  TASK_BEGIN(task);
+  next = 0;
+  for(;;){
+      line = pool_alloc(BLE_CMD_LEN);
+      if(!line){
+          TASK_DELAY(task, BLE_POOL_RETRY_MS);
+          continue;
+      }
+      if(!recorder_line(line, BLE_CMD_LEN, &next)){
+          pool_free(line);
+          break;
+      }
+      ble_write(line);
+      pool_free(line);
+      TASK_WAIT_UNTIL(task, !leuart_tx_pending(), BLE_TX_DONE_CB, TASK_FOREVER);
+  }
+  TASK_END(task);
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Shows the light status on whichever driver owns the RGB LEDs
+ *
+ * @details
+ *  The PWM color of RGB LED_1 by default.  With the framebuffer running
+ *  STATUS_FB_LIGHT shows it and STATUS_FB_BAND the HF band, green, yellow
+ *  or red from 7 to 26 MHz.  A running effect is left alone, it shows
+ *  until "#FX!" turns it off.
+ *
+ * @param[in] dark
+ *  true below SENSE_VAL
+ *
+ ******************************************************************************/
+
+static void app_status_led(bool dark){
+  static const uint8_t band_color[CMU_HF_LEVELS][RGB_PWM_CHANNELS] = {
+    { 0, STATUS_LED_LEVEL, 0 },
+    { STATUS_LED_LEVEL, STATUS_LED_LEVEL, 0 },
+    { STATUS_LED_LEVEL, 0, 0 },
+  };
+  const uint8_t *band;
+
+  switch(rgb_pwm_owner()){
+    case RGB_PWM_OWNER_EFFECT:
+      break;
+    case RGB_PWM_OWNER_FB:
+      band = band_color[cmu_hf_level()];
+      led_fb_set(STATUS_FB_LIGHT, 0, 0, dark ? STATUS_LED_LEVEL : 0);
+      led_fb_set(STATUS_FB_BAND, band[RGB_RED_CH], band[RGB_GREEN_CH], band[RGB_BLUE_CH]);
+      led_fb_commit();
+      break;
+    default:
+      if(dark){
+          rgb_pwm_set(RGB_LED_1, 0, 0, STATUS_LED_LEVEL);
+      } else {
+          rgb_pwm_off();
+      }
+      break;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Hands the RGB LEDs to the effect or the framebuffer, or takes them back
+ *
+ * @details
+ *  The driver owning the PWM TIMER lets go of it first, rgb_pwm_stream()
+ *  asserts on two at once.  Asking for the owner that already has it turns
+ *  it off, the status color comes back with the next light reading.
+ *
+ * @param[in] owner
+ *  RGB_PWM_OWNER_EFFECT or RGB_PWM_OWNER_FB
+ *
+ ******************************************************************************/
+
+static void app_led_owner(uint32_t owner){
+  uint32_t current = rgb_pwm_owner();
+
+  if(current == RGB_PWM_OWNER_COLOR){
+      rgb_pwm_off();
+  } else if(current == RGB_PWM_OWNER_EFFECT){
+      led_effect_stop();
+  } else if(current == RGB_PWM_OWNER_FB){
+      led_fb_stop();
+  }
+  if(current == owner){
+      return;
+  }
+  if(owner == RGB_PWM_OWNER_EFFECT){
+      led_effect_start(RGB_ALL_LEDS, LED_EFFECT_BREATHE, STATUS_EFFECT_MS, 0, 0, STATUS_LED_LEVEL);
+  } else {
+      led_fb_fill(0, 0, 0);
+      led_fb_start();
+  }
+}
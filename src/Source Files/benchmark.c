@@ -0,0 +1,298 @@
+/**
+ * @file benchmark.c
+ * @author Shambaditya Tarafder
+ * @date   12/8/2021
+ * @brief  Microbenchmarks of the scheduler, the LEUART and I2C state machines
+ *         and the text the app formats, run on the board from the boot up
+ *         callback and on the host by the simulation's bench target
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <string.h>
+#include "benchmark.h"
+#include "em_core.h"
+#include "app.h"
+#include "sleep_routines.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define BENCHMARK_SCHED_OPS   1000
+#define BENCHMARK_FMT_OPS     100
+#define BENCHMARK_BUS_OPS     4
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static void benchmark_sched_post(uint32_t ops);
+static void benchmark_leuart_tx(uint32_t ops);
+static void benchmark_leuart_loop(uint32_t ops);
+static void benchmark_i2c_read(uint32_t ops);
+static void benchmark_fmt_sample(uint32_t ops);
+static void benchmark_log_sample(uint32_t ops);
+static void benchmark_fmt_profile(uint32_t ops);
+
+static const BENCHMARK_KERNEL kernels[] = {
+  { "sched_post",   benchmark_sched_post,   BENCHMARK_SCHED_OPS, BENCHMARK_NO_IRQ },
+  { "leuart_tx",    benchmark_leuart_tx,    BENCHMARK_BUS_OPS,   LEUART0_IRQn },
+  { "leuart_loop",  benchmark_leuart_loop,  BENCHMARK_BUS_OPS,   LEUART0_IRQn },
+  { "i2c_read",     benchmark_i2c_read,     BENCHMARK_BUS_OPS,   I2C1_IRQn },
+  { "fmt_sample",   benchmark_fmt_sample,   BENCHMARK_FMT_OPS,   BENCHMARK_NO_IRQ },
+  { "log_sample",   benchmark_log_sample,   BENCHMARK_FMT_OPS,   BENCHMARK_NO_IRQ },
+  { "fmt_profile",  benchmark_fmt_profile,  BENCHMARK_FMT_OPS,   BENCHMARK_NO_IRQ },
+};
+
+static bool i2c_opened;
+static volatile uint32_t sink;      // Keeps the formatting kernels from being optimized away
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static uint64_t benchmark_irq_cycles(int32_t irqn);
+static void benchmark_leuart_start(char *frame);
+static void benchmark_wait(uint32_t events);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Runs every kernel and hands one CSV line per kernel to out
+ *
+ * @details
+ *   "BENCH,<name>,<ops>,<cycles>,<irq_cycles>,<host_ns>" per operation,
+ *   after a header line of the same shape.  Cycles are DWT core cycles,
+ *   which stop while the core sleeps, so for the bus kernels they are the
+ *   CPU cost of an operation and not its latency.  irq_cycles is the part
+ *   spent in the kernel's interrupt handler as charged by the profiler, 0
+ *   without PROFILER_ENABLED.  host_ns is the wall clock time from ns, 0 on
+ *   the board.  Each kernel runs BENCHMARK_REPEATS times and the fastest run
+ *   is reported, which keeps unrelated interrupts out of the numbers.  The
+ *   whole run is one cmu_hf_burst_begin() so every kernel sees the same band.
+ *
+ *   The LEUART kernels need ble_open() done, the app's setup does it.
+ *   Meant to run before letimer_start() so that the app's own traffic does
+ *   not share the link.
+ *
+ * @param[in] out
+ *   Takes each result line, ble_write() on the board.  A line it drops for
+ *   want of a pool block is lost, pool_report() counts it.
+ *
+ * @param[in] ns
+ *   Wall clock of the host, NULL on the board
+ *
+ ******************************************************************************/
+
+void benchmark_run(BENCHMARK_OUT_FN out, BENCHMARK_NS_FN ns){
+  char line[BENCHMARK_LINE_SIZE];
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  cmu_hf_burst_begin();
+
+  snprintf(line, sizeof(line), "BENCH,name,ops,cycles,irq_cycles,host_ns\n");
+  out(line);
+  for(uint32_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++){
+      const BENCHMARK_KERNEL *kernel = &kernels[i];
+      uint32_t best = UINT32_MAX;
+      uint64_t best_irq = 0;
+      uint64_t best_ns = UINT64_MAX;
+
+      for(uint32_t repeat = 0; repeat < BENCHMARK_REPEATS; repeat++){
+          uint64_t irq_start = benchmark_irq_cycles(kernel->irqn);
+          uint64_t ns_start = ns ? ns() : 0;
+          uint32_t start = DWT->CYCCNT;
+          uint32_t cycles;
+          uint64_t elapsed;
+
+          kernel->run(kernel->ops);
+          cycles = DWT->CYCCNT - start;
+          elapsed = ns ? ns() - ns_start : 0;
+          if(cycles < best){
+              best = cycles;
+              best_irq = benchmark_irq_cycles(kernel->irqn) - irq_start;
+          }
+          if(elapsed < best_ns){
+              best_ns = elapsed;
+          }
+      }
+      snprintf(line, sizeof(line), "BENCH,%s,%lu,%lu,%lu,%lu\n", kernel->name,
+               (unsigned long)kernel->ops, (unsigned long)(best / kernel->ops),
+               (unsigned long)(best_irq / kernel->ops), (unsigned long)(best_ns / kernel->ops));
+      out(line);
+  }
+  cmu_hf_burst_end();
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Cycles the profiler has charged to a handler so far
+ *
+ ******************************************************************************/
+
+static uint64_t benchmark_irq_cycles(int32_t irqn){
+#ifdef PROFILER_ENABLED
+  if(irqn != BENCHMARK_NO_IRQ){
+      return profiler_cycles(PROFILER_IRQ(irqn));
+  }
+#else
+  (void)irqn;
+#endif
+  return 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Starts a frame on the HM10 link with its done events cleared
+ *
+ * @details
+ *   leuart_start() returns once the string before it is done, which may
+ *   have been one of the app's, so its BLE_TX_DONE_CB is dropped here
+ *   rather than mistaken for the frame's.
+ *
+ ******************************************************************************/
+
+static void benchmark_leuart_start(char *frame){
+  leuart_start(HM10_LEUART0, frame, strlen(frame));
+  remove_scheduled_event(BLE_TX_DONE_CB | BLE_RX_DONE_CB);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sleeps until every one of events is pending, then takes them
+ *
+ * @details
+ *   Stands in for the main loop, which is not running while the kernels
+ *   are, so the events never reach their callbacks.
+ *
+ ******************************************************************************/
+
+static void benchmark_wait(uint32_t events){
+  while((get_scheduled_events() & events) != events){
+      enter_sleep();
+  }
+  remove_scheduled_event(events);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   An event posted and taken, what every interrupt and the main loop pay
+ *
+ ******************************************************************************/
+
+static void benchmark_sched_post(uint32_t ops){
+  for(uint32_t i = 0; i < ops; i++){
+      add_scheduled_event(BENCHMARK_EVENT);
+      remove_scheduled_event(BENCHMARK_EVENT);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   One frame through the transmit state machine to the HM10
+ *
+ ******************************************************************************/
+
+static void benchmark_leuart_tx(uint32_t ops){
+  char frame[] = BENCHMARK_FRAME;
+
+  for(uint32_t i = 0; i < ops; i++){
+      benchmark_leuart_start(frame);
+      benchmark_wait(BLE_TX_DONE_CB);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   One frame looped back through the transmit and receive state machines
+ *
+ * @details
+ *   The receive cost is the difference to leuart_tx.  The frame goes from
+ *   START_FRAME to SIG_FRAME so the receiver takes all of it.  leuart_start()
+ *   waits for the LOOPBK write to land before the first frame.
+ *
+ ******************************************************************************/
+
+static void benchmark_leuart_loop(uint32_t ops){
+  char frame[] = BENCHMARK_FRAME;
+
+  leuart_ctrl_write(HM10_LEUART0, LEUART_CTRL_LOOPBK, 0);
+  for(uint32_t i = 0; i < ops; i++){
+      benchmark_leuart_start(frame);
+      benchmark_wait(BLE_TX_DONE_CB | BLE_RX_DONE_CB);
+  }
+  leuart_ctrl_write(HM10_LEUART0, 0, LEUART_CTRL_LOOPBK);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   One register read of the SI1133 through the I2C state machine
+ *
+ ******************************************************************************/
+
+static void benchmark_i2c_read(uint32_t ops){
+  if(!i2c_opened){
+      si1133_i2c_open();
+      i2c_opened = true;
+  }
+  for(uint32_t i = 0; i < ops; i++){
+      si1133_read(BENCHMARK_EVENT);
+      benchmark_wait(BENCHMARK_EVENT);
+  }
+  sink = si1133_pass_ID();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The sample line scheduled_letimer0_uf_cb() sends
+ *
+ ******************************************************************************/
+
+static void benchmark_fmt_sample(uint32_t ops){
+  char send[CHAR_SEND];
+
+  for(uint32_t i = 0; i < ops; i++){
+      sprintf(send, "z = %1.1f \n", (float)(i + ADD_THREE) / (i + ADD_ONE));
+      sink = send[4];
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The same sample as a binary log record, against fmt_sample
+ *
+ * @details
+ *   Judged on cycles on the board.  On the host the RTCC read brings the
+ *   simulation up to date and costs more than the record itself.
+ *
+ ******************************************************************************/
+
+static void benchmark_log_sample(uint32_t ops){
+  for(uint32_t i = 0; i < ops; i++){
+      BINLOG3("sample x=%lu y=%lu z=%.2f", i + ADD_THREE, i + ADD_ONE,
+              (float)(i + ADD_THREE) / (i + ADD_ONE));
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The "#PRF!" answer
+ *
+ ******************************************************************************/
+
+static void benchmark_fmt_profile(uint32_t ops){
+  char line[BENCHMARK_LINE_SIZE];
+
+  for(uint32_t i = 0; i < ops; i++){
+      sink = profiler_report(line, sizeof(line));
+  }
+}
@@ -0,0 +1,153 @@
+/**
+ * @file binlog.c
+ * @author Shambaditya Tarafder
+ * @date   12/9/2021
+ * @brief  Deferred binary logging.  A call site stores the ID of its format
+ *         string and its raw arguments in a RAM ring, the text is only made
+ *         on the host, from the format strings in the ELF.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "binlog.h"
+#include "em_core.h"
+#include "em_rtcc.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define BINLOG_ID_SHIFT     16
+#define BINLOG_COUNT_SHIFT  12
+#define BINLOG_COUNT_MASK   0xF
+#define BINLOG_HEX_DIGITS   8
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint32_t ring[BINLOG_WORDS];
+static uint32_t head;               // Next word written
+static uint32_t tail;               // First word of the oldest record
+static uint32_t used;               // Words in the ring
+static uint32_t seq;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static uint32_t binlog_record_words(uint32_t header);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Stores one record, called through BINLOG0() to BINLOG4()
+ *
+ * @details
+ *   A record is a header word, the RTCC count and the arguments.  The header
+ *   holds the ID in its top 16 bits, the argument count in bits 15:12 and a
+ *   sequence number in 11:0 that shows the host where records were lost.
+ *   A full ring drops its oldest records, the newest are the ones that
+ *   matter after a fault.  Safe from interrupt handlers, the whole cost is
+ *   the copy of a few words with interrupts off.
+ *
+ * @param[in] id
+ *   Offset of the format string in the binlog section, BINLOG_ID()
+ *
+ * @param[in] count
+ *   Arguments that follow, up to BINLOG_ARGS_MAX
+ *
+ ******************************************************************************/
+
+void binlog_write(uint32_t id, uint32_t count, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3){
+  uint32_t args[BINLOG_ARGS_MAX] = { a0, a1, a2, a3 };
+  uint32_t words = BINLOG_HEADER + count;
+  uint32_t stamp = RTCC_CounterGet();
+
+  EFM_ASSERT((count <= BINLOG_ARGS_MAX) && (id < (1UL << (32 - BINLOG_ID_SHIFT))));
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  while(BINLOG_WORDS - used < words){
+      uint32_t oldest = binlog_record_words(ring[tail]);
+      tail = (tail + oldest) % BINLOG_WORDS;
+      used -= oldest;
+  }
+  ring[head] = (id << BINLOG_ID_SHIFT) | (count << BINLOG_COUNT_SHIFT) | (seq & BINLOG_SEQ_MASK);
+  head = (head + 1) % BINLOG_WORDS;
+  ring[head] = stamp;
+  head = (head + 1) % BINLOG_WORDS;
+  for(uint32_t i = 0; i < count; i++){
+      ring[head] = args[i];
+      head = (head + 1) % BINLOG_WORDS;
+  }
+  used += words;
+  seq++;
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes the oldest records out of the ring as one line of text
+ *
+ * @details
+ *   "L<hex>\n", every word of as many whole records as fit as 8 hex digits,
+ *   most significant first.  Text, so the line can go through ble_write(),
+ *   a record of one argument is 24 digits.
+ *
+ * @param[out] line
+ *   Destination, NULL terminated
+ *
+ * @param[in] size
+ *   Size of line, at least one record of BINLOG_ARGS_MAX arguments
+ *
+ * @return
+ *   false, and line untouched, if the ring is empty
+ *
+ ******************************************************************************/
+
+bool binlog_line(char *line, uint32_t size){
+  static const char hex[] = "0123456789abcdef";
+  uint32_t len = 0;
+
+  EFM_ASSERT(size >= (BINLOG_HEADER + BINLOG_ARGS_MAX) * BINLOG_HEX_DIGITS + 3);
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if(!used){
+      CORE_EXIT_CRITICAL();
+      return false;
+  }
+  line[len++] = BINLOG_LINE_MARK;
+  while(used){
+      uint32_t words = binlog_record_words(ring[tail]);
+      if(len + words * BINLOG_HEX_DIGITS + 2 > size){
+          break;
+      }
+      for(uint32_t i = 0; i < words; i++){
+          for(int32_t shift = 28; shift >= 0; shift -= 4){
+              line[len++] = hex[(ring[tail] >> shift) & 0xF];
+          }
+          tail = (tail + 1) % BINLOG_WORDS;
+      }
+      used -= words;
+  }
+  CORE_EXIT_CRITICAL();
+  line[len++] = '\n';
+  line[len] = '\0';
+  return true;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Length in words of the record a header starts
+ *
+ ******************************************************************************/
+
+static uint32_t binlog_record_words(uint32_t header){
+  return BINLOG_HEADER + ((header >> BINLOG_COUNT_SHIFT) & BINLOG_COUNT_MASK);
+}
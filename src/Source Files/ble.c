@@ -17,11 +17,33 @@
 //***********************************************************************************
 // defined files
 //***********************************************************************************
+// The rates of AT+BAUD the LEUART also runs at on the LFXO
+#define HM10_BAUD_VALID(baud)   (((baud) == 1200) || ((baud) == 2400) || ((baud) == 4800) || ((baud) == 9600))
+
+_Static_assert(LEUART_BAUD_VALID(HM10_BAUDRATE), "HM10_BAUDRATE is out of the LEUART's range on the LFXO");
+_Static_assert(HM10_BAUD_VALID(HM10_BAUDRATE), "HM10_BAUDRATE is not a rate the HM-10 takes");
 
 
 //***********************************************************************************
 // private variables
 //***********************************************************************************
+// LEUART0 to the HM-10, both directions on the board's pins
+static const LEUART_OPEN_STRUCT hm10_leuart = {
+  .init = {
+    .enable = HM10_ENABLE,
+    .refFreq = HM10_REFFREQ,
+    .baudrate = HM10_BAUDRATE,
+    .databits = HM10_DATABITS,
+    .parity = HM10_PARITY,
+    .stopbits = HM10_STOPBITS,
+  },
+  .startframe = START_FRAME,
+  .sigframe = SIG_FRAME,
+  .routeloc0 = LEUART0_RX_ROUTE | LEUART0_TX_ROUTE,
+  .routepen = LEUART_ROUTEPEN_RXPEN | LEUART_ROUTEPEN_TXPEN,
+  .rx_en = true,
+  .tx_en = true,
+};
 
 /***************************************************************************//**
  * @brief BLE module
@@ -43,11 +65,12 @@
  *   This function initiates the DSD-HM-10 module
  *
  * @details
- *   This STRUCT contains the information to complete the set-up of the leuart external devices.
+ *   The const hm10_leuart table contains the information to complete the
+ *   set-up of the leuart external devices.
  *
  *
  * @note
- *   Setting up the struct only and then calling leuart_open
+ *   Only the events and the self test are given at run time
  *
  * @param[in] tx_event
  *   this is for the TX event callback
@@ -55,32 +78,14 @@
  * @param[in] rx_event
  *   this is for the RX event callback
  *
+ * @param[in] self_test
+ *   Runs the LEUART loopback test, a warm boot skips it
+ *
  ******************************************************************************/
 
-void ble_open(uint32_t tx_event, uint32_t rx_event){
-
-  LEUART_OPEN_STRUCT leuart_Struct;
-
-    leuart_Struct.baudrate = HM10_BAUDRATE;
-    leuart_Struct.databits = HM10_DATABITS;
-    leuart_Struct.enable = HM10_ENABLE;
-    leuart_Struct.parity = HM10_PARITY;
-    leuart_Struct.rx_done_evt = rx_event;
-    leuart_Struct.rx_en = true;
-    leuart_Struct.rx_loc = LEUART0_RX_ROUTE;
-    leuart_Struct.rx_pin_en = LEUART_ROUTEPEN_RXPEN;
-    leuart_Struct.stopbits = HM10_STOPBITS;
-    leuart_Struct.tx_done_evt = tx_event;
-    leuart_Struct.tx_en = true;
-    leuart_Struct.tx_loc = LEUART0_TX_ROUTE;
-    leuart_Struct.tx_pin_en = LEUART_ROUTEPEN_TXPEN;
-    leuart_Struct.startframe = START_FRAME;
-    leuart_Struct.sigframe = SIG_FRAME;
-    leuart_Struct.sigframe_en = true;
-    leuart_Struct.startframe_en = true;
-    leuart_Struct.sfubrx = true;
-    leuart_Struct.rxblocken = true;
-    leuart_open(HM10_LEUART0, &leuart_Struct);
+void ble_open(uint32_t tx_event, uint32_t rx_event, bool self_test){
+
+  leuart_open(HM10_LEUART0, &hm10_leuart, tx_event, rx_event, self_test);
 
 }
 
@@ -97,11 +102,30 @@ void ble_open(uint32_t tx_event, uint32_t rx_event){
  * @note
  *   The string to be sent to the bluetooth module
  *
+ * @return
+ *   false if the string was dropped, see leuart_start()
+ *
  ******************************************************************************/
 
-void ble_write(char* string){
+bool ble_write(char* string){
 
-  leuart_start(HM10_LEUART0, string, strlen(string));
+  return leuart_start(HM10_LEUART0, string, strlen(string));
+
+}
+
+/***************************************************************************//**
+ * @brief
+ *   This function is for reading what the HM-10 module last received
+ *
+ * @details
+ *   Returns the last "#...!" frame sent by the central, to be called when
+ *   the rx_event given to ble_open() is scheduled
+ *
+ ******************************************************************************/
+
+void ble_read(char *string, uint32_t size){
+
+  leuart_rx_copy(string, size);
 
 }
 
@@ -170,8 +194,10 @@ bool ble_test(char *mod_name){
 	// Replace the test_str "" with the command to break or end a BLE connection
 	// Replace the ok_str "" with the result that will be returned from the BLE
 	//   module if there was no BLE connection
-	char		test_str[80] = "AT";
-	char		ok_str[80] = "OK";
+	// The commands and responses that are not built up are constants in flash,
+	// the rest are blocks of the pool
+	const char	*test_str = "AT";
+	const char	*ok_str = "OK";
 
 
 	// output_str will be the string that will program a name to the BLE module.
@@ -184,8 +210,8 @@ bool ble_test(char *mod_name){
 	// The HM-10 datasheet has an error. This response starts with "OK+Set:"
 	//  the backend of the expected response will be concatenated with the
 	//  input argument
-	char		output_str[80] = "AT+NAME";
-	char		result_str[80] = "OK+Set:";
+	const char	*output_cmd = "AT+NAME";
+	const char	*result_cmd = "OK+Set:";
 
 
 	// To program the name into your module, you must reset the module after you
@@ -194,9 +220,11 @@ bool ble_test(char *mod_name){
 	// Replace the reset_str "" with the command to reset the module
 	// Replace the reset_result_str "" with the expected BLE module response to
 	//  to the reset command
-	char		reset_str[80] = "AT+RESET";
-	char		reset_result_str[80] = "OK+RESET";
-	char		return_str[80];
+	const char	*reset_str = "AT+RESET";
+	const char	*reset_result_str = "OK+RESET";
+	char		*output_str = pool_alloc(CHAR_SIZE);
+	char		*result_str = pool_alloc(CHAR_SIZE);
+	char		*return_str = pool_alloc(CHAR_SIZE);
 
 	bool		success;
 	bool		rx_disabled, rx_en, tx_en;
@@ -205,6 +233,10 @@ bool ble_test(char *mod_name){
 	// These are the routines that will build up the entire command and response
 	// of programming the name into the BLE module.  Concatenating the command or
 	// response with the input argument name
+	EFM_ASSERT(output_str && result_str && return_str);
+	EFM_ASSERT(strlen(result_cmd) + strlen(mod_name) < CHAR_SIZE);
+	strcpy(output_str, output_cmd);
+	strcpy(result_str, result_cmd);
 	strcat(output_str, mod_name);
 	strcat(result_str, mod_name);
 
@@ -215,6 +247,8 @@ bool ble_test(char *mod_name){
 	// re-instate the LEUART configuration
 
 	status = leuart_status(HM10_LEUART0);
+	// The commands below reach the LEUART in one synchronization
+	leuart_freeze(HM10_LEUART0);
 	if (status & LEUART_STATUS_RXBLOCK) {
 		rx_disabled = true;
 		// Enabling, unblocking, the receiving of data from the LEUART RX port
@@ -227,9 +261,6 @@ bool ble_test(char *mod_name){
 		rx_en = false;
 		// Enabling the receiving of data from the RX port
 		leuart_cmd_write(HM10_LEUART0, LEUART_CMD_RXEN);
-	// Why could you be stuck in the below while loop after a write to CMD register?
-	// Answer: Not sure but maybe because it insn't configured properly
-		while (!(leuart_status(HM10_LEUART0) & LEUART_STATUS_RXENS));
 	}
 
 	if (status & LEUART_STATUS_TXENS){
@@ -237,9 +268,14 @@ bool ble_test(char *mod_name){
 	} else {
 		// Enabling the transmission of data to the TX port
 		leuart_cmd_write(HM10_LEUART0, LEUART_CMD_TXEN);
-		while (!(leuart_status(HM10_LEUART0) & LEUART_STATUS_TXENS));
 		tx_en = false;
 	}
+	leuart_commit(HM10_LEUART0);
+	// Why could you be stuck in the below while loop after a write to CMD register?
+	// Answer: STATUS only follows once the batch has been synchronized, and
+	// never if the LEUART's clock is off
+	if (!rx_en) while (!(leuart_status(HM10_LEUART0) & LEUART_STATUS_RXENS));
+	if (!tx_en) while (!(leuart_status(HM10_LEUART0) & LEUART_STATUS_TXENS));
 //	leuart_cmd_write(HM10_LEUART0, (LEUART_CMD_CLEARRX | LEUART_CMD_CLEARTX));
 
 	// This sequence of instructions is sending the break ble connection
@@ -299,14 +335,18 @@ bool ble_test(char *mod_name){
 
 	// After the test and programming have been completed, the original
 	// state of the LEUART must be restored
+	leuart_freeze(HM10_LEUART0);
 	if (!rx_en) leuart_cmd_write(HM10_LEUART0, LEUART_CMD_RXDIS);
 	if (rx_disabled) leuart_cmd_write(HM10_LEUART0, LEUART_CMD_RXBLOCKEN);
 	if (!tx_en) leuart_cmd_write(HM10_LEUART0, LEUART_CMD_TXDIS);
+	leuart_commit(HM10_LEUART0);
 	leuart_if_reset(HM10_LEUART0);
 
 	success = true;
 
-
+	pool_free(return_str);
+	pool_free(result_str);
+	pool_free(output_str);
 	CORE_EXIT_CRITICAL();
 	return success;
 }
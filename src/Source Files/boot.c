@@ -0,0 +1,217 @@
+/**
+ * @file boot.c
+ * @author Shambaditya Tarafder
+ * @date   12/9/2021
+ * @brief  Boot sequencer.  Brings the peripherals up as concurrent tasks that
+ *         sleep on their readiness conditions, and times the boot from the
+ *         start of the setup to the app being ready and to its first sample.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include "boot.h"
+#include "em_rtcc.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static TASK             sequencer;
+static TASK             step_tasks[BOOT_STEPS_MAX];
+static const BOOT_STEP  *boot_steps;
+static uint32_t         step_count;
+static bool             warm_boot;
+static uint32_t         start_tick;
+static uint32_t         ready_ms;
+static uint32_t         sample_ms;
+static uint32_t         step_ms[BOOT_STEPS_MAX];
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static TASK_STATUS boot_sequencer(TASK *task);
+static bool boot_steps_check(void);
+static uint32_t boot_elapsed_ms(void);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Starts the boot clock
+ *
+ * @details
+ *   Times are RTCC ticks at TASK_RTCC_HZ, the clock the tasks run on.  What
+ *   main() does before the setup, the clock tree and the DC-DC, is a few
+ *   register writes and is left out.
+ *
+ * @param[in] warm
+ *   An EM4H wake-up, the steps may skip their self tests
+ *
+ * @note
+ *   After task_open(), which starts the RTCC
+ *
+ ******************************************************************************/
+
+void boot_open(bool warm){
+  warm_boot = warm;
+  start_tick = RTCC_CounterGet();
+  ready_ms = BOOT_NOT_YET;
+  sample_ms = BOOT_NOT_YET;
+  for(uint32_t i = 0; i < BOOT_STEPS_MAX; i++){
+      step_ms[i] = BOOT_NOT_YET;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Starts every step at once, each runs up to its first wait
+ *
+ * @details
+ *   The steps overlap their waits, a power on delay runs while a loopback
+ *   test sleeps.  boot_busy() stays true until the last one has ended.
+ *
+ * @param[in] steps
+ *   Static table of the steps, at most BOOT_STEPS_MAX
+ *
+ ******************************************************************************/
+
+void boot_start(const BOOT_STEP *steps, uint32_t count){
+  EFM_ASSERT(count <= BOOT_STEPS_MAX);
+  boot_steps = steps;
+  step_count = count;
+  task_start(&sequencer, boot_sequencer);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Whether a step is still bringing its peripheral up
+ *
+ ******************************************************************************/
+
+bool boot_busy(void){
+  return task_running(&sequencer);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Whether this boot is an EM4H wake-up, as given to boot_open()
+ *
+ ******************************************************************************/
+
+bool boot_warm(void){
+  return warm_boot;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Marks the app's first sample, later calls are ignored
+ *
+ ******************************************************************************/
+
+void boot_sample(void){
+  if(sample_ms == BOOT_NOT_YET){
+      sample_ms = boot_elapsed_ms();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   ms from boot_open() to the last step ending, BOOT_NOT_YET before that
+ *
+ ******************************************************************************/
+
+uint32_t boot_ready_ms(void){
+  return ready_ms;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   ms from boot_open() to the first sample, BOOT_NOT_YET before that
+ *
+ ******************************************************************************/
+
+uint32_t boot_sample_ms(void){
+  return sample_ms;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Formats the boot times as one line for the BLE link
+ *
+ * @details
+ *   "BOOT <cold|warm> <ready> <first sample> <step> <done> ..." in ms, a
+ *   time not reached yet is -1.
+ *
+ ******************************************************************************/
+
+void boot_report(char *report, uint32_t size){
+  uint32_t len;
+
+  EFM_ASSERT(size > 0);
+  len = snprintf(report, size, "BOOT %s %ld %ld", warm_boot ? "warm" : "cold",
+                 (long)(int32_t)ready_ms, (long)(int32_t)sample_ms);
+  for(uint32_t i = 0; (i < step_count) && (len < size); i++){
+      len += snprintf(&report[len], size - len, " %s %ld", boot_steps[i].name, (long)(int32_t)step_ms[i]);
+  }
+  if(len < size){
+      snprintf(&report[len], size - len, "\n");
+  }
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Starts the steps and notes the time once they have all ended
+ *
+ * @details
+ *   Each step ending posts TASK_EVENT, which is what the wait checks on.
+ *
+ ******************************************************************************/
+
+static TASK_STATUS boot_sequencer(TASK *task){
+  TASK_BEGIN(task);
+  for(uint32_t i = 0; i < step_count; i++){
+      task_start(&step_tasks[i], boot_steps[i].fn);
+  }
+  TASK_WAIT_UNTIL(task, boot_steps_check(), 0, TASK_FOREVER);
+  ready_ms = boot_elapsed_ms();
+  TASK_END(task);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Notes the time of the steps that have ended since the last check
+ *
+ * @return
+ *   true once all of them have
+ *
+ ******************************************************************************/
+
+static bool boot_steps_check(void){
+  bool done = true;
+
+  for(uint32_t i = 0; i < step_count; i++){
+      if(task_running(&step_tasks[i])){
+          done = false;
+      } else if(step_ms[i] == BOOT_NOT_YET){
+          step_ms[i] = boot_elapsed_ms();
+      }
+  }
+  return done;
+}
+
+static uint32_t boot_elapsed_ms(void){
+  return (uint32_t)(((uint64_t)(RTCC_CounterGet() - start_tick) * 1000) / TASK_RTCC_HZ);
+}
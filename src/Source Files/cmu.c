@@ -2,28 +2,109 @@
  * @file cmu.c
  * @author Shambaditya Tarafder
  * @date 9/23/2021
- * @brief This file is responsible for enabling all the oscillators and clock
- *        tree.
+ * @brief This file is responsible for the oscillators and clock tree.  Clocks
+ *        are reference counted, drivers request and release them and every
+ *        branch and oscillator is gated off once nothing holds it.
  */
 //***********************************************************************************
 // Include files
 //***********************************************************************************
+#include <stdio.h>
 #include "cmu.h"
+#include "trace.h"
 
 //***********************************************************************************
 // defined files
 //***********************************************************************************
-
+#define NODE(n)     (0x01 << (n))
 
 //***********************************************************************************
 // Private variables
 //***********************************************************************************
 
+typedef enum {
+  CLK_LFXO,
+  CLK_LFRCO,
+  CLK_HFPER,
+  CLK_CORELE,
+  CLK_GPIO,
+  CLK_LDMA,
+  CLK_TIMER0,
+  CLK_TIMER1,
+  CLK_WTIMER0,
+  CLK_I2C0,
+  CLK_I2C1,
+  CLK_LETIMER0,
+  CLK_LEUART0,
+  CLK_RTCC,
+  CLK_NODES
+} CMU_NODE;
+
+typedef struct {
+  const char          *name;
+  bool                is_osc;         // true = oscillator, false = clock gate
+  CMU_Osc_TypeDef     osc;
+  CMU_Clock_TypeDef   clock;
+  uint32_t            depends;        // NODE() mask of the clocks feeding this one
+  bool                select_en;      // select an LF branch source before enabling
+  CMU_Clock_TypeDef   branch;
+  CMU_Select_TypeDef  select;
+} CMU_NODE_STRUCT;
+
+static const CMU_NODE_STRUCT clock_tree[CLK_NODES] = {
+  [CLK_LFXO]     = { "LFXO",     true,  cmuOsc_LFXO,  0,                  0,                              false, 0,            0 },
+  [CLK_LFRCO]    = { "LFRCO",    true,  cmuOsc_LFRCO, 0,                  0,                              false, 0,            0 },
+  [CLK_HFPER]    = { "HFPER",    false, 0,            cmuClock_HFPER,     0,                              false, 0,            0 },
+  [CLK_CORELE]   = { "CORELE",   false, 0,            cmuClock_CORELE,    0,                              false, 0,            0 },
+  [CLK_GPIO]     = { "GPIO",     false, 0,            cmuClock_GPIO,      0,                              false, 0,            0 },
+  [CLK_LDMA]     = { "LDMA",     false, 0,            cmuClock_LDMA,      0,                              false, 0,            0 },
+  [CLK_TIMER0]   = { "TIMER0",   false, 0,            cmuClock_TIMER0,    NODE(CLK_HFPER),                false, 0,            0 },
+  [CLK_TIMER1]   = { "TIMER1",   false, 0,            cmuClock_TIMER1,    NODE(CLK_HFPER),                false, 0,            0 },
+  [CLK_WTIMER0]  = { "WTIMER0",  false, 0,            cmuClock_WTIMER0,   NODE(CLK_HFPER),                false, 0,            0 },
+  [CLK_I2C0]     = { "I2C0",     false, 0,            cmuClock_I2C0,      NODE(CLK_HFPER),                false, 0,            0 },
+  [CLK_I2C1]     = { "I2C1",     false, 0,            cmuClock_I2C1,      NODE(CLK_HFPER),                false, 0,            0 },
+  // ULFRCO is always on in EM0 to EM4H, LFA only needs to be routed to it
+  [CLK_LETIMER0] = { "LETIMER0", false, 0,            cmuClock_LETIMER0,  NODE(CLK_CORELE),               true,  cmuClock_LFA, cmuSelect_ULFRCO },
+  [CLK_LEUART0]  = { "LEUART0",  false, 0,            cmuClock_LEUART0,   NODE(CLK_CORELE) | NODE(CLK_LFXO), true,  cmuClock_LFB, cmuSelect_LFXO },
+  [CLK_RTCC]     = { "RTCC",     false, 0,            cmuClock_RTCC,      NODE(CLK_CORELE),               true,  cmuClock_LFE, cmuSelect_ULFRCO },
+};
+
+static uint32_t clock_count[CLK_NODES];
+static uint32_t clock_holders[CLK_NODES];
+// Holds of each owner, directly or through a child clock.  Its bit in
+// clock_holders stays set until the last one is released
+static uint8_t  owner_count[CLK_NODES][CMU_OWNERS];
+
+typedef struct {
+  CMU_HFRCOFreq_TypeDef   band;
+  EMU_VScaleEM01_TypeDef  vscale;
+} CMU_HF_LEVEL_STRUCT;
+
+// Low power voltage scaling is only valid up to 20 MHz
+static const CMU_HF_LEVEL_STRUCT hf_levels[CMU_HF_LEVELS] = {
+  [CMU_HF_LOW]  = { cmuHFRCOFreq_7M0Hz,  emuVScaleEM01_LowPower },
+  [CMU_HF_MID]  = { cmuHFRCOFreq_13M0Hz, emuVScaleEM01_LowPower },
+  [CMU_HF_HIGH] = { MCU_HFXO_FREQ,       emuVScaleEM01_HighPerformance },
+};
+
+static uint32_t       hf_level;
+static uint32_t       hf_burst;
+static uint32_t       hf_floor[CMU_HF_LEVELS];    // Open requests per minimum level
+static CMU_HF_NOTIFY  hf_notify[CMU_HF_MAX_NOTIFY];
+static uint32_t       hf_notify_count;
 
 //***********************************************************************************
 // Private functions
 //***********************************************************************************
-
+static CMU_NODE cmu_clock_node(CMU_Clock_TypeDef clock);
+static CMU_NODE cmu_osc_node(CMU_Osc_TypeDef osc);
+static uint32_t cmu_owner_index(uint32_t owner);
+static void cmu_node_start(CMU_NODE node);
+static void cmu_node_request(CMU_NODE node, uint32_t owner);
+static void cmu_node_release(CMU_NODE node, uint32_t owner);
+static void cmu_node_gate(CMU_NODE node, bool enable);
+static uint32_t cmu_event_count(uint32_t events);
+static uint32_t cmu_hf_floor_level(void);
 
 //***********************************************************************************
 // Global functions
@@ -31,14 +112,15 @@
 
 /***************************************************************************//**
  * @brief
- *It is responsible for enabling all the oscillators and routing the clock tree
- *for the applications
+ *It is responsible for putting the oscillators and clock tree into a known
+ *state with everything gated off
  *
  *
  * @details
- *CMU is going to enable the oscillators.The LFRCO AND LFXO is going to be
- *disabled.Routing the LF clock to the LF clock tree and enabling clock tree
- *onto LE branches.
+ *The LFRCO and LFXO are disabled and the reference counts cleared.  Nothing is
+ *enabled here; each driver requests the clocks it needs with
+ *cmu_clock_request() and the parents of a clock, its HFPER/CORELE branch and
+ *LF oscillator, are enabled and routed along with it.
  *
  *
  * @note
@@ -48,31 +130,593 @@
 
 void cmu_open(void){
 
-    CMU_ClockEnable(cmuClock_HFPER, true);
-
     // By default, LFRCO is enabled, disable the LFRCO oscillator
-    // Disable the LFRCO oscillator
-    // What is the enumeration required for LFRCO?
-    // It can be found in the online HAL documentation
     CMU_OscillatorEnable(cmuOsc_LFRCO , false, false);
 
-    // Disable the LFXO oscillator
-    // What is the enumeration required for LFXO?
-    // It can be found in the online HAL documentation
+    // Disable the LFXO oscillator until the LEUART asks for it
     CMU_OscillatorEnable(cmuOsc_LFXO, false, false);
 
     // No requirement to enable the ULFRCO oscillator.  It is always enabled in EM0-4H1
 
-    // Route LF clock to the LF clock tree
-    // What is the enumeration required to placed the ULFRCO onto the proper clock branch?
-    // It can be found in the online HAL documentation
-    CMU_ClockSelectSet(cmuClock_LFA, cmuSelect_ULFRCO);    // routing ULFRCO to proper Low Freq clock tree
+    CORE_DECLARE_IRQ_STATE;
+    CORE_ENTER_CRITICAL();
+    for (int i = 0; i < CLK_NODES; i++) {
+      clock_count[i] = 0;
+      clock_holders[i] = CMU_NO_HOLDERS;
+      for (int j = 0; j < CMU_OWNERS; j++) {
+        owner_count[i][j] = 0;
+      }
+    }
+    hf_level = CMU_HF_HIGH;       // main() starts the core at MCU_HFXO_FREQ
+    hf_burst = 0;
+    for (int i = 0; i < CMU_HF_LEVELS; i++) {
+      hf_floor[i] = 0;
+    }
+    hf_notify_count = 0;
+    CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Requests a peripheral or branch clock on behalf of a driver
+ *
+ * @details
+ *   The clock and, on its first request, everything it depends on is turned
+ *   on.  Works like sleep_block_mode(), each request must be paired with a
+ *   cmu_clock_release() by the same owner, an owner may hold a clock more
+ *   than once.  An LF oscillator it needs is started and waited for before
+ *   interrupts are masked, LFXO start-up takes hundreds of ms, only the
+ *   counts, the holders and the enables are written in the critical section.
+ *
+ * @param[in] clock
+ *   The clock to enable, one of the managed cmuClock_ enumerations
+ *
+ * @param[in] owner
+ *   CMU_OWNER_ bit of the driver holding the clock
+ *
+ ******************************************************************************/
+
+void cmu_clock_request(CMU_Clock_TypeDef clock, uint32_t owner){
+  CMU_NODE node = cmu_clock_node(clock);
+
+  cmu_node_start(node);
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  cmu_node_request(node, owner);
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Releases a clock previously requested by a driver
+ *
+ * @details
+ *   When the last holder releases it the clock is gated off, followed by any
+ *   branch or oscillator that is then no longer in use.
+ *
+ * @param[in] clock
+ *   The clock to release
+ *
+ * @param[in] owner
+ *   CMU_OWNER_ bit of the driver that requested it
+ *
+ ******************************************************************************/
+
+void cmu_clock_release(CMU_Clock_TypeDef clock, uint32_t owner){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  cmu_node_release(cmu_clock_node(clock), owner);
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Requests an oscillator directly, for users outside the peripheral tree
+ *
+ * @details
+ *   Started and waited for with interrupts on, as in cmu_clock_request().
+ *
+ * @param[in] osc
+ *   cmuOsc_LFXO or cmuOsc_LFRCO
+ *
+ * @param[in] owner
+ *   CMU_OWNER_ bit of the driver holding the oscillator
+ *
+ ******************************************************************************/
+
+void cmu_osc_request(CMU_Osc_TypeDef osc, uint32_t owner){
+  CMU_NODE node = cmu_osc_node(osc);
+
+  cmu_node_start(node);
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  cmu_node_request(node, owner);
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Releases an oscillator requested with cmu_osc_request()
+ *
+ * @param[in] osc
+ *   cmuOsc_LFXO or cmuOsc_LFRCO
+ *
+ * @param[in] owner
+ *   CMU_OWNER_ bit of the driver that requested it
+ *
+ ******************************************************************************/
+
+void cmu_osc_release(CMU_Osc_TypeDef osc, uint32_t owner){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  cmu_node_release(cmu_osc_node(osc), owner);
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Returns whether a managed clock is currently on
+ *
+ * @param[in] clock
+ *   The clock to query
+ *
+ * @return
+ *   true if at least one driver holds the clock
+ *
+ ******************************************************************************/
+
+bool cmu_clock_is_on(CMU_Clock_TypeDef clock){
+  return clock_count[cmu_clock_node(clock)] > 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Returns the drivers holding a managed clock
+ *
+ * @param[in] clock
+ *   The clock to query
+ *
+ * @return
+ *   Mask of the CMU_OWNER_ bits holding the clock, directly or through a
+ *   clock that depends on it
+ *
+ ******************************************************************************/
+
+uint32_t cmu_clock_holders(CMU_Clock_TypeDef clock){
+  return clock_holders[cmu_clock_node(clock)];
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Writes the clocks that are on and their holders, a line at a time
+ *
+ * @details
+ *   Each enabled clock is listed as NAME:count/holders with the holders as a
+ *   hex CMU_OWNER_ mask, for example "HFPER:2/18 CORELE:1/2\n".  A line
+ *   takes as many whole clocks as fit, call again with the same next until
+ *   it returns false for the rest; each line goes out with ble_write().
+ *
+ * @param[out] report
+ *   Buffer receiving the NUL terminated line
+ *
+ * @param[in] size
+ *   Size of the buffer, at least one clock and its newline
+ *
+ * @param[in,out] next
+ *   Clock to start at, 0 for the first line
+ *
+ * @return
+ *   false, and report empty, once every clock that is on has been written
+ *
+ ******************************************************************************/
+
+bool cmu_clock_report(char *report, uint32_t size, uint32_t *next){
+  uint32_t used = 0;
+
+  EFM_ASSERT(size > 0);
+  report[0] = 0;
+  for (; *next < CLK_NODES; (*next)++) {
+    uint32_t i = *next;
+    int len;
+
+    if (clock_count[i] == 0) {
+      continue;
+    }
+    len = snprintf(&report[used], size - used, "%s%s:%lu/%lx", used ? " " : "",
+                   clock_tree[i].name, (unsigned long)clock_count[i],
+                   (unsigned long)clock_holders[i]);
+    if (used + len + 2 > size) {
+      EFM_ASSERT(used > 0);
+      report[used] = 0;
+      break;
+    }
+    used += len;
+  }
+  if (!used) {
+    return false;
+  }
+  report[used++] = '\n';
+  report[used] = 0;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Moves the HF clock to one of the CMU_HF_ performance levels
+ *
+ * @details
+ *   The HFRCO band and the EM0/EM1 voltage scaling are changed in the order
+ *   that keeps the core within its operating limits: the voltage is raised
+ *   before a faster band and lowered after a slower one.  Every registered
+ *   driver is then told the new HFPERCLK frequency so that it can recompute
+ *   its dividers.
+ *
+ * @note
+ *   Must be called from the main loop, not from an interrupt, as the
+ *   notified drivers reprogram their peripherals.
+ *
+ * @param[in] level
+ *   CMU_HF_LOW, CMU_HF_MID or CMU_HF_HIGH
+ *
+ ******************************************************************************/
 
-    // What is the proper enumeration to enable the clock tree onto the LE clock branches?
-    // It can be found in the Assignment 2 documentation
-     CMU_ClockEnable(cmuClock_CORELE, true);
+void cmu_hf_scale(uint32_t level){
+  EFM_ASSERT(level < CMU_HF_LEVELS);
+  if (level == hf_level) {
+    return;
+  }
+  if (level > hf_level) {
+    EMU_VScaleEM01(hf_levels[level].vscale, true);
+    CMU_HFRCOBandSet(hf_levels[level].band);
+  } else {
+    CMU_HFRCOBandSet(hf_levels[level].band);
+    EMU_VScaleEM01(hf_levels[level].vscale, true);
+  }
+  hf_level = level;
+  TRACE(TRACE_HF, CMU_ClockFreqGet(cmuClock_CORE) / 1000000);
 
-     CMU_ClockSelectSet(cmuClock_LFB, cmuSelect_LFXO);
+  uint32_t hfper_freq = CMU_ClockFreqGet(cmuClock_HFPER);
+  for (uint32_t i = 0; i < hf_notify_count; i++) {
+    hf_notify[i](hfper_freq);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Returns the current HF clock performance level
+ *
+ ******************************************************************************/
 
+uint32_t cmu_hf_level(void){
+  return hf_level;
 }
 
+/***************************************************************************//**
+ * @brief
+ *   Picks the HF clock level for the work that is waiting
+ *
+ * @details
+ *   Called by the main loop before it dispatches the scheduled events.  A
+ *   light queue, the usual single short handler per wake-up, runs at the
+ *   lowest band; a longer queue moves up a level, and any open burst forces
+ *   the highest band.  The level never drops below the highest floor a
+ *   driver has requested with cmu_hf_floor_request().
+ *
+ * @param[in] pending_events
+ *   The scheduler's pending event bits, get_scheduled_events()
+ *
+ ******************************************************************************/
+
+void cmu_hf_policy(uint32_t pending_events){
+  uint32_t events = cmu_event_count(pending_events);
+  uint32_t level;
+
+  if (hf_burst > 0) {
+    level = CMU_HF_HIGH;
+  } else if (events <= CMU_HF_LIGHT_EVENTS) {
+    level = CMU_HF_LOW;
+  } else if (events <= CMU_HF_MEDIUM_EVENTS) {
+    level = CMU_HF_MID;
+  } else {
+    level = CMU_HF_HIGH;
+  }
+  if (level < cmu_hf_floor_level()) {
+    level = cmu_hf_floor_level();
+  }
+  cmu_hf_scale(level);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Runs the core at the highest band until cmu_hf_burst_end()
+ *
+ * @details
+ *   For bursts of CPU bound work such as batch compression or bulk flash
+ *   writes, where finishing quickly and going back to sleep costs less energy
+ *   than running slowly.  Bursts nest like sleep_block_mode().
+ *
+ ******************************************************************************/
+
+void cmu_hf_burst_begin(void){
+  hf_burst++;
+  cmu_hf_scale(CMU_HF_HIGH);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Ends a burst started with cmu_hf_burst_begin()
+ *
+ * @details
+ *   The band is lowered again by the next cmu_hf_policy() call once no burst
+ *   is open.
+ *
+ ******************************************************************************/
+
+void cmu_hf_burst_end(void){
+  EFM_ASSERT(hf_burst > 0);
+  hf_burst--;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Keeps the HF clock at or above a level while a driver needs it
+ *
+ * @details
+ *   For peripherals with a minimum reference clock, such as the I2C master
+ *   which emlib requires to run above 9 MHz for the asymmetric 400 kHz bus.
+ *   The clock is raised at once if it is below the floor.  Requests nest
+ *   like sleep_block_mode().  Not from an interrupt handler, the raise
+ *   runs the HF notifiers.
+ *
+ * @param[in] level
+ *   CMU_HF_LOW, CMU_HF_MID or CMU_HF_HIGH
+ *
+ ******************************************************************************/
+
+void cmu_hf_floor_request(uint32_t level){
+  EFM_ASSERT(level < CMU_HF_LEVELS);
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  hf_floor[level]++;
+  CORE_EXIT_CRITICAL();
+  if (hf_level < level) {
+    cmu_hf_scale(level);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Ends a cmu_hf_floor_request() of the same level
+ *
+ * @details
+ *   The band is lowered again by the next cmu_hf_policy() call, so a
+ *   driver can release from its interrupt handler when its transfer ends.
+ *
+ ******************************************************************************/
+
+void cmu_hf_floor_release(uint32_t level){
+  EFM_ASSERT(level < CMU_HF_LEVELS);
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  EFM_ASSERT(hf_floor[level] > 0);
+  hf_floor[level]--;
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Registers a driver to be told about HF clock changes
+ *
+ * @details
+ *   Drivers whose dividers are derived from HFPERCLK, such as the I2C bus
+ *   clock and the LED PWM prescaler, register once from their open function.
+ *
+ * @param[in] notify
+ *   Function called with the new HFPERCLK frequency after each change
+ *
+ ******************************************************************************/
+
+void cmu_hf_notify_register(CMU_HF_NOTIFY notify){
+  EFM_ASSERT(hf_notify_count < CMU_HF_MAX_NOTIFY);
+  for (uint32_t i = 0; i < hf_notify_count; i++) {
+    if (hf_notify[i] == notify) {
+      return;
+    }
+  }
+  hf_notify[hf_notify_count++] = notify;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Counts the events set in a scheduler event mask
+ *
+ ******************************************************************************/
+
+static uint32_t cmu_event_count(uint32_t events){
+  uint32_t count = 0;
+
+  while (events) {
+    events &= events - 1;
+    count++;
+  }
+  return count;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Highest HF level with an open cmu_hf_floor_request()
+ *
+ ******************************************************************************/
+
+static uint32_t cmu_hf_floor_level(void){
+  for (uint32_t level = CMU_HF_LEVELS - 1; level > CMU_HF_LOW; level--) {
+    if (hf_floor[level] > 0) {
+      return level;
+    }
+  }
+  return CMU_HF_LOW;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Finds the clock tree entry of a peripheral or branch clock
+ *
+ * @note
+ *   Asserts on a clock that is not managed by this module.
+ *
+ ******************************************************************************/
+
+static CMU_NODE cmu_clock_node(CMU_Clock_TypeDef clock){
+  for (int i = 0; i < CLK_NODES; i++) {
+    if (!clock_tree[i].is_osc && (clock_tree[i].clock == clock)) {
+      return (CMU_NODE)i;
+    }
+  }
+  EFM_ASSERT(false);
+  return CLK_HFPER;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Finds the clock tree entry of an oscillator
+ *
+ ******************************************************************************/
+
+static CMU_NODE cmu_osc_node(CMU_Osc_TypeDef osc){
+  for (int i = 0; i < CLK_NODES; i++) {
+    if (clock_tree[i].is_osc && (clock_tree[i].osc == osc)) {
+      return (CMU_NODE)i;
+    }
+  }
+  EFM_ASSERT(false);
+  return CLK_LFRCO;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Index of a CMU_OWNER_ bit in owner_count[]
+ *
+ * @note
+ *   Asserts on no owner or more than one.
+ *
+ ******************************************************************************/
+
+static uint32_t cmu_owner_index(uint32_t owner){
+  EFM_ASSERT(owner && !(owner & (owner - 1)));
+  EFM_ASSERT(owner < (0x01 << CMU_OWNERS));
+  return (uint32_t)__builtin_ctz(owner);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Starts the oscillators under a clock tree entry that are off and waits
+ *   until they are stable
+ *
+ * @details
+ *   Before the critical section of a request, with interrupts on.  The LF
+ *   oscillators are only released from thread context, by the LEUART, so
+ *   one started here is still running when cmu_node_request() takes its
+ *   reference.
+ *
+ ******************************************************************************/
+
+static void cmu_node_start(CMU_NODE node){
+  const CMU_NODE_STRUCT *entry = &clock_tree[node];
+
+  for (int i = 0; i < CLK_NODES; i++) {
+    if (entry->depends & NODE(i)) {
+      cmu_node_start((CMU_NODE)i);
+    }
+  }
+  if (entry->is_osc && (clock_count[node] == 0)) {
+    CMU_OscillatorEnable(entry->osc, true, true);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes a reference on a clock tree entry and its parents
+ *
+ * @details
+ *   Parents are requested first so that a branch is running before the
+ *   clock fed from it is enabled.  LF oscillators were made stable by
+ *   cmu_node_start(), their enable is not waited for here.
+ *
+ * @note
+ *   Must be called inside a critical section.
+ *
+ ******************************************************************************/
+
+static void cmu_node_request(CMU_NODE node, uint32_t owner){
+  const CMU_NODE_STRUCT *entry = &clock_tree[node];
+
+  for (int i = 0; i < CLK_NODES; i++) {
+    if (entry->depends & NODE(i)) {
+      cmu_node_request((CMU_NODE)i, owner);
+    }
+  }
+  if (clock_count[node] == 0) {
+    cmu_node_gate(node, true);
+  }
+  clock_count[node]++;
+  EFM_ASSERT(owner_count[node][cmu_owner_index(owner)] < UINT8_MAX);
+  owner_count[node][cmu_owner_index(owner)]++;
+  clock_holders[node] |= owner;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Drops a reference on a clock tree entry and its parents
+ *
+ * @details
+ *   The owner stops being a holder with its last reference.  Releasing a
+ *   clock it does not hold asserts.
+ *
+ * @note
+ *   Must be called inside a critical section.
+ *
+ ******************************************************************************/
+
+static void cmu_node_release(CMU_NODE node, uint32_t owner){
+  const CMU_NODE_STRUCT *entry = &clock_tree[node];
+
+  uint32_t index = cmu_owner_index(owner);
+
+  EFM_ASSERT(clock_count[node] > 0);
+  EFM_ASSERT(owner_count[node][index] > 0);
+  clock_count[node]--;
+  if (--owner_count[node][index] == 0) {
+    clock_holders[node] &= ~owner;
+  }
+  if (clock_count[node] == 0) {
+    cmu_node_gate(node, false);
+  }
+  for (int i = 0; i < CLK_NODES; i++) {
+    if (entry->depends & NODE(i)) {
+      cmu_node_release((CMU_NODE)i, owner);
+    }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Turns a clock tree entry on or off in the CMU
+ *
+ ******************************************************************************/
+
+static void cmu_node_gate(CMU_NODE node, bool enable){
+  const CMU_NODE_STRUCT *entry = &clock_tree[node];
+
+  if (entry->is_osc) {
+    CMU_OscillatorEnable(entry->osc, enable, false);
+    return;
+  }
+  if (enable && entry->select_en) {
+    CMU_ClockSelectSet(entry->branch, entry->select);
+  }
+  CMU_ClockEnable(entry->clock, enable);
+}
@@ -0,0 +1,246 @@
+/**
+ * @file event_latency.c
+ * @author Shambaditya Tarafder
+ * @date   12/5/2021
+ * @brief  Measures how long each scheduler event stays pending, from
+ *         add_scheduled_event() to the main loop taking it, with the DWT
+ *         cycle counter
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include "event_latency.h"
+#include "em_core.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint32_t             posted_at[EVENT_LATENCY_EVENTS];
+static EVENT_LATENCY_STATS  latency[EVENT_LATENCY_EVENTS];
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static uint32_t event_latency_bucket(uint32_t cycles);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Starts the DWT cycle counter and clears the statistics
+ *
+ * @details
+ *   CYCCNT counts core clock cycles, so it stops while the core sleeps and
+ *   its rate follows the HF band.  An event is posted and taken with the
+ *   core awake, so the latency seen is the time the main loop kept it
+ *   waiting, in cycles of whatever band cmu_hf_policy() picked meanwhile.
+ *
+ ******************************************************************************/
+
+void event_latency_open(void){
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  event_latency_clear();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Timestamps events as they are added to the scheduler
+ *
+ * @details
+ *   Called by add_scheduled_event(), from interrupts as well, with only the
+ *   events its atomic OR found not pending, so that an event posted again
+ *   before it is handled keeps the time of its first post.  Each event has
+ *   its own slot and only the post that set its bit writes it.
+ *
+ * @param[in] events
+ *   Event bits becoming pending
+ *
+ ******************************************************************************/
+
+void event_latency_post(uint32_t events){
+  uint32_t now = DWT->CYCCNT;
+
+  for(uint32_t i = 0; i < EVENT_LATENCY_EVENTS; i++){
+      if(events & (0x01UL << i)){
+          posted_at[i] = now;
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Records the latency of events as they leave the scheduler
+ *
+ * @details
+ *   Called by remove_scheduled_event() from the main loop with only the
+ *   events that are pending, before they are cleared.  The main loop removes
+ *   an event right before calling its handler.  The statistics are only
+ *   written here, so no critical section is needed.
+ *
+ * @param[in] events
+ *   Event bits leaving the pending set
+ *
+ ******************************************************************************/
+
+void event_latency_dispatch(uint32_t events){
+  uint32_t now = DWT->CYCCNT;
+
+  for(uint32_t i = 0; i < EVENT_LATENCY_EVENTS; i++){
+      EVENT_LATENCY_STATS *stats = &latency[i];
+      uint32_t cycles;
+      if(!(events & (0x01UL << i))){
+          continue;
+      }
+      cycles = now - posted_at[i];
+      stats->count++;
+      stats->sum += cycles;
+      if(cycles < stats->min){
+          stats->min = cycles;
+      }
+      if(cycles > stats->max){
+          stats->max = cycles;
+      }
+      stats->histogram[event_latency_bucket(cycles)]++;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Copies the statistics of one event
+ *
+ * @param[in] event
+ *   Bit number of the event, 0 for 0x01
+ *
+ * @return
+ *   false if the event has not been handled yet
+ *
+ ******************************************************************************/
+
+bool event_latency_get(uint32_t event, EVENT_LATENCY_STATS *stats){
+  EFM_ASSERT(event < EVENT_LATENCY_EVENTS);
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *stats = latency[event];
+  CORE_EXIT_CRITICAL();
+  return stats->count > 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Latency below which a percentage of the samples fall
+ *
+ * @details
+ *   Resolved from the histogram, so the result is the top of the bucket the
+ *   percentile lands in, never above the largest sample seen.
+ *
+ * @param[in] percent
+ *   1 to 100
+ *
+ * @return
+ *   Latency in cycles, 0 if there are no samples
+ *
+ ******************************************************************************/
+
+uint32_t event_latency_percentile(const EVENT_LATENCY_STATS *stats, uint32_t percent){
+  uint64_t rank = ((uint64_t)stats->count * percent + 99) / 100;
+  uint64_t seen = 0;
+
+  EFM_ASSERT((percent > 0) && (percent <= 100));
+  if(!stats->count){
+      return 0;
+  }
+  for(uint32_t bucket = 0; bucket < EVENT_LATENCY_BUCKETS - 1; bucket++){
+      seen += stats->histogram[bucket];
+      if(seen >= rank){
+          uint32_t top = (0x01UL << (bucket + 1)) - 1;
+          return (top < stats->max) ? top : stats->max;
+      }
+  }
+  return stats->max;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Formats one event's latency as a compact line for the BLE link
+ *
+ * @details
+ *   "E<n> N<count> <min>/<p50>/<p90>/<p99>/<max>" in cycles, which fits a
+ *   single ble_write().
+ *
+ * @param[in] event
+ *   Bit number of the event, 0 for 0x01
+ *
+ * @return
+ *   The sample count, 0 leaves report empty
+ *
+ ******************************************************************************/
+
+uint32_t event_latency_report(uint32_t event, char *report, uint32_t size){
+  EVENT_LATENCY_STATS stats;
+
+  EFM_ASSERT(size > 0);
+  report[0] = 0;
+  if(!event_latency_get(event, &stats)){
+      return 0;
+  }
+  snprintf(report, size, "E%lu N%lu %lu/%lu/%lu/%lu/%lu\n", (unsigned long)event,
+           (unsigned long)stats.count, (unsigned long)stats.min,
+           (unsigned long)event_latency_percentile(&stats, 50),
+           (unsigned long)event_latency_percentile(&stats, 90),
+           (unsigned long)event_latency_percentile(&stats, 99),
+           (unsigned long)stats.max);
+  return stats.count;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Starts a new measurement window
+ *
+ ******************************************************************************/
+
+void event_latency_clear(void){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  for(uint32_t i = 0; i < EVENT_LATENCY_EVENTS; i++){
+      EVENT_LATENCY_STATS *stats = &latency[i];
+      stats->count = 0;
+      stats->min = UINT32_MAX;
+      stats->max = 0;
+      stats->sum = 0;
+      for(uint32_t bucket = 0; bucket < EVENT_LATENCY_BUCKETS; bucket++){
+          stats->histogram[bucket] = 0;
+      }
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Histogram bucket of a latency, floor(log2(cycles))
+ *
+ ******************************************************************************/
+
+static uint32_t event_latency_bucket(uint32_t cycles){
+  uint32_t bucket = 0;
+
+  while((cycles >>= 1) && (bucket < EVENT_LATENCY_BUCKETS - 1)){
+      bucket++;
+  }
+  return bucket;
+}
@@ -35,7 +35,7 @@
  * the GPIO is basically used for the LEDs
  *
  * @details
- *The function uses the CMU_ClockEnable to set up the clock for the GPIO
+ *The function uses the cmu_clock_request to set up the clock for the GPIO
  *to be used for the pinmode and driver strength.
  *
  * @note
@@ -46,7 +46,7 @@
 
 void gpio_open(void){
 
-  CMU_ClockEnable(cmuClock_GPIO, true);
+  cmu_clock_request(cmuClock_GPIO, CMU_OWNER_GPIO);
 
 	// Configure LED pins
 	GPIO_DriveStrengthSet(LED_RED_PORT, LED_RED_DRIVE_STRENGTH);
@@ -0,0 +1,182 @@
+/**
+ * @file hibernate.c
+ * @author Shambaditya Tarafder
+ * @date   12/9/2021
+ * @brief  EM4H duty cycling.  The RTCC keeps counting and wakes the part
+ *         through a reset, the few words of state the app needs across it
+ *         are kept in the RTCC's retention registers.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <string.h>
+#include "hibernate.h"
+#include "em_emu.h"
+#include "em_rmu.h"
+#include "em_rtcc.h"
+#include "cmu.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HIBERNATE_RTCC_IF     RTCC_IF_CC2   // Flag of HIBERNATE_RTCC_CH
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static bool warm_boot;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static uint32_t hibernate_check(uint32_t size);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Takes the reset cause and turns off the wake-up of the last EM4H
+ *
+ * @details
+ *   A warm boot is an EM4H wake-up with a valid state in the retention
+ *   registers, anything else starts from scratch.  The cause is cleared so
+ *   the next reset reports only its own.
+ *
+ * @note
+ *   After cmu_open() and before task_open(), whose RTCC interrupt would
+ *   otherwise take the wake-up flag
+ *
+ ******************************************************************************/
+
+void hibernate_open(void){
+  uint32_t cause = RMU_ResetCauseGet();
+
+  RMU_ResetCauseClear();
+  cmu_clock_request(cmuClock_RTCC, CMU_OWNER_HIBERNATE);
+  RTCC_EM4WakeupEnable(false);
+  RTCC_IntDisable(HIBERNATE_RTCC_IF);
+  RTCC_IntClear(HIBERNATE_RTCC_IF);
+
+  warm_boot = (cause & RMU_RSTCAUSE_EM4RST) && (RTCC->RET[0].REG == HIBERNATE_MAGIC);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Whether this boot is an EM4H wake-up, the self tests and the once only
+ *   setup can be skipped
+ *
+ ******************************************************************************/
+
+bool hibernate_warm_boot(void){
+  return warm_boot;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Copies the state hibernate_save() kept back into RAM
+ *
+ * @param[out] state
+ *   Left alone on a cold boot or when the saved state does not check out
+ *
+ * @param[in] size
+ *   Bytes, as given to hibernate_save()
+ *
+ * @return
+ *   true if state was restored
+ *
+ ******************************************************************************/
+
+bool hibernate_restore(void *state, uint32_t size){
+  uint32_t words[HIBERNATE_RET_WORDS - HIBERNATE_RET_HEADER];
+
+  EFM_ASSERT(size <= HIBERNATE_MAX_SIZE);
+  if(!warm_boot || (RTCC->RET[1].REG != hibernate_check(size))){
+      return false;
+  }
+  for(uint32_t i = 0; i < (size + 3) / 4; i++){
+      words[i] = RTCC->RET[HIBERNATE_RET_HEADER + i].REG;
+  }
+  memcpy(state, words, size);
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Keeps state in the retention registers for the next warm boot
+ *
+ * @details
+ *   The magic word is written last, a save cut short by a reset leaves the
+ *   old one invalid rather than half written.
+ *
+ * @param[in] size
+ *   Bytes, at most HIBERNATE_MAX_SIZE
+ *
+ ******************************************************************************/
+
+void hibernate_save(const void *state, uint32_t size){
+  uint32_t words[HIBERNATE_RET_WORDS - HIBERNATE_RET_HEADER] = { 0 };
+
+  EFM_ASSERT(size <= HIBERNATE_MAX_SIZE);
+  memcpy(words, state, size);
+  RTCC->RET[0].REG = 0;
+  for(uint32_t i = 0; i < (size + 3) / 4; i++){
+      RTCC->RET[HIBERNATE_RET_HEADER + i].REG = words[i];
+  }
+  RTCC->RET[1].REG = hibernate_check(size);
+  RTCC->RET[0].REG = HIBERNATE_MAGIC;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Enters EM4H until the RTCC has counted seconds
+ *
+ * @details
+ *   Only the RTCC and its ULFRCO keep running, RAM and every other
+ *   peripheral lose their state and main() starts over on the wake-up.
+ *   Drivers still working are cut off, the caller waits for them first.
+ *
+ * @param[in] seconds
+ *   Time in EM4H, at least 1
+ *
+ ******************************************************************************/
+
+void hibernate_enter(uint32_t seconds){
+  RTCC_CCChConf_TypeDef compare = RTCC_CH_INIT_COMPARE_DEFAULT;
+  EMU_EM4Init_TypeDef em4_init = EMU_EM4INIT_DEFAULT;
+
+  EFM_ASSERT(seconds > 0);
+  RTCC_ChannelInit(HIBERNATE_RTCC_CH, &compare);
+  RTCC_ChannelCCVSet(HIBERNATE_RTCC_CH, RTCC_CounterGet() + seconds * HIBERNATE_RTCC_HZ);
+  RTCC_IntClear(HIBERNATE_RTCC_IF);
+  RTCC_IntEnable(HIBERNATE_RTCC_IF);
+  RTCC_EM4WakeupEnable(true);
+
+  em4_init.retainUlfrco = true;
+  em4_init.em4State = emuEM4Hibernate;
+  EMU_EM4Init(&em4_init);
+  EMU_EnterEM4H();
+  while(1);                             // Not reached, the wake-up is a reset
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Check word of the saved state, a rotate and xor over its words and size
+ *
+ ******************************************************************************/
+
+static uint32_t hibernate_check(uint32_t size){
+  uint32_t check = size;
+
+  for(uint32_t i = 0; i < (size + 3) / 4; i++){
+      check = ((check << 1) | (check >> 31)) ^ RTCC->RET[HIBERNATE_RET_HEADER + i].REG;
+  }
+  return check;
+}
@@ -13,6 +13,8 @@
 #include "em_i2c.h"
 #include "i2c.h"
 #include "em_cmu.h"
+#include "profiler.h"
+#include "recorder.h"
 
 
 //***********************************************************************************
@@ -31,6 +33,11 @@ typedef enum {
 I2C_STATE_MACHINE i2c0_sm;
 I2C_STATE_MACHINE i2c1_sm;
 
+static uint32_t             i2c0_bus_freq;
+static uint32_t             i2c1_bus_freq;
+static I2C_ClockHLR_TypeDef i2c0_bus_clhr;
+static I2C_ClockHLR_TypeDef i2c1_bus_clhr;
+
 //***********************************************************************************
 // Private functions
 //***********************************************************************************
@@ -38,8 +45,11 @@ I2C_STATE_MACHINE i2c1_sm;
 static void i2c_bus_reset(I2C_TypeDef *i2c);
 static void i2c_ack_sm(I2C_STATE_MACHINE *i2c);
 static void i2c_nack_sm(I2C_STATE_MACHINE *i2c);
+static void i2c_nack_stop(I2C_STATE_MACHINE *i2c);
 static void i2c_mstop_sm(I2C_STATE_MACHINE *i2c);
 static void i2c_rxdatav_sm(I2C_STATE_MACHINE *i2c);
+static void i2c_clock_update(uint32_t hfper_freq);
+static void i2c_bus_freq_set(I2C_STATE_MACHINE *i2c, uint32_t hfper_freq);
 
 /***************************************************************************//**
  * @brief
@@ -47,7 +57,10 @@ static void i2c_rxdatav_sm(I2C_STATE_MACHINE *i2c);
  *
  * @details
  *   This function basically initializes the i2c bus,it also initializes and sets
- *   up the clock frequencies,interrupts and the i2c struct.
+ *   up the clock frequencies,interrupts and the i2c struct.  The bus frequency
+ *   is kept so that it can be recomputed whenever the HF clock is scaled.
+ *   The HF clock floor the bus needs is only held during a transfer, see
+ *   i2c_start().
  *
  * @note
  *   This function is just for setting up the structs etc. not operating on it
@@ -57,21 +70,25 @@ static void i2c_rxdatav_sm(I2C_STATE_MACHINE *i2c);
  *   It is pointing address of the i2c peripheral being used.[i2c0 or i2c1]
  *
  * @param[in] i2c_open
- *   It is the data structure that will be used for modification etc.
+ *   The const table of the bus, already in register values
  *
  *
  ******************************************************************************/
-void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_open) {
+void i2c_open(I2C_TypeDef *i2c, const I2C_OPEN_STRUCT *i2c_open) {
   i2c0_sm.busy = false;
   i2c1_sm.busy = false;
-  I2C_Init_TypeDef i2c_values;
+  i2c0_sm.I2Cn = I2C0;
+  i2c1_sm.I2Cn = I2C1;
 if(i2c == I2C0) {
-    CMU_ClockEnable(cmuClock_I2C0, true);
+    cmu_clock_request(cmuClock_I2C0, CMU_OWNER_I2C);
   } else if (i2c == I2C1) {
-    CMU_ClockEnable(cmuClock_I2C1, true);
+    cmu_clock_request(cmuClock_I2C1, CMU_OWNER_I2C);
   } else {
     EFM_ASSERT(false);
   }
+  // emlib computes the SCL divider only above the floor, and the bus reset
+  // below runs a START and STOP
+  cmu_hf_floor_request(I2C_HF_FLOOR);
 
   if ((i2c->IF & 0x01) == 0) {
     i2c->IFS = 0x01;
@@ -82,18 +99,22 @@ if(i2c == I2C0) {
     EFM_ASSERT(!(i2c->IF & 0x01));
   }
 
-  i2c_values.clhr = i2c_open->clhr;
-  i2c_values.enable = i2c_open->enable;
-  i2c_values.freq = i2c_open->freq;
-  i2c_values.master = i2c_open->master;
-  i2c_values.refFreq = i2c_open->refFreq;
+  I2C_Init(i2c, &i2c_open->init);
 
-  I2C_Init(i2c, &i2c_values);
+  if(i2c == I2C0) {
+    i2c0_bus_freq = i2c_open->init.freq;
+    i2c0_bus_clhr = i2c_open->init.clhr;
+  } else {
+    i2c1_bus_freq = i2c_open->init.freq;
+    i2c1_bus_clhr = i2c_open->init.clhr;
+  }
+  cmu_hf_notify_register(i2c_clock_update);
 
-  i2c->ROUTELOC0 = i2c_open->out_pin_scl_route | i2c_open->out_pin_sda_route;
-  i2c->ROUTEPEN = (I2C_ROUTEPEN_SCLPEN*i2c_open->out_pin_scl_en) | (I2C_ROUTEPEN_SDAPEN*i2c_open->out_pin_sda_en);
+  i2c->ROUTELOC0 = i2c_open->routeloc0;
+  i2c->ROUTEPEN = i2c_open->routepen;
 
   i2c_bus_reset(i2c);
+  cmu_hf_floor_release(I2C_HF_FLOOR);
 
     i2c->IFC = I2C_IF_ACK;
     i2c->IEN |= I2C_IF_ACK;
@@ -108,6 +129,61 @@ if(i2c == I2C0) {
     }
 }
 
+/***************************************************************************//**
+ * @brief
+ *   Recomputes the SCL divider of every open bus after an HF clock change
+ *
+ * @details
+ *   Registered with cmu_hf_notify_register() so that the bus keeps its
+ *   frequency when cmu_hf_scale() changes the HFRCO band.  Below
+ *   I2C_HF_FLOOR the divider is left as it is, no transfer runs there and
+ *   the raise i2c_start() asks for brings it back here.  A bus in the middle
+ *   of a transfer keeps its divider until the STOP, i2c_mstop_sm() sets the
+ *   new one then.
+ *
+ * @param[in] hfper_freq
+ *   The new HFPERCLK frequency in Hz
+ *
+ ******************************************************************************/
+
+static void i2c_clock_update(uint32_t hfper_freq){
+  if(cmu_hf_level() < I2C_HF_FLOOR) {
+    return;
+  }
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if(cmu_clock_is_on(cmuClock_I2C0)) {
+    i2c_bus_freq_set(&i2c0_sm, hfper_freq);
+  }
+  if(cmu_clock_is_on(cmuClock_I2C1)) {
+    i2c_bus_freq_set(&i2c1_sm, hfper_freq);
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sets the SCL divider of one bus for a HFPERCLK frequency, or keeps the
+ *   frequency for the STOP of the transfer running on it
+ *
+ * @param[in] i2c
+ *   The i2c SM of the bus
+ *
+ * @param[in] hfper_freq
+ *   HFPERCLK frequency in Hz
+ *
+ ******************************************************************************/
+
+static void i2c_bus_freq_set(I2C_STATE_MACHINE *i2c, uint32_t hfper_freq){
+  if(i2c->busy) {
+    i2c->hfper_freq = hfper_freq;
+  } else if(i2c->I2Cn == I2C0) {
+    I2C_BusFreqSet(I2C0, hfper_freq, i2c0_bus_freq, i2c0_bus_clhr);
+  } else {
+    I2C_BusFreqSet(I2C1, hfper_freq, i2c1_bus_freq, i2c1_bus_clhr);
+  }
+}
+
 /***************************************************************************//**
  * @brief
  *   This function resets the i2c
@@ -162,6 +238,7 @@ void i2c_bus_reset(I2C_TypeDef * i2c) {
  ******************************************************************************/
 
 void I2C1_IRQHandler(void) {
+  PROFILER_IRQ_ENTER(I2C1_IRQn);
 
   int int_flag = I2C1->IF;
   I2C1->IFC = int_flag;
@@ -178,6 +255,7 @@ void I2C1_IRQHandler(void) {
   if(int_flag & I2C_IF_RXDATAV) {
     i2c_rxdatav_sm(&i2c1_sm);
   }
+  PROFILER_IRQ_EXIT();
 }
 
 /***************************************************************************//**
@@ -195,6 +273,7 @@ void I2C1_IRQHandler(void) {
 
 
 void I2C0_IRQHandler(void) {
+  PROFILER_IRQ_ENTER(I2C0_IRQn);
 
   int int_flag = I2C0->IF;
   I2C0->IFC = int_flag;
@@ -211,6 +290,7 @@ void I2C0_IRQHandler(void) {
   if(int_flag & I2C_IF_RXDATAV) {
     i2c_rxdatav_sm(&i2c0_sm);
   }
+  PROFILER_IRQ_EXIT();
 }
 
 /***************************************************************************//**
@@ -222,7 +302,9 @@ void I2C0_IRQHandler(void) {
  *
  *
  * @note
- *   Shouldn't encounter EFM Assert.If it does then something must have gone wrong
+ *   An ACK while receiving or stopping answers nothing the master sent and
+ *   is ignored.  Shouldn't encounter EFM Assert.If it does then something
+ *   must have gone wrong
  *
  *
  * @param[in] i2c
@@ -246,10 +328,8 @@ static void i2c_ack_sm(I2C_STATE_MACHINE *i2c){
       i2c->state = Process_Sense;
       break;
     case Process_Sense:
-      EFM_ASSERT(false);
       break;
     case Stop:
-      EFM_ASSERT(false);
       break;
     default :
       EFM_ASSERT(false);
@@ -262,7 +342,9 @@ static void i2c_ack_sm(I2C_STATE_MACHINE *i2c){
  *   This function is called by the i2c interrupt handler whenever NACK is encountered
  *
  * @details
- *   This function defines the NACK or not available behavior for the state machine
+ *   This function defines the NACK or not available behavior for the state machine.
+ *   A slave that does not answer its address or a byte ends the transfer,
+ *   see i2c_nack_stop().  Once the STOP is on its way a NACK changes nothing.
  *
  *
  * @note
@@ -278,19 +360,18 @@ static void i2c_ack_sm(I2C_STATE_MACHINE *i2c){
 static void i2c_nack_sm(I2C_STATE_MACHINE *i2c){
   switch(i2c->state){
     case Start_CMD:
-      EFM_ASSERT(false);
+      i2c_nack_stop(i2c);
       break;
     case Reg_CMD:
-      EFM_ASSERT(false);
+      i2c_nack_stop(i2c);
       break;
     case Wait_Read:
-      EFM_ASSERT(false);
+      i2c_nack_stop(i2c);
       break;
     case Process_Sense:
-      EFM_ASSERT(false);
+      i2c_nack_stop(i2c);
       break;
     case Stop:
-      EFM_ASSERT(false);
       break;
     default :
       EFM_ASSERT(false);
@@ -298,6 +379,28 @@ static void i2c_nack_sm(I2C_STATE_MACHINE *i2c){
   }
 }
 
+/***************************************************************************//**
+ * @brief
+ *   Ends a transfer the slave NACKed
+ *
+ * @details
+ *   Drops what is waiting to go out and sends the STOP.  Its MSTOP finishes
+ *   the transfer in i2c_mstop_sm() like any other, the bus is free again and
+ *   the callback event is posted; the caller tells the two apart with
+ *   i2c_nacked().
+ *
+ * @param[in] i2c
+ *   The i2c SM currently in use
+ *
+ ******************************************************************************/
+
+static void i2c_nack_stop(I2C_STATE_MACHINE *i2c){
+  i2c->nacked = true;
+  i2c->state = Stop;
+  i2c->I2Cn->CMD = I2C_CMD_CLEARTX;
+  i2c->I2Cn->CMD = I2C_CMD_STOP;
+}
+
 /***************************************************************************//**
  * @brief
  *   This function is called by the i2c interrupt handler whenever MSTOP is encountered
@@ -331,9 +434,14 @@ static void i2c_mstop_sm(I2C_STATE_MACHINE *i2c){
     EFM_ASSERT(false);
     break;
   case Stop:
+    i2c->busy = false;
+    if(i2c->hfper_freq) {
+      i2c_bus_freq_set(i2c, i2c->hfper_freq);
+      i2c->hfper_freq = 0;
+    }
+    cmu_hf_floor_release(I2C_HF_FLOOR);
     sleep_unblock_mode(EM2);
     add_scheduled_event(i2c->cb);
-    i2c->busy = false;
     break;
   default:
     EFM_ASSERT(false);
@@ -373,6 +481,7 @@ static void i2c_rxdatav_sm(I2C_STATE_MACHINE *i2c){
   case Process_Sense:
  //   EFM_ASSERT(false);
     i2c->data_add[i2c->counter] = i2c->I2Cn->RXDATA;
+    RECORD(RECORDER_I2C_RX, i2c->data_add[i2c->counter]);
     i2c->bytes--;
     i2c->counter++;
     if (i2c->bytes > 0){
@@ -406,7 +515,9 @@ static void i2c_rxdatav_sm(I2C_STATE_MACHINE *i2c){
  *
  *
  * @note
- *   This function should called when starting the i2c operation
+ *   This function should called when starting the i2c operation.  The HF
+ *   clock is held at I2C_HF_FLOOR or above from here until the STOP, so it
+ *   can drop to CMU_HF_LOW between transfers.
  *
  *
  * @param[in] i2c
@@ -448,6 +559,7 @@ void i2c_start(I2C_TypeDef *i2c, uint32_t slave_add, uint32_t slave_reg, bool wr
   while(i2c_sm_pt->busy);
   EFM_ASSERT((i2c->STATE & _I2C_STATE_STATE_MASK) == I2C_STATE_STATE_IDLE);
   sleep_block_mode(I2C_EM_BLOCK);
+  cmu_hf_floor_request(I2C_HF_FLOOR);
 
 
     i2c_sm_pt->state = Start_CMD;
@@ -458,9 +570,34 @@ void i2c_start(I2C_TypeDef *i2c, uint32_t slave_add, uint32_t slave_reg, bool wr
     i2c_sm_pt->data_add = data_add;
     i2c_sm_pt->bytes = bytes;
     i2c_sm_pt->counter = counter;
+    i2c_sm_pt->nacked = false;
 
     i2c_sm_pt->I2Cn->CMD = I2C_CMD_START;
     i2c_sm_pt->I2Cn->TXDATA = (i2c_sm_pt->slave_add << 1) | I2C_WRITE;
     i2c_sm_pt->busy = true;
     i2c_sm_pt->cb = cb;
 }
+
+/***************************************************************************//**
+ * @brief
+ *   Tells whether the last transfer on a bus was cut short by a NACK
+ *
+ * @details
+ *   For the callback of i2c_start(), which is posted either way.  The data
+ *   of a NACKed read is not valid.
+ *
+ * @param[in] i2c
+ *   It is pointing address of the i2c peripheral being used.[i2c0 or i2c1]
+ *
+ * @return
+ *   true if the slave NACKed its address or a byte
+ *
+ ******************************************************************************/
+
+bool i2c_nacked(I2C_TypeDef *i2c) {
+  if(i2c == I2C0) {
+    return i2c0_sm.nacked;
+  }
+  EFM_ASSERT(i2c == I2C1);
+  return i2c1_sm.nacked;
+}
@@ -0,0 +1,304 @@
+/**
+ * @file led_effects.c
+ * @author Shambaditya Tarafder
+ * @date   11/24/2021
+ * @brief  Fade, breathe and blink effects of the RGB LEDs streamed by the LDMA
+ *         into the PWM compare buffers so that they run with the core asleep
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "led_effects.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+
+/* Effect shapes, one period of LED_EFFECT_STEPS samples scaled 0 to 255 */
+static const uint8_t fade_shape[LED_EFFECT_STEPS] = {
+      0,   8,  16,  24,  32,  40,  48,  56,  64,  72,  80,  88,  96, 104, 112, 120,
+    128, 135, 143, 151, 159, 167, 175, 183, 191, 199, 207, 215, 223, 231, 239, 247,
+    255, 247, 239, 231, 223, 215, 207, 199, 191, 183, 175, 167, 159, 151, 143, 135,
+    128, 120, 112, 104,  96,  88,  80,  72,  64,  56,  48,  40,  32,  24,  16,   8,
+};
+
+static const uint8_t breathe_shape[LED_EFFECT_STEPS] = {
+      0,   0,   1,   2,   3,   5,   7,  10,  14,  18,  22,  28,  34,  41,  49,  58,
+     69,  80,  92, 105, 119, 134, 149, 165, 180, 195, 209, 222, 233, 243, 249, 254,
+    255, 254, 249, 243, 233, 222, 209, 195, 180, 165, 149, 134, 119, 105,  92,  80,
+     69,  58,  49,  41,  34,  28,  22,  18,  14,  10,   7,   5,   3,   2,   1,   0,
+};
+
+/* Compare values streamed into CC[ch].CCVB, one table per color channel */
+static uint32_t effect_table[RGB_PWM_CHANNELS][LED_EFFECT_STEPS];
+static LDMA_Descriptor_t effect_desc[RGB_PWM_CHANNELS];
+static uint32_t effect_active;
+static uint32_t effect_period_ms;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static uint32_t led_effect_shape(uint32_t effect, uint32_t step);
+static void led_effect_build(uint32_t effect, const uint8_t *color);
+static void led_effect_step_timer(uint32_t period_ms);
+static void led_effect_clock_update(uint32_t hfper_freq);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Sets up the LDMA and the step TIMER used by the LED effect engine
+ *
+ * @details
+ *   Each color channel gets an LDMA descriptor that links to itself, so once
+ *   started it walks its waveform table forever.  Each overflow of
+ *   RGB_EFFECT_TIMER requests one word per channel, moving every color one
+ *   sample forward in lock step.
+ *
+ * @note
+ *   rgb_pwm_open() must be called first, the effects are written into its
+ *   compare buffers.
+ *
+ ******************************************************************************/
+
+void led_effect_open(void){
+  LDMA_Init_t ldma_init = LDMA_INIT_DEFAULT;
+  TIMER_Init_TypeDef step_timer_init = TIMER_INIT_DEFAULT;
+
+  // Hold the clocks only while configuring, they are requested again while
+  // an effect runs
+  cmu_clock_request(cmuClock_LDMA, CMU_OWNER_LED_EFFECT);
+  cmu_clock_request(RGB_EFFECT_CLOCK, CMU_OWNER_LED_EFFECT);
+  LDMA_Init(&ldma_init);
+
+  for(uint32_t ch = 0; ch < RGB_PWM_CHANNELS; ch++){
+      effect_desc[ch].xfer.structType = ldmaCtrlStructTypeXfer;
+      effect_desc[ch].xfer.structReq = 0;
+      effect_desc[ch].xfer.xferCnt = LED_EFFECT_STEPS - 1;
+      effect_desc[ch].xfer.byteSwap = 0;
+      effect_desc[ch].xfer.blockSize = ldmaCtrlBlockSizeUnit1;
+      effect_desc[ch].xfer.doneIfs = 0;
+      effect_desc[ch].xfer.reqMode = ldmaCtrlReqModeBlock;
+      effect_desc[ch].xfer.decLoopCnt = 0;
+      effect_desc[ch].xfer.ignoreSrec = 0;
+      effect_desc[ch].xfer.srcInc = ldmaCtrlSrcIncOne;
+      effect_desc[ch].xfer.size = ldmaCtrlSizeWord;
+      effect_desc[ch].xfer.dstInc = ldmaCtrlDstIncNone;
+      effect_desc[ch].xfer.srcAddrMode = ldmaCtrlSrcAddrModeAbs;
+      effect_desc[ch].xfer.dstAddrMode = ldmaCtrlDstAddrModeAbs;
+      effect_desc[ch].xfer.srcAddr = (uint32_t)effect_table[ch];
+      effect_desc[ch].xfer.dstAddr = (uint32_t)&RGB_PWM_TIMER->CC[ch].CCVB;
+      effect_desc[ch].xfer.linkMode = ldmaLinkModeRel;
+      effect_desc[ch].xfer.link = 1;
+      effect_desc[ch].xfer.linkAddr = 0;          // Relative link of 0, loop on itself
+  }
+
+  step_timer_init.enable = false;
+  step_timer_init.debugRun = false;
+  step_timer_init.prescale = LED_EFFECT_PRESCALE;
+  // The UFOF request stays up until cleared, the channels taking it have to
+  // clear it or they free-run through their tables
+  step_timer_init.dmaClrAct = true;
+  TIMER_Init(RGB_EFFECT_TIMER, &step_timer_init);
+
+  cmu_clock_release(RGB_EFFECT_CLOCK, CMU_OWNER_LED_EFFECT);
+  cmu_clock_release(cmuClock_LDMA, CMU_OWNER_LED_EFFECT);
+  effect_active = LED_EFFECT_NONE;
+
+  cmu_hf_notify_register(led_effect_clock_update);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Starts an effect on the selected LEDs in a single call
+ *
+ * @details
+ *   The effect shape is multiplied by the requested color and passed through
+ *   the PWM driver's gamma and brightness scaling once, here, into the
+ *   waveform tables.  From then on the step TIMER and LDMA update the duty
+ *   cycles with no CPU involvement and no interrupts, until the effect is
+ *   stopped or replaced.
+ *
+ * @note
+ *   The effect owns the PWM TIMER until led_effect_stop(), rgb_pwm_set()
+ *   asserts meanwhile.  A color set before or the framebuffer has to be
+ *   turned off first, rgb_pwm_stream() asserts otherwise.
+ *
+ * @param[in] leds
+ *   Bit mask of RGB_LED_0 to RGB_LED_3 to animate
+ *
+ * @param[in] effect
+ *   LED_EFFECT_FADE, LED_EFFECT_BREATHE or LED_EFFECT_BLINK
+ *
+ * @param[in] period_ms
+ *   Duration of one effect period in milliseconds, at least LED_EFFECT_MIN_MS
+ *
+ * @param[in] red
+ *   Peak red level, 0 to 255
+ *
+ * @param[in] green
+ *   Peak green level, 0 to 255
+ *
+ * @param[in] blue
+ *   Peak blue level, 0 to 255
+ *
+ ******************************************************************************/
+
+void led_effect_start(uint32_t leds, uint32_t effect, uint32_t period_ms, uint8_t red, uint8_t green, uint8_t blue){
+  LDMA_TransferCfg_t effect_cfg = LDMA_TRANSFER_CFG_PERIPHERAL(RGB_EFFECT_DMA_SIGNAL);
+  uint8_t color[RGB_PWM_CHANNELS];
+
+  EFM_ASSERT((effect > LED_EFFECT_NONE) && (effect <= LED_EFFECT_BLINK));
+  EFM_ASSERT(period_ms >= LED_EFFECT_MIN_MS);
+
+  led_effect_stop();
+
+  color[RGB_RED_CH] = red;
+  color[RGB_GREEN_CH] = green;
+  color[RGB_BLUE_CH] = blue;
+  led_effect_build(effect, color);
+
+  cmu_clock_request(cmuClock_LDMA, CMU_OWNER_LED_EFFECT);
+  cmu_clock_request(RGB_EFFECT_CLOCK, CMU_OWNER_LED_EFFECT);
+  rgb_pwm_stream(RGB_PWM_OWNER_EFFECT, leds);
+
+  for(uint32_t ch = 0; ch < RGB_PWM_CHANNELS; ch++){
+      TIMER_CompareBufSet(RGB_PWM_TIMER, ch, effect_table[ch][0]);
+      LDMA_StartTransfer(LED_EFFECT_DMA_CH + ch, &effect_cfg, &effect_desc[ch]);
+  }
+
+  led_effect_step_timer(period_ms);
+  effect_period_ms = period_ms;
+  effect_active = effect;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stops the running effect and turns the LEDs off
+ *
+ ******************************************************************************/
+
+void led_effect_stop(void){
+  if(effect_active == LED_EFFECT_NONE){
+      return;
+  }
+  TIMER_Enable(RGB_EFFECT_TIMER, false);
+  for(uint32_t ch = 0; ch < RGB_PWM_CHANNELS; ch++){
+      LDMA_StopTransfer(LED_EFFECT_DMA_CH + ch);
+  }
+  rgb_pwm_stream(RGB_PWM_OWNER_EFFECT, NO_LEDS);
+  cmu_clock_release(RGB_EFFECT_CLOCK, CMU_OWNER_LED_EFFECT);
+  cmu_clock_release(cmuClock_LDMA, CMU_OWNER_LED_EFFECT);
+  effect_active = LED_EFFECT_NONE;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Returns the effect currently running
+ *
+ * @return
+ *   One of the LED_EFFECT_ defines, LED_EFFECT_NONE when idle
+ *
+ ******************************************************************************/
+
+uint32_t led_effect_active(void){
+  return effect_active;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Returns the level of an effect shape at a given step
+ *
+ * @param[in] effect
+ *   The effect whose shape is sampled
+ *
+ * @param[in] step
+ *   Sample index, 0 to LED_EFFECT_STEPS - 1
+ *
+ * @return
+ *   Shape level, 0 to 255
+ *
+ ******************************************************************************/
+
+static uint32_t led_effect_shape(uint32_t effect, uint32_t step){
+  switch(effect){
+    case LED_EFFECT_FADE:
+      return fade_shape[step];
+    case LED_EFFECT_BREATHE:
+      return breathe_shape[step];
+    case LED_EFFECT_BLINK:
+      return (step < LED_EFFECT_STEPS / 2) ? RGB_PWM_BRIGHT_MAX : 0;
+    default:
+      EFM_ASSERT(false);
+      return 0;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Precomputes the compare value waveform of every color channel
+ *
+ * @param[in] effect
+ *   The effect to build
+ *
+ * @param[in] color
+ *   Peak level of each color channel
+ *
+ ******************************************************************************/
+
+static void led_effect_build(uint32_t effect, const uint8_t *color){
+  for(uint32_t step = 0; step < LED_EFFECT_STEPS; step++){
+      uint32_t shape = led_effect_shape(effect, step);
+      for(uint32_t ch = 0; ch < RGB_PWM_CHANNELS; ch++){
+          effect_table[ch][step] = rgb_pwm_duty((uint8_t)((color[ch] * shape) / RGB_PWM_BRIGHT_MAX));
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Programs and starts the TIMER whose overflows pace the waveform samples
+ *
+ * @param[in] period_ms
+ *   Duration of one effect period in milliseconds
+ *
+ ******************************************************************************/
+
+static void led_effect_step_timer(uint32_t period_ms){
+  uint32_t tick_freq = CMU_ClockFreqGet(cmuClock_HFPER) / LED_EFFECT_PRESCALE_DIV;
+  uint32_t step_ticks = (uint32_t)(((uint64_t)tick_freq * period_ms) / (1000 * LED_EFFECT_STEPS));
+
+  EFM_ASSERT(step_ticks > 0);
+  TIMER_CounterSet(RGB_EFFECT_TIMER, 0);
+  TIMER_TopSet(RGB_EFFECT_TIMER, step_ticks - 1);
+  TIMER_Enable(RGB_EFFECT_TIMER, true);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Keeps a running effect at its period after an HF clock change
+ *
+ * @param[in] hfper_freq
+ *   The new HFPERCLK frequency in Hz, read again by led_effect_step_timer()
+ *
+ ******************************************************************************/
+
+static void led_effect_clock_update(uint32_t hfper_freq){
+  (void)hfper_freq;
+  if(effect_active != LED_EFFECT_NONE){
+      led_effect_step_timer(effect_period_ms);
+  }
+}
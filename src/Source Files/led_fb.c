@@ -0,0 +1,251 @@
+/**
+ * @file led_fb.c
+ * @author Shambaditya Tarafder
+ * @date   11/27/2021
+ * @brief  Color framebuffer of the four Thunderboard RGB LEDs, refreshed by
+ *         time multiplexing their enable lines from the PWM TIMER interrupt
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "led_fb.h"
+#include "profiler.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+
+/* Colors as written by the application */
+static uint8_t  fb_color[RGB_LED_COUNT][RGB_PWM_CHANNELS];
+
+/* Compare values of each LED, double buffered so that frames change atomically */
+static uint32_t fb_duty[LED_FB_BUFFERS][RGB_LED_COUNT][RGB_PWM_CHANNELS];
+static uint32_t fb_select[RGB_LED_COUNT];
+
+static volatile uint32_t fb_front;
+static volatile bool     fb_swap_pending;
+static uint32_t          fb_slot;
+static bool              fb_running;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static void led_fb_load(uint32_t led);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Sets up the LED framebuffer
+ *
+ * @details
+ *   Clears both buffers and precomputes the RGB_SELECT_PORT mask of each LED
+ *   so that the refresh interrupt only performs one masked port write.
+ *
+ * @note
+ *   rgb_pwm_open() must be called first, the framebuffer is shown through
+ *   the PWM TIMER.
+ *
+ ******************************************************************************/
+
+void led_fb_open(void){
+  for(uint32_t led = 0; led < RGB_LED_COUNT; led++){
+      fb_select[led] = rgb_select_mask(RGB_LED_0 << led);
+      for(uint32_t ch = 0; ch < RGB_PWM_CHANNELS; ch++){
+          fb_color[led][ch] = 0;
+          fb_duty[0][led][ch] = 0;
+          fb_duty[1][led][ch] = 0;
+      }
+  }
+  fb_front = 0;
+  fb_swap_pending = false;
+  fb_slot = 0;
+  fb_running = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Writes the color of one LED into the framebuffer
+ *
+ * @details
+ *   The change is not shown until led_fb_commit() is called, so several LEDs
+ *   can be changed and appear together.
+ *
+ * @param[in] led
+ *   LED index, 0 to RGB_LED_COUNT - 1
+ *
+ * @param[in] red
+ *   Red level, 0 to 255
+ *
+ * @param[in] green
+ *   Green level, 0 to 255
+ *
+ * @param[in] blue
+ *   Blue level, 0 to 255
+ *
+ ******************************************************************************/
+
+void led_fb_set(uint32_t led, uint8_t red, uint8_t green, uint8_t blue){
+  EFM_ASSERT(led < RGB_LED_COUNT);
+  fb_color[led][RGB_RED_CH] = red;
+  fb_color[led][RGB_GREEN_CH] = green;
+  fb_color[led][RGB_BLUE_CH] = blue;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Writes the same color to every LED of the framebuffer
+ *
+ * @param[in] red
+ *   Red level, 0 to 255
+ *
+ * @param[in] green
+ *   Green level, 0 to 255
+ *
+ * @param[in] blue
+ *   Blue level, 0 to 255
+ *
+ ******************************************************************************/
+
+void led_fb_fill(uint8_t red, uint8_t green, uint8_t blue){
+  for(uint32_t led = 0; led < RGB_LED_COUNT; led++){
+      led_fb_set(led, red, green, blue);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Publishes the framebuffer to the display
+ *
+ * @details
+ *   The colors are converted to compare values in the back buffer, and the
+ *   refresh interrupt swaps it in at the start of the next frame so that a
+ *   partially updated set of LEDs is never shown.
+ *
+ * @note
+ *   The conversion runs inside a critical section so the interrupt cannot
+ *   swap a half written back buffer; it is twelve table lookups.
+ *
+ ******************************************************************************/
+
+void led_fb_commit(void){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  uint32_t back = fb_front ^ 1;
+  for(uint32_t led = 0; led < RGB_LED_COUNT; led++){
+      for(uint32_t ch = 0; ch < RGB_PWM_CHANNELS; ch++){
+          fb_duty[back][led][ch] = rgb_pwm_duty(fb_color[led][ch]);
+      }
+  }
+  fb_swap_pending = true;
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Starts refreshing the LEDs from the framebuffer
+ *
+ * @details
+ *   Any running LED effect is stopped.  The PWM TIMER overflow interrupt is
+ *   enabled and each PWM period shows the next LED, giving every LED one
+ *   quarter of the time at a frame rate of a quarter of the PWM frequency.
+ *
+ * @note
+ *   The framebuffer owns the PWM TIMER until led_fb_stop().  A color set
+ *   with rgb_pwm_set() has to be turned off first, rgb_pwm_stream()
+ *   asserts otherwise.
+ *
+ ******************************************************************************/
+
+void led_fb_start(void){
+  if(fb_running){
+      return;
+  }
+  led_effect_stop();
+  led_fb_commit();
+
+  fb_slot = 0;
+  rgb_pwm_stream(RGB_PWM_OWNER_FB, RGB_LED_0);
+  led_fb_load(fb_slot);
+
+  TIMER_IntClear(RGB_PWM_TIMER, TIMER_IF_OF);
+  TIMER_IntEnable(RGB_PWM_TIMER, TIMER_IEN_OF);
+  NVIC_EnableIRQ(RGB_PWM_IRQn);
+  fb_running = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stops the framebuffer refresh and turns the LEDs off
+ *
+ ******************************************************************************/
+
+void led_fb_stop(void){
+  if(!fb_running){
+      return;
+  }
+  NVIC_DisableIRQ(RGB_PWM_IRQn);
+  TIMER_IntDisable(RGB_PWM_TIMER, TIMER_IEN_OF);
+  rgb_pwm_stream(RGB_PWM_OWNER_FB, NO_LEDS);
+  GPIO_PortOutClear(RGB_SELECT_PORT, RGB_SELECT_ALL_MASK);
+  fb_running = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Refresh interrupt of the LED framebuffer
+ *
+ * @details
+ *   At each overflow the compare values written during the previous period
+ *   have just been latched, so the enable line of that LED is switched on
+ *   with a single masked port write and the next LED's values are loaded into
+ *   the compare buffers.  A pending commit is swapped in at the frame start.
+ *
+ ******************************************************************************/
+
+void TIMER1_IRQHandler(void){
+  PROFILER_IRQ_ENTER(TIMER1_IRQn);
+  uint32_t int_flag = RGB_PWM_TIMER->IF & RGB_PWM_TIMER->IEN;
+  RGB_PWM_TIMER->IFC = int_flag;
+
+  if(int_flag & TIMER_IF_OF){
+      GPIO_PortOutSetVal(RGB_SELECT_PORT, fb_select[fb_slot], RGB_SELECT_ALL_MASK);
+      fb_slot = (fb_slot + 1) % RGB_LED_COUNT;
+      if((fb_slot == 0) && fb_swap_pending){
+          fb_front ^= 1;
+          fb_swap_pending = false;
+      }
+      led_fb_load(fb_slot);
+  }
+  PROFILER_IRQ_EXIT();
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Loads the compare buffers with the colors of one LED
+ *
+ * @param[in] led
+ *   LED index, 0 to RGB_LED_COUNT - 1
+ *
+ ******************************************************************************/
+
+static void led_fb_load(uint32_t led){
+  const uint32_t *duty = fb_duty[fb_front][led];
+
+  RGB_PWM_TIMER->CC[RGB_RED_CH].CCVB = duty[RGB_RED_CH];
+  RGB_PWM_TIMER->CC[RGB_GREEN_CH].CCVB = duty[RGB_GREEN_CH];
+  RGB_PWM_TIMER->CC[RGB_BLUE_CH].CCVB = duty[RGB_BLUE_CH];
+}
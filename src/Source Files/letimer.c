@@ -11,6 +11,8 @@
 // Include files
 //***********************************************************************************
 #include "letimer.h"
+#include "profiler.h"
+#include "recorder.h"
 
 //***********************************************************************************
 // defined files
@@ -53,17 +55,12 @@ static uint32_t scheduled_uf_cb;
  *   Pointer to the base peripheral address of the LETIMER peripheral being opened
  *
  * @param[in] app_letimer_struct
- *   Is the STRUCT that the calling routine will use to set the parameters for PWM
- *   operation
+ *   Is the const table of the calling routine with the parameters for PWM
+ *   operation, already in register values, written as they are
  *
  ******************************************************************************/
 
-void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_letimer_struct){
-	LETIMER_Init_TypeDef letimer_pwm_values;
-
-	unsigned int period_cnt;
-	unsigned int period_active_cnt;
-
+void letimer_pwm_open(LETIMER_TypeDef *letimer, const APP_LETIMER_PWM_TypeDef *app_letimer_struct){
 	/*  Initializing LETIMER for PWM mode */
 	/*  Enable the routed clock to the LETIMER0 peripheral */
 
@@ -76,15 +73,17 @@ void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_let
    * use a while SYNCBUSY loop to verify that the write of the register has propagated
    * into the low frequency domain before reading it. */
    if(letimer == LETIMER0){
-       CMU_ClockEnable(cmuClock_LETIMER0, true);
+       cmu_clock_request(cmuClock_LETIMER0, CMU_OWNER_LETIMER);
    }
    letimer_start(letimer, false);
 
+   // Only CMD is synchronized on this LETIMER, and it has no FREEZE to batch
+   // it with.  Each wait below is for a read or write that depends on the
+   // last command having landed, a few ULFRCO cycles of ms each.
    letimer->CMD = LETIMER_CMD_START;
    while(letimer->SYNCBUSY);
    EFM_ASSERT(letimer->STATUS & LETIMER_STATUS_RUNNING);
    letimer->CMD = LETIMER_CMD_STOP;
-   while(letimer->SYNCBUSY);
 
 
 
@@ -96,37 +95,17 @@ void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_let
 	// will happen quickly upon enabling the LETIMER loading the desired top count from
 	// the COMP0 register.
 
-  // Reset the Counter to a know value such as 0
+  // Reset the Counter to a know value such as 0, once it has stopped
+  while(letimer->SYNCBUSY);
   letimer->CNT = 0; // What is the register enumeration to use to specify the LETIMER Counter Register?
 
-  // Initialize letimer for PWM operation
-  // XXX are values passed into the driver via the input app_letimer_struct
-  // ZZZ are values that you must specify for this PWM specific driver from the online HAL documentation
-	letimer_pwm_values.bufTop = false;		// Comp1 will not be used to load comp0, but used to create an on-time/duty cycle
-	letimer_pwm_values.comp0Top = true;		// load comp0 into cnt register when count register underflows enabling continuous looping
-	letimer_pwm_values.debugRun = app_letimer_struct->debugRun;
-	letimer_pwm_values.enable = app_letimer_struct->enable;
-	letimer_pwm_values.out0Pol = 0;			// While PWM is not active out, idle is DEASSERTED, 0
-	letimer_pwm_values.out1Pol = 0;			// While PWM is not active out, idle is DEASSERTED, 0
-	letimer_pwm_values.repMode = letimerRepeatFree;	// Setup letimer for free running for continuous looping
-	letimer_pwm_values.ufoa0 = letimerUFOAPwm ;		// Using the HAL documentation, set to PWM mode
-	letimer_pwm_values.ufoa1 = letimerUFOAPwm ;		// Using the HAL documentation, set to PWM mode
-
-	LETIMER_Init(letimer, &letimer_pwm_values);		// Initialize letimer
+  // Initialize letimer for PWM operation, LETIMER_PWM_INIT() of the table
+	LETIMER_Init(letimer, &app_letimer_struct->init);		// Initialize letimer
 
-	while(letimer->SYNCBUSY);
+  /* COMP0 and COMP1 were computed into the table at compile time */
 
-	period_cnt = app_letimer_struct->period * LETIMER_HZ;
-	period_active_cnt = app_letimer_struct->active_period * LETIMER_HZ;
-
-
-
-  /* Calculate the value of COMP0 and COMP1 and load these control registers
-   * with the calculated values
-   */
-
-	LETIMER_CompareSet(letimer, 0, period_cnt);				    // comp0 register is PWM period
-	LETIMER_CompareSet(letimer, 1, period_active_cnt);		// comp1 register is PWM active period
+	LETIMER_CompareSet(letimer, 0, app_letimer_struct->period);				    // comp0 register is PWM period
+	LETIMER_CompareSet(letimer, 1, app_letimer_struct->active_period);		// comp1 register is PWM active period
 
   /* Set the REP0 mode bits for PWM operation directly since this driver is PWM specific.
    * Datasheets are very specific and must be read very carefully to implement correct functionality.
@@ -139,12 +118,11 @@ void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_let
 	 letimer->REP0 = 011;
 	 letimer->REP1 = 011;
 
-	 letimer->ROUTELOC0 = app_letimer_struct->out_pin_route0 | app_letimer_struct->out_pin_route1;
-	 letimer->ROUTEPEN = (LETIMER_ROUTEPEN_OUT0PEN*app_letimer_struct->out_pin_0_en) | (LETIMER_ROUTEPEN_OUT1PEN*app_letimer_struct->out_pin_1_en);
+	 letimer->ROUTELOC0 = app_letimer_struct->routeloc0;
+	 letimer->ROUTEPEN = app_letimer_struct->routepen;
 
    LETIMER_IntClear(letimer,LETIMER0->IF); //Clearing out the registers first as stated
-   LETIMER_IntEnable(letimer, (LETIMER_IEN_UF * (app_letimer_struct->uf_irq_enable)) | (LETIMER_IEN_COMP0 * (app_letimer_struct->comp0_irq_enable))
-                     |(LETIMER_IEN_COMP1 * (app_letimer_struct->comp1_irq_enable))); //Enabling the registers
+   LETIMER_IntEnable(letimer, app_letimer_struct->ien); //Enabling the registers
    NVIC_EnableIRQ(LETIMER0_IRQn);
 
 
@@ -157,6 +135,7 @@ void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_let
    scheduled_comp1_cb = app_letimer_struct->comp1_cb;
    scheduled_uf_cb = app_letimer_struct->uf_cb;
 
+   while(letimer->SYNCBUSY);
    if (LETIMER_STATUS_RUNNING & letimer->STATUS) {
          sleep_block_mode(LETIMER_EM);
      }
@@ -190,6 +169,10 @@ void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_let
  *   This function should only be called to enable/turn-on the LETIMER once the
  *   LETIMER peripheral has been completely configured via its open driver
  *
+ *   Waits for a command still under way before reading STATUS, but not for
+ *   its own, so the caller goes on while the start or stop synchronizes.
+ *   CMD is only written when the state changes.
+ *
  * @param[in] letimer
  *   Pointer to the base peripheral address of the LETIMER peripheral being opened
  *
@@ -201,16 +184,18 @@ void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_let
 
 
 void letimer_start(LETIMER_TypeDef *letimer, bool enable){
+  bool running;
 
-  LETIMER_Enable(letimer, true);
+  while(letimer->SYNCBUSY);
+  running = letimer->STATUS & LETIMER_STATUS_RUNNING;
 
-  if(enable & !(letimer->STATUS & LETIMER_STATUS_RUNNING)){
+  if(enable && !running){
     sleep_block_mode(LETIMER_EM);
-    while(letimer->SYNCBUSY);
+    LETIMER_Enable(letimer, true);
   }
-  else if((letimer->STATUS & LETIMER_STATUS_RUNNING) & (!enable)){
+  else if(running && !enable){
     sleep_unblock_mode(LETIMER_EM);
-    while(letimer->SYNCBUSY);
+    LETIMER_Enable(letimer, false);
   }
 
 }
@@ -237,7 +222,10 @@ void letimer_start(LETIMER_TypeDef *letimer, bool enable){
 void LETIMER0_IRQHandler(void){
   uint32_t int_flag;
 
+  PROFILER_IRQ_ENTER(LETIMER0_IRQn);
+
   int_flag = LETIMER0->IF & LETIMER0->IEN;
+  RECORD(RECORDER_LETIMER, int_flag);
 
   LETIMER0->IFC = int_flag;
 
@@ -253,5 +241,5 @@ void LETIMER0_IRQHandler(void){
         add_scheduled_event(scheduled_uf_cb);
         EFM_ASSERT(!(LETIMER0->IF&LETIMER_IF_UF));
     }
-
+  PROFILER_IRQ_EXIT();
 }
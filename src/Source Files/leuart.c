@@ -20,6 +20,9 @@
 //** Developer/user include files
 #include "leuart.h"
 #include "scheduler.h"
+#include "profiler.h"
+#include "task.h"
+#include "recorder.h"
 
 //***********************************************************************************
 // defined files
@@ -47,6 +50,8 @@ typedef enum {
 
 static LEUART_STATE_MACHINE leuart_state;
 static RX_LEUART_STATE_MACHINE leuart_rx_state;
+static TASK test_task;
+static LEUART_SHADOW leuart_shadow;
 
 /***************************************************************************//**
  * @brief LEUART driver
@@ -69,6 +74,8 @@ static void leuart_txc(LEUART_STATE_MACHINE *leuart_state);
 static void leuart_startf(RX_LEUART_STATE_MACHINE *leuart_state);
 static void leuart_rxdatav(RX_LEUART_STATE_MACHINE *leuart_state);
 static void leuart_sigf(RX_LEUART_STATE_MACHINE *leuart_state);
+static void leuart_rx_byte(RX_LEUART_STATE_MACHINE *leuart_state);
+static TASK_STATUS leuart_test_task(TASK *task);
 
 //***********************************************************************************
 // Global functions
@@ -85,64 +92,86 @@ static void leuart_sigf(RX_LEUART_STATE_MACHINE *leuart_state);
  * @note
  *   This function is just for setting up the structs etc. not operating on it
  *
+ *   Everything after LEUART_Init() is written in one leuart_freeze() batch,
+ *   so the setup costs three synchronizations, the clock check, the init
+ *   and the batch, instead of one per register.
  *
  * @param[in] leuart
  *   It is pointing address of the leuart peripheral being used.
  *
  * @param[in] leuart_settings
- *   It is the data structure that will be used for modification etc.
+ *   The const table of the device on the bus, already in register values
  *
+ * @param[in] tx_event
+ *   Event scheduled once a string has gone out
+ *
+ * @param[in] rx_event
+ *   Event scheduled once a frame has come in
+ *
+ * @param[in] self_test
+ *   Runs the loopback self test
  *
  ******************************************************************************/
 
-void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings){
-
-  LEUART_Init_TypeDef leuart_init;
-
+void leuart_open(LEUART_TypeDef *leuart, const LEUART_OPEN_STRUCT *leuart_settings, uint32_t tx_event,
+                 uint32_t rx_event, bool self_test){
 
   if(leuart == LEUART0) {
-      CMU_ClockEnable(cmuClock_LEUART0, true);
+      cmu_clock_request(cmuClock_LEUART0, CMU_OWNER_LEUART);
     } else {
       EFM_ASSERT(false);
     }
 
   if(!(leuart->STARTFRAME & 0x01)){
       leuart->STARTFRAME = 0x01;
-      while(leuart->SYNCBUSY);
+      leuart_sync(leuart, LEUART_SYNCBUSY_STARTFRAME);
       EFM_ASSERT(leuart->STARTFRAME & 0x01);
       leuart->STARTFRAME = 0x00;
-      while(leuart->SYNCBUSY);
     }
 
-  leuart_init.baudrate = leuart_settings->baudrate;
-  leuart_init.databits = leuart_settings->databits;
-  leuart_init.parity = leuart_settings->parity;
-  leuart_init.refFreq = false;
-  leuart_init.stopbits = leuart_settings->stopbits;
-  leuart_init.enable = leuart_settings->enable;
-  tx_done_evt = leuart_settings->tx_done_evt;
-  rx_done_evt = leuart_settings->rx_done_evt;
+  tx_done_evt = tx_event;
+  rx_done_evt = rx_event;
 
-  LEUART_Init(leuart, &leuart_init);
-  while(leuart->SYNCBUSY);
+  LEUART_Init(leuart, &leuart_settings->init);
 
-  leuart->ROUTELOC0 = leuart_settings->rx_loc | leuart_settings->tx_loc;
-  leuart->ROUTEPEN = (leuart_settings->rx_pin_en*leuart_settings->rx_en) | (leuart_settings->tx_pin_en*leuart_settings->tx_en);
+  leuart_freeze(leuart);
+  leuart->ROUTELOC0 = leuart_settings->routeloc0;
+  leuart->ROUTEPEN = leuart_settings->routepen;
 
-  leuart->CMD = LEUART_CMD_CLEARTX | LEUART_CMD_CLEARRX;
+  leuart_cmd_write(leuart, LEUART_CMD_CLEARTX | LEUART_CMD_CLEARRX);
+  if(leuart_settings->tx_en){
+    leuart_cmd_write(leuart, LEUART_CMD_TXEN);
+  }
+  if(leuart_settings->rx_en){
+      leuart_cmd_write(leuart, LEUART_CMD_RXEN);
+  }
 
-  while(leuart->SYNCBUSY);
+  //week's checkpoint
+  leuart_rx_state.leuart = leuart;
+  leuart_rx_state.callback = rx_done_evt;
+  leuart_rx_state.length = ZERO;
+  leuart_rx_state.state = STARTFRAME;
+  pool_free(leuart_rx_state.string);
+  leuart_rx_state.string = NULL;
 
-  LEUART_Enable(leuart, leuart_settings->enable);
-  while(leuart->SYNCBUSY);
+  leuart_rx_state.leuart->STARTFRAME = leuart_settings->startframe;
+  leuart_rx_state.leuart->SIGFRAME = leuart_settings->sigframe;
+
+  //Enabling the interrupts
+  leuart_rx_state.leuart->IEN |= LEUART_IEN_STARTF;
+//  leuart_rx_state.leuart->IEN |= LEUART_IEN_SIGF;
+//  leuart_rx_state.leuart->IEN |= LEUART_IEN_RXDATAV;
 
+  leuart_ctrl_write(leuart, LEUART_CTRL_SFUBRX, 0);
+  leuart_cmd_write(leuart, LEUART_CMD_RXBLOCKEN);
+  leuart_commit(leuart);
+
+  // The enables are the only writes read back
   if(leuart_settings->tx_en){
-    leuart->CMD = LEUART_CMD_TXEN;
     while(!(leuart->STATUS & LEUART_STATUS_TXENS));
     EFM_ASSERT(leuart->STATUS & LEUART_STATUS_TXENS);
   }
   if(leuart_settings->rx_en){
-      leuart->CMD = LEUART_CMD_RXEN;
       while(!(leuart->STATUS & LEUART_STATUS_RXENS));
       EFM_ASSERT(leuart->STATUS & LEUART_STATUS_RXENS);
   }
@@ -153,26 +182,10 @@ void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings){
     else {
       EFM_ASSERT(false);
     }
-  //week's checkpoint
-  leuart_rx_state.leuart = leuart;
-  leuart_rx_state.callback = rx_done_evt;
-  leuart_rx_state.length = ZERO;
-  leuart_rx_state.state = STARTFRAME;
-
-  leuart_rx_state.leuart->STARTFRAME = '#';
-  leuart_rx_state.leuart->SIGFRAME = '!';
-
-  //Enabling the interrupts
-  leuart_rx_state.leuart->IEN |= LEUART_IEN_STARTF;
-//  leuart_rx_state.leuart->IEN |= LEUART_IEN_SIGF;
-//  leuart_rx_state.leuart->IEN |= LEUART_IEN_RXDATAV;
-
-  leuart->CTRL |= LEUART_CTRL_SFUBRX;
-  while(leuart->SYNCBUSY);
-  leuart->CMD = LEUART_CMD_RXBLOCKEN;
-  while(leuart->SYNCBUSY);
 
-  leuart_test();
+  if(self_test){
+      leuart_test();
+  }
 
 
 
@@ -192,6 +205,7 @@ void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings){
  ******************************************************************************/
 
 void LEUART0_IRQHandler(void){
+  PROFILER_IRQ_ENTER(LEUART0_IRQn);
   int int_flag = LEUART0->IF & LEUART0->IEN;
     LEUART0->IFC = int_flag;
 
@@ -210,6 +224,7 @@ void LEUART0_IRQHandler(void){
     if(int_flag & LEUART_IF_SIGF){
         leuart_sigf(&leuart_rx_state);
       }
+    PROFILER_IRQ_EXIT();
 }
 
 /***************************************************************************//**
@@ -241,7 +256,7 @@ static void leuart_txbl(LEUART_STATE_MACHINE *leuart_state){
       if (leuart_state->count == leuart_state->length) {
         leuart_state->leuart->IEN &= ~LEUART_IF_TXBL;
         leuart_state->leuart->IFC = LEUART_IFC_TXC;
-        leuart_state->leuart->IEN = LEUART_IEN_TXC;
+        leuart_state->leuart->IEN |= LEUART_IEN_TXC;
         leuart_state->state = END_TRANSMIT;
       }
       break;
@@ -282,6 +297,8 @@ static void leuart_txc(LEUART_STATE_MACHINE *leuart_state){
       break;
     case END_TRANSMIT:
       leuart_state->leuart->IEN &= ~LEUART_IEN_TXC;
+      pool_free(leuart_state->string);
+      leuart_state->string = NULL;
       add_scheduled_event(leuart_state->callback);
       sleep_unblock_mode(LEUART_TX_EM);
       leuart_state->busy = false;
@@ -300,14 +317,16 @@ static void leuart_startf(RX_LEUART_STATE_MACHINE *leuart_state){
 
       leuart_state->state = RECEIVE;
 
+      // A frame leuart_rx_copy() has not taken is written over
+      if(!leuart_state->string){
+          leuart_state->string = pool_alloc(LEUART_RX_SIZE);
+      }
       leuart_state->length = 0;
 
-      leuart_state->string[leuart_state->length] = leuart_state->leuart->RXDATA;
-
-      leuart_state->length++;
+      leuart_rx_byte(leuart_state);
 
       leuart_state->leuart->IEN |= LEUART_IEN_SIGF;
-      leuart_state->leuart->CMD = LEUART_CMD_RXBLOCKDIS;
+      leuart_cmd_write(leuart_state->leuart, LEUART_CMD_RXBLOCKDIS);
       leuart_state->leuart->IEN |= LEUART_IEN_RXDATAV;
     break;
     }
@@ -334,8 +353,7 @@ static void leuart_rxdatav(RX_LEUART_STATE_MACHINE *leuart_state){
     break;
     }
     case RECEIVE:{
-      leuart_state->string[leuart_state->length] = leuart_state->leuart->RXDATA;
-      leuart_state->length++;
+      leuart_rx_byte(leuart_state);
     break;
     }
     case SIGFRAME:{
@@ -361,11 +379,14 @@ static void leuart_sigf(RX_LEUART_STATE_MACHINE *leuart_state){
       leuart_state->state = SIGFRAME;
       leuart_state->leuart->IEN &= ~LEUART_IEN_SIGF;
       leuart_state->leuart->IEN &= ~LEUART_IEN_RXDATAV;
-      leuart_state->leuart->CMD = LEUART_CMD_RXBLOCKEN;
-      leuart_state->string[leuart_state->length] = '\0';
-      leuart_state->length++;
+      leuart_cmd_write(leuart_state->leuart, LEUART_CMD_RXBLOCKEN);
       leuart_state->state = STARTFRAME;
-      add_scheduled_event(rx_done_evt);
+      // Without a block the frame is dropped, pool_report() counts it as failed
+      if(leuart_state->string){
+          leuart_state->string[leuart_state->length] = '\0';
+          leuart_state->length++;
+          add_scheduled_event(rx_done_evt);
+      }
     break;
     }
     case SIGFRAME:{
@@ -379,7 +400,28 @@ static void leuart_sigf(RX_LEUART_STATE_MACHINE *leuart_state){
   }
 }
 
+/***************************************************************************//**
+ * @brief
+ *   Takes the byte in RXDATA into the frame
+ *
+ * @details
+ *   Bytes past LEUART_RX_SIZE are left out, the SIGFRAME still ends the
+ *   frame.  All of them are recorded.
+ *
+ ******************************************************************************/
+
+static void leuart_rx_byte(RX_LEUART_STATE_MACHINE *leuart_state){
+  char data = leuart_state->leuart->RXDATA;
 
+  // Not the bytes the loopback test sends itself, a replay sends them again
+  if(!(leuart_state->leuart->CTRL & LEUART_CTRL_LOOPBK)){
+      RECORD(RECORDER_LEUART_RX, data);
+  }
+  if(leuart_state->string && (leuart_state->length < LEUART_RX_SIZE - 1)){
+      leuart_state->string[leuart_state->length] = data;
+      leuart_state->length++;
+  }
+}
 
 /***************************************************************************//**
  * @brief
@@ -387,7 +429,12 @@ static void leuart_sigf(RX_LEUART_STATE_MACHINE *leuart_state){
  *
  * @details
  *   This function basically initially block the EM and initializes the leuart
- *   struct and the correct state for thr operations to begin
+ *   struct and the correct state for thr operations to begin.  The string
+ *   is copied into a block of the pool, the caller can reuse its buffer as
+ *   soon as this returns.  A string longer than POOL_LARGE_SIZE goes out cut
+ *   to it, without a free block it is dropped; the pool counts both, see
+ *   pool_report().  Waiting here for a block could wait for ever, the blocks
+ *   are given back by the main loop this is called from.
  *
  * @note
  *   This function is just for setting up the structs etc. not operating on it
@@ -399,18 +446,30 @@ static void leuart_sigf(RX_LEUART_STATE_MACHINE *leuart_state){
  * @param[in] string_len
  *   The length of the string
  *
+ * @return
+ *   false if the string was dropped, nothing is sent and no TX done event
+ *   follows
  *
  ******************************************************************************/
 
 
 
-void leuart_start(LEUART_TypeDef *leuart, char *string, uint32_t string_len){
+bool leuart_start(LEUART_TypeDef *leuart, char *string, uint32_t string_len){
+    char *block;
 
-    while(leuart->SYNCBUSY);
+    // The string goes out with the CTRL and commands written before it
+    leuart_sync(leuart, LEUART_SYNCBUSY_CTRL | LEUART_SYNCBUSY_CMD);
+    // Wait for the previous string with interrupts on, its TXBL and TXC
+    // interrupts are what finish it
+    while(leuart_state.busy == true);
+    block = pool_alloc_clamp(&string_len);
+    if(!block){
+        return false;
+    }
+    memcpy(block, string, string_len);
 
     CORE_DECLARE_IRQ_STATE;
     CORE_ENTER_CRITICAL();
-    while(leuart_state.busy == true);
     sleep_block_mode(LEUART_TX_EM);
 
     leuart_state.callback = tx_done_evt;
@@ -418,13 +477,12 @@ void leuart_start(LEUART_TypeDef *leuart, char *string, uint32_t string_len){
     leuart_state.length = string_len;
     leuart_state.leuart = leuart;
     leuart_state.state = TRANSMIT_DATA;
-    strcpy(leuart_state.string, string);
+    leuart_state.string = block;
     leuart_state.busy = true;
 
-    leuart->IEN = LEUART_IEN_TXBL;
+    leuart->IEN |= LEUART_IEN_TXBL;
     CORE_EXIT_CRITICAL();
-
-
+    return true;
 }
 
 /***************************************************************************//**
@@ -445,6 +503,40 @@ bool leuart_tx_busy(LEUART_TypeDef *leuart){
 
 }
 
+/***************************************************************************//**
+ * @brief
+ *  Copies the last frame received, start and signal frames included
+ *
+ * @details
+ *   Meant for the rx_done_evt callback.  The copy is taken with interrupts
+ *   off so a frame arriving meanwhile cannot tear it.  The frame's block
+ *   goes back to the pool, a second copy or one while the next frame is
+ *   coming in is empty.
+ *
+ * @param[out] *string
+ *   Destination, always NULL terminated
+ *
+ * @param[in] size
+ *   Size of the destination in bytes
+ *
+ ******************************************************************************/
+
+void leuart_rx_copy(char *string, uint32_t size){
+  CORE_DECLARE_IRQ_STATE;
+
+  EFM_ASSERT(size > 0);
+  CORE_ENTER_CRITICAL();
+  if(leuart_rx_state.string && (leuart_rx_state.state == STARTFRAME)){
+      strncpy(string, leuart_rx_state.string, size - 1);
+      pool_free(leuart_rx_state.string);
+      leuart_rx_state.string = NULL;
+  } else {
+      string[0] = '\0';
+  }
+  CORE_EXIT_CRITICAL();
+  string[size - 1] = '\0';
+}
+
 /***************************************************************************//**
  * @brief
  *   LEUART STATUS function returns the STATUS of the peripheral for the
@@ -477,9 +569,14 @@ uint32_t leuart_status(LEUART_TypeDef *leuart){
  * 	 for the TDD tests.
  *
  * @note
- *   Before exiting this function to update  the CMD register, it must
- *   perform a SYNCBUSY while loop to ensure that the CMD has by synchronized
- *   to the lower frequency LEUART domain.
+ *   CMD must not be written again while the last command is still being
+ *   synchronized to the lower frequency LEUART domain, so this waits for
+ *   that before the write rather than for its own write after it.  A read
+ *   of STATUS that depends on the command has to wait for it itself.
+ *   Inside a leuart_freeze() batch the commands are ORed into one write,
+ *   a batch must not hold both halves of an enable and disable pair.  The
+ *   batch masks the LEUART interrupt, so the handler's RXBLOCKDIS and
+ *   RXBLOCKEN always go out on their own and never join the batch.
  *
  * @param[in] *leuart
  *   Defines the LEUART peripheral to access.
@@ -491,8 +588,105 @@ uint32_t leuart_status(LEUART_TypeDef *leuart){
 
 void leuart_cmd_write(LEUART_TypeDef *leuart, uint32_t cmd_update){
 
+	if(leuart_shadow.frozen){
+	    leuart_shadow.cmd |= cmd_update;
+	    leuart->CMD = leuart_shadow.cmd;
+	    return;
+	}
+	leuart_sync(leuart, LEUART_SYNCBUSY_CMD);
 	leuart->CMD = cmd_update;
-	while(leuart->SYNCBUSY);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sets and clears bits of CTRL from its shadow copy
+ *
+ * @details
+ *   Like leuart_cmd_write(), waits for the last CTRL write only when one is
+ *   still under way, and not at all inside a batch.
+ *
+ * @note
+ *   leuart_open() fills the shadow, all later CTRL writes go through here.
+ *
+ * @param[in] set
+ *   Bits to set
+ *
+ * @param[in] clear
+ *   Bits to clear
+ *
+ ******************************************************************************/
+
+void leuart_ctrl_write(LEUART_TypeDef *leuart, uint32_t set, uint32_t clear){
+  if(!leuart_shadow.frozen){
+      leuart_sync(leuart, LEUART_SYNCBUSY_CTRL);
+  }
+  leuart_shadow.ctrl = (leuart_shadow.ctrl & ~clear) | set;
+  leuart->CTRL = leuart_shadow.ctrl;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Starts a batch of register writes
+ *
+ * @details
+ *   FREEZE holds the writes to the synchronized registers back until
+ *   leuart_commit(), which hands them to the LF domain together.  Every
+ *   synchronization costs several LFB clock cycles however many registers
+ *   it carries.  A write still under way from before has to land first.
+ *
+ * @note
+ *   Nothing inside the batch may wait on SYNCBUSY or read back a register
+ *   it wrote, neither changes before the commit.  The LEUART interrupt is
+ *   masked until the commit: a command the handler wrote into a frozen CMD
+ *   would take the place of the batch's, or be ORed with its opposite.
+ *   Batches are for the main loop only, a frame coming in waits for the
+ *   commit.
+ *
+ ******************************************************************************/
+
+void leuart_freeze(LEUART_TypeDef *leuart){
+  EFM_ASSERT(!leuart_shadow.frozen);
+  leuart_shadow.irq = NVIC_GetEnableIRQ(LEUART0_IRQn);
+  NVIC_DisableIRQ(LEUART0_IRQn);
+  while(leuart->SYNCBUSY);
+  leuart_shadow.ctrl = leuart->CTRL;
+  leuart_shadow.cmd = 0;
+  leuart_shadow.frozen = true;
+  leuart->FREEZE = LEUART_FREEZE_REGFREEZE;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Ends a batch, its writes start synchronizing together
+ *
+ * @details
+ *   Returns without waiting, leuart_sync() or a read of STATUS waits for the
+ *   writes that a later step depends on.  The LEUART interrupt masked by
+ *   leuart_freeze() is taken again here.
+ *
+ ******************************************************************************/
+
+void leuart_commit(LEUART_TypeDef *leuart){
+  EFM_ASSERT(leuart_shadow.frozen);
+  leuart_shadow.frozen = false;
+  leuart->FREEZE = 0;
+  if(leuart_shadow.irq){
+      NVIC_EnableIRQ(LEUART0_IRQn);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Waits for register writes to reach the LF domain
+ *
+ * @param[in] mask
+ *   LEUART_SYNCBUSY_ bits of the writes waited for
+ *
+ ******************************************************************************/
+
+void leuart_sync(LEUART_TypeDef *leuart, uint32_t mask){
+  EFM_ASSERT(!leuart_shadow.frozen);
+  while(leuart->SYNCBUSY & mask);
 }
 
 /***************************************************************************//**
@@ -591,6 +785,10 @@ uint8_t leuart_app_receive_byte(LEUART_TypeDef *leuart){
  *   that here.
  *
  *
+ *   The test runs as a task, leuart_test() starts it and returns at its
+ *   first wait, leuart_test_busy() tells when it is done.  The waits for
+ *   the loopback sleep on the RTCC instead of spinning on timer_delay().
+ *
  * @note
  *
  *   The loopback must be enabled and the rxblocken must be handled carefully
@@ -599,127 +797,146 @@ uint8_t leuart_app_receive_byte(LEUART_TypeDef *leuart){
  ******************************************************************************/
 
 void leuart_test(void){
+  task_start(&test_task, leuart_test_task);
+}
 
+/***************************************************************************//**
+ * @brief
+ *   Whether the self test leuart_open() started is still running
+ *
+ * @details
+ *   The link loops back to itself until then, nothing should be written to
+ *   the HM10 before it is done.
+ *
+ ******************************************************************************/
 
-    LEUART_TypeDef * leuart = leuart_rx_state.leuart;
-   // set IEN to 0
-    uint32_t save_IEN;
-    save_IEN = leuart->IEN;
-    leuart->IEN = ZERO;
-
-    //making it atomic
-    CORE_DECLARE_IRQ_STATE;
-    CORE_ENTER_CRITICAL();
-
-    //enable loopback using the CTRL Register
-    leuart->CTRL |= LEUART_CTRL_LOOPBK ;
-    while(leuart->SYNCBUSY);
-
-    EFM_ASSERT(leuart->STATUS & LEUART_STATUS_RXBLOCK);
-
-      char local_startf, local_sigf;
-      local_startf = leuart->STARTFRAME;
-      local_sigf = leuart->SIGFRAME;
-
-      //Test case :  if its not local_startf as in sending anything other than #
-
-      leuart->TXDATA = ~local_startf;
-      timer_delay(TIME_DELAY_SHORT);
-      EFM_ASSERT(!(leuart->IF & LEUART_IF_RXDATAV));
-
-      //Test case : to see if the startframe behaves as expected
-
-      leuart->TXDATA = local_startf;
-      timer_delay(TIME_DELAY_SHORT);
-      EFM_ASSERT(leuart->IF & LEUART_IF_RXDATAV);
-      EFM_ASSERT(local_startf == leuart->RXDATA);
-
-      //Test case : to check if sigframe behaves as expected
-
-      leuart->TXDATA = local_sigf;
-      timer_delay(TIME_DELAY_SHORT);
-      EFM_ASSERT(leuart->IF & LEUART_IF_SIGF);
-      EFM_ASSERT(local_sigf == leuart->RXDATA);
-
-      CORE_EXIT_CRITICAL();
-
-      // clearing the flags
-      leuart->IFC = leuart->IF;
-      leuart->IEN = save_IEN;
-
-
-      leuart->CMD = LEUART_CMD_RXBLOCKEN;
-      while(leuart->SYNCBUSY);
-
- // Test Case : This is for testing and making sure the state machine is implemented correctly
-      char test_str[] = "123";
-      char  input_str[CHAR_SIZE]  ;
-      uint32_t length;
-
-      input_str[ZERO] = ZERO;
-
-      strcat(input_str,"abc");
-      length = strlen(input_str);
-      input_str[length] = leuart->STARTFRAME;
-      input_str[length+ONE] = ZERO;
-      strcat(input_str, test_str);
-      length = strlen(input_str);
-      input_str[length] = leuart->SIGFRAME;
-      input_str[length+ONE] = ZERO;
-      strcat(input_str, "xyz");
-
-      char corr_str[CHAR_SIZE] ;
-
-      corr_str[ZERO] = leuart->STARTFRAME;
-      corr_str[ONE] = ZERO;
-
-      strcat(corr_str,test_str);
-
-      length = strlen(corr_str);
-      corr_str[length] = leuart->SIGFRAME;
-
-      corr_str[length+ONE] = ZERO;
-
-    //  char result_str[CHAR_SIZE];
-
-
-
-      int str_len = strlen(input_str);
-
-      // sending the input string to leuart_start()
-
-      leuart_start(leuart, input_str, str_len);
-
-      while(leuart_tx_busy(leuart));
-
-      timer_delay(TIME_DELAY_LONG);
-
- //     strcpy(result_str,leuart_rx_state.string);  //copying into result from the buffer
-
-  /*    for(size_t i = ZERO;i< strlen(corr_str);i++){
-
-
-         EFM_ASSERT(corr_str[i] == result_str[i]); //checking
-      }*/
-
-      EFM_ASSERT(strcmp(leuart_rx_state.string, corr_str) == 0); // using the c library : strcmp to compare the result
-
-
-      // have to clear the event as well
-
-      EFM_ASSERT((leuart->STATUS & LEUART_STATUS_RXBLOCK)); // Check if RX is blocked
-      leuart->CTRL &= ~LEUART_CTRL_LOOPBK; //disable loopback
-      while(leuart->SYNCBUSY);
-
-      remove_scheduled_event(rx_done_evt);
-
-
-
-
-
+bool leuart_test_busy(void){
+  return task_running(&test_task);
+}
 
+/***************************************************************************//**
+ * @brief
+ *   Whether a string leuart_start() took is still being sent
+ *
+ * @details
+ *   Clears once its last stop bit has left, unlike leuart_tx_busy() which
+ *   only covers the register synchronization.
+ *
+ ******************************************************************************/
 
+bool leuart_tx_pending(void){
+  return leuart_state.busy;
+}
 
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
 
+/***************************************************************************//**
+ * @brief
+ *   Body of the self test, see leuart_test()
+ *
+ * @details
+ *   Locals do not survive the waits, the test keeps its state in statics.
+ *   The interrupts of the LEUART are off for the single byte checks, so the
+ *   main loop going on between them cannot disturb the flags.
+ *
+ ******************************************************************************/
 
+static TASK_STATUS leuart_test_task(TASK *task){
+  static LEUART_TypeDef *leuart;
+  static uint32_t save_IEN;
+  static char local_startf, local_sigf;
+  static char *input_str;
+  static char *corr_str;
+  char test_str[] = "123";
+  uint32_t length;
+  bool sent;
+
+  TASK_BEGIN(task);
+
+  leuart = leuart_rx_state.leuart;
+  // set IEN to 0
+  save_IEN = leuart->IEN;
+  leuart->IEN = ZERO;
+
+  //enable loopback using the CTRL Register, the bytes below have to go out
+  //looped back
+  leuart_ctrl_write(leuart, LEUART_CTRL_LOOPBK, 0);
+  leuart_sync(leuart, LEUART_SYNCBUSY_CTRL);
+
+  EFM_ASSERT(leuart->STATUS & LEUART_STATUS_RXBLOCK);
+
+  local_startf = leuart->STARTFRAME;
+  local_sigf = leuart->SIGFRAME;
+
+  //Test case :  if its not local_startf as in sending anything other than #
+
+  leuart->TXDATA = ~local_startf;
+  TASK_DELAY(task, TIME_DELAY_SHORT);
+  EFM_ASSERT(!(leuart->IF & LEUART_IF_RXDATAV));
+
+  //Test case : to see if the startframe behaves as expected
+
+  leuart->TXDATA = local_startf;
+  TASK_DELAY(task, TIME_DELAY_SHORT);
+  EFM_ASSERT(leuart->IF & LEUART_IF_RXDATAV);
+  EFM_ASSERT(local_startf == leuart->RXDATA);
+
+  //Test case : to check if sigframe behaves as expected
+
+  leuart->TXDATA = local_sigf;
+  TASK_DELAY(task, TIME_DELAY_SHORT);
+  EFM_ASSERT(leuart->IF & LEUART_IF_SIGF);
+  EFM_ASSERT(local_sigf == leuart->RXDATA);
+
+  // clearing the flags
+  leuart->IFC = leuart->IF;
+  leuart->IEN = save_IEN;
+
+  // Lands long before the first byte of the string below is through
+  leuart_cmd_write(leuart, LEUART_CMD_RXBLOCKEN);
+
+  // Test Case : This is for testing and making sure the state machine is implemented correctly
+  input_str = pool_alloc(CHAR_SIZE);
+  corr_str = pool_alloc(CHAR_SIZE);
+  EFM_ASSERT(input_str && corr_str);
+  input_str[ZERO] = ZERO;
+  strcat(input_str,"abc");
+  length = strlen(input_str);
+  input_str[length] = leuart->STARTFRAME;
+  input_str[length+ONE] = ZERO;
+  strcat(input_str, test_str);
+  length = strlen(input_str);
+  input_str[length] = leuart->SIGFRAME;
+  input_str[length+ONE] = ZERO;
+  strcat(input_str, "xyz");
+
+  corr_str[ZERO] = leuart->STARTFRAME;
+  corr_str[ONE] = ZERO;
+  strcat(corr_str,test_str);
+  length = strlen(corr_str);
+  corr_str[length] = leuart->SIGFRAME;
+  corr_str[length+ONE] = ZERO;
+
+  // sending the input string to leuart_start(), the task takes the receive
+  // event ahead of the app's callback
+  sent = leuart_start(leuart, input_str, strlen(input_str));
+  EFM_ASSERT(sent);
+  TASK_WAIT(task, rx_done_evt, TIME_DELAY_LONG);
+  EFM_ASSERT(!TASK_TIMED_OUT(task));
+  // leuart_start() has its own copy, input_str takes the frame
+  leuart_rx_copy(input_str, CHAR_SIZE);
+  EFM_ASSERT(strcmp(input_str, corr_str) == 0); // using the c library : strcmp to compare the result
+  pool_free(input_str);
+  pool_free(corr_str);
+
+  // "xyz" is still on its way after the SIGFRAME
+  TASK_WAIT_UNTIL(task, !leuart_state.busy, tx_done_evt, TIME_DELAY_LONG);
+  EFM_ASSERT(!TASK_TIMED_OUT(task));
+
+  EFM_ASSERT((leuart->STATUS & LEUART_STATUS_RXBLOCK)); // Check if RX is blocked
+  leuart_ctrl_write(leuart, 0, LEUART_CTRL_LOOPBK); //disable loopback, leuart_start() waits for it
+
+  TASK_END(task);
 }
@@ -0,0 +1,265 @@
+/**
+ * @file pool.c
+ * @author Shambaditya Tarafder
+ * @date   12/9/2021
+ * @brief  Fixed-block pool of the message and frame buffers.  Blocks come in
+ *         a few size classes, taking and giving one back is a bit in a mask
+ *         with interrupts off, so the interrupt handlers use it too.  The
+ *         peak of each class is kept to size them by.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "pool.h"
+#include <stdio.h>
+#include "em_core.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define POOL_WORD_BYTES     4
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+typedef struct {
+  uint8_t          *base;
+  uint32_t          size;
+  uint32_t          blocks;
+} POOL_CLASS;
+
+// Whole words, so every block is word aligned
+static uint32_t small_blocks[POOL_SMALL_BLOCKS][POOL_SMALL_SIZE / POOL_WORD_BYTES];
+static uint32_t medium_blocks[POOL_MEDIUM_BLOCKS][POOL_MEDIUM_SIZE / POOL_WORD_BYTES];
+static uint32_t large_blocks[POOL_LARGE_BLOCKS][POOL_LARGE_SIZE / POOL_WORD_BYTES];
+
+static const POOL_CLASS classes[POOL_CLASSES] = {
+  { (uint8_t *)small_blocks,  POOL_SMALL_SIZE,  POOL_SMALL_BLOCKS },
+  { (uint8_t *)medium_blocks, POOL_MEDIUM_SIZE, POOL_MEDIUM_BLOCKS },
+  { (uint8_t *)large_blocks,  POOL_LARGE_SIZE,  POOL_LARGE_BLOCKS },
+};
+
+static uint32_t free_mask[POOL_CLASSES];        // One bit per block, set while free
+static POOL_STATS stats[POOL_CLASSES];
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static uint32_t pool_class_of(uint8_t *block);
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Gives every block back and clears the statistics
+ *
+ * @details
+ *   Before the drivers that take blocks are opened.
+ *
+ ******************************************************************************/
+
+void pool_open(void){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  for(uint32_t i = 0; i < POOL_CLASSES; i++){
+      EFM_ASSERT(classes[i].blocks && (classes[i].blocks <= POOL_BLOCKS_MAX));
+      EFM_ASSERT(!(classes[i].size % POOL_WORD_BYTES));
+      EFM_ASSERT(!i || (classes[i].size > classes[i - 1].size));
+      free_mask[i] = (classes[i].blocks == POOL_BLOCKS_MAX) ? UINT32_MAX : (1UL << classes[i].blocks) - 1;
+      stats[i] = (POOL_STATS){ .size = classes[i].size, .blocks = classes[i].blocks };
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes a block of at least size bytes
+ *
+ * @details
+ *   From the smallest class size fits in, or the next larger one that has a
+ *   block free.  The time taken does not depend on how many blocks are out,
+ *   interrupt handlers can call it.  Each call is counted against the class
+ *   size fits in, so its peak, borrowed and failed counts tell how many
+ *   blocks it needs.
+ *
+ * @param[in] size
+ *   Bytes needed, up to POOL_LARGE_SIZE
+ *
+ * @return
+ *   The block, NULL if the class and all larger ones are empty
+ *
+ ******************************************************************************/
+
+void *pool_alloc(uint32_t size){
+  uint32_t fit = 0;
+  void *block = NULL;
+
+  EFM_ASSERT(size <= POOL_LARGE_SIZE);
+  while(classes[fit].size < size){
+      fit++;
+  }
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if(size > stats[fit].largest){
+      stats[fit].largest = size;
+  }
+  for(uint32_t i = fit; i < POOL_CLASSES; i++){
+      if(free_mask[i]){
+          uint32_t index = __builtin_ctz(free_mask[i]);
+          free_mask[i] &= ~(1UL << index);
+          block = classes[i].base + index * classes[i].size;
+          if(++stats[i].used > stats[i].peak){
+              stats[i].peak = stats[i].used;
+          }
+          if(i != fit){
+              stats[i].borrowed++;
+          }
+          break;
+      }
+  }
+  if(!block){
+      stats[fit].failed++;
+  }
+  CORE_EXIT_CRITICAL();
+  return block;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes a block of at least size bytes, or a large one for more
+ *
+ * @details
+ *   For data that can go out cut short.  A size over POOL_LARGE_SIZE is
+ *   lowered to it and counted as truncated against the large class, the
+ *   rest is pool_alloc().
+ *
+ * @param[in,out] size
+ *   Bytes needed, lowered to the bytes the block holds
+ *
+ * @return
+ *   The block, NULL if the class and all larger ones are empty
+ *
+ ******************************************************************************/
+
+void *pool_alloc_clamp(uint32_t *size){
+  if(*size > POOL_LARGE_SIZE){
+      CORE_DECLARE_IRQ_STATE;
+      CORE_ENTER_CRITICAL();
+      stats[POOL_CLASSES - 1].truncated++;
+      CORE_EXIT_CRITICAL();
+      *size = POOL_LARGE_SIZE;
+  }
+  return pool_alloc(*size);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Gives a block back
+ *
+ * @details
+ *   NULL is ignored.  Anything that is not a block pool_alloc() handed out
+ *   and not given back yet stops on EFM_ASSERT.
+ *
+ * @param[in] block
+ *   What pool_alloc() returned
+ *
+ ******************************************************************************/
+
+void pool_free(void *block){
+  uint32_t i;
+  uint32_t offset;
+  uint32_t bit;
+
+  if(!block){
+      return;
+  }
+  i = pool_class_of(block);
+  EFM_ASSERT(i < POOL_CLASSES);
+  offset = (uint32_t)((uint8_t *)block - classes[i].base);
+  EFM_ASSERT(!(offset % classes[i].size));
+  bit = 1UL << (offset / classes[i].size);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  EFM_ASSERT(!(free_mask[i] & bit));
+  free_mask[i] |= bit;
+  stats[i].used--;
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Copies the statistics of one size class
+ *
+ * @param[in] pool_class
+ *   0 for the smallest to POOL_CLASSES - 1
+ *
+ * @return
+ *   false for a class that does not exist
+ *
+ ******************************************************************************/
+
+bool pool_get(uint32_t pool_class, POOL_STATS *out){
+  if(pool_class >= POOL_CLASSES){
+      return false;
+  }
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *out = stats[pool_class];
+  CORE_EXIT_CRITICAL();
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   One size class as a line of text for the BLE link
+ *
+ * @details
+ *   "P<size> N<blocks> U<used> H<peak> L<largest> B<borrowed> F<failed>
+ *   T<truncated>\n".
+ *
+ * @return
+ *   The peak, the line is written for a class that was never used too
+ *
+ ******************************************************************************/
+
+uint32_t pool_report(uint32_t pool_class, char *report, uint32_t size){
+  POOL_STATS class_stats;
+
+  EFM_ASSERT(size > 0);
+  report[0] = 0;
+  if(!pool_get(pool_class, &class_stats)){
+      return 0;
+  }
+  snprintf(report, size, "P%lu N%lu U%lu H%lu L%lu B%lu F%lu T%lu\n", (unsigned long)class_stats.size,
+           (unsigned long)class_stats.blocks, (unsigned long)class_stats.used,
+           (unsigned long)class_stats.peak, (unsigned long)class_stats.largest,
+           (unsigned long)class_stats.borrowed, (unsigned long)class_stats.failed,
+           (unsigned long)class_stats.truncated);
+  return class_stats.peak;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Size class a block lies in, POOL_CLASSES if none
+ *
+ ******************************************************************************/
+
+static uint32_t pool_class_of(uint8_t *block){
+  for(uint32_t i = 0; i < POOL_CLASSES; i++){
+      if((block >= classes[i].base) && (block < classes[i].base + classes[i].blocks * classes[i].size)){
+          return i;
+      }
+  }
+  return POOL_CLASSES;
+}
@@ -0,0 +1,338 @@
+/**
+ * @file profiler.c
+ * @author Shambaditya Tarafder
+ * @date   12/6/2021
+ * @brief  Charges the core's active cycles to the scheduled callback or
+ *         interrupt handler running them and measures the time asleep, for
+ *         the CPU load and its top consumers
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include "profiler.h"
+#include "em_core.h"
+#include "em_rtcc.h"
+#include "cmu.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint64_t cycles[PROFILER_OWNERS];
+static uint32_t owner_stack[PROFILER_DEPTH];    // [0] is the thread level owner
+static uint32_t owner_depth;
+static uint32_t last_cyccnt;
+static uint32_t window_start;                   // RTCC ticks
+static uint32_t sleep_start;
+static uint32_t sleep_ticks;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static void profiler_charge(void);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Starts the DWT cycle counter and the RTCC timebase and clears the
+ *   profile
+ *
+ * @details
+ *   CYCCNT only runs while the core is awake, so it splits the active time
+ *   between the handlers.  The RTCC runs from the ULFRCO through every energy
+ *   mode the app uses and times the sleeps and the window.  The ULFRCO is
+ *   only accurate to a few percent, which the load inherits.
+ *
+ ******************************************************************************/
+
+void profiler_open(void){
+  RTCC_Init_TypeDef rtcc_init = RTCC_INIT_DEFAULT;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  cmu_clock_request(cmuClock_RTCC, CMU_OWNER_PROFILER);
+  rtcc_init.presc = rtccCntPresc_1;
+  RTCC_Init(&rtcc_init);
+
+  profiler_clear();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Charges the cycles so far to the interrupted owner and starts charging
+ *   an interrupt handler
+ *
+ * @details
+ *   First statement of a handler, through PROFILER_IRQ_ENTER()
+ *
+ ******************************************************************************/
+
+void profiler_irq_enter(IRQn_Type irqn){
+  CORE_DECLARE_IRQ_STATE;
+
+  EFM_ASSERT((uint32_t)irqn < EXT_IRQ_COUNT);
+  CORE_ENTER_CRITICAL();
+  profiler_charge();
+  EFM_ASSERT(owner_depth < PROFILER_DEPTH - 1);
+  owner_stack[++owner_depth] = PROFILER_IRQ(irqn);
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Charges the handler and returns to the owner it interrupted
+ *
+ * @details
+ *   Last statement of a handler, through PROFILER_IRQ_EXIT()
+ *
+ ******************************************************************************/
+
+void profiler_irq_exit(void){
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  profiler_charge();
+  EFM_ASSERT(owner_depth > 0);
+  owner_depth--;
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Hands the thread level to the callback of an event leaving the scheduler
+ *
+ * @details
+ *   Called by remove_scheduled_event() with only the events that are
+ *   pending.  The main loop removes an event right before calling its
+ *   callback, so the callback is charged until the next one is taken or the
+ *   core goes to sleep.  The scheduler no longer masks interrupts, so the
+ *   charge takes its own short critical section against the handlers'.
+ *
+ * @param[in] events
+ *   Event bits leaving the pending set, the lowest one is taken
+ *
+ ******************************************************************************/
+
+void profiler_dispatch(uint32_t events){
+  for(uint32_t i = 0; i < PROFILER_EVENTS; i++){
+      if(events & (0x01UL << i)){
+          CORE_DECLARE_IRQ_STATE;
+          CORE_ENTER_CRITICAL();
+          profiler_charge();
+          owner_stack[0] = PROFILER_EVENT(i);
+          CORE_EXIT_CRITICAL();
+          return;
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Marks the start of a sleep, called by enter_sleep() with interrupts off
+ *
+ ******************************************************************************/
+
+void profiler_sleep_begin(void){
+  profiler_charge();
+  owner_stack[0] = PROFILER_MAIN;
+  sleep_start = RTCC_CounterGet();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Marks the end of a sleep, called by enter_sleep() before the interrupt
+ *   that woke the core is taken
+ *
+ ******************************************************************************/
+
+void profiler_sleep_end(void){
+  sleep_ticks += RTCC_CounterGet() - sleep_start;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Active cycles charged to an owner in this window
+ *
+ * @param[in] owner
+ *   PROFILER_MAIN, PROFILER_EVENT() or PROFILER_IRQ()
+ *
+ ******************************************************************************/
+
+uint64_t profiler_cycles(uint32_t owner){
+  uint64_t count;
+
+  EFM_ASSERT(owner < PROFILER_OWNERS);
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  profiler_charge();
+  count = cycles[owner];
+  CORE_EXIT_CRITICAL();
+  return count;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   CPU load of this window, the time not asleep
+ *
+ * @return
+ *   Load in tenths of a percent, 0 to 1000
+ *
+ ******************************************************************************/
+
+uint32_t profiler_load(void){
+  uint32_t window;
+  uint32_t asleep;
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  window = RTCC_CounterGet() - window_start;
+  asleep = sleep_ticks;
+  CORE_EXIT_CRITICAL();
+  if(!window){
+      return 0;
+  }
+  if(asleep > window){
+      asleep = window;
+  }
+  return (uint32_t)(((uint64_t)(window - asleep) * 1000) / window);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Formats the load and the top consumers as one line for the BLE link
+ *
+ * @details
+ *   "CPU <load>% <window>ms <kilocycles>kc <owner> <share>% ..." with the
+ *   PROFILER_TOP owners by share of the active cycles.  Owners are M for the
+ *   main loop, E<n> for the callback of event bit n and I<n> for the
+ *   handler of IRQ n.
+ *
+ * @return
+ *   Load in tenths of a percent
+ *
+ ******************************************************************************/
+
+uint32_t profiler_report(char *report, uint32_t size){
+  uint32_t top[PROFILER_TOP];
+  uint32_t top_count = 0;
+  uint64_t total = 0;
+  uint32_t load = profiler_load();
+  uint32_t window;
+  uint32_t len;
+
+  EFM_ASSERT(size > 0);
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  profiler_charge();
+  window = RTCC_CounterGet() - window_start;
+  for(uint32_t owner = 0; owner < PROFILER_OWNERS; owner++){
+      total += cycles[owner];
+  }
+  // Selection of the largest owners, PROFILER_TOP is small
+  for(uint32_t rank = 0; rank < PROFILER_TOP; rank++){
+      uint32_t best = PROFILER_OWNERS;
+      for(uint32_t owner = 0; owner < PROFILER_OWNERS; owner++){
+          bool taken = false;
+          for(uint32_t i = 0; i < top_count; i++){
+              taken |= (top[i] == owner);
+          }
+          if(!taken && cycles[owner] && ((best == PROFILER_OWNERS) || (cycles[owner] > cycles[best]))){
+              best = owner;
+          }
+      }
+      if(best == PROFILER_OWNERS){
+          break;
+      }
+      top[top_count++] = best;
+  }
+  len = snprintf(report, size, "CPU %lu.%lu%% %lums %lukc", (unsigned long)(load / 10),
+                 (unsigned long)(load % 10), (unsigned long)((window * 1000ULL) / PROFILER_RTCC_HZ),
+                 (unsigned long)(total / 1000));
+  for(uint32_t i = 0; (i < top_count) && (len < size); i++){
+      char name[12];
+      profiler_owner_name(top[i], name, sizeof(name));
+      len += snprintf(&report[len], size - len, " %s %lu%%", name,
+                      (unsigned long)((cycles[top[i]] * 100) / total));
+  }
+  CORE_EXIT_CRITICAL();
+  if(len < size){
+      snprintf(&report[len], size - len, "\n");
+  }
+  return load;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Starts a new profiling window
+ *
+ ******************************************************************************/
+
+void profiler_clear(void){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  for(uint32_t owner = 0; owner < PROFILER_OWNERS; owner++){
+      cycles[owner] = 0;
+  }
+  last_cyccnt = DWT->CYCCNT;
+  window_start = RTCC_CounterGet();
+  sleep_ticks = 0;
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Owner the core's cycles are charged to right now
+ *
+ * @details
+ *   For the simulator's energy model, which splits the core current the
+ *   same way
+ *
+ ******************************************************************************/
+
+uint32_t profiler_owner(void){
+  return owner_stack[owner_depth];
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Short name of an owner for the report
+ *
+ ******************************************************************************/
+
+void profiler_owner_name(uint32_t owner, char *name, uint32_t size){
+  if(owner == PROFILER_MAIN){
+      snprintf(name, size, "M");
+  } else if(owner < PROFILER_IRQ(0)){
+      snprintf(name, size, "E%lu", (unsigned long)(owner - PROFILER_EVENT(0)));
+  } else {
+      snprintf(name, size, "I%lu", (unsigned long)(owner - PROFILER_IRQ(0)));
+  }
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Charges the cycles since the last charge to the running owner
+ *
+ ******************************************************************************/
+
+static void profiler_charge(void){
+  uint32_t now = DWT->CYCCNT;
+
+  cycles[owner_stack[owner_depth]] += now - last_cyccnt;
+  last_cyccnt = now;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file recorder.c
+ * @author Shambaditya Tarafder
+ * @date   12/9/2021
+ * @brief  Records the external inputs from the last reset on, the LEUART and
+ *         I2C bytes received and the LETIMER interrupts, with their times,
+ *         for the host simulation to replay through the same drivers
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "recorder.h"
+#include "em_core.h"
+#include "em_rtcc.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define RECORDER_DELTA_SHIFT  16
+#define RECORDER_DELTA_MAX    0xFFFF
+#define RECORDER_SOURCE_SHIFT 8
+#define RECORDER_DATA_MASK    0xFF
+#define RECORDER_HEX_DIGITS   8
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint32_t recording[RECORDER_WORDS];
+static uint32_t count;
+static uint32_t last;               // RTCC count of the last input
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Starts a recording
+ *
+ * @details
+ *   Times count from RTCC 0, the host starts the replay when its RTCC
+ *   starts.  After task_open() and before the drivers that take inputs.
+ *   A wake-up from EM4H starts over with the RTCC still running.
+ *
+ ******************************************************************************/
+
+void recorder_open(void){
+  count = 0;
+  last = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Records one input, called through RECORD() from the interrupt handlers
+ *
+ * @details
+ *   Each input is a word: the RTCC ticks since the last input in bits
+ *   31:16, the source in 15:8 and the data in 7:0.  A longer gap is made
+ *   up of RECORDER_TIME words ahead of it.  A replay has to start from the
+ *   reset, so a full recording stops and keeps its beginning.
+ *
+ * @param[in] source
+ *   RECORDER_LEUART_RX to RECORDER_I2C_RX
+ *
+ * @param[in] data
+ *   Low 8 bits kept
+ *
+ ******************************************************************************/
+
+void recorder_input(uint32_t source, uint32_t data){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  uint32_t now = RTCC_CounterGet();
+  uint32_t delta = now - last;
+
+  while((delta > RECORDER_DELTA_MAX) && (count < RECORDER_WORDS)){
+      recording[count++] = (uint32_t)RECORDER_DELTA_MAX << RECORDER_DELTA_SHIFT;
+      delta -= RECORDER_DELTA_MAX;
+  }
+  if(count < RECORDER_WORDS){
+      recording[count++] = (delta << RECORDER_DELTA_SHIFT) | (source << RECORDER_SOURCE_SHIFT)
+                           | (data & RECORDER_DATA_MASK);
+      last = now;
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Copies part of the recording out as one line of text
+ *
+ * @details
+ *   "R<hex>\n", as many words as fit as 8 hex digits each, most
+ *   significant first, for ble_write().  The recording is left as it is,
+ *   it can be read out again from 0.
+ *
+ * @param[out] line
+ *   Destination, NULL terminated
+ *
+ * @param[in] size
+ *   Size of line, at least one word
+ *
+ * @param[in,out] next
+ *   Word the line starts at, moved past the words copied
+ *
+ * @return
+ *   false, and line untouched, once next is at the end
+ *
+ ******************************************************************************/
+
+bool recorder_line(char *line, uint32_t size, uint32_t *next){
+  static const char hex[] = "0123456789abcdef";
+  uint32_t len = 0;
+  uint32_t end;
+
+  EFM_ASSERT(size >= RECORDER_HEX_DIGITS + 3);
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  end = count;
+  CORE_EXIT_CRITICAL();
+  if(*next >= end){
+      return false;
+  }
+  line[len++] = RECORDER_LINE_MARK;
+  while((*next < end) && (len + RECORDER_HEX_DIGITS + 2 <= size)){
+      for(int32_t shift = 28; shift >= 0; shift -= 4){
+          line[len++] = hex[(recording[*next] >> shift) & 0xF];
+      }
+      (*next)++;
+  }
+  line[len++] = '\n';
+  line[len] = '\0';
+  return true;
+}
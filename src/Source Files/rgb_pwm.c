@@ -0,0 +1,400 @@
+/**
+ * @file rgb_pwm.c
+ * @author Shambaditya Tarafder
+ * @date   11/20/2021
+ * @brief  TIMER driven PWM of the Thunderboard RGB color lines with 8-bit color,
+ *         gamma correction and a global brightness setting
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "rgb_pwm.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+
+/* Gamma 2.2 correction of an 8-bit color level into the 10-bit compare range,
+ * placed in flash so that no start-up time is spent building it */
+static const uint16_t gamma_table[256] = {
+     0,    0,    0,    0,    0,    0,    0,    0,    1,    1,    1,    1,    1,    1,    2,    2,
+     2,    3,    3,    3,    4,    4,    5,    5,    6,    6,    7,    7,    8,    9,    9,   10,
+    11,   11,   12,   13,   14,   15,   16,   16,   17,   18,   19,   20,   21,   23,   24,   25,
+    26,   27,   28,   30,   31,   32,   34,   35,   36,   38,   39,   41,   42,   44,   46,   47,
+    49,   51,   52,   54,   56,   58,   60,   61,   63,   65,   67,   69,   71,   73,   76,   78,
+    80,   82,   84,   87,   89,   91,   94,   96,   98,  101,  103,  106,  109,  111,  114,  117,
+   119,  122,  125,  128,  130,  133,  136,  139,  142,  145,  148,  151,  155,  158,  161,  164,
+   167,  171,  174,  177,  181,  184,  188,  191,  195,  198,  202,  206,  209,  213,  217,  221,
+   225,  228,  232,  236,  240,  244,  248,  252,  257,  261,  265,  269,  274,  278,  282,  287,
+   291,  295,  300,  304,  309,  314,  318,  323,  328,  333,  337,  342,  347,  352,  357,  362,
+   367,  372,  377,  382,  387,  393,  398,  403,  408,  414,  419,  425,  430,  436,  441,  447,
+   452,  458,  464,  470,  475,  481,  487,  493,  499,  505,  511,  517,  523,  529,  535,  542,
+   548,  554,  561,  567,  573,  580,  586,  593,  599,  606,  613,  619,  626,  633,  640,  647,
+   653,  660,  667,  674,  681,  689,  696,  703,  710,  717,  725,  732,  739,  747,  754,  762,
+   769,  777,  784,  792,  800,  807,  815,  823,  831,  839,  847,  855,  863,  871,  879,  887,
+   895,  903,  912,  920,  928,  937,  945,  954,  962,  971,  979,  988,  997, 1005, 1014, 1023,
+};
+
+static uint8_t  pwm_color[RGB_PWM_CHANNELS];
+static uint8_t  pwm_brightness;
+static uint32_t pwm_leds;
+static bool     pwm_running;
+static uint32_t pwm_owner;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static TIMER_Prescale_TypeDef rgb_pwm_prescale(uint32_t timer_clk_freq);
+static void rgb_pwm_select(uint32_t leds);
+static void rgb_pwm_update(void);
+static void rgb_pwm_run(bool enable);
+static void rgb_pwm_clock_update(uint32_t hfper_freq);
+static void rgb_pwm_presc_set(uint32_t hfper_freq);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Sets up the TIMER that drives the RGB color lines in PWM mode
+ *
+ * @details
+ *   The three CC channels of RGB_PWM_TIMER are configured for PWM and routed to
+ *   the red, green and blue color lines.  The prescaler is chosen from the
+ *   current HFPERCLK so that the PWM frequency stays above RGB_PWM_FREQ, and
+ *   recomputed each time the PWM starts and on every HF clock change while it
+ *   runs.  The timer is left stopped until a color is set.
+ *
+ * @note
+ *   gpio_open() and rgb_init() must be called first so that the color lines
+ *   are push-pull outputs that idle low whenever the TIMER route is disabled.
+ *
+ ******************************************************************************/
+
+void rgb_pwm_open(void){
+  TIMER_Init_TypeDef    pwm_timer_init = TIMER_INIT_DEFAULT;
+  TIMER_InitCC_TypeDef  pwm_cc_init = TIMER_INITCC_DEFAULT;
+
+  cmu_clock_request(RGB_PWM_CLOCK, CMU_OWNER_RGB_PWM);
+
+  pwm_cc_init.mode = timerCCModePWM;
+  TIMER_InitCC(RGB_PWM_TIMER, RGB_RED_CH, &pwm_cc_init);
+  TIMER_InitCC(RGB_PWM_TIMER, RGB_GREEN_CH, &pwm_cc_init);
+  TIMER_InitCC(RGB_PWM_TIMER, RGB_BLUE_CH, &pwm_cc_init);
+
+  TIMER_TopSet(RGB_PWM_TIMER, RGB_PWM_TOP);
+  TIMER_CompareSet(RGB_PWM_TIMER, RGB_RED_CH, 0);
+  TIMER_CompareSet(RGB_PWM_TIMER, RGB_GREEN_CH, 0);
+  TIMER_CompareSet(RGB_PWM_TIMER, RGB_BLUE_CH, 0);
+
+  pwm_timer_init.enable = false;
+  pwm_timer_init.debugRun = false;
+  pwm_timer_init.prescale = rgb_pwm_prescale(CMU_ClockFreqGet(cmuClock_HFPER));
+  TIMER_Init(RGB_PWM_TIMER, &pwm_timer_init);
+
+  RGB_PWM_TIMER->ROUTELOC0 = RED_RGB_LOC | GREEN_RGB_LOC | BLUE_RGB_LOC;
+  RGB_PWM_TIMER->ROUTEPEN = 0;
+  cmu_clock_release(RGB_PWM_CLOCK, CMU_OWNER_RGB_PWM);
+
+  pwm_color[RGB_RED_CH] = 0;
+  pwm_color[RGB_GREEN_CH] = 0;
+  pwm_color[RGB_BLUE_CH] = 0;
+  pwm_brightness = RGB_PWM_BRIGHT_MAX;
+  pwm_leds = NO_LEDS;
+  pwm_running = false;
+  pwm_owner = RGB_PWM_OWNER_NONE;
+
+  cmu_hf_notify_register(rgb_pwm_clock_update);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Lights the selected LEDs with an 8-bit per channel color
+ *
+ * @details
+ *   The color levels are gamma corrected, scaled by the global brightness and
+ *   written into the buffered compare registers so that the new duty cycle is
+ *   applied at the next TIMER overflow without a glitch.  Once written the
+ *   TIMER holds the color with no further CPU involvement.
+ *
+ * @note
+ *   The four LEDs share the color lines, every selected LED shows the same
+ *   color.  A black color or NO_LEDS turns the TIMER off so that the LEDs draw
+ *   no current and EM2 is no longer blocked.  Asserts while an LED effect or
+ *   the framebuffer drives the TIMER, see rgb_pwm_owner().
+ *
+ * @param[in] leds
+ *   Bit mask of RGB_LED_0 to RGB_LED_3 to light
+ *
+ * @param[in] red
+ *   Red level, 0 to 255
+ *
+ * @param[in] green
+ *   Green level, 0 to 255
+ *
+ * @param[in] blue
+ *   Blue level, 0 to 255
+ *
+ ******************************************************************************/
+
+void rgb_pwm_set(uint32_t leds, uint8_t red, uint8_t green, uint8_t blue){
+  EFM_ASSERT(!(leds & ~RGB_ALL_LEDS));
+  EFM_ASSERT(pwm_owner <= RGB_PWM_OWNER_COLOR);
+
+  pwm_color[RGB_RED_CH] = red;
+  pwm_color[RGB_GREEN_CH] = green;
+  pwm_color[RGB_BLUE_CH] = blue;
+
+  rgb_pwm_select(leds);
+  rgb_pwm_update();
+  pwm_owner = pwm_running ? RGB_PWM_OWNER_COLOR : RGB_PWM_OWNER_NONE;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Lights the selected LEDs with the compare buffers fed by another source
+ *
+ * @details
+ *   Starts the PWM TIMER without writing the compare buffers, for drivers
+ *   such as the LED effect engine that stream the duty cycles into
+ *   CC[ch].CCVB themselves.  The driver owns the TIMER until it streams to
+ *   NO_LEDS, which stops it.
+ *
+ * @note
+ *   Asserts while another driver owns the TIMER, a color set with
+ *   rgb_pwm_set() included: the caller turns that off first.
+ *
+ * @param[in] owner
+ *   RGB_PWM_OWNER_EFFECT or RGB_PWM_OWNER_FB
+ *
+ * @param[in] leds
+ *   Bit mask of RGB_LED_0 to RGB_LED_3 to light, NO_LEDS to stop
+ *
+ ******************************************************************************/
+
+void rgb_pwm_stream(uint32_t owner, uint32_t leds){
+  EFM_ASSERT(!(leds & ~RGB_ALL_LEDS));
+  EFM_ASSERT((owner == RGB_PWM_OWNER_EFFECT) || (owner == RGB_PWM_OWNER_FB));
+  EFM_ASSERT((pwm_owner == RGB_PWM_OWNER_NONE) || (pwm_owner == owner));
+
+  rgb_pwm_select(leds);
+  rgb_pwm_run(leds != NO_LEDS);
+  pwm_owner = pwm_running ? owner : RGB_PWM_OWNER_NONE;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The driver of the PWM TIMER's compare buffers
+ *
+ * @return
+ *   One of the RGB_PWM_OWNER_ defines, RGB_PWM_OWNER_NONE while stopped
+ *
+ ******************************************************************************/
+
+uint32_t rgb_pwm_owner(void){
+  return pwm_owner;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sets the global brightness applied on top of the color levels
+ *
+ * @details
+ *   The brightness scales the gamma corrected duty cycle of every channel, so
+ *   a color keeps its hue while it is dimmed.  An LED effect or framebuffer
+ *   that owns the TIMER takes it at its next start or commit.
+ *
+ * @param[in] brightness
+ *   Global brightness, 0 (off) to RGB_PWM_BRIGHT_MAX (full scale)
+ *
+ ******************************************************************************/
+
+void rgb_pwm_brightness(uint8_t brightness){
+  pwm_brightness = brightness;
+  if(pwm_owner <= RGB_PWM_OWNER_COLOR){
+      rgb_pwm_update();
+      pwm_owner = pwm_running ? RGB_PWM_OWNER_COLOR : RGB_PWM_OWNER_NONE;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Turns all of the RGB LEDs off and stops the PWM TIMER
+ *
+ ******************************************************************************/
+
+void rgb_pwm_off(void){
+  rgb_pwm_set(NO_LEDS, 0, 0, 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Converts an 8-bit color level into the compare value of a channel
+ *
+ * @details
+ *   Looks the level up in the gamma table and scales it by the global
+ *   brightness.  Brightness 0 is off, the scale alone would leave a duty of
+ *   up to 3.  Exposed so that other LED drivers feeding the compare buffers
+ *   produce the same perceived levels.
+ *
+ * @param[in] level
+ *   Color level, 0 to 255
+ *
+ * @return
+ *   Compare value, 0 to RGB_PWM_TOP
+ *
+ ******************************************************************************/
+
+uint32_t rgb_pwm_duty(uint8_t level){
+  if(!pwm_brightness){
+      return 0;
+  }
+  return (gamma_table[level] * ((uint32_t)pwm_brightness + 1)) >> 8;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Switches the LED enable lines to the selected LEDs
+ *
+ * @param[in] leds
+ *   Bit mask of RGB_LED_0 to RGB_LED_3 to enable
+ *
+ ******************************************************************************/
+
+static void rgb_pwm_select(uint32_t leds){
+  if(pwm_leds & ~leds){
+      leds_enabled(pwm_leds & ~leds, NO_COLOR, false);
+  }
+  if(leds){
+      leds_enabled(leds, NO_COLOR, true);
+  }
+  pwm_leds = leds;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Writes the current color into the compare buffers and starts or stops the
+ *   TIMER as required
+ *
+ * @note
+ *   The compare buffers are only written while the TIMER is clocked; they are
+ *   retained while its clock is gated.
+ *
+ ******************************************************************************/
+
+static void rgb_pwm_update(void){
+  uint32_t red_duty = rgb_pwm_duty(pwm_color[RGB_RED_CH]);
+  uint32_t green_duty = rgb_pwm_duty(pwm_color[RGB_GREEN_CH]);
+  uint32_t blue_duty = rgb_pwm_duty(pwm_color[RGB_BLUE_CH]);
+
+  rgb_pwm_run(pwm_leds && (red_duty | green_duty | blue_duty));
+  if(pwm_running){
+      TIMER_CompareBufSet(RGB_PWM_TIMER, RGB_RED_CH, red_duty);
+      TIMER_CompareBufSet(RGB_PWM_TIMER, RGB_GREEN_CH, green_duty);
+      TIMER_CompareBufSet(RGB_PWM_TIMER, RGB_BLUE_CH, blue_duty);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Starts or stops the PWM TIMER and its pin route
+ *
+ * @details
+ *   While the TIMER is running EM2 is blocked, as the TIMER is clocked from
+ *   the HF clock tree, and its clock is held.  The prescaler is set for the
+ *   HFPERCLK of the moment, the band may have changed while it was stopped.
+ *   When stopped the route is removed so that the color lines return to
+ *   their GPIO idle level of off and the TIMER clock is released.
+ *
+ * @param[in] enable
+ *   true to run the PWM, false to stop it
+ *
+ ******************************************************************************/
+
+static void rgb_pwm_run(bool enable){
+  if(enable && !pwm_running){
+      cmu_clock_request(RGB_PWM_CLOCK, CMU_OWNER_RGB_PWM);
+      rgb_pwm_presc_set(CMU_ClockFreqGet(cmuClock_HFPER));
+      RGB_PWM_TIMER->ROUTEPEN = TIMER_ROUTEPEN_CC0PEN | TIMER_ROUTEPEN_CC1PEN | TIMER_ROUTEPEN_CC2PEN;
+      sleep_block_mode(RGB_PWM_EM);
+      TIMER_Enable(RGB_PWM_TIMER, true);
+      pwm_running = true;
+  }
+  else if(!enable && pwm_running){
+      TIMER_Enable(RGB_PWM_TIMER, false);
+      RGB_PWM_TIMER->ROUTEPEN = 0;
+      sleep_unblock_mode(RGB_PWM_EM);
+      cmu_clock_release(RGB_PWM_CLOCK, CMU_OWNER_RGB_PWM);
+      pwm_running = false;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Reprograms the PWM prescaler after an HF clock change
+ *
+ * @details
+ *   Only while the PWM runs, its clock is then held by rgb_pwm_run().  A
+ *   stopped PWM gets the prescaler of the new band when it starts again.
+ *
+ * @param[in] hfper_freq
+ *   The new HFPERCLK frequency in Hz
+ *
+ ******************************************************************************/
+
+static void rgb_pwm_clock_update(uint32_t hfper_freq){
+  if(pwm_running){
+      rgb_pwm_presc_set(hfper_freq);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Writes the prescaler of an HFPERCLK frequency into the TIMER
+ *
+ * @note
+ *   The TIMER clock must be on.
+ *
+ ******************************************************************************/
+
+static void rgb_pwm_presc_set(uint32_t hfper_freq){
+  uint32_t prescale = rgb_pwm_prescale(hfper_freq);
+
+  RGB_PWM_TIMER->CTRL = (RGB_PWM_TIMER->CTRL & ~_TIMER_CTRL_PRESC_MASK) |
+                        (prescale << _TIMER_CTRL_PRESC_SHIFT);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Picks the largest TIMER prescaler that keeps the PWM frequency at or
+ *   above RGB_PWM_FREQ, the TIMER is clocked as slowly as the LEDs allow
+ *
+ * @param[in] timer_clk_freq
+ *   Frequency of the clock feeding the TIMER in Hz
+ *
+ * @return
+ *   The prescale setting for TIMER_Init()
+ *
+ ******************************************************************************/
+
+static TIMER_Prescale_TypeDef rgb_pwm_prescale(uint32_t timer_clk_freq){
+  uint32_t prescale = 0;
+
+  while((prescale < RGB_PWM_MAX_PRESCALE) &&
+        ((timer_clk_freq >> (prescale + 1)) / (RGB_PWM_TOP + 1) >= RGB_PWM_FREQ)){
+      prescale++;
+  }
+  return (TIMER_Prescale_TypeDef)prescale;
+}
@@ -7,16 +7,24 @@
  */
 
 
+#include <stdatomic.h>
 #include "scheduler.h"
 #include "em_assert.h"
-#include "em_core.h"
 #include "em_emu.h"
+#include "event_latency.h"
+#include "profiler.h"
+#include "task.h"
+#include "trace.h"
 
 //***********************************************************************************
 // Private variables
 //***********************************************************************************
 
-static unsigned int event_scheduled;
+// Set from interrupts and cleared from the main loop with LDREX/STREX, so
+// posting an event never masks the interrupts of the others
+static atomic_uint_least32_t event_scheduled;
+static SCHEDULER_CB callbacks[SCHEDULER_EVENTS];
+static uint32_t level_events[SCHEDULER_PRIORITIES];    // Registered event bits of each level
 
 /***************************************************************************//**
  * @brief
@@ -34,10 +42,13 @@ static unsigned int event_scheduled;
  ******************************************************************************/
 
 void scheduler_open(void){
-  CORE_DECLARE_IRQ_STATE;
-  CORE_ENTER_CRITICAL();
-  event_scheduled = 0;
-  CORE_EXIT_CRITICAL();
+  atomic_store(&event_scheduled, 0);
+  for(uint32_t level = 0; level < SCHEDULER_PRIORITIES; level++){
+      level_events[level] = 0;
+  }
+#ifdef EVENT_LATENCY_ENABLED
+  event_latency_open();
+#endif
 }
 
 /***************************************************************************//**
@@ -46,7 +57,12 @@ void scheduler_open(void){
  *
  * @details
  *   ORs a new event, the input argument,into the existing state of the private
- *   (static) variable event_scheduled
+ *   (static) variable event_scheduled.  Events that were not already pending
+ *   are timestamped for the latency statistics.
+ *
+ *   The OR is one atomic read-modify-write, an LDREX/STREX loop on the
+ *   Cortex-M4, which retries if an interrupt posted in between instead of
+ *   masking interrupts around it.
  *
  * @note
  *   Should be called only when adding an event
@@ -59,10 +75,13 @@ void scheduler_open(void){
  ******************************************************************************/
 
 void add_scheduled_event(uint32_t event){
-  CORE_DECLARE_IRQ_STATE;
-  CORE_ENTER_CRITICAL();
-  event_scheduled |= event;
-  CORE_EXIT_CRITICAL();
+  uint32_t pending = atomic_fetch_or(&event_scheduled, event);
+
+  TRACE(TRACE_POST, __builtin_ctz(event));
+#ifdef EVENT_LATENCY_ENABLED
+  event_latency_post(event & ~pending);
+#endif
+  (void)pending;
 }
 
 /***************************************************************************//**
@@ -73,6 +92,11 @@ void add_scheduled_event(uint32_t event){
  *    Removes the event, the input argument, from the existing state of the
  *    private(static)variable event_scheduled.
  *
+ *    Only the main loop removes events, so the events seen pending here stay
+ *    pending until the atomic AND takes them.  The hooks run on that snapshot
+ *    before the AND, while an interrupt posting the same event again still
+ *    finds it pending and leaves its timestamp alone.
+ *
  *
  * @note
  *   Function should only be called when removing an event
@@ -84,10 +108,16 @@ void add_scheduled_event(uint32_t event){
  ******************************************************************************/
 
 void remove_scheduled_event(uint32_t event){
-  CORE_DECLARE_IRQ_STATE;
-  CORE_ENTER_CRITICAL();
-  event_scheduled &= ~event;
-  CORE_EXIT_CRITICAL();
+  uint32_t pending = event & atomic_load(&event_scheduled);
+
+#ifdef EVENT_LATENCY_ENABLED
+  event_latency_dispatch(pending);
+#endif
+#ifdef PROFILER_ENABLED
+  profiler_dispatch(pending);
+#endif
+  (void)pending;
+  atomic_fetch_and(&event_scheduled, ~event);
 }
 
 /***************************************************************************//**
@@ -105,5 +135,99 @@ void remove_scheduled_event(uint32_t event){
  ******************************************************************************/
 
 uint32_t get_scheduled_events(void){
-  return event_scheduled;
+  return atomic_load(&event_scheduled);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Attaches the callback the main loop runs for an event and its priority
+ *
+ * @details
+ *   Events nobody registers stay pending until whoever posted them removes
+ *   them or a task waits on them.
+ *
+ * @param[in] event
+ *   A single event bit
+ *
+ * @param[in] priority
+ *   SCHEDULER_PRIO_URGENT to SCHEDULER_PRIO_LOW
+ *
+ ******************************************************************************/
+
+void scheduler_register(uint32_t event, uint32_t priority, SCHEDULER_CB callback){
+  EFM_ASSERT(event && !(event & (event - 1)));
+  EFM_ASSERT(priority < SCHEDULER_PRIORITIES);
+  EFM_ASSERT(callback);
+  for(uint32_t level = 0; level < SCHEDULER_PRIORITIES; level++){
+      level_events[level] &= ~event;
+  }
+  level_events[priority] |= event;
+  callbacks[__builtin_ctz(event)] = callback;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The registered event the main loop should run next
+ *
+ * @details
+ *   The pending event of the highest priority level, the lowest bit within a
+ *   level.  Callbacks run to completion, so an urgent event posted while a
+ *   low one runs is the next one taken, ahead of anything that was waiting.
+ *   An event a task waits on keeps the level of its callback, one with no
+ *   callback is served at TASK_PRIORITY.
+ *
+ * @return
+ *   The event bit, 0 if no registered event is pending
+ *
+ ******************************************************************************/
+
+uint32_t scheduler_next_event(void){
+  uint32_t pending = atomic_load(&event_scheduled);
+  uint32_t unregistered = pending & task_waiting();
+
+  for(uint32_t level = 0; level < SCHEDULER_PRIORITIES; level++){
+      unregistered &= ~level_events[level];
+  }
+  for(uint32_t level = 0; level < SCHEDULER_PRIORITIES; level++){
+      uint32_t ready = pending & level_events[level];
+      if(level == TASK_PRIORITY){
+          ready |= unregistered;
+      }
+      if(ready){
+          return ready & (~ready + 1);
+      }
+  }
+  return 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes the next event and runs its callback
+ *
+ * @details
+ *   One event per call, so the main loop picks the priorities up again,
+ *   and picks the HF band, between callbacks.  A task waiting on the event
+ *   takes it instead of the callback.  The trace brackets either with
+ *   TRACE_DISPATCH and TRACE_DONE.
+ *
+ * @return
+ *   false if no registered event was pending
+ *
+ ******************************************************************************/
+
+bool scheduler_dispatch(void){
+  uint32_t event = scheduler_next_event();
+
+  if(!event){
+      return false;
+  }
+  remove_scheduled_event(event);
+  TRACE(TRACE_DISPATCH, __builtin_ctz(event));
+  if(event & task_waiting()){
+      task_notify(event);
+  } else {
+      callbacks[__builtin_ctz(event)]();
+  }
+  TRACE(TRACE_DONE, __builtin_ctz(event));
+  return true;
 }
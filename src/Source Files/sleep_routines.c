@@ -38,6 +38,8 @@
 
 
 #include "sleep_routines.h"
+#include "profiler.h"
+#include "trace.h"
 
 //***********************************************************************************
 // Private variables
@@ -92,19 +94,31 @@ void sleep_open(void){
 void enter_sleep(void){
   CORE_DECLARE_IRQ_STATE;
   CORE_ENTER_CRITICAL();
+#ifdef PROFILER_ENABLED
+  profiler_sleep_begin();
+#endif
   if (lowest_energy_mode[EM0] > 0) {
   }
   else if (lowest_energy_mode[EM1] > 0) {
   }
   else if (lowest_energy_mode[EM2] > 0) {
+    TRACE(TRACE_SLEEP, EM1);
     EMU_EnterEM1();
+    TRACE(TRACE_WAKE, EM1);
   }
   else if (lowest_energy_mode[EM3] > 0) {
+    TRACE(TRACE_SLEEP, EM2);
     EMU_EnterEM2(true);
+    TRACE(TRACE_WAKE, EM2);
   }
   else {
+    TRACE(TRACE_SLEEP, EM3);
     EMU_EnterEM3(true);
+    TRACE(TRACE_WAKE, EM3);
   }
+#ifdef PROFILER_ENABLED
+  profiler_sleep_end();
+#endif
   CORE_EXIT_CRITICAL();
 }
 
@@ -0,0 +1,284 @@
+/**
+ * @file stack.c
+ * @author Shambaditya Tarafder
+ * @date   12/9/2021
+ * @brief  High-water mark of the main stack and of each interrupt handler.
+ *         The unused stack is painted with STACK_PAINT, the lowest word that
+ *         lost the paint is as deep as the stack has been.
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "stack.h"
+#include <stdio.h>
+#include "em_core.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define STACK_WORD_BYTES    4
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+// Ends of the main stack, from the linker script
+extern uint32_t __StackLimit[];
+extern uint32_t __StackTop[];
+
+typedef struct {
+  IRQn_Type         irqn;
+  uint32_t         *sp;             // SP at the hook, NULL if not on the main stack
+  uint32_t         *bottom;         // Lowest word of the painted window
+  uint32_t         *lowest;         // Deepest word a nested handler found in use
+} STACK_ENTRY;
+
+static STACK_ENTRY entries[STACK_DEPTH];
+static uint32_t entry_depth;
+static uint32_t *low_water;         // Deepest word known to have been used
+static STACK_IRQ_STATS irq_stats[EXT_IRQ_COUNT];
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static bool stack_on_main(uint32_t *sp);
+static uint32_t *stack_scan(uint32_t *from, uint32_t *to);
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Paints the main stack under the caller and clears the handler peaks
+ *
+ * @details
+ *   First thing of app_peripheral_setup(), the less of the stack in use the
+ *   more of it is measured.  STACK_GUARD bytes under the SP are left for
+ *   this function's own frame.  Off the main stack nothing is painted and
+ *   nothing measured.
+ *
+ ******************************************************************************/
+
+void stack_open(void){
+  uint32_t *sp = (uint32_t *)(uintptr_t)__get_MSP();
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  entry_depth = 0;
+  low_water = __StackTop;
+  for(uint32_t i = 0; i < EXT_IRQ_COUNT; i++){
+      irq_stats[i] = (STACK_IRQ_STATS){ 0 };
+  }
+  if(stack_on_main(sp)){
+      for(uint32_t *p = __StackLimit; p < sp - STACK_GUARD / STACK_WORD_BYTES; p++){
+          *p = STACK_PAINT;
+      }
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Size of the main stack in bytes
+ *
+ ******************************************************************************/
+
+uint32_t stack_size(void){
+  return (uint32_t)(__StackTop - __StackLimit) * STACK_WORD_BYTES;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Most of the main stack ever in use, in bytes from its top
+ *
+ * @details
+ *   Scans up from the limit to the first word that lost the paint, at most
+ *   to the deepest word the handler hooks already found.  All of the stack
+ *   once the paint at the limit is gone, it may have overflowed.
+ *
+ ******************************************************************************/
+
+uint32_t stack_used(void){
+  uint32_t *lowest;
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  lowest = stack_scan(__StackLimit, low_water);
+  low_water = lowest;
+  CORE_EXIT_CRITICAL();
+  return (uint32_t)(__StackTop - lowest) * STACK_WORD_BYTES;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Paints the window under the SP of a handler, first thing it does
+ *
+ * @details
+ *   Through STACK_IRQ_ENTER() in PROFILER_IRQ_ENTER(), built with
+ *   STACK_IRQ_ENABLED, a debug profile.  The window may hold
+ *   the deepest use of the stack so far, it is taken down before the paint
+ *   goes over it, for the main stack and for the handlers this one nests
+ *   in.  A handler that goes deeper than STACK_IRQ_WINDOW shows as using
+ *   all of it, stack_used() still sees the rest.
+ *
+ * @param[in] irqn
+ *   Interrupt of the handler
+ *
+ ******************************************************************************/
+
+void stack_irq_enter(IRQn_Type irqn){
+  uint32_t *sp = (uint32_t *)(uintptr_t)__get_MSP();
+  STACK_ENTRY *entry;
+  uint32_t *used;
+
+  EFM_ASSERT((uint32_t)irqn < EXT_IRQ_COUNT);
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  EFM_ASSERT(entry_depth < STACK_DEPTH);
+  entry = &entries[entry_depth++];
+  entry->irqn = irqn;
+  entry->sp = stack_on_main(sp) ? sp : NULL;
+  if(entry->sp){
+      entry->bottom = sp - STACK_IRQ_WINDOW / STACK_WORD_BYTES;
+      if(entry->bottom < __StackLimit){
+          entry->bottom = __StackLimit;
+      }
+      entry->lowest = sp;
+      used = stack_scan(entry->bottom, sp);
+      if(used < low_water){
+          low_water = used;
+      }
+      for(uint32_t i = 0; i + 1 < entry_depth; i++){
+          if(entries[i].sp && (used < entries[i].lowest)){
+              entries[i].lowest = used;
+          }
+      }
+      for(uint32_t *p = entry->bottom; p < sp; p++){
+          *p = STACK_PAINT;
+      }
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes down how deep the handler went, last thing it does
+ *
+ * @details
+ *   Through STACK_IRQ_EXIT() in PROFILER_IRQ_EXIT(), the hooks' own frames
+ *   are counted in.
+ *
+ ******************************************************************************/
+
+void stack_irq_exit(void){
+  STACK_ENTRY *entry;
+  STACK_IRQ_STATS *stats;
+  uint32_t *used;
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  EFM_ASSERT(entry_depth > 0);
+  entry = &entries[--entry_depth];
+  if(entry->sp){
+      used = stack_scan(entry->bottom, entry->sp);
+      if(entry->lowest < used){
+          used = entry->lowest;
+      }
+      if(used < low_water){
+          low_water = used;
+      }
+      stats = &irq_stats[entry->irqn];
+      stats->count++;
+      if((uint32_t)(__StackTop - used) * STACK_WORD_BYTES > stats->depth){
+          stats->depth = (uint32_t)(__StackTop - used) * STACK_WORD_BYTES;
+      }
+      if((uint32_t)(entry->sp - used) * STACK_WORD_BYTES > stats->own){
+          stats->own = (uint32_t)(entry->sp - used) * STACK_WORD_BYTES;
+      }
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Copies the peaks of one interrupt handler
+ *
+ * @return
+ *   false for an interrupt that does not exist
+ *
+ ******************************************************************************/
+
+bool stack_irq_get(IRQn_Type irqn, STACK_IRQ_STATS *out){
+  if((uint32_t)irqn >= EXT_IRQ_COUNT){
+      return false;
+  }
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *out = irq_stats[irqn];
+  CORE_EXIT_CRITICAL();
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   The main stack as a line of text for the BLE link
+ *
+ * @details
+ *   "S<size> H<high-water mark>\n", in bytes.
+ *
+ ******************************************************************************/
+
+void stack_report(char *report, uint32_t size){
+  EFM_ASSERT(size > 0);
+  snprintf(report, size, "S%lu H%lu\n", (unsigned long)stack_size(), (unsigned long)stack_used());
+}
+
+/***************************************************************************//**
+ * @brief
+ *   One interrupt handler as a line of text for the BLE link
+ *
+ * @details
+ *   "I<irqn> N<runs> D<depth> O<own>\n", the depth from the top of the main
+ *   stack and the handler's own use under its SP, in bytes.
+ *
+ * @return
+ *   Runs measured, no line for a handler that has not run
+ *
+ ******************************************************************************/
+
+uint32_t stack_irq_report(IRQn_Type irqn, char *report, uint32_t size){
+  STACK_IRQ_STATS stats;
+
+  EFM_ASSERT(size > 0);
+  report[0] = 0;
+  if(!stack_irq_get(irqn, &stats) || !stats.count){
+      return 0;
+  }
+  snprintf(report, size, "I%lu N%lu D%lu O%lu\n", (unsigned long)irqn, (unsigned long)stats.count,
+           (unsigned long)stats.depth, (unsigned long)stats.own);
+  return stats.count;
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static bool stack_on_main(uint32_t *sp){
+  return (sp > __StackLimit) && (sp <= __StackTop);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Lowest word from from up to to that lost the paint, to if none
+ *
+ ******************************************************************************/
+
+static uint32_t *stack_scan(uint32_t *from, uint32_t *to){
+  while((from < to) && (*from == STACK_PAINT)){
+      from++;
+  }
+  return from;
+}
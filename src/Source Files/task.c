@@ -0,0 +1,286 @@
+/**
+ * @file task.c
+ * @author Shambaditya Tarafder
+ * @date   12/8/2021
+ * @brief  Stackless cooperative tasks on top of the scheduler, for flows of
+ *         several steps that wait on events and timeouts between them
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stddef.h>
+#include "task.h"
+#include "em_rtcc.h"
+#include "cmu.h"
+#include "profiler.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TASK_RTCC_IF      RTCC_IF_CC1   // Flag of TASK_RTCC_CH
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static TASK *tasks[TASK_MAX];
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+static void task_resume(TASK *task);
+static void task_arm(void);
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Starts the RTCC compare channel the timeouts run on and hands
+ *   TASK_EVENT to the scheduler
+ *
+ * @details
+ *   The RTCC runs from the ULFRCO in every energy mode the app sleeps in,
+ *   so a task waiting on a timeout leaves the core asleep until it is due.
+ *   The profiler sets the RTCC up the same way, whichever opens first
+ *   starts it.
+ *
+ * @note
+ *   After scheduler_open() and before any driver that starts a task
+ *
+ ******************************************************************************/
+
+void task_open(void){
+  RTCC_Init_TypeDef rtcc_init = RTCC_INIT_DEFAULT;
+  RTCC_CCChConf_TypeDef compare = RTCC_CH_INIT_COMPARE_DEFAULT;
+
+  for(uint32_t i = 0; i < TASK_MAX; i++){
+      tasks[i] = NULL;
+  }
+  cmu_clock_request(cmuClock_RTCC, CMU_OWNER_TASK);
+  rtcc_init.presc = rtccCntPresc_1;
+  RTCC_Init(&rtcc_init);
+  RTCC_ChannelInit(TASK_RTCC_CH, &compare);
+  RTCC_IntDisable(TASK_RTCC_IF);
+  RTCC_IntClear(TASK_RTCC_IF);
+  NVIC_ClearPendingIRQ(RTCC_IRQn);
+  NVIC_EnableIRQ(RTCC_IRQn);
+
+  scheduler_register(TASK_EVENT, TASK_PRIORITY, task_run);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Starts a task and runs it up to its first wait
+ *
+ * @param[in] task
+ *   Static storage of the task, idle
+ *
+ * @param[in] fn
+ *   Body of the task, between TASK_BEGIN() and TASK_END()
+ *
+ ******************************************************************************/
+
+void task_start(TASK *task, TASK_FN fn){
+  uint32_t slot = TASK_MAX;
+
+  EFM_ASSERT(!task->running);
+  for(uint32_t i = 0; i < TASK_MAX; i++){
+      if(!tasks[i]){
+          slot = i;
+          break;
+      }
+  }
+  EFM_ASSERT(slot < TASK_MAX);
+  tasks[slot] = task;
+  task->lc = 0;
+  task->fn = fn;
+  task->waiting = 0;
+  task->events = 0;
+  task->timed = false;
+  task->timed_out = false;
+  task->running = true;
+  task_resume(task);
+  task_arm();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Whether a task has been started and not ended yet
+ *
+ ******************************************************************************/
+
+bool task_running(TASK *task){
+  return task->running;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Starts the timeout of the wait a task is entering
+ *
+ * @details
+ *   Called by TASK_WAIT_UNTIL(), also clears what arrived during the last
+ *   wait.  The deadline is rounded up to whole RTCC ticks plus the one
+ *   already under way, so a wait lasts at least ms.
+ *
+ * @param[in] ms
+ *   Timeout in ms, TASK_FOREVER for none
+ *
+ ******************************************************************************/
+
+void task_timeout(TASK *task, uint32_t ms){
+  task->events = 0;
+  task->timed_out = false;
+  task->timed = (ms != TASK_FOREVER);
+  if(task->timed){
+      uint32_t ticks = (uint32_t)(((uint64_t)ms * TASK_RTCC_HZ + 999) / 1000) + 1;
+      task->deadline = RTCC_CounterGet() + ticks;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Events some task is waiting on
+ *
+ * @details
+ *   The scheduler hands these to task_notify() instead of their callbacks.
+ *
+ ******************************************************************************/
+
+uint32_t task_waiting(void){
+  uint32_t waiting = 0;
+
+  for(uint32_t i = 0; i < TASK_MAX; i++){
+      if(tasks[i]){
+          waiting |= tasks[i]->waiting;
+      }
+  }
+  return waiting;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Resumes the tasks waiting on an event the main loop took
+ *
+ * @param[in] event
+ *   A single event bit, already removed from the scheduler
+ *
+ ******************************************************************************/
+
+void task_notify(uint32_t event){
+  for(uint32_t i = 0; i < TASK_MAX; i++){
+      TASK *task = tasks[i];
+      if(task && (task->waiting & event)){
+          task->events |= event;
+          task_resume(task);
+      }
+  }
+  task_arm();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Callback of TASK_EVENT, expires the timeouts that are due and lets every
+ *   task check what it waits on
+ *
+ * @details
+ *   TASK_EVENT comes from the RTCC compare and from a task that ended, the
+ *   conditions of TASK_WAIT_UNTIL() are checked on both.
+ *
+ ******************************************************************************/
+
+void task_run(void){
+  uint32_t now = RTCC_CounterGet();
+
+  for(uint32_t i = 0; i < TASK_MAX; i++){
+      TASK *task = tasks[i];
+      if(task && task->timed && ((int32_t)(now - task->deadline) >= 0)){
+          task->timed_out = true;
+      }
+  }
+  for(uint32_t i = 0; i < TASK_MAX; i++){
+      if(tasks[i]){
+          task_resume(tasks[i]);
+      }
+  }
+  task_arm();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   RTCC interrupt, a task timeout is due
+ *
+ ******************************************************************************/
+
+void RTCC_IRQHandler(void){
+  PROFILER_IRQ_ENTER(RTCC_IRQn);
+  uint32_t int_flag = RTCC_IntGet() & RTCC->IEN;
+  RTCC_IntClear(int_flag);
+
+  if(int_flag & TASK_RTCC_IF){
+      add_scheduled_event(TASK_EVENT);
+  }
+  PROFILER_IRQ_EXIT();
+}
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Runs a task from where it waited until its next wait or its end
+ *
+ * @details
+ *   The end of a task posts TASK_EVENT, so the tasks waiting for it see it.
+ *
+ ******************************************************************************/
+
+static void task_resume(TASK *task){
+  task->waiting = 0;
+  if(task->fn(task) == TASK_ENDED){
+      task->running = false;
+      task->timed = false;
+      for(uint32_t i = 0; i < TASK_MAX; i++){
+          if(tasks[i] == task){
+              tasks[i] = NULL;
+          }
+      }
+      add_scheduled_event(TASK_EVENT);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Points the RTCC compare at the earliest timeout
+ *
+ * @details
+ *   A deadline the counter reached while the compare was being set would
+ *   only match after the counter wraps, so it is posted here instead.
+ *
+ ******************************************************************************/
+
+static void task_arm(void){
+  bool timed = false;
+  uint32_t earliest = 0;
+
+  for(uint32_t i = 0; i < TASK_MAX; i++){
+      TASK *task = tasks[i];
+      if(task && task->timed && (!timed || ((int32_t)(task->deadline - earliest) < 0))){
+          earliest = task->deadline;
+          timed = true;
+      }
+  }
+  if(!timed){
+      RTCC_IntDisable(TASK_RTCC_IF);
+      return;
+  }
+  RTCC_ChannelCCVSet(TASK_RTCC_CH, earliest);
+  RTCC_IntClear(TASK_RTCC_IF);
+  RTCC_IntEnable(TASK_RTCC_IF);
+  if((int32_t)(RTCC_CounterGet() - earliest) >= 0){
+      add_scheduled_event(TASK_EVENT);
+  }
+}
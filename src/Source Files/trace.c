@@ -0,0 +1,218 @@
+/**
+ * @file trace.c
+ * @author Shambaditya Tarafder
+ * @date   12/9/2021
+ * @brief  Flight recorder of the interrupt handlers, scheduler posts and
+ *         dispatches, sleeps and HF clock changes, read out over the BLE link
+ *         and turned into a Chrome/Perfetto timeline on the host
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdatomic.h>
+#include "trace.h"
+#include "em_core.h"
+#include "em_cmu.h"
+#include "em_rtcc.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TRACE_TYPE_SHIFT    24
+#define TRACE_ARG_SHIFT     16
+#define TRACE_ARG_MASK      0xFF
+#define TRACE_CYCLE_MASK    0xFFFF
+#define TRACE_HEX_DIGITS    8
+
+_Static_assert((TRACE_RECORDS & (TRACE_RECORDS - 1)) == 0, "the sequence numbers wrap with the ring");
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint32_t ring[TRACE_RECORDS][TRACE_WORDS];
+static atomic_uint_least32_t head;          // Sequence number of the next record written
+static atomic_uint_least32_t tail;          // Sequence number of the oldest record not read
+static atomic_uint_least32_t clock_word;    // TRACE_HF in force at the oldest record, once overwritten
+static volatile bool running;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Keeps aside a TRACE_HF record a writer is about to overwrite
+ *
+ * @details
+ *   The low 16 bits of the kept word hold the low bits of the record's
+ *   sequence number, trace_line() puts the oldest record's cycle stamp there.
+ *   A nested writer can overwrite a later TRACE_HF first, the compare and
+ *   swap keeps the later one.
+ *
+ * @param[in] word
+ *   Second word of the TRACE_HF record
+ *
+ * @param[in] seq
+ *   Sequence number of the TRACE_HF record
+ *
+ ******************************************************************************/
+
+static void trace_keep_clock(uint32_t word, uint32_t seq){
+  uint32_t want = (word & ~TRACE_CYCLE_MASK) | (seq & TRACE_CYCLE_MASK);
+  uint32_t have = atomic_load(&clock_word);
+
+  do {
+      if(have && ((int16_t)((seq - have) & TRACE_CYCLE_MASK) < 0)){
+          return;
+      }
+  } while(!atomic_compare_exchange_weak(&clock_word, &have, want));
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Empties the ring and starts recording
+ *
+ * @details
+ *   The first record is the core clock, the host needs it for the cycle
+ *   stamps.  The RTCC has to be running, task_open() and profiler_open()
+ *   start it.
+ *
+ ******************************************************************************/
+
+void trace_start(void){
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  atomic_store(&head, 0);
+  atomic_store(&tail, 0);
+  atomic_store(&clock_word, 0);
+  running = true;
+  CORE_EXIT_CRITICAL();
+  trace_record(TRACE_HF, CMU_ClockFreqGet(cmuClock_CORE) / 1000000);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stops recording and keeps what the ring holds, so reading it out over
+ *   the BLE link does not overwrite it with its own interrupts
+ *
+ ******************************************************************************/
+
+void trace_stop(void){
+  running = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stores one record, called through TRACE()
+ *
+ * @details
+ *   The first word is the RTCC count, the LF time that survives the sleeps.
+ *   The second holds the type in its top 8 bits, the argument in bits 23:16
+ *   and the low 16 bits of the DWT cycle counter, which place the record
+ *   within its RTCC tick while the core is awake.  A full ring overwrites
+ *   its oldest record, it always holds the latest TRACE_RECORDS.  An
+ *   overwritten TRACE_HF is kept aside, the host needs the clock from the
+ *   first record on.
+ *
+ *   The interrupt handlers and scheduler posts record, so this takes no
+ *   critical section: the atomic add on head hands each writer its own slot,
+ *   a handler that nests in a writer takes the next one and finishes first.
+ *   trace_line() runs in the main loop and never sees a slot half written.
+ *
+ * @param[in] type
+ *   TRACE_IRQ_ENTER to TRACE_HF
+ *
+ * @param[in] arg
+ *   Argument of the type, low 8 bits kept
+ *
+ ******************************************************************************/
+
+void trace_record(uint32_t type, uint32_t arg){
+  uint32_t seq, lost, *slot;
+
+  if(!running){
+      return;
+  }
+  seq = atomic_fetch_add(&head, 1);
+  slot = ring[seq % TRACE_RECORDS];
+  lost = seq - TRACE_RECORDS;
+  if((seq >= TRACE_RECORDS) && ((int32_t)(lost - atomic_load(&tail)) >= 0)
+      && ((slot[1] >> TRACE_TYPE_SHIFT) == TRACE_HF)){
+      trace_keep_clock(slot[1], lost);
+  }
+  slot[0] = RTCC_CounterGet();
+  slot[1] = (type << TRACE_TYPE_SHIFT) | ((arg & TRACE_ARG_MASK) << TRACE_ARG_SHIFT)
+            | (DWT->CYCCNT & TRACE_CYCLE_MASK);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes the oldest records out of the ring as one line of text
+ *
+ * @details
+ *   "T<hex>\n", both words of as many records as fit as 8 hex digits each,
+ *   most significant first, for ble_write().  A TRACE_HF the ring lost goes
+ *   ahead of the oldest record, with its time.  The critical section only
+ *   keeps a handler from overwriting a record while it is copied.
+ *
+ * @param[out] line
+ *   Destination, NULL terminated
+ *
+ * @param[in] size
+ *   Size of line, at least one record
+ *
+ * @return
+ *   false, and line untouched, if the ring is empty
+ *
+ ******************************************************************************/
+
+bool trace_line(char *line, uint32_t size){
+  static const char hex[] = "0123456789abcdef";
+  uint32_t len = 0, next, end, kept;
+
+  EFM_ASSERT(size >= TRACE_WORDS * TRACE_HEX_DIGITS + 3);
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  end = atomic_load(&head);
+  next = atomic_load(&tail);
+  kept = atomic_load(&clock_word);
+  if(end - next > TRACE_RECORDS){
+      next = end - TRACE_RECORDS;
+  }
+  if(next == end){
+      CORE_EXIT_CRITICAL();
+      return false;
+  }
+  line[len++] = TRACE_LINE_MARK;
+  while((next != end) && (len + TRACE_WORDS * TRACE_HEX_DIGITS + 2 <= size)){
+      uint32_t *oldest = ring[next % TRACE_RECORDS];
+      uint32_t clock[TRACE_WORDS] = { oldest[0], (kept & ~TRACE_CYCLE_MASK) | (oldest[1] & TRACE_CYCLE_MASK) };
+      uint32_t *record = kept ? clock : oldest;
+      for(uint32_t i = 0; i < TRACE_WORDS; i++){
+          for(int32_t shift = 28; shift >= 0; shift -= 4){
+              line[len++] = hex[(record[i] >> shift) & 0xF];
+          }
+      }
+      if(kept){
+          kept = 0;
+      } else {
+          next++;
+      }
+  }
+  atomic_store(&clock_word, kept);
+  atomic_store(&tail, next);
+  CORE_EXIT_CRITICAL();
+  line[len++] = '\n';
+  line[len] = '\0';
+  return true;
+}
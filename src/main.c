@@ -52,51 +52,16 @@ int main(void)
   while (1) {
          // EMU_EnterEM1();
         //  EMU_EnterEM2(true);
-          if(!get_scheduled_events()) {
+          // Pending bits nothing takes, unregistered with no task waiting,
+          // stay pending and must not keep the core in EM0
+          if(!scheduler_next_event()) {
                 enter_sleep();
               }
 
+          // Run the wake-up at the slowest HF band the pending work allows
+          cmu_hf_policy(get_scheduled_events());
 
-          if(get_scheduled_events() & LETIMER0_COMP1_CB){
-              remove_scheduled_event(LETIMER0_COMP1_CB);
-                       scheduled_letimer0_comp1_cb();
-
-
-
-
-                   }
-          if(get_scheduled_events() & LETIMER0_UF_CB){
-                        remove_scheduled_event(LETIMER0_UF_CB);
-                        scheduled_letimer0_uf_cb();
-
-
-
-                    }
-          if(get_scheduled_events() & LETIMER0_COMP0_CB){
-              remove_scheduled_event(LETIMER0_COMP0_CB);
-              scheduled_letimer0_comp0_cb();
-
-
-
-          }
-        /*  if(get_scheduled_events() == SI1133_REG_READ_CB) {
-              remove_scheduled_event(SI1133_REG_READ_CB);
-              scheduled_si1133_cb();
-             }*/
-
-          if(get_scheduled_events() &  SI1133_REG_READ_CB  ){
-              remove_scheduled_event(SI1133_REG_READ_CB);
-              si1133_white_op();
-          }
-
-          if(get_scheduled_events() == BOOT_UP_CB) {
-                remove_scheduled_event(BOOT_UP_CB);
-                scheduled_boot_up_cb();
-              }
-          if(get_scheduled_events() == BLE_TX_DONE_CB) {
-                scheduled_ble_tx_done_cb();
-              }
-
-
+          // Highest priority pending event next, one per pass
+          scheduler_dispatch();
   }
 }